@@ -0,0 +1,289 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdint>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Счётчики глобального operator new. Определены вместе с перегрузками
+// operator new/delete в bench/main.cpp.
+struct AllocationCounter {
+    static std::atomic<uint64_t> count;
+    static std::atomic<uint64_t> bytes;
+};
+
+struct BenchOptions {
+    std::string outputPath = "bench.json";   // "-" — в stdout
+    std::string modelDir = "res/models";
+    std::string assetDir = "res";            // полный набор ресурсов для замеров чтения
+    std::string workDir = "bench_data";      // синтетические OBJ и временные файлы
+    std::vector<size_t> syntheticFaces = { 1000000, 10000000, 50000000 };
+    std::vector<std::string> suites;         // пусто — все наборы
+    std::string filter;                      // подстрока имени замера
+    std::string cameraPath;                  // путь камеры для occlusion (пусто — встроенный)
+    unsigned iterations = 5;
+    size_t singleIterationBytes = 256u << 20; // входы крупнее прогоняются один раз
+};
+
+// Описание замера: bytes и items — объём работы одной итерации.
+struct BenchCase {
+    std::string name;
+    std::string input;
+    uint64_t bytes = 0;
+    uint64_t items = 0;
+    std::string itemUnit;
+    std::vector<std::pair<std::string, double>> params;
+};
+
+// Результат одного замера. Время — по итерациям, выделения памяти — в среднем
+// на итерацию, пиковый RSS — процесса на момент окончания замера.
+struct BenchResult {
+    std::string name;
+    std::string input;
+    std::vector<std::pair<std::string, double>> params;
+    unsigned iterations = 0;
+    double msMin = 0.0;
+    double msMedian = 0.0;
+    double msMean = 0.0;
+    uint64_t bytes = 0;
+    uint64_t items = 0;
+    std::string itemUnit;
+    double allocationsPerIter = 0.0;
+    double allocatedBytesPerIter = 0.0;
+    uint64_t peakRssKb = 0;
+};
+
+class BenchHarness {
+public:
+    static constexpr unsigned MAX_PREPARE_ATTEMPTS = 3;
+
+    explicit BenchHarness(const BenchOptions& opts) : options(opts) {}
+
+    const BenchOptions& getOptions() const { return options; }
+
+    bool wantsSuite(const std::string& suite) const {
+        return options.suites.empty() ||
+               std::find(options.suites.begin(), options.suites.end(), suite) != options.suites.end();
+    }
+
+    bool wantsCase(const std::string& name) const {
+        return options.filter.empty() || name.find(options.filter) != std::string::npos;
+    }
+
+    // Один замер: fn вызывается iterations раз, setup — перед каждым вызовом
+    // вне таймера.
+    void run(const BenchCase& bench, const std::function<void()>& fn,
+             const std::function<void()>& setup = nullptr) {
+        if (!setup) {
+            runPrepared(bench, fn, nullptr);
+            return;
+        }
+        runPrepared(bench, fn, [&setup] {
+            setup();
+            return true;
+        });
+    }
+
+    // То же, но prepare сообщает, готово ли состояние для итерации (например,
+    // удалось ли выселить файлы из кэша). Неготовая итерация не замеряется и
+    // готовится заново, до MAX_PREPARE_ATTEMPTS раз на итерацию; если так и не
+    // вышло, замеряется как есть. Оба числа попадают в параметры замера:
+    // skipped_iterations и unprepared_iterations.
+    void runPrepared(const BenchCase& bench, const std::function<void()>& fn,
+                     const std::function<bool()>& prepare) {
+        if (!wantsCase(bench.name)) return;
+
+        unsigned iterations = bench.bytes > options.singleIterationBytes
+            ? 1u : std::max(1u, options.iterations);
+        std::vector<double> samples;
+        samples.reserve(iterations);
+
+        uint64_t allocCount = 0;
+        uint64_t allocBytes = 0;
+        unsigned skipped = 0;
+        unsigned unprepared = 0;
+        for (unsigned i = 0; i < iterations; ++i) {
+            if (prepare) {
+                unsigned attempt = 1;
+                while (!prepare()) {
+                    if (attempt == MAX_PREPARE_ATTEMPTS) {
+                        ++unprepared;
+                        break;
+                    }
+                    ++attempt;
+                    ++skipped;
+                }
+            }
+            uint64_t countBefore = AllocationCounter::count.load(std::memory_order_relaxed);
+            uint64_t bytesBefore = AllocationCounter::bytes.load(std::memory_order_relaxed);
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            auto finish = std::chrono::steady_clock::now();
+            allocCount += AllocationCounter::count.load(std::memory_order_relaxed) - countBefore;
+            allocBytes += AllocationCounter::bytes.load(std::memory_order_relaxed) - bytesBefore;
+            samples.push_back(std::chrono::duration<double, std::milli>(finish - start).count());
+        }
+
+        BenchResult result;
+        result.name = bench.name;
+        result.input = bench.input;
+        result.params = bench.params;
+        if (prepare && (skipped > 0 || unprepared > 0)) {
+            result.params.emplace_back("skipped_iterations", skipped);
+            result.params.emplace_back("unprepared_iterations", unprepared);
+        }
+        result.iterations = iterations;
+        result.bytes = bench.bytes;
+        result.items = bench.items;
+        result.itemUnit = bench.itemUnit;
+        result.allocationsPerIter = static_cast<double>(allocCount) / iterations;
+        result.allocatedBytesPerIter = static_cast<double>(allocBytes) / iterations;
+        result.peakRssKb = peakRssKb();
+
+        std::vector<double> sorted = samples;
+        std::sort(sorted.begin(), sorted.end());
+        result.msMin = sorted.front();
+        result.msMedian = sorted[sorted.size() / 2];
+        double sum = 0.0;
+        for (double s : samples) sum += s;
+        result.msMean = sum / samples.size();
+
+        std::cerr << "  " << result.name << " [" << result.input << "]: " << result.msMedian << " ms";
+        if (result.msMedian > 0.0 && result.items > 0) {
+            std::cerr << ", " << result.items / (result.msMedian / 1000.0) << " " << result.itemUnit << "/s";
+        }
+        std::cerr << ", " << result.allocationsPerIter << " allocs";
+        if (unprepared > 0) {
+            std::cerr << ", " << unprepared << " of " << iterations << " iterations not prepared";
+        }
+        std::cerr << "\n";
+
+        results.push_back(std::move(result));
+    }
+
+    static uint64_t peakRssKb() {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            return counters.PeakWorkingSetSize / 1024;
+        }
+        return 0;
+#else
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+        return static_cast<uint64_t>(usage.ru_maxrss) / 1024;
+#else
+        return static_cast<uint64_t>(usage.ru_maxrss);
+#endif
+#endif
+    }
+
+    bool writeJson() const {
+        std::ostringstream out;
+        out << "{\n";
+        out << "  \"schema\": 1,\n";
+        out << "  \"compiler\": " << quote(compilerName()) << ",\n";
+#ifdef NDEBUG
+        out << "  \"optimized\": true,\n";
+#else
+        out << "  \"optimized\": false,\n";
+#endif
+        out << "  \"hardware_threads\": " << std::max(1u, std::thread::hardware_concurrency()) << ",\n";
+        out << "  \"peak_rss_kb\": " << peakRssKb() << ",\n";
+        out << "  \"results\": [";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const BenchResult& r = results[i];
+            out << (i == 0 ? "\n" : ",\n") << "    {";
+            out << "\"name\": " << quote(r.name);
+            out << ", \"input\": " << quote(r.input);
+            for (const auto& p : r.params) {
+                out << ", " << quote(p.first) << ": " << number(p.second);
+            }
+            out << ", \"iterations\": " << r.iterations;
+            out << ", \"ms_min\": " << number(r.msMin);
+            out << ", \"ms_median\": " << number(r.msMedian);
+            out << ", \"ms_mean\": " << number(r.msMean);
+            out << ", \"bytes\": " << r.bytes;
+            out << ", \"items\": " << r.items;
+            out << ", \"item_unit\": " << quote(r.itemUnit);
+            double seconds = r.msMedian / 1000.0;
+            out << ", \"mb_per_s\": " << number(seconds > 0.0 ? r.bytes / (1024.0 * 1024.0) / seconds : 0.0);
+            out << ", \"items_per_s\": " << number(seconds > 0.0 ? r.items / seconds : 0.0);
+            out << ", \"allocations\": " << number(r.allocationsPerIter);
+            out << ", \"allocated_bytes\": " << number(r.allocatedBytesPerIter);
+            out << ", \"peak_rss_kb\": " << r.peakRssKb;
+            out << "}";
+        }
+        out << "\n  ]\n}\n";
+
+        if (options.outputPath == "-") {
+            std::cout << out.str();
+            return true;
+        }
+        std::ofstream file(options.outputPath, std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Failed to write benchmark results: " << options.outputPath << std::endl;
+            return false;
+        }
+        file << out.str();
+        std::cerr << "Wrote " << results.size() << " results to " << options.outputPath << "\n";
+        return true;
+    }
+
+private:
+    BenchOptions options;
+    std::vector<BenchResult> results;
+
+    static std::string compilerName() {
+#if defined(__clang__)
+        return "clang " __clang_version__;
+#elif defined(__GNUC__)
+        return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+        return "msvc " + std::to_string(_MSC_VER);
+#else
+        return "unknown";
+#endif
+    }
+
+    static std::string quote(const std::string& s) {
+        std::string out = "\"";
+        for (char c : s) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+        return out + "\"";
+    }
+
+    static std::string number(double value) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.6g", value);
+        return buf;
+    }
+};
@@ -0,0 +1,339 @@
+#pragma once
+
+#include <vector>
+#include <random>
+#include <iostream>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "BenchHarness.hpp"
+#include "Frustum.hpp"
+#include "SceneBvh.hpp"
+#include "Primitives.hpp"
+#include "OcclusionCuller.hpp"
+#include "CameraPath.hpp"
+#include "CellGraph.hpp"
+#include "LightClusters.hpp"
+
+// Отсечение по видимости на CPU: пачка мировых AABB против пирамиды камеры,
+// с SSE и без. Сцена синтетическая — объекты разбросаны вокруг камеры во
+// все стороны, так что в пирамиду попадает меньшая их часть. Сюда же —
+// лучи через двухуровневую BVH сцены из копий одной сферы, отсечение
+// перекрытых объектов на пути камеры по галерее из трёх залов и видимость
+// через проёмы в анфиладе из многих залов и сборка списков источников по
+// кластерам пирамиды.
+class CullingSuite {
+public:
+    static void run(BenchHarness& harness) {
+        std::cerr << "culling\n";
+        const size_t counts[] = { 1000, 100000 };
+        for (size_t count : counts) {
+            BoxBatch boxes = randomBoxes(count, 200.0f);
+            Frustum frustum = cameraFrustum();
+            std::vector<uint8_t> visible(count);
+            std::string input = std::to_string(count) + " boxes";
+
+            size_t culled = frustum.cullBoxes(boxes, visible.data());
+            harness.run({ "frustum.boxes", input, 0, count, "boxes",
+                          { { "culled_fraction", static_cast<double>(culled) / count } } },
+                        [&] { culled = frustum.cullBoxes(boxes, visible.data()); });
+            harness.run({ "frustum.boxes_scalar", input, 0, count, "boxes",
+                          { { "culled_fraction", static_cast<double>(culled) / count } } },
+                        [&] { culled = frustum.cullBoxesScalar(boxes, visible.data()); });
+        }
+
+        if (harness.wantsCase("bvh.scene_rays")) {
+            runSceneRays(harness);
+        }
+        if (harness.wantsCase("occlusion.camera_path")) {
+            runOcclusion(harness);
+        }
+        if (harness.wantsCase("cells.enfilade")) {
+            runCells(harness);
+        }
+        if (harness.wantsCase("lights.clusters")) {
+            runLightClusters(harness);
+        }
+    }
+
+private:
+    // Сетка 32×32 сфер по 2 000 треугольников; лучи из точек над сценой
+    // вниз-вбок, как при выборе мышью с высоты человеческого роста.
+    static void runSceneRays(BenchHarness& harness) {
+        MeshData sphere = Primitives::Sphere(1.0f, 40, 25);
+        std::shared_ptr<const MeshBvh> mesh = MeshBvh::build(sphere.vertices, sphere.indices);
+        SceneBvh scene;
+        const int side = 32;
+        for (int x = 0; x < side; ++x) {
+            for (int z = 0; z < side; ++z) {
+                scene.addObject(mesh, glm::translate(glm::mat4(1.0f), glm::vec3(x * 4.0f, 1.0f, z * 4.0f)));
+            }
+        }
+        scene.build();
+
+        const size_t rayCount = 10000;
+        std::mt19937 rng(5);
+        std::uniform_real_distribution<float> across(0.0f, side * 4.0f);
+        std::uniform_real_distribution<float> tilt(-1.0f, 1.0f);
+        std::vector<glm::vec3> origins(rayCount), directions(rayCount);
+        for (size_t i = 0; i < rayCount; ++i) {
+            origins[i] = glm::vec3(across(rng), 1.7f, across(rng));
+            directions[i] = glm::vec3(tilt(rng), -0.3f, tilt(rng));
+        }
+        size_t hits = 0;
+        auto castAll = [&] {
+            hits = 0;
+            for (size_t i = 0; i < rayCount; ++i) {
+                RayHit hit;
+                hits += scene.raycast(origins[i], directions[i], hit) ? 1 : 0;
+            }
+        };
+        castAll();
+        std::string input = std::to_string(side * side) + " spheres";
+        harness.run({ "bvh.scene_rays", input, 0, rayCount, "rays",
+                      { { "triangles", static_cast<double>(mesh->triangleCount() * side * side) },
+                        { "hit_fraction", static_cast<double>(hits) / rayCount } } },
+                    castAll);
+    }
+
+    struct Gallery {
+        std::shared_ptr<const MeshBvh> box;   // куб ±1
+        std::vector<glm::mat4> occluders;
+        BoxBatch exhibits;
+    };
+
+    // Зал 60×30×20 (как в музее), разделённый двумя стенами с проёмами на
+    // три; в каждом — постаменты с экспонатами и картины на стенах.
+    static Gallery gallery() {
+        Gallery g;
+        MeshData cube = Primitives::Cube();
+        g.box = MeshBvh::build(cube.vertices, cube.indices);
+        auto wall = [&](glm::vec3 min, glm::vec3 max) {
+            glm::vec3 center = (min + max) * 0.5f, half = (max - min) * 0.5f;
+            g.occluders.push_back(glm::translate(glm::mat4(1.0f), center) * glm::scale(glm::mat4(1.0f), half));
+        };
+        wall({ -30.0f, -5.0f, -15.2f }, { 30.0f, 15.0f, -15.0f });
+        wall({ -30.0f, -5.0f, 15.0f }, { 30.0f, 15.0f, 15.2f });
+        wall({ -30.2f, -5.0f, -15.0f }, { -30.0f, 15.0f, 15.0f });
+        wall({ 30.0f, -5.0f, -15.0f }, { 30.2f, 15.0f, 15.0f });
+        for (float x : { -10.0f, 10.0f }) {
+            wall({ x - 0.2f, -5.0f, -15.0f }, { x + 0.2f, 15.0f, -2.0f });
+            wall({ x - 0.2f, -5.0f, 2.0f }, { x + 0.2f, 15.0f, 15.0f });
+            wall({ x - 0.2f, 3.0f, -2.0f }, { x + 0.2f, 15.0f, 2.0f });
+        }
+
+        std::vector<std::pair<glm::vec3, glm::vec3>> exhibits;
+        for (int bay = 0; bay < 3; ++bay) {
+            float bayX = -20.0f + bay * 20.0f;
+            for (int i = 0; i < 4; ++i) {
+                for (float z : { -8.0f, 8.0f }) {
+                    glm::vec3 plinth(bayX - 6.0f + i * 4.0f, -4.0f, z);
+                    wall(plinth - glm::vec3(0.6f, 1.0f, 0.6f), plinth + glm::vec3(0.6f, 1.0f, 0.6f));
+                    exhibits.push_back({ plinth + glm::vec3(0.0f, 1.6f, 0.0f), glm::vec3(0.4f, 0.6f, 0.4f) });
+                }
+                exhibits.push_back({ glm::vec3(bayX - 6.0f + i * 4.0f, 2.0f, -14.9f), glm::vec3(1.0f, 0.8f, 0.05f) });
+                exhibits.push_back({ glm::vec3(bayX - 6.0f + i * 4.0f, 2.0f, 14.9f), glm::vec3(1.0f, 0.8f, 0.05f) });
+            }
+        }
+        g.exhibits.resize(exhibits.size());
+        for (size_t i = 0; i < exhibits.size(); ++i) g.exhibits.set(i, exhibits[i].first, exhibits[i].second);
+        return g;
+    }
+
+    // Доля отброшенных экспонатов (из прошедших отсечение по пирамиде) на
+    // записанном пути или встроенном проходе через все три зала.
+    static void runOcclusion(BenchHarness& harness) {
+        Gallery g = gallery();
+        CameraPath path;
+        std::string input = "built-in walk";
+        const std::string& recorded = harness.getOptions().cameraPath;
+        if (!recorded.empty() && path.load(recorded)) {
+            input = recorded;
+        } else {
+            path = CameraPath::walk({ { -25.0f, -3.3f, 0.0f }, { 25.0f, -3.3f, 0.0f }, { 25.0f, -3.3f, 10.0f },
+                                      { -25.0f, -3.3f, 10.0f } }, 120, 60.0f);
+        }
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+
+        OcclusionCuller culler;
+        std::vector<uint8_t> visible(g.exhibits.size());
+        size_t tested = 0, occluded = 0, triangles = 0;
+        auto replay = [&](unsigned threads) {
+            tested = occluded = triangles = 0;
+            for (const CameraPath::Frame& frame : path.frames) {
+                glm::mat4 viewProjection = projection * glm::lookAt(frame.position, frame.position + frame.front,
+                                                                    glm::vec3(0.0f, 1.0f, 0.0f));
+                Frustum frustum = Frustum::fromMatrix(viewProjection);
+                culler.begin(viewProjection);
+                for (const glm::mat4& occluder : g.occluders) {
+                    glm::vec3 center = glm::vec3(occluder[3]);
+                    glm::vec3 extents(occluder[0][0], occluder[1][1], occluder[2][2]);
+                    if (frustum.intersectsBox(center, extents)) culler.addOccluder(*g.box, occluder);
+                }
+                triangles += culler.triangleCount();
+                culler.rasterize(threads);
+                frustum.cullBoxes(g.exhibits, visible.data());
+                for (size_t i = 0; i < g.exhibits.size(); ++i) {
+                    if (!visible[i]) continue;
+                    ++tested;
+                    occluded += culler.isVisible(g.exhibits.center(i), g.exhibits.extents(i)) ? 0 : 1;
+                }
+            }
+        };
+
+        std::vector<unsigned> threadCounts = { 1 };
+        if (Parallel::hardwareThreads() > 1) threadCounts.push_back(Parallel::hardwareThreads());
+        for (unsigned threads : threadCounts) {
+            replay(threads);
+            size_t frames = path.frames.size();
+            harness.run({ "occlusion.camera_path", input, 0, frames, "frames",
+                          { { "threads", threads },
+                            { "rejected_fraction", tested > 0 ? static_cast<double>(occluded) / tested : 0.0 },
+                            { "draws_tested", static_cast<double>(tested) / frames },
+                            { "occluder_triangles", static_cast<double>(triangles) / frames } } },
+                        [&] { replay(threads); });
+        }
+    }
+
+    // Анфилада залов 30×30 с проёмами 4×8 и 40 экспонатами в каждом, как
+    // Scene::CreateGallery. Камера ходит по первым трём залам; с ростом
+    // числа залов стоимость обхода ячеек не меняется, а проверка всех
+    // AABB пирамидой камеры растёт вместе с музеем.
+    static void runCells(BenchHarness& harness) {
+        const int hallCounts[] = { 8, 64 };
+        const int exhibitsPerHall = 40;
+        CameraPath path = CameraPath::walk({ { -10.0f, 2.0f, 0.0f }, { 70.0f, 2.0f, 0.0f }, { 70.0f, 2.0f, 10.0f },
+                                             { -10.0f, 2.0f, -10.0f } }, 120, 80.0f);
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+        for (int halls : hallCounts) {
+            CellGraph graph;
+            std::vector<std::vector<size_t>> cellObjects(halls);
+            BoxBatch boxes;
+            boxes.resize(static_cast<size_t>(halls) * exhibitsPerHall);
+            std::mt19937 rng(11);
+            std::uniform_real_distribution<float> offset(-13.0f, 13.0f);
+            for (int h = 0; h < halls; ++h) {
+                float x = h * 30.0f;
+                graph.addCell("hall", glm::vec3(x - 15.0f, -5.5f, -15.5f), glm::vec3(x + 15.0f, 15.5f, 15.5f));
+                if (h > 0) {
+                    float door = x - 15.0f;
+                    graph.addPortal(h - 1, h, { glm::vec3(door, -5.0f, -2.0f), glm::vec3(door, -5.0f, 2.0f),
+                                                glm::vec3(door, 3.0f, 2.0f), glm::vec3(door, 3.0f, -2.0f) });
+                }
+                for (int i = 0; i < exhibitsPerHall; ++i) {
+                    size_t index = static_cast<size_t>(h) * exhibitsPerHall + i;
+                    boxes.set(index, glm::vec3(x + offset(rng), -3.0f, offset(rng)), glm::vec3(0.8f, 2.0f, 0.8f));
+                    cellObjects[h].push_back(index);
+                }
+            }
+
+            std::vector<uint8_t> visible(boxes.size());
+            CellVisibility cells;
+            size_t tested = 0, drawn = 0, cellsVisible = 0;
+            auto portals = [&] {
+                tested = drawn = cellsVisible = 0;
+                for (const CameraPath::Frame& frame : path.frames) {
+                    glm::mat4 viewProjection = projection * glm::lookAt(frame.position, frame.position + frame.front,
+                                                                        glm::vec3(0.0f, 1.0f, 0.0f));
+                    graph.traverse(frame.position, viewProjection, cells);
+                    cellsVisible += cells.order.size();
+                    for (int c : cells.order) {
+                        Frustum through = Frustum::fromMatrix(CellGraph::rectMatrix(cells.rects[c]) * viewProjection);
+                        for (size_t i : cellObjects[c]) {
+                            ++tested;
+                            drawn += through.intersectsBox(boxes.center(i), boxes.extents(i)) ? 1 : 0;
+                        }
+                    }
+                }
+            };
+            auto flat = [&] {
+                tested = drawn = 0;
+                for (const CameraPath::Frame& frame : path.frames) {
+                    glm::mat4 viewProjection = projection * glm::lookAt(frame.position, frame.position + frame.front,
+                                                                        glm::vec3(0.0f, 1.0f, 0.0f));
+                    tested += boxes.size();
+                    drawn += boxes.size() - Frustum::fromMatrix(viewProjection).cullBoxes(boxes, visible.data());
+                }
+            };
+
+            std::string input = std::to_string(halls) + " halls";
+            size_t frames = path.frames.size();
+            portals();
+            harness.run({ "cells.enfilade", input, 0, frames, "frames",
+                          { { "cells_visible", static_cast<double>(cellsVisible) / frames },
+                            { "boxes_tested", static_cast<double>(tested) / frames },
+                            { "boxes_drawn", static_cast<double>(drawn) / frames } } },
+                        portals);
+            flat();
+            harness.run({ "cells.enfilade_flat", input, 0, frames, "frames",
+                          { { "boxes_tested", static_cast<double>(tested) / frames },
+                            { "boxes_drawn", static_cast<double>(drawn) / frames } } },
+                        flat);
+        }
+    }
+
+    // Точечные источники и прожекторы радиусом 4–16 по площадке 240×240,
+    // камера в центре смотрит вдоль неё; сетка кластеров строится заново
+    // на каждом кадре, как в Renderer. Радиус — Light::influenceRadius,
+    // так что задаётся интенсивностью.
+    static void runLightClusters(BenchHarness& harness) {
+        glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 2.0f, -1.0f),
+                                     glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+        const size_t counts[] = { 64, 512, 4096 };
+        for (size_t count : counts) {
+            std::mt19937 rng(11);
+            std::uniform_real_distribution<float> across(-120.0f, 120.0f);
+            std::uniform_real_distribution<float> height(0.0f, 12.0f);
+            std::uniform_real_distribution<float> radius(4.0f, 16.0f);
+            auto intensityFor = [](float r) {
+                return (1.0f + Light::ATTENUATION_LINEAR * r + Light::ATTENUATION_QUADRATIC * r * r) / 512.0f;
+            };
+            std::vector<Light> lights;
+            std::vector<size_t> active;
+            for (size_t i = 0; i < count; ++i) {
+                glm::vec3 position(across(rng), height(rng), across(rng));
+                float r = radius(rng);
+                if (i % 4 == 0) {
+                    lights.push_back(Light(position, glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(1.0f), intensityFor(r),
+                                           r, 12.0f, 18.0f));
+                } else {
+                    lights.push_back(Light(position, glm::vec3(1.0f), intensityFor(r), r));
+                }
+                active.push_back(i);
+            }
+            std::vector<int> shadowSlots(count, -1);
+
+            LightClusters clusters;
+            std::string input = std::to_string(count) + " lights";
+            auto build = [&](unsigned threads) {
+                clusters.build(lights, active, shadowSlots, view, projection, threads);
+            };
+            build(0);
+            std::vector<std::pair<std::string, double>> params = {
+                { "list_entries", static_cast<double>(clusters.indices.size()) },
+                { "max_per_cluster", static_cast<double>(clusters.maxPerCluster) } };
+            harness.run({ "lights.clusters", input, 0, count, "lights", params }, [&] { build(0); });
+            harness.run({ "lights.clusters_serial", input, 0, count, "lights", params }, [&] { build(1); });
+        }
+    }
+
+    static BoxBatch randomBoxes(size_t count, float range) {
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> position(-range, range);
+        std::uniform_real_distribution<float> size(0.1f, 4.0f);
+        BoxBatch boxes;
+        boxes.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            boxes.set(i, glm::vec3(position(rng), position(rng) * 0.1f, position(rng)),
+                      glm::vec3(size(rng), size(rng), size(rng)));
+        }
+        return boxes;
+    }
+
+    static Frustum cameraFrustum() {
+        glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 2.0f, -1.0f),
+                                     glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+        return Frustum::fromMatrix(projection * view);
+    }
+};
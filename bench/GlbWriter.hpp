@@ -0,0 +1,87 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <cstddef>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include "MeshData.hpp"
+#include "Bounds.hpp"
+#include "Vertex.hpp"
+#include "GltfLoader.hpp"
+
+// Пишет MeshData в .glb так, как его экспортирует DCC: один чередующийся
+// bufferView вершин (позиция, нормаль, UV) и один с uint32-индексами.
+// Нужен, чтобы сравнить загрузку glTF и OBJ на одной и той же сетке.
+class GlbWriter {
+public:
+    static bool write(const std::string& path, const MeshData& data) {
+        const size_t vertexBytes = data.vertices.size() * sizeof(Vertex);
+        const size_t indexBytes = data.indices.size() * sizeof(uint32_t);
+        Bounds bounds = Bounds::fromVertices(data.vertices);
+
+        nlohmann::json json;
+        json["asset"] = { { "version", "2.0" }, { "generator", "illumination_bench" } };
+        json["buffers"] = { { { "byteLength", vertexBytes + indexBytes } } };
+        json["bufferViews"] = {
+            { { "buffer", 0 }, { "byteOffset", 0 }, { "byteLength", vertexBytes },
+              { "byteStride", sizeof(Vertex) }, { "target", 34962 } },
+            { { "buffer", 0 }, { "byteOffset", vertexBytes }, { "byteLength", indexBytes },
+              { "target", 34963 } },
+        };
+        json["accessors"] = {
+            { { "bufferView", 0 }, { "byteOffset", offsetof(Vertex, position) },
+              { "componentType", GLTF_FLOAT }, { "count", data.vertices.size() }, { "type", "VEC3" },
+              { "min", { bounds.min.x, bounds.min.y, bounds.min.z } },
+              { "max", { bounds.max.x, bounds.max.y, bounds.max.z } } },
+            { { "bufferView", 0 }, { "byteOffset", offsetof(Vertex, normal) },
+              { "componentType", GLTF_FLOAT }, { "count", data.vertices.size() }, { "type", "VEC3" } },
+            { { "bufferView", 0 }, { "byteOffset", offsetof(Vertex, texCoords) },
+              { "componentType", GLTF_FLOAT }, { "count", data.vertices.size() }, { "type", "VEC2" } },
+            { { "bufferView", 1 }, { "componentType", GLTF_UNSIGNED_INT },
+              { "count", data.indices.size() }, { "type", "SCALAR" } },
+        };
+        json["materials"] = { { { "pbrMetallicRoughness",
+            { { "baseColorFactor", { 0.8, 0.8, 0.8, 1.0 } }, { "metallicFactor", 0.0 }, { "roughnessFactor", 0.6 } } } } };
+        json["meshes"] = { { { "primitives", { {
+            { "attributes", { { "POSITION", 0 }, { "NORMAL", 1 }, { "TEXCOORD_0", 2 } } },
+            { "indices", 3 }, { "material", 0 } } } } } };
+        json["nodes"] = { { { "mesh", 0 } } };
+        json["scenes"] = { { { "nodes", { 0 } } } };
+        json["scene"] = 0;
+
+        std::string text = json.dump();
+        text.resize((text.size() + 3) & ~size_t(3), ' ');
+        const size_t binBytes = (vertexBytes + indexBytes + 3) & ~size_t(3);
+        const size_t total = 12 + 8 + text.size() + 8 + binBytes;
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "Failed to create glTF file: " << path << std::endl;
+            return false;
+        }
+        writeU32(out, GltfLoader::GLB_MAGIC);
+        writeU32(out, 2);
+        writeU32(out, static_cast<uint32_t>(total));
+        writeU32(out, static_cast<uint32_t>(text.size()));
+        writeU32(out, GltfLoader::CHUNK_JSON);
+        out.write(text.data(), static_cast<std::streamsize>(text.size()));
+        writeU32(out, static_cast<uint32_t>(binBytes));
+        writeU32(out, GltfLoader::CHUNK_BIN);
+        out.write(reinterpret_cast<const char*>(data.vertices.data()), static_cast<std::streamsize>(vertexBytes));
+        out.write(reinterpret_cast<const char*>(data.indices.data()), static_cast<std::streamsize>(indexBytes));
+        for (size_t i = vertexBytes + indexBytes; i < binBytes; ++i) out.put('\0');
+        return out.good();
+    }
+
+private:
+    static void writeU32(std::ofstream& out, uint32_t value) {
+        unsigned char bytes[4] = {
+            static_cast<unsigned char>(value), static_cast<unsigned char>(value >> 8),
+            static_cast<unsigned char>(value >> 16), static_cast<unsigned char>(value >> 24)
+        };
+        out.write(reinterpret_cast<const char*>(bytes), 4);
+    }
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <algorithm>
+#include <iostream>
+#include "BenchHarness.hpp"
+#include "AsyncFileReader.hpp"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// Чтение всего набора ресурсов музея (res/: модели, текстуры, шейдеры) через
+// AsyncFileReader: оба бэкенда на разных глубинах очереди. Перед каждой
+// итерацией страницы файлов выселяются из кэша, так что замеряется диск.
+// POSIX_FADV_DONTNEED — только совет, поэтому после него mincore проверяет,
+// что в кэше ничего не осталось; иначе итерация не замеряется (см.
+// BenchHarness::runPrepared), а тёплые всё же замеренные попадают в
+// unprepared_iterations.
+class IoSuite {
+public:
+    static void run(BenchHarness& harness) {
+        const BenchOptions& options = harness.getOptions();
+
+        std::vector<std::string> paths;
+        uint64_t totalBytes = 0;
+        std::error_code ec;
+        for (auto it = std::filesystem::recursive_directory_iterator(options.assetDir, ec);
+             it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+            if (ec) break;
+            if (!it->is_regular_file(ec) || it->path().extension() == ".meshcache") continue;
+            paths.push_back(it->path().string());
+            totalBytes += it->file_size(ec);
+        }
+        if (paths.empty()) {
+            std::cerr << "No assets found under " << options.assetDir << std::endl;
+            return;
+        }
+        std::sort(paths.begin(), paths.end());
+        std::cerr << options.assetDir << " (" << paths.size() << " files, "
+                  << totalBytes / (1024.0 * 1024.0) << " MB)\n";
+
+        const ReadBackend backends[] = { ReadBackend::IoUring, ReadBackend::ThreadPool };
+        const unsigned depths[] = { 1, 2, 4, 8, 16, 32, 64 };
+        for (ReadBackend backend : backends) {
+            for (unsigned depth : depths) {
+                AsyncFileReader reader(depth, backend);
+                // Без io_uring оба прогона совпали бы.
+                if (reader.backend() != backend) break;
+
+                size_t read = 0;
+                harness.runPrepared({ "io.read_all", options.assetDir, totalBytes, paths.size(), "files",
+                                      { { "backend", backend == ReadBackend::IoUring ? 0 : 1 },
+                                        { "queue_depth", depth } } },
+                                    [&] { read = reader.readAll(paths, [](size_t, FileBuffer&&) {}); },
+                                    [&] { return evict(paths) == 0; });
+                if (read != paths.size()) {
+                    std::cerr << "  only " << read << " of " << paths.size() << " files were read\n";
+                }
+            }
+        }
+    }
+
+private:
+    // drop_caches требует root, поэтому файлы выселяются по одному.
+    // Возвращает, сколько байт осталось в кэше страниц.
+    static uint64_t evict(const std::vector<std::string>& paths) {
+        uint64_t resident = 0;
+#if !defined(_WIN32)
+        const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        std::vector<unsigned char> pages;
+        for (const auto& path : paths) {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) continue;
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            resident += residentBytes(fd, page, pages);
+            ::close(fd);
+        }
+#else
+        // Выселять нечем: все итерации тёплые.
+        for (const auto& path : paths) {
+            std::error_code ec;
+            resident += std::filesystem::file_size(path, ec);
+        }
+#endif
+        return resident;
+    }
+
+#if !defined(_WIN32)
+    // Страницы файла в кэше по mincore на отображении, которое само
+    // ничего не читает.
+    static uint64_t residentBytes(int fd, size_t page, std::vector<unsigned char>& pages) {
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size <= 0) return 0;
+        const size_t size = static_cast<size_t>(st.st_size);
+        void* map = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED) return 0;
+        pages.assign((size + page - 1) / page, 0);
+        uint64_t resident = 0;
+        if (::mincore(map, size, pages.data()) == 0) {
+            for (unsigned char p : pages) resident += (p & 1) ? page : 0;
+        }
+        ::munmap(map, size);
+        return std::min<uint64_t>(resident, size);
+    }
+#endif
+};
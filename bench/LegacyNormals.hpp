@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "Vertex.hpp"
+
+// Копия calculateNormals из ModelLoader до NormalGenerator: эталон для
+// тестов и базовая линия для бенчмарка normals.legacy. Не исправлять —
+// вырожденный треугольник здесь по-прежнему даёт NaN.
+inline void legacyCalculateNormals(std::vector<Vertex>& vertices,
+                                   const std::vector<uint32_t>& indices) {
+    for (auto& vertex : vertices) {
+        vertex.normal = glm::vec3(0.0f);
+    }
+
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        uint32_t idx0 = indices[i];
+        uint32_t idx1 = indices[i + 1];
+        uint32_t idx2 = indices[i + 2];
+
+        glm::vec3 v0 = vertices[idx0].position;
+        glm::vec3 v1 = vertices[idx1].position;
+        glm::vec3 v2 = vertices[idx2].position;
+
+        glm::vec3 edge1 = v1 - v0;
+        glm::vec3 edge2 = v2 - v0;
+        glm::vec3 normal = glm::normalize(glm::cross(edge1, edge2));
+
+        vertices[idx0].normal += normal;
+        vertices[idx1].normal += normal;
+        vertices[idx2].normal += normal;
+    }
+
+    for (auto& vertex : vertices) {
+        if (glm::length(vertex.normal) > 0.0f) {
+            vertex.normal = glm::normalize(vertex.normal);
+        } else {
+            vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+        }
+    }
+}
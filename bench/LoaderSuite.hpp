@@ -0,0 +1,311 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <algorithm>
+#include <random>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "BenchHarness.hpp"
+#include "SyntheticObj.hpp"
+#include "LegacyNormals.hpp"
+#include "GlbWriter.hpp"
+#include "MappedFile.hpp"
+#include "MeshData.hpp"
+#include "MeshCache.hpp"
+#include "Bounds.hpp"
+#include "ObjParser.hpp"
+#include "GltfLoader.hpp"
+#include "NormalGenerator.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+#include "MeshletBuilder.hpp"
+#include "MeshBvh.hpp"
+#include "VertexFormat.hpp"
+#include "Primitives.hpp"
+#include "Parallel.hpp"
+#include "Vertex.hpp"
+
+// CPU-пути загрузки: разбор OBJ, нормали, transformVertex, бинарный кэш,
+// glTF той же сетки и генераторы примитивов. Входы — res/models/*.obj и синтетические сетки.
+class LoaderSuite {
+public:
+    static void run(BenchHarness& harness) {
+        const BenchOptions& options = harness.getOptions();
+
+        runPrimitives(harness);
+
+        std::vector<std::string> models;
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(options.modelDir, ec)) {
+            if (entry.path().extension() == ".obj") {
+                models.push_back(entry.path().string());
+            }
+        }
+        std::sort(models.begin(), models.end());
+        for (const auto& path : models) {
+            runObj(harness, path, std::filesystem::path(path).filename().string());
+        }
+
+        // По возрастанию размера: пиковый RSS процесса только растёт.
+        std::vector<size_t> synthetic = options.syntheticFaces;
+        std::sort(synthetic.begin(), synthetic.end());
+        for (size_t faces : synthetic) {
+            std::string path = SyntheticObj::ensure(options.workDir, faces);
+            if (path.empty()) continue;
+            runObj(harness, path, "synthetic_" + faceLabel(faces));
+        }
+    }
+
+private:
+    static std::string faceLabel(size_t faces) {
+        if (faces % 1000000 == 0) return std::to_string(faces / 1000000) + "M";
+        if (faces % 1000 == 0) return std::to_string(faces / 1000) + "K";
+        return std::to_string(faces);
+    }
+
+    static void runObj(BenchHarness& harness, const std::string& path, const std::string& input) {
+        const BenchOptions& options = harness.getOptions();
+        MappedFile file(path);
+        if (!file.isOpen()) {
+            std::cerr << "Failed to open OBJ file: " << path << std::endl;
+            return;
+        }
+
+        std::cerr << input << " (" << file.size() / (1024.0 * 1024.0) << " MB)\n";
+        // Заодно прогревает страничный кэш: замеряется разбор, а не диск.
+        const size_t faces = ObjParser::countFaces(file.view());
+        const unsigned threads = Parallel::hardwareThreads();
+
+        MeshData data;
+        harness.run({ "obj.parse", input, file.size(), faces, "faces", { { "threads", 1 } } },
+                    [&] { data = ObjParser::parse(file.view()); },
+                    [&] { data = MeshData(); });
+        harness.run({ "obj.parse_parallel", input, file.size(), faces, "faces", { { "threads", threads } } },
+                    [&] { data = ObjParser::parseParallel(file.view(), threads); },
+                    [&] { data = MeshData(); });
+        if (data.vertices.empty()) {
+            data = ObjParser::parse(file.view());
+        }
+
+        const size_t triangles = data.indices.size() / 3;
+        const size_t vertexCount = data.vertices.size();
+        std::vector<Vertex> work;
+        auto resetVertices = [&] { work = data.vertices; };
+
+        // Базовая линия: calculateNormals до NormalGenerator.
+        harness.run({ "normals.legacy", input, 0, triangles, "triangles", { { "threads", 1 } } },
+                    [&] { legacyCalculateNormals(work, data.indices); },
+                    resetVertices);
+        harness.run({ "normals.uniform", input, 0, triangles, "triangles", { { "threads", 1 } } },
+                    [&] { NormalGenerator::generate(work, data.indices, NormalWeighting::Uniform, 1); },
+                    resetVertices);
+        harness.run({ "normals.uniform_parallel", input, 0, triangles, "triangles", { { "threads", threads } } },
+                    [&] { NormalGenerator::generate(work, data.indices, NormalWeighting::Uniform, threads); },
+                    resetVertices);
+        harness.run({ "normals.area", input, 0, triangles, "triangles", { { "threads", threads } } },
+                    [&] { NormalGenerator::generate(work, data.indices, NormalWeighting::Area, threads); },
+                    resetVertices);
+        harness.run({ "normals.angle", input, 0, triangles, "triangles", { { "threads", threads } } },
+                    [&] { NormalGenerator::generate(work, data.indices, NormalWeighting::Angle, threads); },
+                    resetVertices);
+
+        if (harness.wantsCase("mesh.optimize")) {
+            // Метрики кэша считаются один раз и пишутся в параметры случая.
+            MeshData optimized = data;
+            MeshOptimizeStats stats = MeshOptimizer::optimize(optimized);
+            optimized = MeshData();
+            harness.run({ "mesh.optimize", input, 0, triangles, "triangles",
+                          { { "acmr_before", stats.acmrBefore }, { "acmr_after", stats.acmrAfter },
+                            { "atvr_before", stats.atvrBefore }, { "atvr_after", stats.atvrAfter } } },
+                        [&] { MeshOptimizer::optimize(optimized); },
+                        [&] { optimized = data; });
+        }
+
+        if (harness.wantsCase("mesh.lods")) {
+            MeshData simplified = data;
+            harness.run({ "mesh.lods", input, 0, triangles, "triangles", { { "levels", 3 } } },
+                        [&] { MeshSimplifier::buildLods(simplified, 3); });
+        }
+
+        if (harness.wantsCase("mesh.meshlets")) {
+            MeshData clustered = data;
+            size_t meshlets = MeshletBuilder::build(clustered);
+            harness.run({ "mesh.meshlets", input, 0, triangles, "triangles",
+                          { { "meshlets", static_cast<double>(meshlets) },
+                            { "acmr_after", MeshOptimizer::acmr(clustered.indices, clustered.vertices.size()) } } },
+                        [&] { MeshletBuilder::build(clustered); },
+                        [&] { clustered = data; });
+        }
+
+        if (harness.wantsCase("mesh.bvh") || harness.wantsCase("mesh.bvh_rays")) {
+            std::shared_ptr<const MeshBvh> bvh = MeshBvh::build(data.vertices, data.indices);
+            harness.run({ "mesh.bvh", input, 0, triangles, "triangles",
+                          { { "nodes", static_cast<double>(bvh->nodeCount()) },
+                            { "memory_bytes", static_cast<double>(bvh->memoryBytes()) } } },
+                        [&] { bvh = MeshBvh::build(data.vertices, data.indices); });
+
+            // Лучи снаружи AABB сетки к случайным точкам внутри: часть
+            // попадает, часть проходит насквозь мимо треугольников.
+            const size_t rayCount = 10000;
+            std::mt19937 rng(11);
+            std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+            glm::vec3 lo = bvh->boundsMin(), hi = bvh->boundsMax();
+            glm::vec3 center = (lo + hi) * 0.5f;
+            float radius = glm::length(hi - lo);
+            std::vector<glm::vec3> origins(rayCount), directions(rayCount);
+            for (size_t i = 0; i < rayCount; ++i) {
+                glm::vec3 target = lo + (hi - lo) * glm::vec3(unit(rng), unit(rng), unit(rng));
+                glm::vec3 away = glm::vec3(unit(rng), unit(rng), unit(rng)) - glm::vec3(0.5f);
+                origins[i] = center + away * (radius * 4.0f);
+                directions[i] = target - origins[i];
+            }
+            size_t hits = 0;
+            auto castAll = [&] {
+                hits = 0;
+                for (size_t i = 0; i < rayCount; ++i) {
+                    MeshHit hit;
+                    hits += bvh->raycast(origins[i], directions[i], hit) ? 1 : 0;
+                }
+            };
+            castAll();
+            harness.run({ "mesh.bvh_rays", input, 0, rayCount, "rays",
+                          { { "hit_fraction", static_cast<double>(hits) / rayCount } } },
+                        castAll);
+        }
+
+        if (harness.wantsCase("mesh.vertex_format")) {
+            // Выбор раскладки и упаковка вершин для VBO; в параметрах — размер
+            // вершины и индекса в компактном формате.
+            VertexFormatPolicy policy;
+            VertexDecode decode;
+            VertexFormat format = VertexFormat::choose(data.vertices.data(), data.vertices.size(),
+                                                       data.indices.data(), data.indices.size(), policy, decode);
+            double indexBytes = data.vertices.size() < 65536 ? 2 : 4;
+            std::vector<unsigned char> packed;
+            harness.run({ "mesh.vertex_format", input, data.vertices.size() * sizeof(Vertex), data.vertices.size(),
+                          "vertices",
+                          { { "vertex_bytes", static_cast<double>(format.stride()) }, { "index_bytes", indexBytes } } },
+                        [&] {
+                            format = VertexFormat::choose(data.vertices.data(), data.vertices.size(),
+                                                          data.indices.data(), data.indices.size(), policy, decode);
+                            packed = format.pack(data.vertices.data(), data.vertices.size(), decode);
+                        });
+        }
+
+        if (harness.wantsCase("transform_vertex")) {
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, -5.0f, 2.0f)) *
+                              glm::rotate(glm::mat4(1.0f), glm::radians(30.0f), glm::vec3(0.0f, 1.0f, 0.0f)) *
+                              glm::scale(glm::mat4(1.0f), glm::vec3(0.08f));
+            work.assign(vertexCount, Vertex());
+            harness.run({ "transform_vertex", input, 0, vertexCount, "vertices", {} },
+                        [&] {
+                            for (size_t i = 0; i < vertexCount; ++i) {
+                                work[i] = transformVertex(data.vertices[i], model);
+                            }
+                        });
+        }
+        work = std::vector<Vertex>();
+
+        runGltf(harness, data, input);
+
+        if (harness.wantsCase("mesh_cache")) {
+            Bounds bounds = Bounds::fromVertices(data.vertices);
+            SourceStamp stamp = MeshCache::stamp(path, file, MeshCache::settingsKey(0, true, 3, true));
+            std::string cachePath = options.workDir + "/" + input + ".meshcache";
+            std::error_code ec;
+            std::filesystem::create_directories(options.workDir, ec);
+            uint64_t payload = vertexCount * sizeof(Vertex) + data.indices.size() * sizeof(uint32_t);
+
+            harness.run({ "mesh_cache.write", input, payload, triangles, "triangles", {} },
+                        [&] { MeshCache::write(cachePath, data, bounds, stamp); });
+
+            MeshData loaded;
+            harness.run({ "mesh_cache.load", input, payload, triangles, "triangles", {} },
+                        [&] {
+                            MappedFile cacheFile;
+                            CachedMeshView view;
+                            if (MeshCache::load(cachePath, stamp, cacheFile, view)) {
+                                loaded.vertices.assign(view.vertices, view.vertices + view.vertexCount);
+                                loaded.indices.assign(view.indices, view.indices + view.indexCount);
+                            }
+                        },
+                        [&] { loaded = MeshData(); });
+            std::filesystem::remove(cachePath, ec);
+        }
+    }
+
+    // Та же сетка в .glb: gltf.load — вся CPU-часть ModelLoader::loadGLB до
+    // glBufferData (отображение, JSON, проверка accessor'ов и индексов),
+    // её и стоит сравнивать с obj.parse. gltf.bvh — BVH по accessor'ам,
+    // которую loadGLB строит в отдельном потоке одновременно с загрузкой
+    // буферов; модель готова не раньше, чем через столько. gltf.to_mesh_data —
+    // запасной путь через Vertex для примитивов, которые нельзя отдать в GL
+    // напрямую.
+    static void runGltf(BenchHarness& harness, const MeshData& data, const std::string& input) {
+        if (!harness.wantsCase("gltf")) return;
+        const BenchOptions& options = harness.getOptions();
+        std::error_code ec;
+        std::filesystem::create_directories(options.workDir, ec);
+        std::string glbPath = options.workDir + "/" + input + ".glb";
+        if (!GlbWriter::write(glbPath, data)) return;
+
+        const uint64_t fileBytes = std::filesystem::file_size(glbPath, ec);
+        const size_t triangles = data.indices.size() / 3;
+        size_t direct = 0;
+        harness.run({ "gltf.load", input, fileBytes, triangles, "triangles", {} },
+                    [&] {
+                        GltfDocument doc;
+                        if (!GltfLoader::load(glbPath, doc)) return;
+                        for (const auto& mesh : doc.meshes) {
+                            for (const auto& prim : mesh.primitives) {
+                                direct += GltfLoader::canUseDirectly(doc, prim) ? 1 : 0;
+                            }
+                        }
+                    });
+        if (direct == 0) {
+            std::cerr << "  " << input << ".glb cannot be uploaded directly\n";
+        }
+
+        GltfDocument doc;
+        if (GltfLoader::load(glbPath, doc) && !doc.meshes.empty() && !doc.meshes[0].primitives.empty()) {
+            const GltfPrimitive& prim = doc.meshes[0].primitives[0];
+            if (GltfLoader::canUseDirectly(doc, prim)) {
+                std::shared_ptr<const MeshBvh> bvh;
+                harness.run({ "gltf.bvh", input, fileBytes, triangles, "triangles", {} },
+                            [&] { bvh = GltfLoader::buildBvh(doc, prim); },
+                            [&] { bvh.reset(); });
+            }
+            MeshData converted;
+            harness.run({ "gltf.to_mesh_data", input, fileBytes, triangles, "triangles", {} },
+                        [&] { GltfLoader::toMeshData(doc, prim, converted); },
+                        [&] { converted = MeshData(); });
+        }
+        doc = GltfDocument();
+        std::filesystem::remove(glbPath, ec);
+    }
+
+    static void runPrimitives(BenchHarness& harness) {
+        std::cerr << "primitives\n";
+        size_t sink = 0;
+        auto generate = [&](const char* name, size_t repeats, auto&& make) {
+            harness.run({ name, "primitives", 0, repeats, "meshes", {} }, [&] {
+                for (size_t i = 0; i < repeats; ++i) {
+                    MeshData data = make();
+                    sink += data.vertices.size();
+                }
+            });
+        };
+
+        generate("primitives.cube", 10000, [] { return Primitives::Cube(); });
+        generate("primitives.plane", 10000, [] { return Primitives::Plane(60.0f, 30.0f); });
+        generate("primitives.sphere_32x16", 1000, [] { return Primitives::Sphere(1.5f, 32, 16); });
+        generate("primitives.sphere_256x128", 20, [] { return Primitives::Sphere(1.5f, 256, 128); });
+        generate("primitives.picture_plane", 10000, [] { return Primitives::PicturePlane(4.0f, 3.0f, 0.3f, 0.4f); });
+
+        if (sink == 0) {
+            std::cerr << "primitives produced no vertices\n";
+        }
+    }
+};
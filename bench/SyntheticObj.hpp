@@ -0,0 +1,129 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <charconv>
+#include <cmath>
+#include <iostream>
+
+// Генератор синтетических OBJ: волнистая сетка (cols x rows квадов, по два
+// треугольника) с v/vt и без vn, чтобы загрузчик считал нормали сам.
+// Файл переиспользуется между запусками, если уже лежит в каталоге.
+class SyntheticObj {
+public:
+    static constexpr int COLUMNS = 1000;
+
+    static std::string pathFor(const std::string& dir, size_t faceCount) {
+        return dir + "/synthetic_" + std::to_string(faceCount) + ".obj";
+    }
+
+    static std::string ensure(const std::string& dir, size_t faceCount) {
+        std::string path = pathFor(dir, faceCount);
+        std::error_code ec;
+        if (std::filesystem::exists(path, ec) && std::filesystem::file_size(path, ec) > 0) {
+            return path;
+        }
+        std::filesystem::create_directories(dir, ec);
+
+        std::cerr << "Generating " << path << "...\n";
+        std::string tmpPath = path + ".tmp";
+        if (!write(tmpPath, faceCount)) {
+            std::filesystem::remove(tmpPath, ec);
+            return std::string();
+        }
+        std::filesystem::rename(tmpPath, path, ec);
+        return ec ? std::string() : path;
+    }
+
+    static bool write(const std::string& path, size_t faceCount) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "Failed to create synthetic OBJ: " << path << std::endl;
+            return false;
+        }
+
+        const size_t cols = COLUMNS;
+        const size_t rows = std::max<size_t>(1, (faceCount + cols * 2 - 1) / (cols * 2));
+        std::vector<char> buffer;
+        buffer.reserve(BUFFER_SIZE + 256);
+
+        auto flush = [&](bool force) {
+            if (force || buffer.size() >= BUFFER_SIZE) {
+                out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                buffer.clear();
+            }
+        };
+
+        for (size_t r = 0; r <= rows; ++r) {
+            for (size_t c = 0; c <= cols; ++c) {
+                float x = static_cast<float>(c) * 0.1f;
+                float z = static_cast<float>(r) * 0.1f;
+                float y = std::sin(x * 0.7f) * std::cos(z * 0.5f) * 0.5f;
+                append(buffer, "v ");
+                appendFloat(buffer, x); buffer.push_back(' ');
+                appendFloat(buffer, y); buffer.push_back(' ');
+                appendFloat(buffer, z); buffer.push_back('\n');
+                flush(false);
+            }
+        }
+        for (size_t r = 0; r <= rows; ++r) {
+            for (size_t c = 0; c <= cols; ++c) {
+                append(buffer, "vt ");
+                appendFloat(buffer, static_cast<float>(c) / cols); buffer.push_back(' ');
+                appendFloat(buffer, static_cast<float>(r) / rows); buffer.push_back('\n');
+                flush(false);
+            }
+        }
+
+        size_t written = 0;
+        for (size_t r = 0; r < rows && written < faceCount; ++r) {
+            for (size_t c = 0; c < cols && written < faceCount; ++c) {
+                size_t a = r * (cols + 1) + c + 1;
+                size_t b = a + 1;
+                size_t d = a + cols + 1;
+                size_t e = d + 1;
+                appendFace(buffer, a, d, b);
+                ++written;
+                if (written < faceCount) {
+                    appendFace(buffer, b, d, e);
+                    ++written;
+                }
+                flush(false);
+            }
+        }
+        flush(true);
+        return out.good();
+    }
+
+private:
+    static constexpr size_t BUFFER_SIZE = 1u << 20;
+
+    static void append(std::vector<char>& buffer, const char* text) {
+        while (*text) buffer.push_back(*text++);
+    }
+
+    static void appendFloat(std::vector<char>& buffer, float value) {
+        char tmp[32];
+        auto res = std::to_chars(tmp, tmp + sizeof(tmp), value, std::chars_format::fixed, 4);
+        buffer.insert(buffer.end(), tmp, res.ptr);
+    }
+
+    static void appendIndex(std::vector<char>& buffer, size_t value) {
+        char tmp[24];
+        auto res = std::to_chars(tmp, tmp + sizeof(tmp), value);
+        buffer.insert(buffer.end(), tmp, res.ptr);
+    }
+
+    static void appendFace(std::vector<char>& buffer, size_t a, size_t b, size_t c) {
+        buffer.push_back('f');
+        for (size_t index : { a, b, c }) {
+            buffer.push_back(' ');
+            appendIndex(buffer, index);
+            buffer.push_back('/');
+            appendIndex(buffer, index);
+        }
+        buffer.push_back('\n');
+    }
+};
@@ -0,0 +1,118 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include "BenchHarness.hpp"
+#include "LoaderSuite.hpp"
+#include "IoSuite.hpp"
+#include "CullingSuite.hpp"
+
+// Подсчёт выделений: все operator new проходят через эти перегрузки.
+std::atomic<uint64_t> AllocationCounter::count{ 0 };
+std::atomic<uint64_t> AllocationCounter::bytes{ 0 };
+
+static void* countedAlloc(std::size_t size) {
+    AllocationCounter::count.fetch_add(1, std::memory_order_relaxed);
+    AllocationCounter::bytes.fetch_add(size, std::memory_order_relaxed);
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size) { return countedAlloc(size); }
+void* operator new[](std::size_t size) { return countedAlloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+static std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t comma = text.find(',', start);
+        if (comma == std::string::npos) comma = text.size();
+        if (comma > start) items.push_back(text.substr(start, comma - start));
+        start = comma + 1;
+    }
+    return items;
+}
+
+static void printUsage() {
+    std::cerr <<
+        "usage: illumination_bench [options]\n"
+        "  --out <file|->          JSON results (default bench.json)\n"
+        "  --models <dir>          OBJ models to benchmark (default res/models)\n"
+        "  --assets <dir>          resource tree for the io suite (default res)\n"
+        "  --work-dir <dir>        synthetic inputs and scratch files (default bench_data)\n"
+        "  --synthetic <list>      synthetic OBJ sizes in millions of faces, e.g. 1,10,50; 'none' to skip\n"
+        "  --suite <list>          suites to run (loader, io, culling); default all\n"
+        "  --filter <substring>    only cases whose name contains the substring\n"
+        "  --camera-path <file>    camera path recorded with ILLUMINATION_RECORD_CAMERA for the occlusion cases\n"
+        "  --iterations <n>        timed iterations per case (default 5)\n"
+        "  --quick                 1M synthetic faces only, 3 iterations\n";
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << "\n";
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--out") {
+            options.outputPath = value();
+        } else if (arg == "--models") {
+            options.modelDir = value();
+        } else if (arg == "--assets") {
+            options.assetDir = value();
+        } else if (arg == "--work-dir") {
+            options.workDir = value();
+        } else if (arg == "--synthetic") {
+            options.syntheticFaces.clear();
+            for (const auto& item : splitList(value())) {
+                if (item == "none") continue;
+                options.syntheticFaces.push_back(static_cast<size_t>(std::stod(item) * 1000000.0));
+            }
+        } else if (arg == "--suite") {
+            options.suites = splitList(value());
+        } else if (arg == "--filter") {
+            options.filter = value();
+        } else if (arg == "--camera-path") {
+            options.cameraPath = value();
+        } else if (arg == "--iterations") {
+            options.iterations = static_cast<unsigned>(std::max(1, std::atoi(value().c_str())));
+        } else if (arg == "--quick") {
+            options.syntheticFaces = { 1000000 };
+            options.iterations = 3;
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return 0;
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            printUsage();
+            return 2;
+        }
+    }
+
+    BenchHarness harness(options);
+    if (harness.wantsSuite("loader")) {
+        LoaderSuite::run(harness);
+    }
+    if (harness.wantsSuite("io")) {
+        IoSuite::run(harness);
+    }
+    if (harness.wantsSuite("culling")) {
+        CullingSuite::run(harness);
+    }
+
+    return harness.writeJson() ? 0 : 1;
+}
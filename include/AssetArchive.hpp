@@ -0,0 +1,395 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include "Vertex.hpp"
+#include "Bounds.hpp"
+#include "MeshData.hpp"
+#include "MappedFile.hpp"
+#include "MeshCache.hpp"
+
+// Что лежит в записи архива.
+enum class AssetKind : uint32_t {
+    Raw = 0,       // файл как есть (шейдеры, .mtl, .glb)
+    Mesh = 1,      // разобранный OBJ: Vertex[vertexCount], uint32[indexCount], индексы и таблица LOD, кластеры
+    Texture = 2,   // декодированные пиксели width*height*channels
+};
+
+// Запись оглавления. Пути хранятся в таблице строк, записи отсортированы
+// по хешу пути для двоичного поиска.
+struct ArchiveEntry {
+    uint64_t pathHash;
+    uint32_t pathOffset;
+    uint32_t pathLength;
+    uint32_t kind;
+    uint32_t flags;
+    uint64_t offset;        // от начала архива, кратно ALIGNMENT
+    uint64_t size;
+    uint64_t vertexCount;
+    uint64_t indexCount;
+    float    boundsMin[3];
+    float    boundsMax[3];
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;
+    uint32_t lodCount;      // Mesh: уровней LOD после индексов (см. MeshCache)
+    uint32_t meshletCount;  // Mesh: кластеров после таблицы LOD
+    uint32_t settings;      // Mesh: MeshCache::settingsKey, с которыми сетка собрана
+    uint64_t sourceSize;    // размер и время изменения исходника при сборке
+    int64_t  sourceMtime;
+};
+
+// Текстура в архиве: пиксели смотрят прямо в отображённый файл.
+struct ArchiveTextureView {
+    const unsigned char* pixels = nullptr;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    bool flipped = false;
+};
+
+// Упакованный res/: один файл, отображается целиком при старте и отдаёт
+// сетки, текстуры и исходники без копирования. Если архив не смонтирован
+// или в нём нет нужного пути, загрузчики читают файлы с диска как раньше.
+class AssetArchive {
+public:
+    static constexpr uint32_t VERSION = 4;   // 2: кластеры сеток, 3: настройки сборки сеток,
+                                             // 4: отпечатки исходников
+    static constexpr size_t ALIGNMENT = 64;
+    static constexpr uint32_t FLAG_FLIPPED = 1;   // Texture: перевёрнута по вертикали, как для stbi
+
+    // Архив, из которого читают ModelLoader, Texture и Shader. Монтируется
+    // один раз до начала загрузки; дальше только чтение из любых потоков.
+    static AssetArchive& global() {
+        static AssetArchive archive;
+        return archive;
+    }
+
+    bool mount(const std::string& archivePath) {
+        unmount();
+        if (!file.open(archivePath)) {
+            return false;
+        }
+        if (file.size() < sizeof(Header)) {
+            std::cerr << "Asset archive is too small: " << archivePath << std::endl;
+            unmount();
+            return false;
+        }
+
+        Header header;
+        std::memcpy(&header, file.data(), sizeof(Header));
+        uint64_t tocBytes = header.entryCount * sizeof(ArchiveEntry);
+        if (std::memcmp(header.magic, MAGIC, 4) != 0 || header.version != VERSION ||
+            header.vertexStride != sizeof(Vertex) ||
+            header.tocOffset > file.size() || tocBytes > file.size() - header.tocOffset ||
+            header.stringsOffset > file.size() || header.stringsSize > file.size() - header.stringsOffset) {
+            std::cerr << "Unsupported or corrupt asset archive: " << archivePath << std::endl;
+            unmount();
+            return false;
+        }
+
+        entries = reinterpret_cast<const ArchiveEntry*>(file.data() + header.tocOffset);
+        entryCount = static_cast<size_t>(header.entryCount);
+        strings = file.data() + header.stringsOffset;
+        stringsSize = static_cast<size_t>(header.stringsSize);
+        for (size_t i = 0; i < entryCount; ++i) {
+            const ArchiveEntry& e = entries[i];
+            if (e.offset > file.size() || e.size > file.size() - e.offset ||
+                e.pathOffset > stringsSize || e.pathLength > stringsSize - e.pathOffset) {
+                std::cerr << "Corrupt asset archive entry in " << archivePath << std::endl;
+                unmount();
+                return false;
+            }
+        }
+
+        // Исходник, изменённый после сборки архива, читается с диска.
+        stale.assign(entryCount, 0);
+        size_t staleCount = 0;
+        for (size_t i = 0; i < entryCount; ++i) {
+            const ArchiveEntry& e = entries[i];
+            std::string source(strings + e.pathOffset, e.pathLength);
+            std::error_code ec;
+            uint64_t size = std::filesystem::file_size(source, ec);
+            if (ec) continue;
+            if (size != e.sourceSize || MeshCache::modifiedTime(source) > e.sourceMtime) {
+                stale[i] = 1;
+                ++staleCount;
+            }
+        }
+
+        std::cout << "Mounted asset archive " << archivePath << ": " << entryCount << " entries, "
+                  << file.size() / (1024.0 * 1024.0) << " MB\n";
+        if (staleCount > 0) {
+            std::cout << "  " << staleCount << " entries are older than their source files and will be "
+                      << "loaded from disk; re-run illumination_cook to update " << archivePath << "\n";
+        }
+        return true;
+    }
+
+    void unmount() {
+        file.close();
+        entries = nullptr;
+        entryCount = 0;
+        strings = nullptr;
+        stringsSize = 0;
+        stale.clear();
+    }
+
+    bool isMounted() const { return entries != nullptr; }
+    size_t size() const { return entryCount; }
+
+    const ArchiveEntry* find(const std::string& path) const {
+        if (!isMounted()) return nullptr;
+        std::string key = normalize(path);
+        uint64_t hash = MeshCache::hashBytes(key.data(), key.size());
+
+        const ArchiveEntry* end = entries + entryCount;
+        const ArchiveEntry* it = std::lower_bound(entries, end, hash,
+            [](const ArchiveEntry& e, uint64_t h) { return e.pathHash < h; });
+        for (; it != end && it->pathHash == hash; ++it) {
+            if (std::string_view(strings + it->pathOffset, it->pathLength) == key) {
+                return stale[it - entries] ? nullptr : it;
+            }
+        }
+        return nullptr;
+    }
+
+    // Содержимое файла как есть.
+    bool findRaw(const std::string& path, std::string_view& out) const {
+        const ArchiveEntry* e = find(path);
+        if (e == nullptr || e->kind != static_cast<uint32_t>(AssetKind::Raw)) return false;
+        out = std::string_view(file.data() + e->offset, static_cast<size_t>(e->size));
+        return true;
+    }
+
+    // Готовая сетка (тот же вид, что у бинарного кэша), если она собрана с
+    // теми же настройками settings (MeshCache::settingsKey). Иначе false, и
+    // загрузчик собирает сетку из исходника сам.
+    bool findMesh(const std::string& path, uint32_t settings, CachedMeshView& view) const {
+        const ArchiveEntry* e = find(path);
+        if (e == nullptr || e->kind != static_cast<uint32_t>(AssetKind::Mesh)) return false;
+        if (e->settings != settings) {
+            std::cerr << "Archived mesh " << path << " was cooked with other settings ("
+                      << std::hex << e->settings << ", requested " << settings << std::dec
+                      << "); loading the source instead\n";
+            return false;
+        }
+        uint64_t vertexBytes = e->vertexCount * sizeof(Vertex);
+        uint64_t indexBytes = e->indexCount * sizeof(uint32_t);
+        uint64_t lodBytes = uint64_t(e->lodCount) * sizeof(MeshLod);
+        uint64_t meshletBytes = uint64_t(e->meshletCount) * sizeof(Meshlet);
+        uint64_t tableBytes = lodBytes + meshletBytes;
+        if (e->size < vertexBytes + indexBytes + tableBytes ||
+            (e->size - vertexBytes - indexBytes - tableBytes) % sizeof(uint32_t) != 0) {
+            return false;
+        }
+        const char* payload = file.data() + e->offset;
+        view.vertices = reinterpret_cast<const Vertex*>(payload);
+        view.vertexCount = static_cast<size_t>(e->vertexCount);
+        view.indices = reinterpret_cast<const uint32_t*>(payload + vertexBytes);
+        view.indexCount = static_cast<size_t>(e->indexCount);
+        view.lodIndices = reinterpret_cast<const uint32_t*>(payload + vertexBytes + indexBytes);
+        view.lodIndexCount = static_cast<size_t>((e->size - vertexBytes - indexBytes - tableBytes) / sizeof(uint32_t));
+        view.lods = reinterpret_cast<const MeshLod*>(payload + e->size - tableBytes);
+        view.lodCount = e->lodCount;
+        view.meshlets = reinterpret_cast<const Meshlet*>(payload + e->size - meshletBytes);
+        view.meshletCount = e->meshletCount;
+        view.bounds.min = glm::vec3(e->boundsMin[0], e->boundsMin[1], e->boundsMin[2]);
+        view.bounds.max = glm::vec3(e->boundsMax[0], e->boundsMax[1], e->boundsMax[2]);
+        return true;
+    }
+
+    bool findTexture(const std::string& path, ArchiveTextureView& view) const {
+        const ArchiveEntry* e = find(path);
+        if (e == nullptr || e->kind != static_cast<uint32_t>(AssetKind::Texture) ||
+            e->size != uint64_t(e->width) * e->height * e->channels) {
+            return false;
+        }
+        view.pixels = reinterpret_cast<const unsigned char*>(file.data() + e->offset);
+        view.width = static_cast<int>(e->width);
+        view.height = static_cast<int>(e->height);
+        view.channels = static_cast<int>(e->channels);
+        view.flipped = (e->flags & FLAG_FLIPPED) != 0;
+        return true;
+    }
+
+    // Ключ записи: путь с прямыми слешами без "." и "..", как его передают
+    // загрузчики ("res/models/sofa.obj").
+    static std::string normalize(const std::string& path) {
+        return std::filesystem::path(path).lexically_normal().generic_string();
+    }
+
+private:
+    friend class AssetArchiveWriter;
+
+    static constexpr char MAGIC[4] = { 'R', 'P', 'A', 'K' };
+
+    struct Header {
+        char     magic[4];
+        uint32_t version;
+        uint32_t vertexStride;
+        uint32_t reserved;
+        uint64_t entryCount;
+        uint64_t tocOffset;
+        uint64_t stringsOffset;
+        uint64_t stringsSize;
+    };
+
+    MappedFile file;
+    const ArchiveEntry* entries = nullptr;
+    size_t entryCount = 0;
+    const char* strings = nullptr;
+    size_t stringsSize = 0;
+    std::vector<uint8_t> stale;   // по записи: исходник на диске новее
+};
+
+// Запись архива: данные пишутся в файл сразу по мере добавления, оглавление
+// и таблица строк — в finish(). Готовый архив появляется только после
+// переименования временного файла.
+class AssetArchiveWriter {
+public:
+    bool open(const std::string& archivePath) {
+        path = archivePath;
+        tmpPath = archivePath + ".tmp";
+        out.open(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "Failed to create asset archive: " << archivePath << std::endl;
+            return false;
+        }
+        AssetArchive::Header header{};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        position = sizeof(header);
+        return true;
+    }
+
+    // source: отпечаток исходника (MeshCache::stamp), по которому mount()
+    // узнаёт устаревшие записи; хеш и настройки здесь не нужны.
+    bool addRaw(const std::string& key, const void* data, size_t size, const SourceStamp& source) {
+        ArchiveEntry e = makeEntry(key, AssetKind::Raw, source);
+        return append(e, data, size);
+    }
+
+    bool addMesh(const std::string& key, const MeshData& data, const Bounds& bounds, const SourceStamp& source) {
+        ArchiveEntry e = makeEntry(key, AssetKind::Mesh, source);
+        e.settings = source.settings;
+        e.vertexCount = data.vertices.size();
+        e.indexCount = data.indices.size();
+        e.lodCount = static_cast<uint32_t>(data.lods.size());
+        e.meshletCount = static_cast<uint32_t>(data.meshlets.size());
+        e.boundsMin[0] = bounds.min.x; e.boundsMin[1] = bounds.min.y; e.boundsMin[2] = bounds.min.z;
+        e.boundsMax[0] = bounds.max.x; e.boundsMax[1] = bounds.max.y; e.boundsMax[2] = bounds.max.z;
+        if (!append(e, data.vertices.data(), data.vertices.size() * sizeof(Vertex))) return false;
+        // Индексы идут сразу за вершинами: sizeof(Vertex) кратен 4.
+        writeBytes(data.indices.data(), data.indices.size() * sizeof(uint32_t));
+        writeBytes(data.lodIndices.data(), data.lodIndices.size() * sizeof(uint32_t));
+        writeBytes(data.lods.data(), data.lods.size() * sizeof(MeshLod));
+        writeBytes(data.meshlets.data(), data.meshlets.size() * sizeof(Meshlet));
+        entries.back().size += (data.indices.size() + data.lodIndices.size()) * sizeof(uint32_t) +
+                               data.lods.size() * sizeof(MeshLod) + data.meshlets.size() * sizeof(Meshlet);
+        return out.good();
+    }
+
+    bool addTexture(const std::string& key, const unsigned char* pixels,
+                    int width, int height, int channels, bool flipped, const SourceStamp& source) {
+        ArchiveEntry e = makeEntry(key, AssetKind::Texture, source);
+        e.width = static_cast<uint32_t>(width);
+        e.height = static_cast<uint32_t>(height);
+        e.channels = static_cast<uint32_t>(channels);
+        e.flags = flipped ? AssetArchive::FLAG_FLIPPED : 0;
+        return append(e, pixels, size_t(width) * height * channels);
+    }
+
+    bool finish() {
+        std::sort(entries.begin(), entries.end(),
+                  [](const ArchiveEntry& a, const ArchiveEntry& b) { return a.pathHash < b.pathHash; });
+
+        AssetArchive::Header header{};
+        std::memcpy(header.magic, AssetArchive::MAGIC, 4);
+        header.version = AssetArchive::VERSION;
+        header.vertexStride = sizeof(Vertex);
+        header.entryCount = entries.size();
+
+        pad();
+        header.tocOffset = position;
+        writeBytes(entries.data(), entries.size() * sizeof(ArchiveEntry));
+        header.stringsOffset = position;
+        header.stringsSize = strings.size();
+        writeBytes(strings.data(), strings.size());
+
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.close();
+
+        std::error_code ec;
+        if (!out.good()) {
+            std::filesystem::remove(tmpPath, ec);
+            std::cerr << "Failed to write asset archive: " << path << std::endl;
+            return false;
+        }
+        std::filesystem::rename(tmpPath, path, ec);
+        if (ec) {
+            std::filesystem::remove(tmpPath, ec);
+            std::cerr << "Failed to write asset archive: " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Бросает недописанный архив.
+    void abort() {
+        out.close();
+        std::error_code ec;
+        std::filesystem::remove(tmpPath, ec);
+    }
+
+    size_t bytesWritten() const { return position; }
+
+private:
+    std::string path;
+    std::string tmpPath;
+    std::ofstream out;
+    uint64_t position = 0;
+    std::vector<ArchiveEntry> entries;
+    std::string strings;
+
+    ArchiveEntry makeEntry(const std::string& key, AssetKind kind, const SourceStamp& source) {
+        std::string normalized = AssetArchive::normalize(key);
+        ArchiveEntry e{};
+        e.pathHash = MeshCache::hashBytes(normalized.data(), normalized.size());
+        e.pathOffset = static_cast<uint32_t>(strings.size());
+        e.pathLength = static_cast<uint32_t>(normalized.size());
+        e.kind = static_cast<uint32_t>(kind);
+        e.sourceSize = source.size;
+        e.sourceMtime = source.mtime;
+        strings += normalized;
+        return e;
+    }
+
+    bool append(ArchiveEntry& e, const void* data, size_t size) {
+        pad();
+        e.offset = position;
+        e.size = size;
+        writeBytes(data, size);
+        entries.push_back(e);
+        return out.good();
+    }
+
+    void pad() {
+        static const char zeros[AssetArchive::ALIGNMENT] = {};
+        size_t padding = (AssetArchive::ALIGNMENT - position % AssetArchive::ALIGNMENT) % AssetArchive::ALIGNMENT;
+        writeBytes(zeros, padding);
+    }
+
+    void writeBytes(const void* data, size_t size) {
+        if (size == 0) return;
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        position += size;
+    }
+};
@@ -0,0 +1,260 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <iostream>
+#include "Mesh.hpp"
+#include "MeshData.hpp"
+#include "MeshBvh.hpp"
+#include "Bounds.hpp"
+#include "Texture.hpp"
+#include "ModelLoader.hpp"
+#include "Parallel.hpp"
+#include "AssetArchive.hpp"
+#include "AsyncFileReader.hpp"
+
+// Фоновая загрузка ресурсов. Файлы читаются пачкой через AsyncFileReader
+// (отдельный поток ввода-вывода), каждый дочитанный файл сразу уходит
+// рабочим потокам на разбор OBJ или декодирование изображения, готовые
+// CPU-данные встают в очередь, а поток с GL-контекстом забирает их в pump()
+// и делает glBufferData/glTexImage2D. До готовности вместо ресурса видна
+// заглушка. Ресурсы из смонтированного архива не читаются вовсе.
+class AssetPipeline {
+public:
+    // Сетка из архива или кэша приходит видом на отображённый файл и
+    // загружается в GL через ModelLoader::createMesh без копии.
+    using MeshReady = std::function<void(LoadedObj&& mesh, bool ok)>;
+    using TextureReady = std::function<void(TextureImage&& image, bool ok)>;
+
+    static constexpr unsigned IO_QUEUE_DEPTH = 32;
+
+    explicit AssetPipeline(unsigned workerCount = 0, unsigned ioQueueDepth = IO_QUEUE_DEPTH) {
+        if (workerCount == 0) {
+            workerCount = std::max(1u, Parallel::hardwareThreads() - 1);
+        }
+        startTime = std::chrono::steady_clock::now();
+        workers.reserve(workerCount);
+        for (unsigned i = 0; i < workerCount; ++i) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+        ioThread = std::thread([this, ioQueueDepth] { ioLoop(ioQueueDepth); });
+    }
+
+    // Незабранные результаты просто выбрасываются: их колбэки не вызываются.
+    // Уже начатая пачка чтений дочитывается.
+    ~AssetPipeline() {
+        {
+            std::lock_guard<std::mutex> lock(ioMutex);
+            ioStopping = true;
+        }
+        ioCondition.notify_all();
+        ioThread.join();
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            stopping = true;
+        }
+        jobCondition.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    AssetPipeline(const AssetPipeline&) = delete;
+    AssetPipeline& operator=(const AssetPipeline&) = delete;
+
+    // Разбор OBJ в рабочем потоке; onReady вызывается из pump() в GL-потоке.
+    void loadMesh(const std::string& path, MeshReady onReady,
+                  const ModelLoadOptions& options = ModelLoadOptions()) {
+        // file == nullptr: сетка лежит в архиве, читать нечего.
+        auto parse = [this, path, options, onReady = std::move(onReady)](const FileBuffer* file) {
+            auto result = std::make_shared<LoadedObj>();
+            bool ok = file == nullptr
+                ? ModelLoader::loadOBJData(path, *result, options)
+                : file->ok && ModelLoader::loadOBJData(path, file->view(), *result, options);
+            if (ok && result->isMapped()) {
+                const CachedMeshView& view = result->view;
+                result->view.bvh = MeshBvh::build(view.vertices, view.indices, view.indexCount);
+            } else if (ok) {
+                result->data.bvh = MeshBvh::build(result->data.vertices, result->data.indices);
+            }
+            complete([result, ok, onReady]() {
+                onReady(std::move(*result), ok);
+            });
+        };
+        submit(path, std::move(parse));
+    }
+
+    // Декодирование изображения в рабочем потоке; onReady вызывается из
+    // pump() в GL-потоке, где изображение и загружается в текстуру.
+    void loadTexture(const std::string& path, TextureReady onReady, bool flipVertically = true) {
+        auto decode = [this, path, flipVertically, onReady = std::move(onReady)](const FileBuffer* file) {
+            auto image = std::make_shared<TextureImage>();
+            bool ok = file == nullptr
+                ? Texture::decode(path.c_str(), *image, flipVertically)
+                : file->ok && Texture::decodeMemory(reinterpret_cast<const unsigned char*>(file->data.get()),
+                                                    file->size, *image, flipVertically);
+            complete([image, ok, onReady]() {
+                onReady(std::move(*image), ok);
+            });
+        };
+        submit(path, std::move(decode));
+    }
+
+    // Отдаёт накопленные чтения потоку ввода-вывода одной пачкой. pump()
+    // делает это сам; явный вызов после постановки всех ресурсов сцены
+    // начинает чтение, не дожидаясь первого кадра.
+    void flushReads() {
+        if (reads.empty()) return;
+        {
+            std::lock_guard<std::mutex> lock(ioMutex);
+            for (auto& r : reads) {
+                ioQueue.push_back(std::move(r));
+            }
+        }
+        reads.clear();
+        ioCondition.notify_one();
+    }
+
+    // Вызывается раз в кадр из GL-потока. Выполняет готовые загрузки, пока не
+    // истечёт budgetMs (хотя бы одну), чтобы крупный ресурс не подвесил кадр.
+    size_t pump(double budgetMs = 4.0) {
+        flushReads();
+        auto start = std::chrono::steady_clock::now();
+        size_t done = 0;
+
+        while (true) {
+            std::function<void()> upload;
+            {
+                std::lock_guard<std::mutex> lock(readyMutex);
+                if (ready.empty()) break;
+                upload = std::move(ready.front());
+                ready.pop_front();
+            }
+            upload();
+            ++done;
+            --pending;
+
+            double elapsed = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+            if (elapsed >= budgetMs) break;
+        }
+
+        if (done > 0 && pending == 0) {
+            double total = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - startTime).count();
+            std::cout << "All assets ready in " << total << " ms\n";
+        }
+        return done;
+    }
+
+    size_t pendingCount() const { return pending; }
+    bool isIdle() const { return pending == 0; }
+
+private:
+    using ReadDone = std::function<void(const FileBuffer* file)>;
+
+    struct ReadRequest {
+        std::string path;
+        ReadDone onRead;
+    };
+
+    std::vector<std::thread> workers;
+
+    std::mutex jobMutex;
+    std::condition_variable jobCondition;
+    std::deque<std::function<void()>> jobs;
+    bool stopping = false;
+
+    std::mutex readyMutex;
+    std::deque<std::function<void()>> ready;
+
+    // Чтения копятся в GL-потоке (reads) и пачкой уходят в ioQueue.
+    std::vector<ReadRequest> reads;
+    std::thread ioThread;
+    std::mutex ioMutex;
+    std::condition_variable ioCondition;
+    std::deque<ReadRequest> ioQueue;
+    bool ioStopping = false;
+
+    // Меняется только в GL-потоке: при постановке задачи и в pump().
+    size_t pending = 0;
+    std::chrono::steady_clock::time_point startTime;
+
+    // Ресурс из архива сразу идёт рабочим потокам, остальные сначала читаются.
+    void submit(const std::string& path, ReadDone process) {
+        ++pending;
+        if (AssetArchive::global().find(path) != nullptr) {
+            enqueue([process = std::move(process)]() { process(nullptr); });
+        } else {
+            reads.push_back({ path, std::move(process) });
+        }
+    }
+
+    void enqueue(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            jobs.push_back(std::move(job));
+        }
+        jobCondition.notify_one();
+    }
+
+    void complete(std::function<void()> upload) {
+        std::lock_guard<std::mutex> lock(readyMutex);
+        ready.push_back(std::move(upload));
+    }
+
+    void workerLoop() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(jobMutex);
+                jobCondition.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (stopping) return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+    // Забирает всё, что накопилось, и читает одной пачкой; каждый файл
+    // отдаётся рабочим потокам, как только дочитан.
+    void ioLoop(unsigned queueDepth) {
+        AsyncFileReader reader(queueDepth);
+        while (true) {
+            std::vector<ReadRequest> batch;
+            {
+                std::unique_lock<std::mutex> lock(ioMutex);
+                ioCondition.wait(lock, [this] { return ioStopping || !ioQueue.empty(); });
+                if (ioStopping) return;
+                batch.assign(std::make_move_iterator(ioQueue.begin()), std::make_move_iterator(ioQueue.end()));
+                ioQueue.clear();
+            }
+
+            std::vector<std::string> paths;
+            paths.reserve(batch.size());
+            for (const auto& r : batch) {
+                paths.push_back(r.path);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            size_t bytes = 0;
+            reader.readAll(paths, [&](size_t index, FileBuffer&& file) {
+                bytes += file.size;
+                auto shared = std::make_shared<FileBuffer>(std::move(file));
+                enqueue([shared, onRead = std::move(batch[index].onRead)]() { onRead(shared.get()); });
+            });
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "Read " << paths.size() << " files (" << bytes / (1024.0 * 1024.0) << " MB) with "
+                      << AsyncFileReader::backendName(reader.backend()) << " in " << ms << " ms\n";
+        }
+    }
+};
@@ -0,0 +1,485 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <algorithm>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#define ILLUMINATION_HAS_IO_URING 1
+#endif
+
+// Прочитанный целиком файл.
+struct FileBuffer {
+    std::string path;
+    std::unique_ptr<char[]> data;
+    size_t size = 0;
+    bool ok = false;
+
+    std::string_view view() const { return std::string_view(data.get(), size); }
+};
+
+enum class ReadBackend {
+    Auto,        // io_uring, если ядро его даёт, иначе пул потоков
+    IoUring,
+    ThreadPool,
+};
+
+// Асинхронное чтение пачки файлов. Все файлы разбиваются на куски по
+// chunkSize, и в полёте одновременно до queueDepth чтений: в io_uring это
+// глубина очереди, в запасном варианте — число потоков с pread.
+// onComplete вызывается в потоке, вызвавшем readAll, для каждого файла,
+// как только он дочитан, в порядке готовности, а не в порядке путей.
+class AsyncFileReader {
+public:
+    using Completion = std::function<void(size_t index, FileBuffer&& file)>;
+
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 512u << 10;
+
+    explicit AsyncFileReader(unsigned queueDepth = 32, ReadBackend preferred = ReadBackend::Auto,
+                             size_t chunkSize = DEFAULT_CHUNK_SIZE)
+        : depth(std::max(1u, queueDepth)), chunk(std::max<size_t>(4096, chunkSize)) {
+        active = ReadBackend::ThreadPool;
+#ifdef ILLUMINATION_HAS_IO_URING
+        if (preferred != ReadBackend::ThreadPool && ring.init(depth)) {
+            active = ReadBackend::IoUring;
+        }
+#endif
+        if (preferred == ReadBackend::IoUring && active != ReadBackend::IoUring) {
+            std::cerr << "io_uring is not available, reading with a thread pool\n";
+        }
+    }
+
+    AsyncFileReader(const AsyncFileReader&) = delete;
+    AsyncFileReader& operator=(const AsyncFileReader&) = delete;
+
+    ReadBackend backend() const { return active; }
+    unsigned queueDepth() const { return depth; }
+
+    static const char* backendName(ReadBackend backend) {
+        switch (backend) {
+            case ReadBackend::IoUring:    return "io_uring";
+            case ReadBackend::ThreadPool: return "threads";
+            default:                      return "auto";
+        }
+    }
+
+    // Возвращает, сколько файлов прочитано успешно.
+    size_t readAll(const std::vector<std::string>& paths, const Completion& onComplete) {
+        Batch batch;
+        batch.files.resize(paths.size());
+        for (size_t i = 0; i < paths.size(); ++i) {
+            openFile(batch, i, paths[i]);
+        }
+
+        size_t succeeded = 0;
+        auto finish = [&](size_t index) {
+            OpenFile& f = batch.files[index];
+            closeHandle(f);
+            if (f.buffer.ok) ++succeeded;
+            else std::cerr << "Failed to read file: " << f.buffer.path << std::endl;
+            onComplete(index, std::move(f.buffer));
+        };
+
+        // Пустые и неоткрывшиеся файлы готовы сразу.
+        for (size_t i = 0; i < batch.files.size(); ++i) {
+            if (batch.files[i].remaining == 0) finish(i);
+        }
+
+#ifdef ILLUMINATION_HAS_IO_URING
+        if (active == ReadBackend::IoUring) {
+            readWithRing(batch, finish);
+            return succeeded;
+        }
+#endif
+        readWithThreads(batch, finish);
+        return succeeded;
+    }
+
+    // Удобная обёртка: все файлы в порядке путей.
+    std::vector<FileBuffer> readFiles(const std::vector<std::string>& paths) {
+        std::vector<FileBuffer> result(paths.size());
+        readAll(paths, [&](size_t index, FileBuffer&& file) { result[index] = std::move(file); });
+        return result;
+    }
+
+private:
+#ifdef _WIN32
+    using Handle = HANDLE;
+    static Handle invalidHandle() { return INVALID_HANDLE_VALUE; }
+#else
+    using Handle = int;
+    static Handle invalidHandle() { return -1; }
+#endif
+
+    struct OpenFile {
+        FileBuffer buffer;
+        Handle handle = invalidHandle();
+        size_t remaining = 0;
+    };
+
+    struct Chunk {
+        size_t file;
+        size_t offset;
+        size_t length;
+    };
+
+    struct Batch {
+        std::vector<OpenFile> files;
+        std::vector<Chunk> chunks;
+    };
+
+    unsigned depth;
+    size_t chunk;
+    ReadBackend active;
+
+    // Открытие и размер — синхронно в вызывающем потоке, сами данные
+    // читаются асинхронно.
+    void openFile(Batch& batch, size_t index, const std::string& path) {
+        OpenFile& f = batch.files[index];
+        f.buffer.path = path;
+        size_t size = 0;
+#ifdef _WIN32
+        f.handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                               OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        LARGE_INTEGER fileSize;
+        if (f.handle == INVALID_HANDLE_VALUE || !GetFileSizeEx(f.handle, &fileSize)) {
+            closeHandle(f);
+            return;
+        }
+        size = static_cast<size_t>(fileSize.QuadPart);
+#else
+        f.handle = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (f.handle < 0 || fstat(f.handle, &st) != 0) {
+            closeHandle(f);
+            return;
+        }
+        size = static_cast<size_t>(st.st_size);
+#endif
+        f.buffer.data.reset(new char[size > 0 ? size : 1]);
+        f.buffer.size = size;
+        f.buffer.ok = true;
+        f.remaining = size;
+        for (size_t offset = 0; offset < size; offset += chunk) {
+            batch.chunks.push_back({ index, offset, std::min(chunk, size - offset) });
+        }
+    }
+
+    static void closeHandle(OpenFile& f) {
+        if (f.handle == invalidHandle()) return;
+#ifdef _WIN32
+        CloseHandle(f.handle);
+#else
+        ::close(f.handle);
+#endif
+        f.handle = invalidHandle();
+    }
+
+    // Блокирующее чтение всего куска; false — ошибка или файл укоротился.
+    static bool readChunk(const OpenFile& f, char* dst, size_t offset, size_t length) {
+        while (length > 0) {
+#ifdef _WIN32
+            OVERLAPPED overlapped{};
+            overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFFu);
+            overlapped.OffsetHigh = static_cast<DWORD>(static_cast<uint64_t>(offset) >> 32);
+            DWORD got = 0;
+            DWORD want = static_cast<DWORD>(std::min<size_t>(length, 1u << 30));
+            if (!ReadFile(f.handle, dst, want, &got, &overlapped) || got == 0) return false;
+#else
+            ssize_t got = pread(f.handle, dst, length, static_cast<off_t>(offset));
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) return false;
+#endif
+            dst += got;
+            offset += static_cast<size_t>(got);
+            length -= static_cast<size_t>(got);
+        }
+        return true;
+    }
+
+    // Запасной путь: depth потоков разбирают общий список кусков; дочитанные
+    // файлы передаются в вызывающий поток через очередь.
+    template <typename Finish>
+    void readWithThreads(Batch& batch, Finish& finish) {
+        if (batch.chunks.empty()) return;
+
+        std::vector<std::atomic<size_t>> remaining(batch.files.size());
+        std::vector<std::atomic<bool>> failed(batch.files.size());
+        size_t pendingFiles = 0;
+        for (size_t i = 0; i < batch.files.size(); ++i) {
+            remaining[i] = batch.files[i].remaining;
+            failed[i] = false;
+            if (batch.files[i].remaining > 0) ++pendingFiles;
+        }
+
+        std::atomic<size_t> next{ 0 };
+        std::mutex doneMutex;
+        std::condition_variable doneCondition;
+        std::deque<size_t> done;
+
+        auto worker = [&]() {
+            while (true) {
+                size_t c = next.fetch_add(1, std::memory_order_relaxed);
+                if (c >= batch.chunks.size()) return;
+                const Chunk& ch = batch.chunks[c];
+                OpenFile& f = batch.files[ch.file];
+                if (!failed[ch.file].load(std::memory_order_relaxed) &&
+                    !readChunk(f, f.buffer.data.get() + ch.offset, ch.offset, ch.length)) {
+                    failed[ch.file] = true;
+                }
+                if (remaining[ch.file].fetch_sub(ch.length, std::memory_order_acq_rel) == ch.length) {
+                    std::lock_guard<std::mutex> lock(doneMutex);
+                    done.push_back(ch.file);
+                    doneCondition.notify_one();
+                }
+            }
+        };
+
+        unsigned threadCount = static_cast<unsigned>(std::min<size_t>(depth, batch.chunks.size()));
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount);
+        for (unsigned t = 0; t < threadCount; ++t) {
+            threads.emplace_back(worker);
+        }
+
+        while (pendingFiles > 0) {
+            size_t index;
+            {
+                std::unique_lock<std::mutex> lock(doneMutex);
+                doneCondition.wait(lock, [&] { return !done.empty(); });
+                index = done.front();
+                done.pop_front();
+            }
+            if (failed[index]) batch.files[index].buffer.ok = false;
+            finish(index);
+            --pendingFiles;
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+
+#ifdef ILLUMINATION_HAS_IO_URING
+    // Минимальная обёртка над io_uring без liburing: кольца SQ/CQ и массив
+    // SQE отображаются из дескриптора, синхронизация — acquire/release на
+    // головах и хвостах колец.
+    class Ring {
+    public:
+        Ring() = default;
+        Ring(const Ring&) = delete;
+        Ring& operator=(const Ring&) = delete;
+
+        ~Ring() {
+            if (sqes != nullptr) munmap(sqes, sqesSize);
+            if (cqRing != nullptr && cqRing != sqRing) munmap(cqRing, cqRingSize);
+            if (sqRing != nullptr) munmap(sqRing, sqRingSize);
+            if (fd >= 0) ::close(fd);
+        }
+
+        bool init(unsigned entries) {
+            io_uring_params params{};
+            fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+            if (fd < 0) return false;
+
+            sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if (single) {
+                sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+            }
+
+            sqRing = mapRegion(sqRingSize, IORING_OFF_SQ_RING);
+            if (sqRing == nullptr) return false;
+            cqRing = single ? sqRing : mapRegion(cqRingSize, IORING_OFF_CQ_RING);
+            if (cqRing == nullptr) return false;
+            sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+            sqes = static_cast<io_uring_sqe*>(mapRegion(sqesSize, IORING_OFF_SQES));
+            if (sqes == nullptr) return false;
+
+            char* sq = static_cast<char*>(sqRing);
+            char* cq = static_cast<char*>(cqRing);
+            sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+            cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+            capacity = params.sq_entries;
+            return true;
+        }
+
+        unsigned size() const { return capacity; }
+
+        void queueRead(int file, void* dst, size_t length, size_t offset, uint64_t userData) {
+            unsigned tail = *sqTail;
+            unsigned index = tail & sqMask;
+            io_uring_sqe& sqe = sqes[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = IORING_OP_READ;
+            sqe.fd = file;
+            sqe.addr = reinterpret_cast<uint64_t>(dst);
+            sqe.len = static_cast<uint32_t>(length);
+            sqe.off = offset;
+            sqe.user_data = userData;
+            sqArray[index] = index;
+            std::atomic_ref<unsigned>(*sqTail).store(tail + 1, std::memory_order_release);
+            ++queued;
+        }
+
+        // Отправляет накопленные SQE и ждёт хотя бы minComplete завершений.
+        bool submit(unsigned minComplete) {
+            while (true) {
+                int ret = static_cast<int>(syscall(__NR_io_uring_enter, fd, queued, minComplete,
+                                                   minComplete > 0 ? IORING_ENTER_GETEVENTS : 0u,
+                                                   nullptr, 0));
+                if (ret >= 0) {
+                    queued -= std::min<unsigned>(queued, static_cast<unsigned>(ret));
+                    if (queued == 0) return true;
+                    continue;
+                }
+                // Переполнена очередь завершений: разберём её и повторим.
+                if (errno == EAGAIN || errno == EBUSY) return true;
+                if (errno != EINTR) return false;
+            }
+        }
+
+        template <typename Fn>
+        unsigned reap(Fn&& fn) {
+            unsigned head = *cqHead;
+            unsigned tail = std::atomic_ref<unsigned>(*cqTail).load(std::memory_order_acquire);
+            unsigned count = 0;
+            for (; head != tail; ++head, ++count) {
+                const io_uring_cqe& cqe = cqes[head & cqMask];
+                fn(cqe.user_data, cqe.res);
+            }
+            std::atomic_ref<unsigned>(*cqHead).store(head, std::memory_order_release);
+            return count;
+        }
+
+    private:
+        int fd = -1;
+        void* sqRing = nullptr;
+        void* cqRing = nullptr;
+        io_uring_sqe* sqes = nullptr;
+        size_t sqRingSize = 0;
+        size_t cqRingSize = 0;
+        size_t sqesSize = 0;
+        unsigned* sqTail = nullptr;
+        unsigned* sqArray = nullptr;
+        unsigned sqMask = 0;
+        unsigned* cqHead = nullptr;
+        unsigned* cqTail = nullptr;
+        unsigned cqMask = 0;
+        io_uring_cqe* cqes = nullptr;
+        unsigned capacity = 0;
+        unsigned queued = 0;
+
+        void* mapRegion(size_t size, off_t offset) {
+            void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+            return p == MAP_FAILED ? nullptr : p;
+        }
+    };
+
+    Ring ring;
+
+    // До depth чтений в полёте; короткое чтение дочитывается новым SQE.
+    // Завершения обрабатываются в этом же потоке.
+    template <typename Finish>
+    void readWithRing(Batch& batch, Finish& finish) {
+        std::vector<Chunk> chunks = std::move(batch.chunks);
+        const unsigned limit = std::min(depth, ring.size());
+        size_t next = 0;
+        unsigned inFlight = 0;
+
+        auto queue = [&](size_t c) {
+            const Chunk& ch = chunks[c];
+            OpenFile& f = batch.files[ch.file];
+            ring.queueRead(f.handle, f.buffer.data.get() + ch.offset, ch.length, ch.offset, c);
+            ++inFlight;
+        };
+
+        while (next < chunks.size() || inFlight > 0) {
+            while (next < chunks.size() && inFlight < limit) {
+                if (batch.files[chunks[next].file].buffer.ok) {
+                    queue(next);
+                } else {
+                    // Файл уже не прочитался: оставшиеся куски не нужны.
+                    OpenFile& f = batch.files[chunks[next].file];
+                    f.remaining -= chunks[next].length;
+                    if (f.remaining == 0) finish(chunks[next].file);
+                }
+                ++next;
+            }
+            if (inFlight == 0) continue;
+            if (!ring.submit(1)) {
+                // Кольцо сломалось: дочитываем то, что осталось, синхронно.
+                std::cerr << "io_uring_enter failed, finishing the batch synchronously\n";
+                for (size_t c = 0; c < chunks.size(); ++c) {
+                    OpenFile& f = batch.files[chunks[c].file];
+                    if (f.remaining == 0) continue;
+                    if (f.buffer.ok && !readChunk(f, f.buffer.data.get() + chunks[c].offset,
+                                                  chunks[c].offset, chunks[c].length)) {
+                        f.buffer.ok = false;
+                    }
+                }
+                for (size_t i = 0; i < batch.files.size(); ++i) {
+                    if (batch.files[i].remaining > 0) {
+                        batch.files[i].remaining = 0;
+                        finish(i);
+                    }
+                }
+                return;
+            }
+            ring.reap([&](uint64_t userData, int32_t res) {
+                --inFlight;
+                Chunk& ch = chunks[static_cast<size_t>(userData)];
+                OpenFile& f = batch.files[ch.file];
+                size_t done = ch.length;
+                if (res < 0 && res != -EINTR && res != -EAGAIN) {
+                    f.buffer.ok = false;
+                } else if (res <= 0 || static_cast<size_t>(res) < ch.length) {
+                    if (res == 0) {
+                        f.buffer.ok = false;      // файл укоротился
+                    } else {
+                        size_t got = res > 0 ? static_cast<size_t>(res) : 0;
+                        ch.offset += got;
+                        ch.length -= got;
+                        f.remaining -= got;
+                        queue(static_cast<size_t>(userData));
+                        return;
+                    }
+                }
+                f.remaining -= done;
+                if (f.remaining == 0) finish(ch.file);
+            });
+        }
+    }
+#endif
+};
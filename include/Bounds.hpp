@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include <cfloat>
+#include <glm/glm.hpp>
+#include "Vertex.hpp"
+
+// Ограничивающий объём сетки в локальных координатах: AABB и описанная сфера.
+struct Bounds {
+    glm::vec3 min = glm::vec3(FLT_MAX);
+    glm::vec3 max = glm::vec3(-FLT_MAX);
+
+    bool isValid() const {
+        return min.x <= max.x && min.y <= max.y && min.z <= max.z;
+    }
+
+    void expand(const glm::vec3& p) {
+        min = glm::min(min, p);
+        max = glm::max(max, p);
+    }
+
+    glm::vec3 center() const {
+        return isValid() ? (min + max) * 0.5f : glm::vec3(0.0f);
+    }
+
+    glm::vec3 extents() const {
+        return isValid() ? (max - min) * 0.5f : glm::vec3(0.0f);
+    }
+
+    float radius() const {
+        return glm::length(extents());
+    }
+
+    static Bounds fromVertices(const Vertex* vertices, size_t count) {
+        Bounds b;
+        for (size_t i = 0; i < count; ++i) {
+            b.expand(vertices[i].position);
+        }
+        return b;
+    }
+
+    static Bounds fromVertices(const std::vector<Vertex>& vertices) {
+        return fromVertices(vertices.data(), vertices.size());
+    }
+};
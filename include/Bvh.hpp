@@ -0,0 +1,262 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cfloat>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "Parallel.hpp"
+
+// Узел BVH: AABB и либо участок примитивов [first, first + count) в order
+// (лист, count > 0), либо номер левого потомка first (правый — first + 1).
+// Потомки всегда лежат после родителя, так что refit идёт с конца массива.
+struct BvhNode {
+    glm::vec3 min = glm::vec3(FLT_MAX);
+    uint32_t  first = 0;
+    glm::vec3 max = glm::vec3(-FLT_MAX);
+    uint32_t  count = 0;
+
+    bool isLeaf() const { return count > 0; }
+};
+
+// Дерево над набором AABB примитивов (треугольников сетки или объектов
+// сцены), построенное по SAH с разбиением на корзины.
+class Bvh {
+public:
+    static constexpr int    BINS = 12;
+    static constexpr size_t MAX_LEAF = 4;
+    // Крупные деревья после нескольких верхних уровней достраиваются по
+    // поддеревьям в отдельных потоках.
+    static constexpr size_t PARALLEL_THRESHOLD = 1u << 16;
+    static constexpr int    PARALLEL_DEPTH = 3;
+
+    std::vector<BvhNode>  nodes;
+    std::vector<uint32_t> order;   // номера примитивов в порядке листьев
+
+    bool empty() const { return nodes.empty(); }
+
+    // Примитивы с пустым AABB (min > max) в дерево не попадают.
+    void build(const std::vector<glm::vec3>& boxMin, const std::vector<glm::vec3>& boxMax) {
+        nodes.clear();
+        order.clear();
+        std::vector<glm::vec3> centers(boxMin.size());
+        for (uint32_t i = 0; i < boxMin.size(); ++i) {
+            if (boxMin[i].x > boxMax[i].x) continue;
+            centers[i] = (boxMin[i] + boxMax[i]) * 0.5f;
+            order.push_back(i);
+        }
+        if (order.empty()) return;
+
+        Builder builder{ boxMin, boxMax, centers, order };
+        nodes.emplace_back();
+        if (order.size() < PARALLEL_THRESHOLD) {
+            builder.split(nodes, 0, 0, static_cast<uint32_t>(order.size()), INT32_MAX, nullptr);
+            return;
+        }
+
+        // Верхние уровни — здесь, оставшиеся поддеревья — параллельно, каждое
+        // в свой массив, потом дописываются в конец с поправкой номеров.
+        std::vector<Pending> pending;
+        builder.split(nodes, 0, 0, static_cast<uint32_t>(order.size()), PARALLEL_DEPTH, &pending);
+        std::vector<std::vector<BvhNode>> subtrees(pending.size());
+        Parallel::forEachIndex(pending.size(), [&](size_t i) {
+            subtrees[i].emplace_back();
+            builder.split(subtrees[i], 0, pending[i].begin, pending[i].end, INT32_MAX, nullptr);
+        });
+        for (size_t i = 0; i < pending.size(); ++i) {
+            const std::vector<BvhNode>& sub = subtrees[i];
+            uint32_t base = static_cast<uint32_t>(nodes.size());
+            auto relocate = [&](BvhNode node) {
+                if (!node.isLeaf()) node.first = base + node.first - 1;
+                return node;
+            };
+            nodes[pending[i].node] = relocate(sub[0]);
+            for (size_t n = 1; n < sub.size(); ++n) {
+                nodes.push_back(relocate(sub[n]));
+            }
+        }
+    }
+
+    // Пересчитывает AABB узлов по новым AABB примитивов; форма дерева прежняя.
+    void refit(const std::vector<glm::vec3>& boxMin, const std::vector<glm::vec3>& boxMax) {
+        for (size_t n = nodes.size(); n-- > 0;) {
+            BvhNode& node = nodes[n];
+            if (node.isLeaf()) {
+                node.min = glm::vec3(FLT_MAX);
+                node.max = glm::vec3(-FLT_MAX);
+                for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                    node.min = glm::min(node.min, boxMin[order[i]]);
+                    node.max = glm::max(node.max, boxMax[order[i]]);
+                }
+            } else {
+                node.min = glm::min(nodes[node.first].min, nodes[node.first + 1].min);
+                node.max = glm::max(nodes[node.first].max, nodes[node.first + 1].max);
+            }
+        }
+    }
+
+    // Вход луча в AABB (slab test): t входа или FLT_MAX, если луч проходит
+    // мимо или входит дальше maxT. invDir — 1 / направление.
+    static float rayBox(const glm::vec3& origin, const glm::vec3& invDir, float maxT,
+                        const glm::vec3& min, const glm::vec3& max) {
+        float t0 = 0.0f, t1 = maxT;
+        for (int a = 0; a < 3; ++a) {
+            float near = (min[a] - origin[a]) * invDir[a];
+            float far = (max[a] - origin[a]) * invDir[a];
+            if (near > far) std::swap(near, far);
+            t0 = near > t0 ? near : t0;
+            t1 = far < t1 ? far : t1;
+        }
+        return t0 <= t1 ? t0 : FLT_MAX;
+    }
+
+    static float boxDistanceSquared(const glm::vec3& p, const glm::vec3& min, const glm::vec3& max) {
+        glm::vec3 d = glm::max(glm::max(min - p, p - max), glm::vec3(0.0f));
+        return glm::dot(d, d);
+    }
+
+    static glm::vec3 inverseDirection(const glm::vec3& direction) {
+        glm::vec3 inv;
+        for (int a = 0; a < 3; ++a) {
+            inv[a] = direction[a] != 0.0f ? 1.0f / direction[a] : (direction[a] < 0.0f ? -FLT_MAX : FLT_MAX);
+        }
+        return inv;
+    }
+
+private:
+    struct Pending {
+        uint32_t node;
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    struct Builder {
+        const std::vector<glm::vec3>& boxMin;
+        const std::vector<glm::vec3>& boxMax;
+        const std::vector<glm::vec3>& centers;
+        std::vector<uint32_t>& order;
+
+        // Узел nodeIndex над order[begin, end); на глубине depth == 0
+        // (если pending задан) узел откладывается для отдельного потока.
+        void split(std::vector<BvhNode>& nodes, uint32_t nodeIndex, uint32_t begin, uint32_t end,
+                   int depth, std::vector<Pending>* pending) const {
+            struct Task { uint32_t node, begin, end; int depth; };
+            std::vector<Task> stack{ { nodeIndex, begin, end, depth } };
+            while (!stack.empty()) {
+                Task task = stack.back();
+                stack.pop_back();
+
+                BvhNode node;
+                glm::vec3 centerMin(FLT_MAX), centerMax(-FLT_MAX);
+                for (uint32_t i = task.begin; i < task.end; ++i) {
+                    uint32_t p = order[i];
+                    node.min = glm::min(node.min, boxMin[p]);
+                    node.max = glm::max(node.max, boxMax[p]);
+                    centerMin = glm::min(centerMin, centers[p]);
+                    centerMax = glm::max(centerMax, centers[p]);
+                }
+                uint32_t count = task.end - task.begin;
+                node.first = task.begin;
+                node.count = count;
+
+                if (pending != nullptr && task.depth == 0) {
+                    nodes[task.node] = node;
+                    pending->push_back({ task.node, task.begin, task.end });
+                    continue;
+                }
+
+                int axis = -1;
+                float position = 0.0f;
+                if (count > MAX_LEAF) {
+                    float leafCost = static_cast<float>(count) * area(node.min, node.max);
+                    float bestCost = leafCost;
+                    for (int a = 0; a < 3; ++a) {
+                        float cost;
+                        float split = bestSplit(task.begin, task.end, a, centerMin[a], centerMax[a], cost);
+                        if (cost < bestCost) {
+                            bestCost = cost;
+                            axis = a;
+                            position = split;
+                        }
+                    }
+                }
+
+                uint32_t middle = task.begin;
+                if (axis >= 0) {
+                    middle = static_cast<uint32_t>(std::partition(order.begin() + task.begin, order.begin() + task.end,
+                                                                  [&](uint32_t p) { return centers[p][axis] < position; }) -
+                                                   order.begin());
+                }
+                if (axis < 0 || middle == task.begin || middle == task.end) {
+                    // Лист; слишком крупный (все центры совпали) делится пополам.
+                    if (count <= MAX_LEAF * 4 || centerMin == centerMax) {
+                        nodes[task.node] = node;
+                        continue;
+                    }
+                    middle = task.begin + count / 2;
+                }
+
+                uint32_t left = static_cast<uint32_t>(nodes.size());
+                nodes.emplace_back();
+                nodes.emplace_back();
+                node.first = left;
+                node.count = 0;
+                nodes[task.node] = node;
+                stack.push_back({ left + 1, middle, task.end, task.depth - 1 });
+                stack.push_back({ left, task.begin, middle, task.depth - 1 });
+            }
+        }
+
+        // Лучшая плоскость по оси axis среди границ корзин; cost — её SAH.
+        float bestSplit(uint32_t begin, uint32_t end, int axis, float lo, float hi, float& cost) const {
+            cost = FLT_MAX;
+            if (hi <= lo) return lo;
+            struct Bin { glm::vec3 min = glm::vec3(FLT_MAX); glm::vec3 max = glm::vec3(-FLT_MAX); uint32_t count = 0; };
+            std::array<Bin, BINS> bins;
+            float scale = BINS / (hi - lo);
+            for (uint32_t i = begin; i < end; ++i) {
+                uint32_t p = order[i];
+                int b = std::min(BINS - 1, static_cast<int>((centers[p][axis] - lo) * scale));
+                bins[b].min = glm::min(bins[b].min, boxMin[p]);
+                bins[b].max = glm::max(bins[b].max, boxMax[p]);
+                ++bins[b].count;
+            }
+
+            std::array<float, BINS - 1> leftArea, rightArea;
+            std::array<uint32_t, BINS - 1> leftCount, rightCount;
+            glm::vec3 lmin(FLT_MAX), lmax(-FLT_MAX), rmin(FLT_MAX), rmax(-FLT_MAX);
+            uint32_t lc = 0, rc = 0;
+            for (int i = 0; i < BINS - 1; ++i) {
+                lc += bins[i].count;
+                lmin = glm::min(lmin, bins[i].min);
+                lmax = glm::max(lmax, bins[i].max);
+                leftCount[i] = lc;
+                leftArea[i] = lc > 0 ? area(lmin, lmax) : 0.0f;
+
+                int j = BINS - 1 - i;
+                rc += bins[j].count;
+                rmin = glm::min(rmin, bins[j].min);
+                rmax = glm::max(rmax, bins[j].max);
+                rightCount[j - 1] = rc;
+                rightArea[j - 1] = rc > 0 ? area(rmin, rmax) : 0.0f;
+            }
+
+            float best = lo;
+            for (int i = 0; i < BINS - 1; ++i) {
+                if (leftCount[i] == 0 || rightCount[i] == 0) continue;
+                float c = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+                if (c < cost) {
+                    cost = c;
+                    best = lo + (i + 1) / scale;
+                }
+            }
+            return best;
+        }
+
+        static float area(const glm::vec3& min, const glm::vec3& max) {
+            glm::vec3 e = max - min;
+            return e.x * e.y + e.y * e.z + e.z * e.x;
+        }
+    };
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <cmath>
+#include <glm/glm.hpp>
+
+// Записанный путь камеры: положение и направление взгляда в каждом кадре.
+// Текстом, кадр на строку: "x y z fx fy fz". Пишется приложением
+// (ILLUMINATION_RECORD_CAMERA) и проигрывается без окна в бенчмарке.
+struct CameraPath {
+    struct Frame {
+        glm::vec3 position = glm::vec3(0.0f);
+        glm::vec3 front = glm::vec3(0.0f, 0.0f, -1.0f);
+    };
+
+    std::vector<Frame> frames;
+
+    void record(const glm::vec3& position, const glm::vec3& front) {
+        frames.push_back({ position, front });
+    }
+
+    bool save(const std::string& path) const {
+        std::ofstream file(path, std::ios::trunc);
+        if (!file) {
+            std::cerr << "Failed to write camera path: " << path << std::endl;
+            return false;
+        }
+        for (const Frame& f : frames) {
+            file << f.position.x << ' ' << f.position.y << ' ' << f.position.z << ' '
+                 << f.front.x << ' ' << f.front.y << ' ' << f.front.z << '\n';
+        }
+        return true;
+    }
+
+    bool load(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) {
+            std::cerr << "Failed to read camera path: " << path << std::endl;
+            return false;
+        }
+        frames.clear();
+        Frame f;
+        while (file >> f.position.x >> f.position.y >> f.position.z >> f.front.x >> f.front.y >> f.front.z) {
+            frames.push_back(f);
+        }
+        return !frames.empty();
+    }
+
+    // Проход по точкам waypoints, по framesPerLeg кадров на отрезок; взгляд
+    // по ходу движения, покачиваясь по сторонам на ±sweepDegrees. Путь по
+    // умолчанию, когда записанного нет.
+    static CameraPath walk(const std::vector<glm::vec3>& waypoints, size_t framesPerLeg, float sweepDegrees) {
+        CameraPath path;
+        size_t frame = 0;
+        for (size_t leg = 0; leg + 1 < waypoints.size(); ++leg) {
+            glm::vec3 from = waypoints[leg], to = waypoints[leg + 1];
+            glm::vec3 heading = glm::normalize(to - from);
+            for (size_t i = 0; i < framesPerLeg; ++i, ++frame) {
+                float t = static_cast<float>(i) / static_cast<float>(framesPerLeg);
+                float sweep = glm::radians(sweepDegrees) * std::sin(static_cast<float>(frame) * 0.05f);
+                glm::vec3 front(heading.x * std::cos(sweep) - heading.z * std::sin(sweep), heading.y,
+                                heading.x * std::sin(sweep) + heading.z * std::cos(sweep));
+                path.record(from + (to - from) * t, glm::normalize(front));
+            }
+        }
+        return path;
+    }
+};
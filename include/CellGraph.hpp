@@ -0,0 +1,205 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cfloat>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+// Залы музея (ячейки) и проёмы между ними (порталы). Видимость считается
+// от ячейки камеры: соседняя ячейка видна, если виден портал к ней, и
+// видна только через прямоугольник экрана, который этот портал занимает
+// (Luebke, Georges. Portals and Mirrors, 1995).
+struct Cell {
+    std::string name;
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+    std::vector<size_t> portals;
+};
+
+// Выпуклый многоугольник проёма в мировых координатах.
+struct Portal {
+    int cells[2] = { -1, -1 };
+    std::vector<glm::vec3> polygon;
+    glm::vec3 min = glm::vec3(FLT_MAX);
+    glm::vec3 max = glm::vec3(-FLT_MAX);
+};
+
+// Итог обхода: видимые ячейки и прямоугольник экрана (NDC: x0, y0, x1, y1),
+// через который видна каждая.
+struct CellVisibility {
+    std::vector<uint8_t> visible;
+    std::vector<glm::vec4> rects;
+    std::vector<int> order;          // видимые ячейки в порядке обнаружения
+    size_t portalsTested = 0;
+};
+
+class CellGraph {
+public:
+    // Камера ближе этого к проёму видит через него всё, что видит сама:
+    // иначе портал может целиком уйти за ближнюю плоскость.
+    static constexpr float PORTAL_MARGIN = 0.5f;
+
+    std::vector<Cell> cells;
+    std::vector<Portal> portals;
+
+    bool empty() const { return cells.empty(); }
+
+    int addCell(const std::string& name, const glm::vec3& min, const glm::vec3& max) {
+        Cell cell;
+        cell.name = name;
+        cell.min = min;
+        cell.max = max;
+        cells.push_back(std::move(cell));
+        return static_cast<int>(cells.size()) - 1;
+    }
+
+    void addPortal(int a, int b, const std::vector<glm::vec3>& polygon) {
+        Portal portal;
+        portal.cells[0] = a;
+        portal.cells[1] = b;
+        portal.polygon = polygon;
+        for (const glm::vec3& p : polygon) {
+            portal.min = glm::min(portal.min, p);
+            portal.max = glm::max(portal.max, p);
+        }
+        cells[a].portals.push_back(portals.size());
+        cells[b].portals.push_back(portals.size());
+        portals.push_back(std::move(portal));
+    }
+
+    bool inside(int cell, const glm::vec3& point) const {
+        const Cell& c = cells[cell];
+        return point.x >= c.min.x && point.y >= c.min.y && point.z >= c.min.z &&
+               point.x <= c.max.x && point.y <= c.max.y && point.z <= c.max.z;
+    }
+
+    // Ячейка, содержащая точку, или -1. Ячейки не пересекаются (кроме
+    // общих границ, там — любая из них).
+    int findCell(const glm::vec3& point) const {
+        for (size_t i = 0; i < cells.size(); ++i) {
+            if (inside(static_cast<int>(i), point)) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    // Обход от ячейки камеры. Камера вне всех ячеек видит все целиком.
+    void traverse(const glm::vec3& eye, const glm::mat4& viewProjection, CellVisibility& out) const {
+        out.visible.assign(cells.size(), 0);
+        out.rects.assign(cells.size(), glm::vec4(1.0f, 1.0f, -1.0f, -1.0f));
+        out.order.clear();
+        out.portalsTested = 0;
+        const glm::vec4 screen(-1.0f, -1.0f, 1.0f, 1.0f);
+        int start = locate(eye);
+        if (start < 0) {
+            for (size_t i = 0; i < cells.size(); ++i) {
+                out.visible[i] = 1;
+                out.rects[i] = screen;
+                out.order.push_back(static_cast<int>(i));
+            }
+            return;
+        }
+        onPath.assign(cells.size(), 0);
+        visit(start, screen, eye, viewProjection, out);
+    }
+
+    // Матрица, растягивающая прямоугольник rect на весь NDC: пирамида
+    // Frustum::fromMatrix(rectMatrix(rect) * viewProjection) смотрит только в него.
+    static glm::mat4 rectMatrix(const glm::vec4& rect) {
+        glm::mat4 m(1.0f);
+        m[0][0] = 2.0f / (rect.z - rect.x);
+        m[3][0] = -(rect.x + rect.z) / (rect.z - rect.x);
+        m[1][1] = 2.0f / (rect.w - rect.y);
+        m[3][1] = -(rect.y + rect.w) / (rect.w - rect.y);
+        return m;
+    }
+
+private:
+    mutable std::vector<uint8_t> onPath;
+    mutable int lastCell = -1;
+
+    // Камера обычно остаётся в прошлой ячейке или переходит в соседнюю:
+    // их проверяем первыми, весь список — только если камера вышла из них.
+    int locate(const glm::vec3& eye) const {
+        if (lastCell >= 0 && static_cast<size_t>(lastCell) < cells.size()) {
+            if (inside(lastCell, eye)) return lastCell;
+            for (size_t p : cells[lastCell].portals) {
+                const Portal& portal = portals[p];
+                int next = portal.cells[0] == lastCell ? portal.cells[1] : portal.cells[0];
+                if (inside(next, eye)) return lastCell = next;
+            }
+        }
+        return lastCell = findCell(eye);
+    }
+
+    static bool contains(const glm::vec4& outer, const glm::vec4& inner) {
+        return inner.x >= outer.x && inner.y >= outer.y && inner.z <= outer.z && inner.w <= outer.w;
+    }
+
+    // Ячейка видна через rect. Повторный заход в уже видимую ячейку нужен,
+    // только если новый прямоугольник выходит за прежний; по кругу (через
+    // ячейки текущего пути) обход не идёт.
+    void visit(int cell, const glm::vec4& rect, const glm::vec3& eye, const glm::mat4& viewProjection,
+               CellVisibility& out) const {
+        if (out.visible[cell] && contains(out.rects[cell], rect)) return;
+        if (!out.visible[cell]) {
+            out.visible[cell] = 1;
+            out.rects[cell] = rect;
+            out.order.push_back(cell);
+        } else {
+            glm::vec4& r = out.rects[cell];
+            r = glm::vec4(std::min(r.x, rect.x), std::min(r.y, rect.y), std::max(r.z, rect.z), std::max(r.w, rect.w));
+        }
+
+        onPath[cell] = 1;
+        for (size_t p : cells[cell].portals) {
+            const Portal& portal = portals[p];
+            int next = portal.cells[0] == cell ? portal.cells[1] : portal.cells[0];
+            if (onPath[next]) continue;
+            ++out.portalsTested;
+            glm::vec4 through;
+            if (!portalRect(portal, eye, viewProjection, through)) continue;
+            through = glm::vec4(std::max(through.x, rect.x), std::max(through.y, rect.y),
+                                std::min(through.z, rect.z), std::min(through.w, rect.w));
+            if (through.x >= through.z || through.y >= through.w) continue;
+            visit(next, through, eye, viewProjection, out);
+        }
+        onPath[cell] = 0;
+    }
+
+    // Прямоугольник экрана, который занимает портал; false — портал целиком
+    // за ближней плоскостью. Многоугольник обрезается ближней плоскостью
+    // (z + w >= 0) до проекции.
+    static bool portalRect(const Portal& portal, const glm::vec3& eye, const glm::mat4& viewProjection,
+                           glm::vec4& rect) {
+        glm::vec3 d = glm::max(glm::max(portal.min - eye, eye - portal.max), glm::vec3(0.0f));
+        if (glm::dot(d, d) <= PORTAL_MARGIN * PORTAL_MARGIN) {
+            rect = glm::vec4(-1.0f, -1.0f, 1.0f, 1.0f);
+            return true;
+        }
+        rect = glm::vec4(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+        bool any = false;
+        size_t n = portal.polygon.size();
+        for (size_t i = 0; i < n; ++i) {
+            glm::vec4 p = viewProjection * glm::vec4(portal.polygon[i], 1.0f);
+            glm::vec4 q = viewProjection * glm::vec4(portal.polygon[(i + 1) % n], 1.0f);
+            float dp = p.z + p.w, dq = q.z + q.w;
+            if (dp >= 0.0f) {
+                include(rect, p);
+                any = true;
+            }
+            if ((dp >= 0.0f) != (dq >= 0.0f)) {
+                include(rect, p + (q - p) * (dp / (dp - dq)));
+                any = true;
+            }
+        }
+        return any;
+    }
+
+    static void include(glm::vec4& rect, const glm::vec4& clip) {
+        float w = std::max(clip.w, 1e-6f);
+        float x = clip.x / w, y = clip.y / w;
+        rect = glm::vec4(std::min(rect.x, x), std::min(rect.y, y), std::max(rect.z, x), std::max(rect.w, y));
+    }
+};
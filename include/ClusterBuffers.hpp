@@ -0,0 +1,64 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <vector>
+#include <algorithm>
+#include "LightClusters.hpp"
+
+// Буферные текстуры (GL 3.1, без SSBO) со списками LightClusters: данные
+// источников (RGBA32F), сетка кластеров (RG32UI) и номера источников
+// (R32UI). Каждый кадр буферы переразмечаются (orphaning) и заливаются
+// заново — GPU может ещё читать прошлый кадр.
+class ClusterBuffers {
+private:
+    enum { LIGHTS, GRID, INDICES, COUNT };
+    GLuint buffers[COUNT] = {};
+    GLuint textures[COUNT] = {};
+
+    template <typename T>
+    void upload(int which, const std::vector<T>& data, GLenum format) {
+        // Пустой буфер текстуре не годится: хоть один элемент.
+        static const T empty{};
+        const T* source = data.empty() ? &empty : data.data();
+        GLsizeiptr bytes = static_cast<GLsizeiptr>(std::max<size_t>(data.size(), 1) * sizeof(T));
+        glBindBuffer(GL_TEXTURE_BUFFER, buffers[which]);
+        glBufferData(GL_TEXTURE_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, source);
+        glBindTexture(GL_TEXTURE_BUFFER, textures[which]);
+        glTexBuffer(GL_TEXTURE_BUFFER, format, buffers[which]);
+    }
+
+public:
+    ClusterBuffers() = default;
+    ClusterBuffers(const ClusterBuffers&) = delete;
+    ClusterBuffers& operator=(const ClusterBuffers&) = delete;
+    ~ClusterBuffers() { cleanup(); }
+
+    void upload(const LightClusters& clusters) {
+        if (buffers[0] == 0) {
+            glGenBuffers(COUNT, buffers);
+            glGenTextures(COUNT, textures);
+        }
+        upload(LIGHTS, clusters.lightTexels, GL_RGBA32F);
+        upload(GRID, clusters.grid, GL_RG32UI);
+        upload(INDICES, clusters.indices, GL_R32UI);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    // Три текстуры на блоки firstUnit, firstUnit + 1, firstUnit + 2.
+    void bind(GLuint firstUnit) const {
+        for (int i = 0; i < COUNT; ++i) {
+            glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+            glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+        }
+    }
+
+    void cleanup() {
+        if (buffers[0] != 0) {
+            glDeleteTextures(COUNT, textures);
+            glDeleteBuffers(COUNT, buffers);
+            for (int i = 0; i < COUNT; ++i) buffers[i] = textures[i] = 0;
+        }
+    }
+};
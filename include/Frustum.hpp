@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <glm/glm.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRUSTUM_SSE 1
+#endif
+
+// Мировые AABB набора объектов структурой массивов (центр и полуразмеры):
+// так Frustum::cullBoxes проверяет их по четыре за раз.
+struct BoxBatch {
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+
+    size_t size() const { return centerX.size(); }
+
+    void resize(size_t count) {
+        for (std::vector<float>* v : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ }) {
+            v->resize(count, 0.0f);
+        }
+    }
+
+    void set(size_t i, const glm::vec3& center, const glm::vec3& extents) {
+        centerX[i] = center.x;
+        centerY[i] = center.y;
+        centerZ[i] = center.z;
+        extentX[i] = extents.x;
+        extentY[i] = extents.y;
+        extentZ[i] = extents.z;
+    }
+
+    glm::vec3 center(size_t i) const { return glm::vec3(centerX[i], centerY[i], centerZ[i]); }
+    glm::vec3 extents(size_t i) const { return glm::vec3(extentX[i], extentY[i], extentZ[i]); }
+
+    // AABB i задевает сферу: расстояние от центра сферы до коробки не больше радиуса.
+    bool touchesSphere(size_t i, const glm::vec3& sphereCenter, float radius) const {
+        glm::vec3 d = glm::max(glm::abs(sphereCenter - center(i)) - extents(i), glm::vec3(0.0f));
+        return glm::dot(d, d) <= radius * radius;
+    }
+
+    void clear() { resize(0); }
+};
+
+// Шесть плоскостей пирамиды видимости в мировых координатах (нормали внутрь),
+// извлечённые из матрицы projection * view (Gribb–Hartmann).
+struct Frustum {
+    std::array<glm::vec4, 6> planes;
+
+    static Frustum fromMatrix(const glm::mat4& viewProjection) {
+        const glm::mat4& m = viewProjection;
+        glm::vec4 rows[4];
+        for (int i = 0; i < 4; ++i) {
+            rows[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+        }
+        Frustum f;
+        f.planes = { rows[3] + rows[0], rows[3] - rows[0],    // левая, правая
+                     rows[3] + rows[1], rows[3] - rows[1],    // нижняя, верхняя
+                     rows[3] + rows[2], rows[3] - rows[2] };  // ближняя, дальняя
+        for (glm::vec4& p : f.planes) {
+            float length = glm::length(glm::vec3(p.x, p.y, p.z));
+            if (length > 0.0f) p = p / length;
+        }
+        return f;
+    }
+
+    // false, только если AABB целиком снаружи одной из плоскостей.
+    bool intersectsBox(const glm::vec3& center, const glm::vec3& extents) const {
+        for (const glm::vec4& p : planes) {
+            float distance = p.x * center.x + p.y * center.y + p.z * center.z + p.w;
+            float reach = std::abs(p.x) * extents.x + std::abs(p.y) * extents.y + std::abs(p.z) * extents.z;
+            if (distance + reach < 0.0f) return false;
+        }
+        return true;
+    }
+
+    // visible[i] — пересекает ли пирамиду i-й AABB пачки; возвращает число
+    // отсечённых. С SSE2 — по четыре AABB за раз.
+    size_t cullBoxes(const BoxBatch& boxes, uint8_t* visible) const {
+        const size_t count = boxes.size();
+        size_t i = 0;
+        size_t culled = 0;
+#ifdef FRUSTUM_SSE
+        __m128 n[6][7];
+        for (int k = 0; k < 6; ++k) {
+            const glm::vec4& p = planes[k];
+            float values[7] = { p.x, p.y, p.z, p.w, std::abs(p.x), std::abs(p.y), std::abs(p.z) };
+            for (int c = 0; c < 7; ++c) n[k][c] = _mm_set1_ps(values[c]);
+        }
+        const __m128 zero = _mm_setzero_ps();
+        for (; i + 4 <= count; i += 4) {
+            __m128 cx = _mm_loadu_ps(&boxes.centerX[i]);
+            __m128 cy = _mm_loadu_ps(&boxes.centerY[i]);
+            __m128 cz = _mm_loadu_ps(&boxes.centerZ[i]);
+            __m128 ex = _mm_loadu_ps(&boxes.extentX[i]);
+            __m128 ey = _mm_loadu_ps(&boxes.extentY[i]);
+            __m128 ez = _mm_loadu_ps(&boxes.extentZ[i]);
+            __m128 outside = zero;
+            for (int k = 0; k < 6; ++k) {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(n[k][0], cx), _mm_mul_ps(n[k][1], cy)),
+                                                        _mm_mul_ps(n[k][2], cz)), n[k][3]);
+                __m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(n[k][4], ex), _mm_mul_ps(n[k][5], ey)),
+                                          _mm_mul_ps(n[k][6], ez));
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, reach), zero));
+            }
+            int mask = _mm_movemask_ps(outside);
+            for (int lane = 0; lane < 4; ++lane) {
+                bool out = (mask >> lane) & 1;
+                visible[i + lane] = out ? 0 : 1;
+                culled += out ? 1 : 0;
+            }
+        }
+#endif
+        return culled + cullBoxesScalar(boxes, visible, i);
+    }
+
+    // То же без SIMD для AABB с номера first.
+    size_t cullBoxesScalar(const BoxBatch& boxes, uint8_t* visible, size_t first = 0) const {
+        size_t culled = 0;
+        for (size_t i = first; i < boxes.size(); ++i) {
+            bool in = intersectsBox(glm::vec3(boxes.centerX[i], boxes.centerY[i], boxes.centerZ[i]),
+                                    glm::vec3(boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i]));
+            visible[i] = in ? 1 : 0;
+            culled += in ? 0 : 1;
+        }
+        return culled;
+    }
+
+    // false, только если сфера целиком снаружи одной из плоскостей.
+    bool intersectsSphere(const glm::vec3& center, float radius) const {
+        for (const glm::vec4& p : planes) {
+            if (p.x * center.x + p.y * center.y + p.z * center.z + p.w < -radius) return false;
+        }
+        return true;
+    }
+};
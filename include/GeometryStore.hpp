@@ -0,0 +1,342 @@
+#pragma once
+
+#include <map>
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <iostream>
+#include <glad/glad.h>
+#include "VertexFormat.hpp"
+
+// Свободные участки [offset, offset + size) буфера, в элементах. Соседние
+// свободные участки сливаются, место выдаётся первым подходящим.
+class RangeAllocator {
+public:
+    static constexpr size_t NONE = SIZE_MAX;
+
+    void reset(size_t newCapacity) {
+        ranges.clear();
+        total = newCapacity;
+        available = newCapacity;
+        if (newCapacity > 0) ranges[0] = newCapacity;
+    }
+
+    size_t allocate(size_t size) {
+        if (size == 0) return 0;
+        for (auto it = ranges.begin(); it != ranges.end(); ++it) {
+            if (it->second < size) continue;
+            size_t offset = it->first;
+            size_t rest = it->second - size;
+            ranges.erase(it);
+            if (rest > 0) ranges[offset + size] = rest;
+            available -= size;
+            return offset;
+        }
+        return NONE;
+    }
+
+    void release(size_t offset, size_t size) {
+        if (size == 0) return;
+        available += size;
+        auto next = ranges.lower_bound(offset);
+        if (next != ranges.begin()) {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == offset) {
+                offset = prev->first;
+                size += prev->second;
+                ranges.erase(prev);
+            }
+        }
+        if (next != ranges.end() && offset + size == next->first) {
+            size += next->second;
+            ranges.erase(next);
+        }
+        ranges[offset] = size;
+    }
+
+    // Буфер вырос до newCapacity: хвост становится свободным.
+    void grow(size_t newCapacity) {
+        if (newCapacity <= total) return;
+        size_t added = newCapacity - total;
+        size_t offset = total;
+        total = newCapacity;
+        release(offset, added);
+    }
+
+    size_t capacity() const { return total; }
+    size_t used() const { return total - available; }
+    // Самый большой участок, который можно выдать без роста буфера.
+    size_t largestFree() const {
+        size_t largest = 0;
+        for (const auto& [offset, size] : ranges) largest = std::max(largest, size);
+        return largest;
+    }
+
+private:
+    std::map<size_t, size_t> ranges;
+    size_t total = 0;
+    size_t available = 0;
+};
+
+// Общие VBO и EBO для сеток одной раскладки вершин и одного типа индексов
+// за одним VAO. Каждая сетка занимает участок вершин и участок индексов;
+// индексы в нём локальные, а рисуется участок через *BaseVertex. При росте
+// и сжатии буферы пересоздаются и участки переезжают, поэтому смещения
+// берутся из арены в момент рисования; VAO при этом остаётся прежним.
+// Работает только в GL-потоке.
+class GeometryArena {
+public:
+    static constexpr uint32_t NO_BLOCK = UINT32_MAX;
+    static constexpr size_t MIN_VERTICES = 1 << 16;
+    static constexpr size_t MIN_INDICES = 1 << 18;
+
+    GeometryArena(const VertexFormat& vertexFormat, GLenum elementType)
+        : format(vertexFormat), vertexStride(vertexFormat.stride()),
+          indexBytes(elementType == GL_UNSIGNED_INT ? 4 : elementType == GL_UNSIGNED_SHORT ? 2 : 1) {
+        glGenVertexArrays(1, &vao);
+    }
+
+    GeometryArena(const GeometryArena&) = delete;
+    GeometryArena& operator=(const GeometryArena&) = delete;
+
+    ~GeometryArena() {
+        if (vbo != 0) glDeleteBuffers(1, &vbo);
+        if (ebo != 0) glDeleteBuffers(1, &ebo);
+        if (vao != 0) glDeleteVertexArrays(1, &vao);
+    }
+
+    // Участок под vertexCount вершин и indexCount индексов; буферы растут
+    // вдвое, если места нет.
+    uint32_t allocate(size_t vertexCount, size_t indexCount) {
+        size_t firstVertex = vertexSpace.allocate(vertexCount);
+        size_t firstIndex = indexSpace.allocate(indexCount);
+        if (firstVertex == RangeAllocator::NONE || firstIndex == RangeAllocator::NONE) {
+            if (firstVertex != RangeAllocator::NONE) vertexSpace.release(firstVertex, vertexCount);
+            if (firstIndex != RangeAllocator::NONE) indexSpace.release(firstIndex, indexCount);
+            relocate(grownCapacity(vertexSpace, vertexCount, MIN_VERTICES),
+                     grownCapacity(indexSpace, indexCount, MIN_INDICES), false);
+            firstVertex = vertexSpace.allocate(vertexCount);
+            firstIndex = indexSpace.allocate(indexCount);
+        }
+
+        Block block{ firstVertex, vertexCount, firstIndex, indexCount, true };
+        if (!freeBlocks.empty()) {
+            uint32_t id = freeBlocks.back();
+            freeBlocks.pop_back();
+            blocks[id] = block;
+            return id;
+        }
+        blocks.push_back(block);
+        return static_cast<uint32_t>(blocks.size() - 1);
+    }
+
+    // Все вершины участка: vertexCount * stride байт в раскладке арены.
+    void uploadVertices(uint32_t id, const void* data) {
+        const Block& b = blocks[id];
+        upload(vbo, b.firstVertex * vertexStride, b.vertexCount * vertexStride, data);
+    }
+
+    // count индексов участка, начиная с его индекса first.
+    void uploadIndices(uint32_t id, size_t first, const void* data, size_t count) {
+        const Block& b = blocks[id];
+        upload(ebo, (b.firstIndex + first) * indexBytes, count * indexBytes, data);
+    }
+
+    void release(uint32_t id) {
+        Block& b = blocks[id];
+        if (!b.live) return;
+        vertexSpace.release(b.firstVertex, b.vertexCount);
+        indexSpace.release(b.firstIndex, b.indexCount);
+        b.live = false;
+        freeBlocks.push_back(id);
+    }
+
+    GLuint vertexArray() const { return vao; }
+    GLint baseVertex(uint32_t id) const { return static_cast<GLint>(blocks[id].firstVertex); }
+    size_t indexByteOffset(uint32_t id) const { return blocks[id].firstIndex * indexBytes; }
+
+    size_t usedBytes() const { return vertexSpace.used() * vertexStride + indexSpace.used() * indexBytes; }
+    size_t capacityBytes() const {
+        return vertexSpace.capacity() * vertexStride + indexSpace.capacity() * indexBytes;
+    }
+    size_t liveBlocks() const { return blocks.size() - freeBlocks.size(); }
+
+    // Сдвигает живые участки к началу и урезает буферы до занятого (с
+    // запасом в восьмую часть). false — сжимать было незачем.
+    bool compact() {
+        if (capacityBytes() == 0) return false;
+        if (liveBlocks() == 0) {
+            relocate(0, 0, true);
+            return true;
+        }
+        if (usedBytes() * 4 >= capacityBytes() * 3) return false;
+        relocate(vertexSpace.used() + vertexSpace.used() / 8, indexSpace.used() + indexSpace.used() / 8, true);
+        return true;
+    }
+
+private:
+    struct Block {
+        size_t firstVertex = 0;
+        size_t vertexCount = 0;
+        size_t firstIndex = 0;
+        size_t indexCount = 0;
+        bool live = false;
+    };
+
+    VertexFormat format;
+    size_t vertexStride;
+    size_t indexBytes;
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    GLuint ebo = 0;
+    RangeAllocator vertexSpace;
+    RangeAllocator indexSpace;
+    std::vector<Block> blocks;
+    std::vector<uint32_t> freeBlocks;
+
+    static size_t grownCapacity(const RangeAllocator& space, size_t needed, size_t minimum) {
+        if (space.largestFree() >= needed) return space.capacity();
+        return std::max({ space.capacity() * 2, space.capacity() + needed, minimum });
+    }
+
+    static void upload(GLuint buffer, size_t offset, size_t bytes, const void* data) {
+        if (bytes == 0) return;
+        // GL_COPY_WRITE_BUFFER не входит в состояние VAO, так что загрузка
+        // не задевает привязанный сейчас VAO.
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(bytes), data);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    // Новые буферы заданной ёмкости с копией содержимого на GPU. pack —
+    // живые участки переезжают вплотную друг к другу, иначе всё копируется
+    // на прежние места.
+    void relocate(size_t vertexCapacity, size_t indexCapacity, bool pack) {
+        // Без упаковки буфер прежней ёмкости остаётся как есть.
+        bool newVertices = pack || vertexCapacity != vertexSpace.capacity();
+        bool newIndices = pack || indexCapacity != indexSpace.capacity();
+        GLuint newVbo = newVertices ? createBuffer(vertexCapacity * vertexStride) : vbo;
+        GLuint newEbo = newIndices ? createBuffer(indexCapacity * indexBytes) : ebo;
+
+        if (pack) {
+            vertexSpace.reset(vertexCapacity);
+            indexSpace.reset(indexCapacity);
+            for (Block& b : blocks) {
+                if (!b.live) continue;
+                size_t firstVertex = vertexSpace.allocate(b.vertexCount);
+                size_t firstIndex = indexSpace.allocate(b.indexCount);
+                copy(vbo, newVbo, b.firstVertex * vertexStride, firstVertex * vertexStride,
+                     b.vertexCount * vertexStride);
+                copy(ebo, newEbo, b.firstIndex * indexBytes, firstIndex * indexBytes, b.indexCount * indexBytes);
+                b.firstVertex = firstVertex;
+                b.firstIndex = firstIndex;
+            }
+        } else {
+            if (newVertices) copy(vbo, newVbo, 0, 0, vertexSpace.capacity() * vertexStride);
+            if (newIndices) copy(ebo, newEbo, 0, 0, indexSpace.capacity() * indexBytes);
+            vertexSpace.grow(vertexCapacity);
+            indexSpace.grow(indexCapacity);
+        }
+
+        if (newVertices && vbo != 0) glDeleteBuffers(1, &vbo);
+        if (newIndices && ebo != 0) glDeleteBuffers(1, &ebo);
+        vbo = newVbo;
+        ebo = newEbo;
+
+        // Тот же VAO смотрит в новые буферы.
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        if (vbo != 0) format.linkAttributes();
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    static GLuint createBuffer(size_t bytes) {
+        if (bytes == 0) return 0;
+        GLuint buffer = 0;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(bytes), nullptr, GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        return buffer;
+    }
+
+    static void copy(GLuint from, GLuint to, size_t fromOffset, size_t toOffset, size_t bytes) {
+        if (from == 0 || to == 0 || bytes == 0) return;
+        glBindBuffer(GL_COPY_READ_BUFFER, from);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, to);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(fromOffset),
+                            static_cast<GLintptr>(toOffset), static_cast<GLsizeiptr>(bytes));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+};
+
+struct GeometryStoreStats {
+    size_t arenas        = 0;
+    size_t meshes        = 0;   // живые участки во всех аренах
+    size_t usedBytes     = 0;
+    size_t capacityBytes = 0;   // VBO + EBO всех арен
+};
+
+// Арены статической геометрии по раскладке вершин и типу индексов: сетки
+// одного формата рисуются из одного VAO без перепривязки буферов.
+// Работает только в GL-потоке.
+class GeometryStore {
+public:
+    static GeometryStore& global() {
+        static GeometryStore store;
+        return store;
+    }
+
+    // Выключено — каждая сетка получает свои VAO/VBO/EBO, как раньше.
+    void setEnabled(bool enable) { enabled = enable; }
+    bool isEnabled() const { return enabled; }
+
+    std::shared_ptr<GeometryArena> arena(const VertexFormat& format, GLenum indexType) {
+        std::string key = format.describe() + (indexType == GL_UNSIGNED_SHORT ? "/u16" : "/u32");
+        std::shared_ptr<GeometryArena>& slot = arenas[key];
+        if (!slot) slot = std::make_shared<GeometryArena>(format, indexType);
+        return slot;
+    }
+
+    // Сжимает арены с большими дырами; число сжатых.
+    size_t compact() {
+        size_t compacted = 0;
+        for (auto& [key, arena] : arenas) {
+            compacted += arena->compact() ? 1 : 0;
+        }
+        return compacted;
+    }
+
+    GeometryStoreStats stats() const {
+        GeometryStoreStats s;
+        for (const auto& [key, arena] : arenas) {
+            ++s.arenas;
+            s.meshes += arena->liveBlocks();
+            s.usedBytes += arena->usedBytes();
+            s.capacityBytes += arena->capacityBytes();
+        }
+        return s;
+    }
+
+    void printStats() const {
+        GeometryStoreStats s = stats();
+        std::cout << "Geometry store: " << s.meshes << " meshes in " << s.arenas << " arenas, "
+                  << s.usedBytes / (1024.0 * 1024.0) << " of " << s.capacityBytes / (1024.0 * 1024.0)
+                  << " MB used\n";
+    }
+
+    // Забывает арены; сетки, которые ещё в них лежат, держат их сами.
+    void clear() {
+        arenas.clear();
+    }
+
+private:
+    std::map<std::string, std::shared_ptr<GeometryArena>> arenas;
+    bool enabled = true;
+};
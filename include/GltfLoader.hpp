@@ -0,0 +1,724 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <nlohmann/json.hpp>
+#include "MappedFile.hpp"
+#include "AssetArchive.hpp"
+#include "MeshData.hpp"
+#include "Bounds.hpp"
+#include "Material.hpp"
+#include "NormalGenerator.hpp"
+#include "MeshBvh.hpp"
+
+// Коды типов компонентов glTF совпадают с GLenum (GL_FLOAT и т.д.), но
+// GL-заголовки здесь не нужны: разбор .glb идёт без контекста.
+enum GltfComponentType : uint32_t {
+    GLTF_BYTE           = 5120,
+    GLTF_UNSIGNED_BYTE  = 5121,
+    GLTF_SHORT          = 5122,
+    GLTF_UNSIGNED_SHORT = 5123,
+    GLTF_UNSIGNED_INT   = 5125,
+    GLTF_FLOAT          = 5126,
+};
+
+struct GltfBufferView {
+    const unsigned char* data = nullptr;  // внутри отображённого файла
+    size_t length = 0;
+    size_t stride = 0;                    // 0 — элементы плотно упакованы
+};
+
+struct GltfAccessor {
+    int bufferView = -1;
+    size_t offset = 0;                    // byteOffset внутри bufferView
+    size_t count = 0;
+    uint32_t componentType = GLTF_FLOAT;
+    int components = 1;
+    bool normalized = false;
+    bool sparse = false;
+    bool hasMinMax = false;
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+
+    size_t elementSize() const {
+        return componentSize(componentType) * static_cast<size_t>(components);
+    }
+
+    static size_t componentSize(uint32_t type) {
+        switch (type) {
+            case GLTF_BYTE: case GLTF_UNSIGNED_BYTE:   return 1;
+            case GLTF_SHORT: case GLTF_UNSIGNED_SHORT: return 2;
+            default:                                   return 4;
+        }
+    }
+};
+
+struct GltfPrimitive {
+    int position = -1;                    // индексы accessors
+    int normal = -1;
+    int texCoord = -1;
+    int indices = -1;
+    int material = -1;
+    Bounds bounds;
+};
+
+struct GltfMesh {
+    std::string name;
+    std::vector<GltfPrimitive> primitives;
+};
+
+struct GltfMaterial {
+    std::string name;
+    glm::vec4 baseColor = glm::vec4(1.0f);
+    float metallic = 1.0f;
+    float roughness = 1.0f;
+    int baseColorImage = -1;              // индекс images (через textures[].source)
+};
+
+// Изображение либо лежит в бинарном чанке (data/size), либо во внешнем файле.
+struct GltfImage {
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    std::string path;
+};
+
+// Экземпляр сетки в сцене glTF: мировая матрица узла.
+struct GltfInstance {
+    int mesh = -1;
+    glm::mat4 transform = glm::mat4(1.0f);
+};
+
+// Разобранный .glb. Все указатели смотрят в отображённые файлы, которые
+// живут вместе с документом (или в смонтированный архив ресурсов).
+struct GltfDocument {
+    std::string path;
+    MappedFile file;
+    std::vector<MappedFile> externalBuffers;
+    std::vector<GltfBufferView> bufferViews;
+    std::vector<GltfAccessor> accessors;
+    std::vector<GltfMesh> meshes;
+    std::vector<GltfMaterial> materials;
+    std::vector<GltfImage> images;
+    std::vector<GltfInstance> instances;
+
+    // Начало данных accessor'а и шаг между элементами.
+    const unsigned char* accessorData(const GltfAccessor& accessor) const {
+        return bufferViews[accessor.bufferView].data + accessor.offset;
+    }
+
+    size_t accessorStride(const GltfAccessor& accessor) const {
+        size_t stride = bufferViews[accessor.bufferView].stride;
+        return stride != 0 ? stride : accessor.elementSize();
+    }
+};
+
+class GltfLoader {
+public:
+    static constexpr uint32_t GLB_MAGIC = 0x46546C67;   // "glTF"
+    static constexpr uint32_t CHUNK_JSON = 0x4E4F534A;  // "JSON"
+    static constexpr uint32_t CHUNK_BIN = 0x004E4942;   // "BIN\0"
+
+    // Отображает файл, разбирает JSON и проверяет, что каждый accessor
+    // целиком лежит внутри своего bufferView. Копий данных не делает.
+    static bool load(const std::string& filepath, GltfDocument& doc) {
+        doc = GltfDocument();
+        doc.path = filepath;
+
+        // Из архива файл читается прямо из его отображения.
+        std::string_view packed;
+        if (!AssetArchive::global().findRaw(filepath, packed)) {
+            if (!doc.file.open(filepath)) {
+                std::cerr << "Failed to open glTF file: " << filepath << std::endl;
+                return false;
+            }
+            packed = doc.file.view();
+        }
+
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(packed.data());
+        const size_t size = packed.size();
+        if (size < 20 || readU32(bytes) != GLB_MAGIC || readU32(bytes + 4) != 2) {
+            std::cerr << "Not a glTF 2.0 binary file: " << filepath << std::endl;
+            return false;
+        }
+        const size_t declared = std::min<size_t>(readU32(bytes + 8), size);
+
+        const char* jsonBegin = nullptr;
+        size_t jsonLength = 0;
+        const unsigned char* bin = nullptr;
+        size_t binLength = 0;
+        for (size_t pos = 12; pos + 8 <= declared;) {
+            size_t length = readU32(bytes + pos);
+            uint32_t type = readU32(bytes + pos + 4);
+            pos += 8;
+            if (length > declared - pos) {
+                std::cerr << "Truncated glTF chunk in " << filepath << std::endl;
+                return false;
+            }
+            if (type == CHUNK_JSON && jsonBegin == nullptr) {
+                jsonBegin = reinterpret_cast<const char*>(bytes + pos);
+                jsonLength = length;
+            } else if (type == CHUNK_BIN && bin == nullptr) {
+                bin = bytes + pos;
+                binLength = length;
+            }
+            pos += (length + 3) & ~size_t(3);
+        }
+        if (jsonBegin == nullptr) {
+            std::cerr << "glTF file has no JSON chunk: " << filepath << std::endl;
+            return false;
+        }
+
+        nlohmann::json json = nlohmann::json::parse(jsonBegin, jsonBegin + jsonLength, nullptr, false);
+        if (json.is_discarded() || !json.is_object()) {
+            std::cerr << "Invalid glTF JSON in " << filepath << std::endl;
+            return false;
+        }
+
+        const std::filesystem::path baseDir = std::filesystem::path(filepath).parent_path();
+        return readBuffers(json, bin, binLength, baseDir, doc) &&
+               readAccessors(json, doc) &&
+               readMeshes(json, doc) &&
+               readMaterials(json, baseDir, doc) &&
+               readNodes(json, doc);
+    }
+
+    // glTF PBR -> Phong-материал рендерера: baseColor идёт в diffuse,
+    // металличность окрашивает блик, шероховатость задаёт его размер.
+    static Material toMaterial(const GltfMaterial& src) {
+        glm::vec3 base = glm::vec3(src.baseColor);
+        float metallic = std::clamp(src.metallic, 0.0f, 1.0f);
+        float roughness = std::clamp(src.roughness, 0.05f, 1.0f);
+
+        Material mat;
+        mat.ambient = base * 0.2f;
+        mat.diffuse = base * (1.0f - 0.5f * metallic);
+        mat.specular = glm::mix(glm::vec3(0.04f), base, metallic) * (1.0f - 0.5f * roughness);
+        mat.shininess = std::clamp(2.0f / (roughness * roughness * roughness * roughness) - 2.0f, 1.0f, 256.0f);
+        return mat;
+    }
+
+    // Можно ли отдать bufferView'ы примитива в GL без преобразования:
+    // float-позиции и нормали, UV float или нормализованные целые, индексы
+    // любого допустимого в GL типа и все в пределах числа вершин.
+    static bool canUseDirectly(const GltfDocument& doc, const GltfPrimitive& prim) {
+        if (prim.normal < 0 || prim.indices < 0) return false;
+        const GltfAccessor& positions = doc.accessors[prim.position];
+        const GltfAccessor& normals = doc.accessors[prim.normal];
+        const GltfAccessor& indices = doc.accessors[prim.indices];
+        if (positions.componentType != GLTF_FLOAT || normals.componentType != GLTF_FLOAT ||
+            normals.count < positions.count) {
+            return false;
+        }
+        if (prim.texCoord >= 0) {
+            const GltfAccessor& texCoords = doc.accessors[prim.texCoord];
+            bool packed = texCoords.normalized && (texCoords.componentType == GLTF_UNSIGNED_BYTE ||
+                                                   texCoords.componentType == GLTF_UNSIGNED_SHORT);
+            if ((texCoords.componentType != GLTF_FLOAT && !packed) || texCoords.count < positions.count) {
+                return false;
+            }
+        }
+        // GL читает индексы подряд, шаг у их bufferView недопустим.
+        if (doc.bufferViews[indices.bufferView].stride != 0 ||
+            (indices.componentType != GLTF_UNSIGNED_BYTE && indices.componentType != GLTF_UNSIGNED_SHORT &&
+             indices.componentType != GLTF_UNSIGNED_INT) ||
+            indices.count == 0 || indices.offset % GltfAccessor::componentSize(indices.componentType) != 0) {
+            return false;
+        }
+        return maxIndex(doc, indices) < positions.count;
+    }
+
+    static uint32_t maxIndex(const GltfDocument& doc, const GltfAccessor& indices) {
+        const unsigned char* p = doc.accessorData(indices);
+        uint32_t result = 0;
+        for (size_t i = 0; i < indices.count; ++i) {
+            uint32_t value;
+            if (indices.componentType == GLTF_UNSIGNED_BYTE) {
+                value = p[i];
+            } else if (indices.componentType == GLTF_UNSIGNED_SHORT) {
+                uint16_t v;
+                std::memcpy(&v, p + i * 2, 2);
+                value = v;
+            } else {
+                std::memcpy(&value, p + i * 4, 4);
+            }
+            result = std::max(result, value);
+        }
+        return result;
+    }
+
+    // BVH примитива, который canUseDirectly отдаёт в GL как есть: позиции
+    // (float) и индексы читаются прямо из отображения, без копии в Vertex.
+    static std::shared_ptr<const MeshBvh> buildBvh(const GltfDocument& doc, const GltfPrimitive& prim) {
+        const GltfAccessor& positions = doc.accessors[prim.position];
+        const GltfAccessor& indices = doc.accessors[prim.indices];
+        const unsigned char* p = doc.accessorData(positions);
+        const size_t stride = doc.accessorStride(positions);
+        auto position = [p, stride](uint32_t i) {
+            float v[3];
+            std::memcpy(v, p + i * stride, sizeof(v));
+            return glm::vec3(v[0], v[1], v[2]);
+        };
+        const unsigned char* q = doc.accessorData(indices);
+        if (indices.componentType == GLTF_UNSIGNED_BYTE) {
+            return MeshBvh::build(indices.count, position, [q](size_t k) { return uint32_t(q[k]); });
+        }
+        if (indices.componentType == GLTF_UNSIGNED_SHORT) {
+            return MeshBvh::build(indices.count, position, [q](size_t k) {
+                uint16_t v;
+                std::memcpy(&v, q + k * 2, 2);
+                return uint32_t(v);
+            });
+        }
+        return MeshBvh::build(indices.count, position, [q](size_t k) {
+            uint32_t v;
+            std::memcpy(&v, q + k * 4, 4);
+            return v;
+        });
+    }
+
+    // Вершины примитива в формате Vertex: для accessor'ов, которые нельзя
+    // отдать в GL как есть (нет нормалей или индексов, нестандартные типы).
+    static bool toMeshData(const GltfDocument& doc, const GltfPrimitive& prim, MeshData& out,
+                           NormalWeighting weighting = NormalWeighting::Uniform) {
+        out = MeshData();
+        if (prim.position < 0) return false;
+        const GltfAccessor& positions = doc.accessors[prim.position];
+        const size_t count = positions.count;
+
+        out.vertices.resize(count);
+        float value[4];
+        for (size_t i = 0; i < count; ++i) {
+            readElement(doc, positions, i, value);
+            out.vertices[i].position = glm::vec3(value[0], value[1], value[2]);
+        }
+        if (prim.normal >= 0 && doc.accessors[prim.normal].count == count) {
+            const GltfAccessor& normals = doc.accessors[prim.normal];
+            for (size_t i = 0; i < count; ++i) {
+                readElement(doc, normals, i, value);
+                out.vertices[i].normal = glm::vec3(value[0], value[1], value[2]);
+            }
+            out.hasNormals = true;
+        }
+        if (prim.texCoord >= 0 && doc.accessors[prim.texCoord].count == count) {
+            const GltfAccessor& texCoords = doc.accessors[prim.texCoord];
+            for (size_t i = 0; i < count; ++i) {
+                readElement(doc, texCoords, i, value);
+                out.vertices[i].texCoords = glm::vec2(value[0], value[1]);
+            }
+        }
+
+        if (prim.indices >= 0) {
+            const GltfAccessor& indices = doc.accessors[prim.indices];
+            out.indices.resize(indices.count);
+            for (size_t i = 0; i < indices.count; ++i) {
+                readElement(doc, indices, i, value);
+                out.indices[i] = static_cast<uint32_t>(value[0]);
+                if (out.indices[i] >= count) {
+                    std::cerr << "glTF index out of range in " << doc.path << std::endl;
+                    out = MeshData();
+                    return false;
+                }
+            }
+        } else {
+            out.indices.resize(count - count % 3);
+            for (size_t i = 0; i < out.indices.size(); ++i) {
+                out.indices[i] = static_cast<uint32_t>(i);
+            }
+        }
+
+        if (!out.hasNormals) {
+            NormalGenerator::generate(out.vertices, out.indices, weighting);
+            out.hasNormals = true;
+        }
+        return true;
+    }
+
+    // Элемент accessor'а как float[4]; целые нормализуются, если так указано.
+    static void readElement(const GltfDocument& doc, const GltfAccessor& accessor,
+                            size_t index, float* out) {
+        const unsigned char* p = doc.accessorData(accessor) + index * doc.accessorStride(accessor);
+        for (int c = 0; c < accessor.components && c < 4; ++c) {
+            switch (accessor.componentType) {
+                case GLTF_FLOAT: {
+                    float v;
+                    std::memcpy(&v, p + c * 4, 4);
+                    out[c] = v;
+                    break;
+                }
+                case GLTF_UNSIGNED_INT: {
+                    uint32_t v;
+                    std::memcpy(&v, p + c * 4, 4);
+                    out[c] = static_cast<float>(v);
+                    break;
+                }
+                case GLTF_UNSIGNED_SHORT: {
+                    uint16_t v;
+                    std::memcpy(&v, p + c * 2, 2);
+                    out[c] = accessor.normalized ? v / 65535.0f : static_cast<float>(v);
+                    break;
+                }
+                case GLTF_SHORT: {
+                    int16_t v;
+                    std::memcpy(&v, p + c * 2, 2);
+                    out[c] = accessor.normalized ? std::max(v / 32767.0f, -1.0f) : static_cast<float>(v);
+                    break;
+                }
+                case GLTF_UNSIGNED_BYTE:
+                    out[c] = accessor.normalized ? p[c] / 255.0f : static_cast<float>(p[c]);
+                    break;
+                case GLTF_BYTE: {
+                    int8_t v = static_cast<int8_t>(p[c]);
+                    out[c] = accessor.normalized ? std::max(v / 127.0f, -1.0f) : static_cast<float>(v);
+                    break;
+                }
+                default:
+                    out[c] = 0.0f;
+            }
+        }
+    }
+
+private:
+    static uint32_t readU32(const unsigned char* p) {
+        return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+    }
+
+    static const nlohmann::json& array(const nlohmann::json& json, const char* key) {
+        static const nlohmann::json empty = nlohmann::json::array();
+        auto it = json.find(key);
+        return it != json.end() && it->is_array() ? *it : empty;
+    }
+
+    static int getInt(const nlohmann::json& json, const char* key, int fallback = -1) {
+        auto it = json.find(key);
+        return it != json.end() && it->is_number_integer() ? it->get<int>() : fallback;
+    }
+
+    static bool getBool(const nlohmann::json& json, const char* key) {
+        auto it = json.find(key);
+        return it != json.end() && it->is_boolean() && it->get<bool>();
+    }
+
+    static size_t getSize(const nlohmann::json& json, const char* key, size_t fallback = 0) {
+        auto it = json.find(key);
+        return it != json.end() && it->is_number_unsigned() ? it->get<size_t>() : fallback;
+    }
+
+    static float getFloat(const nlohmann::json& json, const char* key, float fallback) {
+        auto it = json.find(key);
+        return it != json.end() && it->is_number() ? it->get<float>() : fallback;
+    }
+
+    static std::string getString(const nlohmann::json& json, const char* key) {
+        auto it = json.find(key);
+        return it != json.end() && it->is_string() ? it->get<std::string>() : std::string();
+    }
+
+    static bool getFloats(const nlohmann::json& json, const char* key, float* out, size_t count) {
+        auto it = json.find(key);
+        if (it == json.end() || !it->is_array() || it->size() < count) return false;
+        for (size_t i = 0; i < count; ++i) {
+            if (!(*it)[i].is_number()) return false;
+            out[i] = (*it)[i].get<float>();
+        }
+        return true;
+    }
+
+    static bool readBuffers(const nlohmann::json& json, const unsigned char* bin, size_t binLength,
+                            const std::filesystem::path& baseDir, GltfDocument& doc) {
+        struct Range { const unsigned char* data; size_t length; };
+        std::vector<Range> buffers;
+        const nlohmann::json& bufferList = array(json, "buffers");
+        doc.externalBuffers.reserve(bufferList.size());
+
+        for (size_t i = 0; i < bufferList.size(); ++i) {
+            const nlohmann::json& buffer = bufferList[i];
+            size_t length = getSize(buffer, "byteLength");
+            std::string uri = getString(buffer, "uri");
+            if (uri.empty()) {
+                // Буфер без uri — бинарный чанк самого .glb.
+                if (bin == nullptr || length > binLength) {
+                    std::cerr << "glTF buffer " << i << " exceeds the BIN chunk in " << doc.path << std::endl;
+                    return false;
+                }
+                buffers.push_back({ bin, length });
+            } else if (uri.rfind("data:", 0) == 0) {
+                std::cerr << "Embedded data URIs are not supported: " << doc.path << std::endl;
+                return false;
+            } else {
+                MappedFile external;
+                std::string externalPath = (baseDir / uri).string();
+                if (!external.open(externalPath) || external.size() < length) {
+                    std::cerr << "Failed to open glTF buffer: " << externalPath << std::endl;
+                    return false;
+                }
+                buffers.push_back({ reinterpret_cast<const unsigned char*>(external.data()), length });
+                doc.externalBuffers.push_back(std::move(external));
+            }
+        }
+
+        for (const auto& view : array(json, "bufferViews")) {
+            int buffer = getInt(view, "buffer");
+            size_t offset = getSize(view, "byteOffset");
+            size_t length = getSize(view, "byteLength");
+            if (buffer < 0 || buffer >= static_cast<int>(buffers.size()) ||
+                offset > buffers[buffer].length || length > buffers[buffer].length - offset) {
+                std::cerr << "glTF bufferView out of range in " << doc.path << std::endl;
+                return false;
+            }
+            GltfBufferView out;
+            out.data = buffers[buffer].data + offset;
+            out.length = length;
+            out.stride = getSize(view, "byteStride");
+            doc.bufferViews.push_back(out);
+        }
+        return true;
+    }
+
+    static int componentCount(const std::string& type) {
+        if (type == "SCALAR") return 1;
+        if (type == "VEC2")   return 2;
+        if (type == "VEC3")   return 3;
+        if (type == "VEC4")   return 4;
+        return 0;
+    }
+
+    static bool readAccessors(const nlohmann::json& json, GltfDocument& doc) {
+        for (const auto& accessor : array(json, "accessors")) {
+            GltfAccessor out;
+            out.bufferView = getInt(accessor, "bufferView");
+            out.offset = getSize(accessor, "byteOffset");
+            out.count = getSize(accessor, "count");
+            out.componentType = static_cast<uint32_t>(getInt(accessor, "componentType", GLTF_FLOAT));
+            out.components = componentCount(getString(accessor, "type"));
+            out.normalized = getBool(accessor, "normalized");
+            out.sparse = accessor.contains("sparse");
+
+            float minValues[3], maxValues[3];
+            if (out.components == 3 && getFloats(accessor, "min", minValues, 3) &&
+                getFloats(accessor, "max", maxValues, 3)) {
+                out.hasMinMax = true;
+                out.min = glm::vec3(minValues[0], minValues[1], minValues[2]);
+                out.max = glm::vec3(maxValues[0], maxValues[1], maxValues[2]);
+            }
+
+            // accessor без bufferView (только sparse или нули) не поддерживается.
+            if (out.components == 0 || out.bufferView < 0 ||
+                out.bufferView >= static_cast<int>(doc.bufferViews.size())) {
+                out.count = 0;
+                out.bufferView = -1;
+            } else if (out.count > 0) {
+                const GltfBufferView& view = doc.bufferViews[out.bufferView];
+                size_t stride = view.stride != 0 ? view.stride : out.elementSize();
+                size_t end = out.offset + stride * (out.count - 1) + out.elementSize();
+                if (end > view.length) {
+                    std::cerr << "glTF accessor exceeds its bufferView in " << doc.path << std::endl;
+                    return false;
+                }
+            }
+            doc.accessors.push_back(out);
+        }
+        return true;
+    }
+
+    static bool validAccessor(const GltfDocument& doc, int index, int components) {
+        return index >= 0 && index < static_cast<int>(doc.accessors.size()) &&
+               doc.accessors[index].bufferView >= 0 &&
+               doc.accessors[index].components == components;
+    }
+
+    static bool usesSparse(const GltfDocument& doc, const GltfPrimitive& prim) {
+        for (int index : { prim.position, prim.normal, prim.texCoord, prim.indices }) {
+            if (index >= 0 && index < static_cast<int>(doc.accessors.size()) && doc.accessors[index].sparse) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool readMeshes(const nlohmann::json& json, GltfDocument& doc) {
+        for (const auto& mesh : array(json, "meshes")) {
+            GltfMesh out;
+            out.name = getString(mesh, "name");
+            for (const auto& primitive : array(mesh, "primitives")) {
+                // Рендерер рисует только GL_TRIANGLES (mode 4 по умолчанию).
+                if (getInt(primitive, "mode", 4) != 4) {
+                    std::cerr << "Skipping non-triangle glTF primitive in " << doc.path << std::endl;
+                    continue;
+                }
+                auto attributes = primitive.find("attributes");
+                if (attributes == primitive.end() || !attributes->is_object()) continue;
+
+                GltfPrimitive prim;
+                prim.position = getInt(*attributes, "POSITION");
+                prim.normal = getInt(*attributes, "NORMAL");
+                prim.texCoord = getInt(*attributes, "TEXCOORD_0");
+                prim.indices = getInt(primitive, "indices");
+                prim.material = getInt(primitive, "material");
+
+                if (!validAccessor(doc, prim.position, 3) || doc.accessors[prim.position].count == 0) {
+                    std::cerr << "Skipping glTF primitive without positions in " << doc.path << std::endl;
+                    continue;
+                }
+                if (usesSparse(doc, prim)) {
+                    std::cerr << "Skipping glTF primitive with sparse accessors in " << doc.path << std::endl;
+                    continue;
+                }
+                if (!validAccessor(doc, prim.normal, 3)) prim.normal = -1;
+                if (!validAccessor(doc, prim.texCoord, 2)) prim.texCoord = -1;
+                if (!validAccessor(doc, prim.indices, 1)) prim.indices = -1;
+                if (prim.material >= static_cast<int>(array(json, "materials").size())) prim.material = -1;
+
+                // min/max у POSITION обязательны по спецификации, но не всегда есть.
+                const GltfAccessor& positions = doc.accessors[prim.position];
+                if (positions.hasMinMax) {
+                    prim.bounds.min = positions.min;
+                    prim.bounds.max = positions.max;
+                } else {
+                    float value[4];
+                    for (size_t i = 0; i < positions.count; ++i) {
+                        readElement(doc, positions, i, value);
+                        prim.bounds.expand(glm::vec3(value[0], value[1], value[2]));
+                    }
+                }
+                out.primitives.push_back(prim);
+            }
+            doc.meshes.push_back(std::move(out));
+        }
+        return true;
+    }
+
+    static bool readMaterials(const nlohmann::json& json, const std::filesystem::path& baseDir,
+                              GltfDocument& doc) {
+        for (const auto& image : array(json, "images")) {
+            GltfImage out;
+            int view = getInt(image, "bufferView");
+            std::string uri = getString(image, "uri");
+            if (view >= 0 && view < static_cast<int>(doc.bufferViews.size())) {
+                out.data = doc.bufferViews[view].data;
+                out.size = doc.bufferViews[view].length;
+            } else if (!uri.empty() && uri.rfind("data:", 0) != 0) {
+                out.path = (baseDir / uri).string();
+            }
+            doc.images.push_back(out);
+        }
+
+        const nlohmann::json& textures = array(json, "textures");
+        for (const auto& material : array(json, "materials")) {
+            GltfMaterial out;
+            out.name = getString(material, "name");
+            auto pbr = material.find("pbrMetallicRoughness");
+            if (pbr != material.end() && pbr->is_object()) {
+                float color[4];
+                if (getFloats(*pbr, "baseColorFactor", color, 4)) {
+                    out.baseColor = glm::vec4(color[0], color[1], color[2], color[3]);
+                }
+                out.metallic = getFloat(*pbr, "metallicFactor", 1.0f);
+                out.roughness = getFloat(*pbr, "roughnessFactor", 1.0f);
+
+                auto baseTexture = pbr->find("baseColorTexture");
+                if (baseTexture != pbr->end() && baseTexture->is_object()) {
+                    int texture = getInt(*baseTexture, "index");
+                    if (texture >= 0 && texture < static_cast<int>(textures.size())) {
+                        int source = getInt(textures[texture], "source");
+                        if (source >= 0 && source < static_cast<int>(doc.images.size())) {
+                            out.baseColorImage = source;
+                        }
+                    }
+                }
+            }
+            doc.materials.push_back(out);
+        }
+        return true;
+    }
+
+    static glm::mat4 localTransform(const nlohmann::json& node) {
+        float m[16];
+        if (getFloats(node, "matrix", m, 16)) {
+            glm::mat4 result;
+            for (int c = 0; c < 4; ++c) {
+                result[c] = glm::vec4(m[c * 4], m[c * 4 + 1], m[c * 4 + 2], m[c * 4 + 3]);
+            }
+            return result;
+        }
+
+        glm::mat4 result(1.0f);
+        float t[3], r[4], s[3];
+        if (getFloats(node, "translation", t, 3)) {
+            result = glm::translate(result, glm::vec3(t[0], t[1], t[2]));
+        }
+        if (getFloats(node, "rotation", r, 4)) {
+            result = result * glm::mat4_cast(glm::quat(r[3], r[0], r[1], r[2]));
+        }
+        if (getFloats(node, "scale", s, 3)) {
+            result = glm::scale(result, glm::vec3(s[0], s[1], s[2]));
+        }
+        return result;
+    }
+
+    static bool readNodes(const nlohmann::json& json, GltfDocument& doc) {
+        const nlohmann::json& nodes = array(json, "nodes");
+        const nlohmann::json& scenes = array(json, "scenes");
+
+        std::vector<int> roots;
+        if (!scenes.empty()) {
+            int scene = std::clamp(getInt(json, "scene", 0), 0, static_cast<int>(scenes.size()) - 1);
+            for (const auto& root : array(scenes[scene], "nodes")) {
+                if (root.is_number_integer()) roots.push_back(root.get<int>());
+            }
+        } else {
+            // Без scenes корнями считаются узлы, которые ничьи не дети.
+            std::vector<bool> isChild(nodes.size(), false);
+            for (const auto& node : nodes) {
+                for (const auto& child : array(node, "children")) {
+                    if (child.is_number_integer() && child.get<int>() >= 0 &&
+                        child.get<size_t>() < nodes.size()) {
+                        isChild[child.get<size_t>()] = true;
+                    }
+                }
+            }
+            for (size_t i = 0; i < nodes.size(); ++i) {
+                if (!isChild[i]) roots.push_back(static_cast<int>(i));
+            }
+        }
+
+        // Обход без рекурсии; счётчик посещений защищает от циклов в файле.
+        std::vector<std::pair<int, glm::mat4>> stack;
+        for (auto it = roots.rbegin(); it != roots.rend(); ++it) {
+            stack.push_back({ *it, glm::mat4(1.0f) });
+        }
+        std::vector<bool> visited(nodes.size(), false);
+        while (!stack.empty()) {
+            auto [index, parent] = stack.back();
+            stack.pop_back();
+            if (index < 0 || index >= static_cast<int>(nodes.size()) || visited[index]) continue;
+            visited[index] = true;
+
+            const nlohmann::json& node = nodes[index];
+            glm::mat4 world = parent * localTransform(node);
+            int mesh = getInt(node, "mesh");
+            if (mesh >= 0 && mesh < static_cast<int>(doc.meshes.size())) {
+                doc.instances.push_back({ mesh, world });
+            }
+            const nlohmann::json& children = array(node, "children");
+            for (auto it = children.rbegin(); it != children.rend(); ++it) {
+                if (it->is_number_integer()) stack.push_back({ it->get<int>(), world });
+            }
+        }
+
+        // Файл без узлов: каждая сетка один раз в начале координат.
+        if (nodes.empty()) {
+            for (size_t i = 0; i < doc.meshes.size(); ++i) {
+                doc.instances.push_back({ static_cast<int>(i), glm::mat4(1.0f) });
+            }
+        }
+        return true;
+    }
+};
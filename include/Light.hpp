@@ -1,5 +1,8 @@
 #pragma once
 
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -63,6 +66,28 @@ struct Light {
           outerCutOff(outerCut)
     {}
 
+    // Ослабление точечных и прожекторов в default.frag:
+    // 1 / (1 + ATTENUATION_LINEAR * d + ATTENUATION_QUADRATIC * d²).
+    static constexpr float ATTENUATION_LINEAR = 0.09f;
+    static constexpr float ATTENUATION_QUADRATIC = 0.032f;
+
+    // Радиус, дальше которого источник добавляет к каналу меньше 1/256 —
+    // шага 8-битного цвета. По нему отсекаются тени, кластеры и ячейки, так
+    // что они не меняют картинку; range шейдер не использует. Диффузная
+    // часть и блик материала каждая не больше 1, отсюда множитель 2.
+    float influenceRadius() const {
+        if (type == LightType::DIRECTIONAL) return FLT_MAX;
+        return attenuationRadius(2.0f * intensity * std::max(color.x, std::max(color.y, color.z)));
+    }
+
+    // Корень 1 + k1 d + k2 d² = 256 * peak, где peak — вклад без ослабления.
+    static float attenuationRadius(float peak) {
+        float c = 1.0f - 256.0f * peak;
+        if (c >= 0.0f) return 0.0f;
+        float k1 = ATTENUATION_LINEAR, k2 = ATTENUATION_QUADRATIC;
+        return (std::sqrt(k1 * k1 - 4.0f * k2 * c) - k1) / (2.0f * k2);
+    }
+
 private:
     Light() = default;
 };
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "Light.hpp"
+#include "Parallel.hpp"
+
+// Списки источников по кластерам пирамиды камеры (clustered forward
+// shading, Olsson et al. 2012): экран делится на TILES_X × TILES_Y плиток,
+// глубина — на SLICES слоёв с экспоненциальным шагом (кластер — froxel).
+// Фрагмент обходит только источники своего кластера, так что цена пикселя
+// зависит от того, сколько света до него доходит, а не от числа источников.
+//
+// Раскладка для шейдера (см. ClusterBuffers и default.frag):
+//   lightTexels — по 4 vec4 на источник: (позиция, тип), (направление, range),
+//                 (цвет, интенсивность), (cos cutOff, cos outerCutOff, куб тени, 0);
+//                 сначала направленные (светят везде), потом точечные и прожекторы;
+//   grid        — на кластер пара (начало, число) в indices, кластеры по
+//                 (слой, строка, столбец);
+//   indices     — номера источников в lightTexels.
+class LightClusters {
+public:
+    static constexpr int TILES_X = 16;
+    static constexpr int TILES_Y = 9;
+    static constexpr int SLICES = 24;
+    static constexpr int CLUSTERS = TILES_X * TILES_Y * SLICES;
+    static constexpr int TILES = TILES_X * TILES_Y;
+    // С этого числа источников слои раскладываются по потокам: на меньших
+    // сборка короче запуска потоков.
+    static constexpr size_t PARALLEL_LIGHTS = 256;
+
+    std::vector<glm::vec4> lightTexels;
+    std::vector<uint32_t> grid;
+    std::vector<uint32_t> indices;
+    int globalLights = 0;           // направленные, в начале lightTexels
+    int localLights = 0;
+    // Слой фрагмента: log(глубина) * sliceScale + sliceBias.
+    float sliceScale = 0.0f;
+    float sliceBias = 0.0f;
+    // Третья строка матрицы вида со знаком минус: dot(depthPlane, (p, 1)) —
+    // глубина мировой точки p.
+    glm::vec4 depthPlane = glm::vec4(0.0f);
+    glm::ivec3 size = glm::ivec3(1);  // сетка последнего build: без вида — один кластер
+    size_t maxPerCluster = 0;
+
+    // lights[active[i]] — источники кадра; shadowSlots[j] — куб тени
+    // источника j (-1 — без тени). Перспективная projection; дальняя
+    // граница кластеров — её дальняя плоскость.
+    void build(const std::vector<Light>& lights, const std::vector<size_t>& active,
+               const std::vector<int>& shadowSlots, const glm::mat4& view, const glm::mat4& projection,
+               unsigned threads = 0) {
+        packLights(lights, active, shadowSlots);
+        size = glm::ivec3(TILES_X, TILES_Y, SLICES);
+        setFrustum(projection);
+        depthPlane = -glm::vec4(view[0][2], view[1][2], view[2][2], view[3][2]);
+
+        // Границы каждого источника: слои и прямоугольник плиток по AABB
+        // его сферы в пространстве вида.
+        const size_t count = static_cast<size_t>(localLights);
+        spheres.resize(count);
+        ranges.resize(count);
+        for (std::vector<uint32_t>& bin : sliceLights) bin.clear();
+        for (size_t l = 0; l < count; ++l) {
+            const glm::vec4* texels = &lightTexels[(globalLights + l) * 4];
+            glm::vec3 center = glm::vec3(view * glm::vec4(glm::vec3(texels[0]), 1.0f));
+            float radius = localRadii[l];
+            spheres[l] = glm::vec4(center, radius);
+            Range& r = ranges[l];
+            float depth = -center.z;
+            float nearDepth = std::max(depth - radius, zNear);
+            float farDepth = std::min(depth + radius, zFar);
+            if (nearDepth > farDepth) {
+                r.slice0 = 1;
+                r.slice1 = 0;
+                continue;
+            }
+            r.slice0 = sliceOf(nearDepth);
+            r.slice1 = sliceOf(farDepth);
+            // x/d монотонно по d при постоянном x: крайние значения — в углах.
+            float ndcX[2] = { FLT_MAX, -FLT_MAX }, ndcY[2] = { FLT_MAX, -FLT_MAX };
+            for (float d : { nearDepth, farDepth }) {
+                for (float x : { center.x - radius, center.x + radius }) {
+                    float n = x * scaleX / d - offsetX;
+                    ndcX[0] = std::min(ndcX[0], n);
+                    ndcX[1] = std::max(ndcX[1], n);
+                }
+                for (float y : { center.y - radius, center.y + radius }) {
+                    float n = y * scaleY / d - offsetY;
+                    ndcY[0] = std::min(ndcY[0], n);
+                    ndcY[1] = std::max(ndcY[1], n);
+                }
+            }
+            r.x0 = tileOf(ndcX[0], TILES_X);
+            r.x1 = tileOf(ndcX[1], TILES_X);
+            r.y0 = tileOf(ndcY[0], TILES_Y);
+            r.y1 = tileOf(ndcY[1], TILES_Y);
+            for (int s = r.slice0; s <= r.slice1; ++s) sliceLights[s].push_back(static_cast<uint32_t>(l));
+        }
+
+        // Каждый слой — независимо: свои счётчики и свой кусок indices.
+        unsigned workers = count >= PARALLEL_LIGHTS ? threads : 1;
+        Parallel::forRange(SLICES, workers, 1, [&](size_t begin, size_t end) {
+            for (size_t s = begin; s < end; ++s) fillSlice(static_cast<int>(s));
+        });
+
+        grid.resize(static_cast<size_t>(CLUSTERS) * 2);
+        indices.clear();
+        maxPerCluster = 0;
+        for (int s = 0; s < SLICES; ++s) {
+            const SliceLists& slice = slices[s];
+            uint32_t base = static_cast<uint32_t>(indices.size());
+            indices.insert(indices.end(), slice.indices.begin(), slice.indices.end());
+            for (int t = 0; t < TILES; ++t) {
+                size_t cluster = static_cast<size_t>(s) * TILES + t;
+                grid[cluster * 2] = base + slice.offsets[t];
+                grid[cluster * 2 + 1] = slice.counts[t];
+                maxPerCluster = std::max<size_t>(maxPerCluster, slice.counts[t]);
+            }
+        }
+    }
+
+    // Без вида камеры: один кластер со всеми источниками.
+    void buildUnclustered(const std::vector<Light>& lights, const std::vector<size_t>& active,
+                          const std::vector<int>& shadowSlots) {
+        packLights(lights, active, shadowSlots);
+        size = glm::ivec3(1);
+        sliceScale = 0.0f;
+        sliceBias = 0.0f;
+        depthPlane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        indices.resize(localLights);
+        for (int i = 0; i < localLights; ++i) indices[i] = static_cast<uint32_t>(globalLights + i);
+        grid = { 0u, static_cast<uint32_t>(localLights) };
+        maxPerCluster = static_cast<size_t>(localLights);
+    }
+
+private:
+    struct Range {
+        int slice0 = 0, slice1 = -1;
+        int x0 = 0, x1 = -1, y0 = 0, y1 = -1;
+    };
+
+    // Пары (плитка, источник) слоя раскладываются подсчётом: номера
+    // источников внутри кластера остаются по возрастанию.
+    struct SliceLists {
+        std::array<uint32_t, TILES> counts{};
+        std::array<uint32_t, TILES> offsets{};
+        std::vector<uint32_t> pairs;
+        std::vector<uint32_t> indices;
+    };
+
+    float zNear = 0.1f, zFar = 1000.0f;
+    float scaleX = 1.0f, scaleY = 1.0f, offsetX = 0.0f, offsetY = 0.0f;
+    glm::mat4 cachedProjection = glm::mat4(0.0f);
+    // AABB кластеров в пространстве вида; зависят только от проекции.
+    std::vector<glm::vec3> clusterMin, clusterMax;
+    std::vector<float> localRadii;  // Light::influenceRadius точечных и прожекторов по порядку lightTexels
+    std::vector<glm::vec4> spheres;
+    std::vector<Range> ranges;
+    std::array<std::vector<uint32_t>, SLICES> sliceLights;
+    std::array<SliceLists, SLICES> slices;
+
+    void packLights(const std::vector<Light>& lights, const std::vector<size_t>& active,
+                    const std::vector<int>& shadowSlots) {
+        lightTexels.clear();
+        localRadii.clear();
+        globalLights = 0;
+        localLights = 0;
+        for (int pass = 0; pass < 2; ++pass) {
+            for (size_t i : active) {
+                const Light& light = lights[i];
+                if ((light.type == LightType::DIRECTIONAL) != (pass == 0)) continue;
+                float shadow = i < shadowSlots.size() ? static_cast<float>(shadowSlots[i]) : -1.0f;
+                lightTexels.emplace_back(light.position, static_cast<float>(light.type));
+                lightTexels.emplace_back(light.direction, light.range);
+                lightTexels.emplace_back(light.color, light.intensity);
+                lightTexels.emplace_back(std::cos(glm::radians(light.cutOff)),
+                                         std::cos(glm::radians(light.outerCutOff)), shadow, 0.0f);
+                if (pass == 1) localRadii.push_back(light.influenceRadius());
+                ++(pass == 0 ? globalLights : localLights);
+            }
+        }
+    }
+
+    void setFrustum(const glm::mat4& projection) {
+        if (projection == cachedProjection && !clusterMin.empty()) return;
+        cachedProjection = projection;
+        // Перспективная матрица glm: clip.z = A z + B, clip.w = -z.
+        float a = projection[2][2], b = projection[3][2];
+        zNear = b / (a - 1.0f);
+        zFar = b / (a + 1.0f);
+        scaleX = projection[0][0];
+        scaleY = projection[1][1];
+        // ndc.x = x * scaleX / d - offsetX на глубине d.
+        offsetX = projection[2][0];
+        offsetY = projection[2][1];
+        float logRatio = std::log(zFar / zNear);
+        sliceScale = SLICES / logRatio;
+        sliceBias = -SLICES * std::log(zNear) / logRatio;
+
+        clusterMin.resize(CLUSTERS);
+        clusterMax.resize(CLUSTERS);
+        for (int s = 0; s < SLICES; ++s) {
+            float d0 = zNear * std::pow(zFar / zNear, static_cast<float>(s) / SLICES);
+            float d1 = zNear * std::pow(zFar / zNear, static_cast<float>(s + 1) / SLICES);
+            for (int ty = 0; ty < TILES_Y; ++ty) {
+                for (int tx = 0; tx < TILES_X; ++tx) {
+                    glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+                    for (float d : { d0, d1 }) {
+                        for (int cx = 0; cx < 2; ++cx) {
+                            for (int cy = 0; cy < 2; ++cy) {
+                                float nx = -1.0f + 2.0f * (tx + cx) / TILES_X;
+                                float ny = -1.0f + 2.0f * (ty + cy) / TILES_Y;
+                                glm::vec3 p(d * (nx + offsetX) / scaleX, d * (ny + offsetY) / scaleY, -d);
+                                lo = glm::min(lo, p);
+                                hi = glm::max(hi, p);
+                            }
+                        }
+                    }
+                    size_t cluster = (static_cast<size_t>(s) * TILES_Y + ty) * TILES_X + tx;
+                    clusterMin[cluster] = lo;
+                    clusterMax[cluster] = hi;
+                }
+            }
+        }
+    }
+
+    int sliceOf(float depth) const {
+        int s = static_cast<int>(std::floor(std::log(depth) * sliceScale + sliceBias));
+        return std::clamp(s, 0, SLICES - 1);
+    }
+
+    static int tileOf(float ndc, int tiles) {
+        // Сфера может быть больше всей пирамиды: зажимаем до перевода в int.
+        float t = std::floor((ndc * 0.5f + 0.5f) * tiles);
+        return static_cast<int>(std::clamp(t, 0.0f, static_cast<float>(tiles - 1)));
+    }
+
+    void fillSlice(int s) {
+        SliceLists& slice = slices[s];
+        slice.counts.fill(0);
+        slice.pairs.clear();
+        for (uint32_t l : sliceLights[s]) {
+            const Range& r = ranges[l];
+            glm::vec3 center = glm::vec3(spheres[l]);
+            float r2 = spheres[l].w * spheres[l].w;
+            for (int ty = r.y0; ty <= r.y1; ++ty) {
+                for (int tx = r.x0; tx <= r.x1; ++tx) {
+                    int tile = ty * TILES_X + tx;
+                    size_t cluster = static_cast<size_t>(s) * TILES + tile;
+                    glm::vec3 d = glm::max(glm::max(clusterMin[cluster] - center, center - clusterMax[cluster]),
+                                           glm::vec3(0.0f));
+                    if (glm::dot(d, d) > r2) continue;
+                    slice.pairs.push_back(static_cast<uint32_t>(tile));
+                    slice.pairs.push_back(l);
+                    ++slice.counts[tile];
+                }
+            }
+        }
+        uint32_t offset = 0;
+        for (int t = 0; t < TILES; ++t) {
+            slice.offsets[t] = offset;
+            offset += slice.counts[t];
+        }
+        slice.indices.resize(offset);
+        std::array<uint32_t, TILES> cursor = slice.offsets;
+        for (size_t p = 0; p < slice.pairs.size(); p += 2) {
+            slice.indices[cursor[slice.pairs[p]]++] = static_cast<uint32_t>(globalLights) + slice.pairs[p + 1];
+        }
+    }
+};
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Файл, отображённый в память только для чтения. Данные живут, пока жив объект.
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    explicit MappedFile(const std::string& filepath) {
+        open(filepath);
+    }
+
+    ~MappedFile() {
+        close();
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            ptr = other.ptr;
+            length = other.length;
+#ifdef _WIN32
+            fileHandle = other.fileHandle;
+            mappingHandle = other.mappingHandle;
+            other.fileHandle = INVALID_HANDLE_VALUE;
+            other.mappingHandle = nullptr;
+#endif
+            opened = other.opened;
+            other.ptr = nullptr;
+            other.length = 0;
+            other.opened = false;
+        }
+        return *this;
+    }
+
+    bool open(const std::string& filepath) {
+        close();
+#ifdef _WIN32
+        fileHandle = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                 OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(fileHandle, &fileSize)) {
+            close();
+            return false;
+        }
+        length = static_cast<size_t>(fileSize.QuadPart);
+        opened = true;
+        if (length == 0) {
+            return true;
+        }
+        mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mappingHandle == nullptr) {
+            close();
+            return false;
+        }
+        ptr = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        if (ptr == nullptr) {
+            close();
+            return false;
+        }
+#else
+        int fd = ::open(filepath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        length = static_cast<size_t>(st.st_size);
+        opened = true;
+        if (length > 0) {
+            void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(fd);
+                opened = false;
+                length = 0;
+                return false;
+            }
+            ptr = static_cast<const char*>(mapped);
+            madvise(mapped, length, MADV_SEQUENTIAL);
+        }
+        ::close(fd);
+#endif
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (ptr != nullptr) {
+            UnmapViewOfFile(ptr);
+        }
+        if (mappingHandle != nullptr) {
+            CloseHandle(mappingHandle);
+            mappingHandle = nullptr;
+        }
+        if (fileHandle != INVALID_HANDLE_VALUE) {
+            CloseHandle(fileHandle);
+            fileHandle = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (ptr != nullptr) {
+            munmap(const_cast<char*>(ptr), length);
+        }
+#endif
+        ptr = nullptr;
+        length = 0;
+        opened = false;
+    }
+
+    // Подсказывает ОС, что страницы диапазона больше не нужны (RSS не растёт
+    // при проходе по большому файлу). Данные остаются доступны: при следующем
+    // обращении страницы будут прочитаны заново.
+    void evict(const char* begin, const char* end) const {
+#ifndef _WIN32
+        if (ptr == nullptr || begin >= end) return;
+        static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t from = static_cast<size_t>(begin - ptr) / pageSize * pageSize;
+        size_t to = static_cast<size_t>(end - ptr) / pageSize * pageSize;
+        if (to > from) {
+            madvise(const_cast<char*>(ptr) + from, to - from, MADV_DONTNEED);
+        }
+#else
+        (void)begin;
+        (void)end;
+#endif
+    }
+
+    bool isOpen() const { return opened; }
+    const char* data() const { return ptr; }
+    size_t size() const { return length; }
+    std::string_view view() const { return std::string_view(ptr, length); }
+
+private:
+    const char* ptr = nullptr;
+    size_t length = 0;
+    bool opened = false;
+#ifdef _WIN32
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mappingHandle = nullptr;
+#endif
+};
@@ -1,9 +1,19 @@
 #pragma once
 
 #include <vector>
+#include <memory>
+#include <utility>
+#include <algorithm>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include "Vertex.hpp"
+#include "Bounds.hpp"
+#include "MeshData.hpp"
+#include "MeshCache.hpp"
+#include "Primitives.hpp"
+#include "VertexFormat.hpp"
+#include "GeometryStore.hpp"
+#include "MeshBvh.hpp"
 #include "VAO.hpp"
 #include "VBO.hpp"
 #include "EBO.hpp"
@@ -22,170 +32,362 @@ struct PictureFrameMeshes {
     Mesh* rightBar     = nullptr;
 
     PictureFrameMeshes() = default;
+
+    // Сетки рамки нужны, только чтобы скопировать их в сцену: копии держат
+    // GL-буферы сами.
+    void release();
+};
+
+// GL-объекты сетки. Общие для всех копий Mesh и удаляются вместе с
+// последней из них, поэтому копия Mesh — ещё один экземпляр той же сетки,
+// а не новый буфер. Освобождать нужно, пока жив GL-контекст.
+// У сеток из GeometryStore вместо своих буферов — участок арены, который
+// освобождается так же, с последней копией.
+struct MeshBuffers {
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    GLuint ebo = 0;
+    size_t bytes = 0;   // VBO + EBO
+    std::shared_ptr<GeometryArena> arena;
+    uint32_t block = GeometryArena::NO_BLOCK;
+
+    MeshBuffers(GLuint vertexArray, GLuint vertexBuffer, GLuint elementBuffer, size_t bufferBytes = 0)
+        : vao(vertexArray), vbo(vertexBuffer), ebo(elementBuffer), bytes(bufferBytes) {}
+
+    MeshBuffers(std::shared_ptr<GeometryArena> owner, uint32_t arenaBlock, size_t bufferBytes)
+        : vao(owner->vertexArray()), bytes(bufferBytes), arena(std::move(owner)), block(arenaBlock) {}
+
+    MeshBuffers(const MeshBuffers&) = delete;
+    MeshBuffers& operator=(const MeshBuffers&) = delete;
+
+    ~MeshBuffers() {
+        if (arena) {
+            arena->release(block);
+            return;
+        }
+        if (vbo != 0) glDeleteBuffers(1, &vbo);
+        if (ebo != 0) glDeleteBuffers(1, &ebo);
+        if (vao != 0) glDeleteVertexArrays(1, &vao);
+    }
+
+    // Смещения участка в арене: они меняются при её росте и сжатии.
+    GLint baseVertex() const { return arena ? arena->baseVertex(block) : 0; }
+    size_t indexByteOffset() const { return arena ? arena->indexByteOffset(block) : 0; }
+};
+
+// Участок индексного буфера со своим материалом: части одной модели
+// (usemtl в OBJ) лежат в общих VBO/EBO и рисуются по участкам.
+struct SubMesh {
+    size_t   firstIndex = 0;
+    GLsizei  indexCount = 0;
+    Material material;
+    TextureHandle texture;
+    // Тот же участок на LOD1..n (пусто — у сетки нет уровней).
+    std::vector<MeshLod> lods;
 };
 
 class Mesh {
 public:
-    std::vector<Vertex>   vertices;
-    std::vector<uint32_t> indices;
+    // Копия вершин и индексов на стороне CPU, общая для всех копий Mesh.
+    // После releaseCpuData() пусто: сетка по-прежнему рисуется из GL-буферов.
+    std::shared_ptr<const MeshData> cpuData;
     Material              material;
 
+    Bounds                bounds;
+
+    // У сеток из GeometryStore VAO_id — VAO арены, а VBO_id и EBO_id нули:
+    // буферы арены пересоздаются при росте и сжатии.
     GLuint   VAO_id = 0;
     GLuint   VBO_id = 0;
     GLuint   EBO_id = 0;
-    Texture* texture = nullptr;
+    GLsizei  indexCount = 0;
+    // Индексы не обязательно uint32 с начала EBO: так рисуются сетки,
+    // загруженные прямо из буферов .glb.
+    GLenum   indexType = GL_UNSIGNED_INT;
+    size_t   indexOffset = 0;
+    // Раскладка вершин в VBO и параметры её распаковки для шейдера; CPU-копия
+    // всегда в полном формате Vertex.
+    VertexFormat vertexFormat;
+    VertexDecode decode;
+    TextureHandle texture;
+    // Пусто — вся сетка одного материала. Иначе участки покрывают весь
+    // индексный буфер, так что draw() по-прежнему рисует сетку целиком
+    // (например, в карту теней) одним вызовом.
+    std::vector<SubMesh> submeshes;
+    // Упрощённые уровни LOD1..n; их индексы лежат в том же EBO после LOD0
+    // и ссылаются на те же вершины.
+    std::vector<MeshLod> lods;
+    // Кластеры LOD0 для отсечения по частям; пусто — сетка рисуется целиком.
+    std::vector<Meshlet> meshlets;
+    // Владелец VAO_id/VBO_id/EBO_id; пуст у заглушек и у сеток, чьи буферы
+    // принадлежат кому-то ещё.
+    std::shared_ptr<MeshBuffers> buffers;
+    // BVH треугольников LOD0 (SceneBvh); переживает releaseCpuData().
+    std::shared_ptr<const MeshBvh> bvh;
 
     Mesh() = default;
 
     Mesh(const std::vector<Vertex>& verts,
          const std::vector<uint32_t>& inds,
          const Material& mat = Material::PlasticWhite(),
-         Texture* tex = nullptr)
-        : vertices(verts), indices(inds), material(mat), texture(tex)
+         TextureHandle tex = nullptr)
+        : material(mat), texture(std::move(tex))
+    {
+        auto data = std::make_shared<MeshData>();
+        data->vertices = verts;
+        data->indices = inds;
+        cpuData = std::move(data);
+        bounds = Bounds::fromVertices(cpuData->vertices);
+        buildBvh();
+        setupMesh();
+    }
+
+    // Загрузка из внешней памяти (отображённого кэша или архива): в GL уходят
+    // сами эти указатели, без промежуточного буфера. BVH строится тоже прямо
+    // по ним, так что выбору мышью и запросам к сцене CPU-копия не нужна;
+    // она делается, только если keepCpuCopy.
+    Mesh(const CachedMeshView& view,
+         const Material& mat = Material::PlasticWhite(),
+         TextureHandle tex = nullptr,
+         bool keepCpuCopy = false)
+        : material(mat), bounds(view.bounds), texture(std::move(tex))
+    {
+        lods.assign(view.lods, view.lods + view.lodCount);
+        meshlets.assign(view.meshlets, view.meshlets + view.meshletCount);
+        bvh = view.bvh ? view.bvh : MeshBvh::build(view.vertices, view.indices, view.indexCount);
+        if (keepCpuCopy) {
+            auto data = std::make_shared<MeshData>();
+            view.copyTo(*data);
+            data->bvh = bvh;
+            cpuData = std::move(data);
+        }
+        setupMesh(view.vertices, view.vertexCount, view.indices, view.indexCount,
+                  view.lodIndices, view.lodIndexCount);
+    }
+
+    // Забирает готовые данные загрузчика без копирования.
+    Mesh(MeshData&& data, const Bounds& meshBounds,
+         const Material& mat = Material::PlasticWhite(),
+         TextureHandle tex = nullptr)
+        : cpuData(std::make_shared<MeshData>(std::move(data))),
+          material(mat), bounds(meshBounds), texture(std::move(tex))
     {
+        lods = cpuData->lods;
+        meshlets = cpuData->meshlets;
+        buildBvh();
         setupMesh();
     }
 
-    void addTexture(Texture* tex) {
-        texture = tex;
+    // Пустая сетка (indexCount == 0) ничего не рисует — так выглядит заглушка,
+    // пока данные ещё грузятся в фоне.
+    bool isReady() const {
+        return VAO_id != 0 && indexCount > 0;
+    }
+
+    void addTexture(TextureHandle tex) {
+        texture = std::move(tex);
     }
 
     void setupMesh() {
+        if (!cpuData) return;
+        setupMesh(cpuData->vertices.data(), cpuData->vertices.size(),
+                  cpuData->indices.data(), cpuData->indices.size(),
+                  cpuData->lodIndices.data(), cpuData->lodIndices.size());
+    }
+
+    // Берёт BVH, готовую в MeshData, или строит её по CPU-копии.
+    void buildBvh() {
+        if (!cpuData) return;
+        bvh = cpuData->bvh ? cpuData->bvh : MeshBvh::build(cpuData->vertices, cpuData->indices);
+    }
+
+    bool hasCpuData() const {
+        return cpuData != nullptr;
+    }
+
+    // Отпускает CPU-копию этой сетки; память освобождается, когда её
+    // отпустят все копии.
+    void releaseCpuData() {
+        cpuData.reset();
+    }
+
+    void setupMesh(const Vertex* verts, size_t vertexCount,
+                   const uint32_t* inds, size_t indCount,
+                   const uint32_t* lodInds = nullptr, size_t lodIndCount = 0) {
+        const VertexFormatPolicy& policy = VertexFormatPolicy::global();
+        vertexFormat = VertexFormat::choose(verts, vertexCount, inds, indCount, policy, decode);
+
+        std::vector<unsigned char> packed;
+        if (!vertexFormat.isFull()) packed = vertexFormat.pack(verts, vertexCount, decode);
+        const void* vertexData = packed.empty() ? static_cast<const void*>(verts) : packed.data();
+        size_t vertexBytes = vertexCount * vertexFormat.stride();
+
+        // Сетке меньше чем из 65536 вершин хватает 16-битных индексов.
+        indexType = policy.shortIndices && vertexCount < 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        size_t indexBytes = (indCount + lodIndCount) * indexSize();
+        std::vector<uint16_t> narrow;
+        if (indexType == GL_UNSIGNED_SHORT) {
+            narrow.reserve(indCount + lodIndCount);
+            narrow.insert(narrow.end(), inds, inds + indCount);
+            if (lodIndCount > 0) narrow.insert(narrow.end(), lodInds, lodInds + lodIndCount);
+        }
+        indexCount = static_cast<GLsizei>(indCount);
+        indexOffset = 0;
+
+        GeometryStore& store = GeometryStore::global();
+        if (store.isEnabled() && vertexCount > 0 && indCount > 0) {
+            std::shared_ptr<GeometryArena> arena = store.arena(vertexFormat, indexType);
+            uint32_t block = arena->allocate(vertexCount, indCount + lodIndCount);
+            arena->uploadVertices(block, vertexData);
+            if (!narrow.empty()) {
+                arena->uploadIndices(block, 0, narrow.data(), narrow.size());
+            } else {
+                arena->uploadIndices(block, 0, inds, indCount);
+                arena->uploadIndices(block, indCount, lodInds, lodIndCount);
+            }
+            VAO_id = arena->vertexArray();
+            VBO_id = 0;
+            EBO_id = 0;
+            buffers = std::make_shared<MeshBuffers>(std::move(arena), block, vertexBytes + indexBytes);
+            return;
+        }
+
         VAO vao;
         vao.bind();
 
-        VBO vbo(vertices.data(), vertices.size() * sizeof(Vertex));
-        EBO ebo(indices.data(), indices.size() * sizeof(uint32_t));
+        VBO vbo(vertexData, vertexBytes);
+
+        EBO ebo(!narrow.empty() ? static_cast<const void*>(narrow.data()) : lodIndCount > 0 ? nullptr : inds,
+                indexBytes);
+        if (narrow.empty() && lodIndCount > 0) {
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indCount * sizeof(uint32_t), inds);
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, indCount * sizeof(uint32_t),
+                            lodIndCount * sizeof(uint32_t), lodInds);
+        }
 
-        vao.linkAttrib(vbo, 0, 3, GL_FLOAT, sizeof(Vertex), (void*)offsetof(Vertex, position));
-        vao.linkAttrib(vbo, 1, 3, GL_FLOAT, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-        vao.linkAttrib(vbo, 2, 2, GL_FLOAT, sizeof(Vertex), (void*)offsetof(Vertex, texCoords));
+        vertexFormat.linkAttributes(vao, vbo);
 
         VAO_id = vao.id;
         VBO_id = vbo.id;
         EBO_id = ebo.id;
+        buffers = std::make_shared<MeshBuffers>(vao.id, vbo.id, ebo.id, vertexBytes + indexBytes);
 
         vao.unbind();
         vbo.unbind();
         ebo.unbind();
     }
 
+    size_t indexSize() const {
+        return indexType == GL_UNSIGNED_INT ? 4 : indexType == GL_UNSIGNED_SHORT ? 2 : 1;
+    }
+
     void draw() {
+        draw(0);
+    }
+
+    // Уровень 0 — полная сетка; номер больше последнего даёт самый грубый.
+    void draw(size_t lod) {
+        if (!isReady()) return;
         glBindVertexArray(VAO_id);
-        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, 0);
+        drawLevel(lod);
         glBindVertexArray(0);
     }
 
-    void cleanup() {
-        glDeleteBuffers(1, &VBO_id);
-        glDeleteBuffers(1, &EBO_id);
-        glDeleteVertexArrays(1, &VAO_id);
+    // То же при уже привязанном VAO (bind()): сетки одной арены рисуются
+    // подряд без перепривязки.
+    void drawLevel(size_t lod) const {
+        if (lod == 0 || lods.empty()) {
+            drawRange(0, static_cast<size_t>(indexCount));
+        } else {
+            const MeshLod& level = lods[std::min(lod, lods.size()) - 1];
+            drawRange(level.firstIndex, level.indexCount);
+        }
     }
 
-    
-    static Mesh CreateCube(const Material& mat = Material::PlasticWhite()) {
-        std::vector<Vertex> verts = {
-            
-            Vertex(glm::vec3(-1, -1,  1), glm::vec3(0, 0,  1), glm::vec2(0, 0)),
-            Vertex(glm::vec3( 1, -1,  1), glm::vec3(0, 0,  1), glm::vec2(1, 0)),
-            Vertex(glm::vec3( 1,  1,  1), glm::vec3(0, 0,  1), glm::vec2(1, 1)),
-            Vertex(glm::vec3(-1,  1,  1), glm::vec3(0, 0,  1), glm::vec2(0, 1)),
-
-            
-            Vertex(glm::vec3( 1, -1, -1), glm::vec3(0, 0, -1), glm::vec2(0, 0)),
-            Vertex(glm::vec3(-1, -1, -1), glm::vec3(0, 0, -1), glm::vec2(1, 0)),
-            Vertex(glm::vec3(-1,  1, -1), glm::vec3(0, 0, -1), glm::vec2(1, 1)),
-            Vertex(glm::vec3( 1,  1, -1), glm::vec3(0, 0, -1), glm::vec2(0, 1)),
-
-            
-            Vertex(glm::vec3(-1,  1, -1), glm::vec3(0, 1, 0), glm::vec2(0, 0)),
-            Vertex(glm::vec3(-1,  1,  1), glm::vec3(0, 1, 0), glm::vec2(1, 0)),
-            Vertex(glm::vec3( 1,  1,  1), glm::vec3(0, 1, 0), glm::vec2(1, 1)),
-            Vertex(glm::vec3( 1,  1, -1), glm::vec3(0, 1, 0), glm::vec2(0, 1)),
-
-            
-            Vertex(glm::vec3(-1, -1, -1), glm::vec3(0, -1, 0), glm::vec2(0, 0)),
-            Vertex(glm::vec3( 1, -1, -1), glm::vec3(0, -1, 0), glm::vec2(1, 0)),
-            Vertex(glm::vec3( 1, -1,  1), glm::vec3(0, -1, 0), glm::vec2(1, 1)),
-            Vertex(glm::vec3(-1, -1,  1), glm::vec3(0, -1, 0), glm::vec2(0, 1)),
-
-            
-            Vertex(glm::vec3( 1, -1,  1), glm::vec3(1, 0, 0), glm::vec2(0, 0)),
-            Vertex(glm::vec3( 1, -1, -1), glm::vec3(1, 0, 0), glm::vec2(1, 0)),
-            Vertex(glm::vec3( 1,  1, -1), glm::vec3(1, 0, 0), glm::vec2(1, 1)),
-            Vertex(glm::vec3( 1,  1,  1), glm::vec3(1, 0, 0), glm::vec2(0, 1)),
-
-            
-            Vertex(glm::vec3(-1, -1, -1), glm::vec3(-1, 0, 0), glm::vec2(0, 0)),
-            Vertex(glm::vec3(-1, -1,  1), glm::vec3(-1, 0, 0), glm::vec2(1, 0)),
-            Vertex(glm::vec3(-1,  1,  1), glm::vec3(-1, 0, 0), glm::vec2(1, 1)),
-            Vertex(glm::vec3(-1,  1, -1), glm::vec3(-1, 0, 0), glm::vec2(0, 1))
-        };
-
-        std::vector<uint32_t> inds = {
-            0,  1,  2,  2,  3,  0,   
-            4,  5,  6,  6,  7,  4,   
-            8,  9,  10, 10, 11, 8,   
-            12, 13, 14, 14, 15, 12,  
-            16, 17, 18, 18, 19, 16,  
-            20, 21, 22, 22, 23, 20   
-        };
-
-        return Mesh(verts, inds, mat);
+    size_t lodCount() const {
+        return lods.size() + 1;
     }
 
-    static Mesh CreatePlane(float width, float height,
-                            const Material& mat = Material::PlasticWhite()) {
-        std::vector<Vertex> verts = {
-            Vertex(glm::vec3(-width/2, 0, -height/2), glm::vec3(0, 1, 0), glm::vec2(0, 0)),
-            Vertex(glm::vec3( width/2, 0, -height/2), glm::vec3(0, 1, 0), glm::vec2(1, 0)),
-            Vertex(glm::vec3( width/2, 0,  height/2), glm::vec3(0, 1, 0), glm::vec2(1, 1)),
-            Vertex(glm::vec3(-width/2, 0,  height/2), glm::vec3(0, 1, 0), glm::vec2(0, 1))
-        };
+    float lodError(size_t lod) const {
+        return lod == 0 || lods.empty() ? 0.0f : lods[std::min(lod, lods.size()) - 1].error;
+    }
 
-        std::vector<uint32_t> inds = {0, 1, 2, 2, 3, 0};
+    size_t triangleCount(size_t lod = 0) const {
+        if (lod == 0 || lods.empty()) return static_cast<size_t>(indexCount) / 3;
+        return lods[std::min(lod, lods.size()) - 1].indexCount / 3;
+    }
 
-        return Mesh(verts, inds, mat);
+    // Рисование по участкам: VAO привязывается один раз через bind(),
+    // материал каждого участка выставляет вызывающий.
+    void bind() const {
+        glBindVertexArray(VAO_id);
     }
 
-    static Mesh CreateSphere(float radius, int segments = 32, int rings = 16,
-                             const Material& mat = Material::PlasticWhite()) {
-        std::vector<Vertex>   verts;
-        std::vector<uint32_t> inds;
+    void drawSubMesh(const SubMesh& sub, size_t lod = 0) const {
+        if (lod > 0 && !sub.lods.empty()) {
+            const MeshLod& level = sub.lods[std::min(lod, sub.lods.size()) - 1];
+            drawRange(level.firstIndex, level.indexCount);
+            return;
+        }
+        drawRange(sub.firstIndex, static_cast<size_t>(sub.indexCount));
+    }
 
-        for (int i = 0; i <= rings; ++i) {
-            float phi = glm::pi<float>() * i / rings;
-            for (int j = 0; j <= segments; ++j) {
-                float theta = 2.0f * glm::pi<float>() * j / segments;
+    // count индексов с firstIndex; VAO уже привязан.
+    void drawRange(size_t firstIndex, size_t count) const {
+        glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(count), indexType, indexPointer(firstIndex),
+                                 baseVertex());
+    }
 
-                float x = radius * std::sin(phi) * std::cos(theta);
-                float y = radius * std::cos(phi);
-                float z = radius * std::sin(phi) * std::sin(theta);
+    // Кластеры, лежащие в участке индексов [firstIndex, firstIndex + count):
+    // первый и число.
+    std::pair<size_t, size_t> meshletRange(size_t firstIndex, size_t count) const {
+        auto first = std::lower_bound(meshlets.begin(), meshlets.end(), firstIndex,
+                                      [](const Meshlet& m, size_t index) { return m.firstIndex < index; });
+        auto last = std::lower_bound(first, meshlets.end(), firstIndex + count,
+                                     [](const Meshlet& m, size_t index) { return m.firstIndex < index; });
+        return { static_cast<size_t>(first - meshlets.begin()), static_cast<size_t>(last - first) };
+    }
 
-                glm::vec3 pos(x, y, z);
-                glm::vec3 normal = glm::normalize(pos);
-                glm::vec2 uv((float)j / segments, (float)i / rings);
+    // Смещение индекса firstIndex в EBO, как его ждут glDrawElements*.
+    const void* indexPointer(size_t firstIndex) const {
+        size_t arenaOffset = buffers ? buffers->indexByteOffset() : 0;
+        return (const void*)(indexOffset + arenaOffset + firstIndex * indexSize());
+    }
 
-                verts.emplace_back(pos, normal, uv);
-            }
-        }
+    // Номер первой вершины сетки в VBO: индексы в EBO от него отсчитываются.
+    GLint baseVertex() const {
+        return buffers ? buffers->baseVertex() : 0;
+    }
 
-        for (int i = 0; i < rings; ++i) {
-            for (int j = 0; j < segments; ++j) {
-                uint32_t a = i * (segments + 1) + j;
-                uint32_t b = a + segments + 1;
+    // Отпускает буферы и текстуры этой копии; GL-объекты удаляются вместе
+    // с последней.
+    void cleanup() {
+        buffers.reset();
+        cpuData.reset();
+        bvh.reset();
+        texture.reset();
+        submeshes.clear();
+        lods.clear();
+        meshlets.clear();
+        VAO_id = 0;
+        VBO_id = 0;
+        EBO_id = 0;
+        indexCount = 0;
+    }
 
-                inds.push_back(a);
-                inds.push_back(b);
-                inds.push_back(a + 1);
+    
+    static Mesh CreateCube(const Material& mat = Material::PlasticWhite()) {
+        return fromData(Primitives::Cube(), mat);
+    }
 
-                inds.push_back(a + 1);
-                inds.push_back(b);
-                inds.push_back(b + 1);
-            }
-        }
+    static Mesh CreatePlane(float width, float height,
+                            const Material& mat = Material::PlasticWhite()) {
+        return fromData(Primitives::Plane(width, height), mat);
+    }
 
-        return Mesh(verts, inds, mat);
+    static Mesh CreateSphere(float radius, int segments = 32, int rings = 16,
+                             const Material& mat = Material::PlasticWhite()) {
+        return fromData(Primitives::Sphere(radius, segments, rings), mat);
     }
 
     
@@ -200,36 +402,30 @@ public:
     {
         PictureFrameMeshes res;
 
-        float halfW = width  * 0.5f;
-        float halfH = height * 0.5f;
-        float t     = frameThickness;
-        float d     = frameDepth;
-
-        
-        {
-            std::vector<Vertex>   verts;
-            std::vector<uint32_t> inds = {0,1,2, 2,3,0};
-
-            float z = -d * 0.5f + 0.001f;
-
-            verts.emplace_back(glm::vec3(-halfW + t, -halfH + t, z),
-                               glm::vec3(0,0,1), glm::vec2(0,0));
-            verts.emplace_back(glm::vec3( halfW - t, -halfH + t, z),
-                               glm::vec3(0,0,1), glm::vec2(1,0));
-            verts.emplace_back(glm::vec3( halfW - t,  halfH - t, z),
-                               glm::vec3(0,0,1), glm::vec2(1,1));
-            verts.emplace_back(glm::vec3(-halfW + t,  halfH - t, z),
-                               glm::vec3(0,0,1), glm::vec2(0,1));
-
-            res.picturePlane = new Mesh(verts, inds, pictureMat);
-        }
+        res.picturePlane = new Mesh(fromData(
+            Primitives::PicturePlane(width, height, frameThickness, frameDepth), pictureMat));
 
         
-        res.bottomBar = new Mesh(Mesh::CreateCube(frameMat));
-        res.topBar    = new Mesh(Mesh::CreateCube(frameMat));
-        res.leftBar   = new Mesh(Mesh::CreateCube(frameMat));
-        res.rightBar  = new Mesh(Mesh::CreateCube(frameMat));
+        // Все четыре планки — копии одного куба с общими буферами.
+        Mesh bar = Mesh::CreateCube(frameMat);
+        res.bottomBar = new Mesh(bar);
+        res.topBar    = new Mesh(bar);
+        res.leftBar   = new Mesh(bar);
+        res.rightBar  = new Mesh(bar);
 
         return res;
     }
+
+private:
+    static Mesh fromData(MeshData&& data, const Material& mat) {
+        Bounds meshBounds = Bounds::fromVertices(data.vertices);
+        return Mesh(std::move(data), meshBounds, mat);
+    }
 };
+
+inline void PictureFrameMeshes::release() {
+    for (Mesh** mesh : { &picturePlane, &bottomBar, &topBar, &leftBar, &rightBar }) {
+        delete *mesh;
+        *mesh = nullptr;
+    }
+}
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "Bvh.hpp"
+#include "Vertex.hpp"
+
+// Попадание луча в треугольник сетки.
+struct MeshHit {
+    float    t = FLT_MAX;       // в длинах направления луча
+    uint32_t triangle = 0;      // номер треугольника в индексах LOD0
+    float    u = 0.0f;          // барицентрические координаты при вершинах 1 и 2
+    float    v = 0.0f;
+    glm::vec3 normal = glm::vec3(0.0f);   // нормаль грани (не нормирована)
+};
+
+// BVH над треугольниками LOD0 одной сетки (нижний уровень SceneBvh). Хранит
+// свою копию вершин треугольников в порядке листьев, так что работает и
+// после Mesh::releaseCpuData. Неизменяемый: общий для всех копий сетки.
+class MeshBvh {
+public:
+    static constexpr int STACK_SIZE = 128;   // глубина обхода; SAH-деревья намного мельче
+
+    static std::shared_ptr<const MeshBvh> build(const std::vector<Vertex>& vertices,
+                                                const std::vector<uint32_t>& indices) {
+        return build(vertices.data(), indices.data(), indices.size());
+    }
+
+    // То же по внешней памяти (например, отображённому кэшу сетки).
+    static std::shared_ptr<const MeshBvh> build(const Vertex* vertices, const uint32_t* indices,
+                                                size_t indexCount) {
+        return build(indexCount, [vertices](uint32_t i) { return vertices[i].position; },
+                     [indices](size_t k) { return indices[k]; });
+    }
+
+    // Позиции и индексы через функции: position(i) -> glm::vec3,
+    // index(k) -> uint32_t. Так дерево строится прямо по accessor'ам glTF
+    // в отображении файла, без копии в Vertex.
+    template <typename PositionAt, typename IndexAt>
+    static std::shared_ptr<const MeshBvh> build(size_t indexCount, PositionAt position, IndexAt index) {
+        auto bvh = std::make_shared<MeshBvh>();
+        size_t triangles = indexCount / 3;
+        std::vector<glm::vec3> boxMin(triangles), boxMax(triangles);
+        for (size_t t = 0; t < triangles; ++t) {
+            glm::vec3 a = position(index(t * 3));
+            glm::vec3 b = position(index(t * 3 + 1));
+            glm::vec3 c = position(index(t * 3 + 2));
+            boxMin[t] = glm::min(a, glm::min(b, c));
+            boxMax[t] = glm::max(a, glm::max(b, c));
+        }
+        bvh->tree.build(boxMin, boxMax);
+
+        bvh->corners.reserve(bvh->tree.order.size() * 3);
+        for (uint32_t t : bvh->tree.order) {
+            glm::vec3 a = position(index(t * 3));
+            bvh->corners.push_back(a);
+            bvh->corners.push_back(position(index(t * 3 + 1)) - a);
+            bvh->corners.push_back(position(index(t * 3 + 2)) - a);
+        }
+        return bvh;
+    }
+
+    bool empty() const { return tree.empty(); }
+    size_t triangleCount() const { return tree.order.size(); }
+    size_t nodeCount() const { return tree.nodes.size(); }
+    size_t memoryBytes() const {
+        return tree.nodes.size() * sizeof(BvhNode) + tree.order.size() * sizeof(uint32_t) +
+               corners.size() * sizeof(glm::vec3);
+    }
+
+    // AABB всей сетки (корень).
+    glm::vec3 boundsMin() const { return empty() ? glm::vec3(FLT_MAX) : tree.nodes[0].min; }
+    glm::vec3 boundsMax() const { return empty() ? glm::vec3(-FLT_MAX) : tree.nodes[0].max; }
+
+    // Ближайшее попадание луча origin + t * direction при t в [0, hit.t);
+    // обе стороны треугольника. hit.t на входе — предел дальности.
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, MeshHit& hit) const {
+        if (empty()) return false;
+        glm::vec3 invDir = Bvh::inverseDirection(direction);
+        bool found = false;
+        uint32_t stack[STACK_SIZE];
+        int top = 0;
+        if (Bvh::rayBox(origin, invDir, hit.t, tree.nodes[0].min, tree.nodes[0].max) == FLT_MAX) return false;
+        stack[top++] = 0;
+        while (top > 0) {
+            const BvhNode& node = tree.nodes[stack[--top]];
+            if (node.isLeaf()) {
+                for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                    found |= intersectTriangle(origin, direction, i, hit);
+                }
+                continue;
+            }
+            // Сначала ближний потомок: дальний часто отсекается по hit.t.
+            const BvhNode& left = tree.nodes[node.first];
+            const BvhNode& right = tree.nodes[node.first + 1];
+            float tl = Bvh::rayBox(origin, invDir, hit.t, left.min, left.max);
+            float tr = Bvh::rayBox(origin, invDir, hit.t, right.min, right.max);
+            uint32_t near = node.first, far = node.first + 1;
+            if (tr < tl) {
+                std::swap(tl, tr);
+                std::swap(near, far);
+            }
+            if (tr != FLT_MAX && top < STACK_SIZE) stack[top++] = far;
+            if (tl != FLT_MAX && top < STACK_SIZE) stack[top++] = near;
+        }
+        return found;
+    }
+
+    // Отрезок from → to: hit.t в долях его длины.
+    bool intersectSegment(const glm::vec3& from, const glm::vec3& to, MeshHit& hit) const {
+        hit.t = 1.0f;
+        return raycast(from, to - from, hit);
+    }
+
+    // Треугольники, которые задевает сфера (номера в индексах LOD0).
+    void overlapSphere(const glm::vec3& center, float radius, std::vector<uint32_t>& triangles) const {
+        visitSphere(center, radius, [&](uint32_t i) {
+            triangles.push_back(tree.order[i]);
+            return true;
+        });
+    }
+
+    bool intersectsSphere(const glm::vec3& center, float radius) const {
+        bool found = false;
+        visitSphere(center, radius, [&](uint32_t) {
+            found = true;
+            return false;
+        });
+        return found;
+    }
+
+    // Вершины i-го треугольника в порядке листьев; для SceneBvh.
+    void triangle(uint32_t i, glm::vec3& a, glm::vec3& b, glm::vec3& c) const {
+        a = corners[i * 3];
+        b = a + corners[i * 3 + 1];
+        c = a + corners[i * 3 + 2];
+    }
+
+    // Номер треугольника в индексах LOD0 по номеру в порядке листьев.
+    uint32_t sourceTriangle(uint32_t i) const { return tree.order[i]; }
+
+    // Обход листовых треугольников, чьи AABB-узлы ближе radius к center;
+    // fn(i) получает номер в порядке листьев, false — остановиться.
+    // Без проверки самого треугольника.
+    template <typename Fn>
+    void visitNear(const glm::vec3& center, float radius, Fn&& fn) const {
+        if (empty()) return;
+        float r2 = radius * radius;
+        uint32_t stack[STACK_SIZE];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const BvhNode& node = tree.nodes[stack[--top]];
+            if (Bvh::boxDistanceSquared(center, node.min, node.max) > r2) continue;
+            if (node.isLeaf()) {
+                for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                    if (!fn(i)) return;
+                }
+                continue;
+            }
+            if (top + 1 < STACK_SIZE) {
+                stack[top++] = node.first + 1;
+                stack[top++] = node.first;
+            }
+        }
+    }
+
+    // Ближайшая к p точка треугольника abc (Ericson, Real-Time Collision Detection 5.1.5).
+    static glm::vec3 closestPointOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b,
+                                            const glm::vec3& c) {
+        glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+        float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+        if (d1 <= 0.0f && d2 <= 0.0f) return a;
+        glm::vec3 bp = p - b;
+        float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+        if (d3 >= 0.0f && d4 <= d3) return b;
+        float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return a + ab * (d1 / (d1 - d3));
+        glm::vec3 cp = p - c;
+        float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+        if (d6 >= 0.0f && d5 <= d6) return c;
+        float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return a + ac * (d2 / (d2 - d6));
+        float va = d3 * d6 - d5 * d4;
+        if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+            return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+        }
+        float denom = 1.0f / (va + vb + vc);
+        return a + ab * (vb * denom) + ac * (vc * denom);
+    }
+
+private:
+    Bvh tree;
+    // На треугольник: вершина 0 и рёбра к вершинам 1 и 2 (Möller–Trumbore).
+    std::vector<glm::vec3> corners;
+
+    bool intersectTriangle(const glm::vec3& origin, const glm::vec3& direction, uint32_t i, MeshHit& hit) const {
+        const glm::vec3& v0 = corners[i * 3];
+        const glm::vec3& e1 = corners[i * 3 + 1];
+        const glm::vec3& e2 = corners[i * 3 + 2];
+        glm::vec3 p = glm::cross(direction, e2);
+        float det = glm::dot(e1, p);
+        if (std::abs(det) < 1e-12f) return false;
+        float invDet = 1.0f / det;
+        glm::vec3 s = origin - v0;
+        float u = glm::dot(s, p) * invDet;
+        if (u < 0.0f || u > 1.0f) return false;
+        glm::vec3 q = glm::cross(s, e1);
+        float v = glm::dot(direction, q) * invDet;
+        if (v < 0.0f || u + v > 1.0f) return false;
+        float t = glm::dot(e2, q) * invDet;
+        if (t < 0.0f || t >= hit.t) return false;
+        hit.t = t;
+        hit.triangle = tree.order[i];
+        hit.u = u;
+        hit.v = v;
+        hit.normal = glm::cross(e1, e2);
+        return true;
+    }
+
+    template <typename Fn>
+    void visitSphere(const glm::vec3& center, float radius, Fn&& fn) const {
+        float r2 = radius * radius;
+        visitNear(center, radius, [&](uint32_t i) {
+            glm::vec3 a, b, c;
+            triangle(i, a, b, c);
+            glm::vec3 d = closestPointOnTriangle(center, a, b, c) - center;
+            return glm::dot(d, d) > r2 ? true : fn(i);
+        });
+    }
+};
@@ -0,0 +1,268 @@
+#pragma once
+
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <memory>
+#include <iostream>
+#include "Vertex.hpp"
+#include "Bounds.hpp"
+#include "MeshData.hpp"
+#include "MappedFile.hpp"
+
+// Отпечаток исходного файла и настроек, с которыми из него собрана сетка
+// (MeshCache::settingsKey): кэш действителен, только пока совпадают все поля.
+struct SourceStamp {
+    uint64_t size  = 0;
+    int64_t  mtime = 0;
+    uint64_t hash  = 0;
+    uint32_t settings = 0;
+
+    bool operator==(const SourceStamp& other) const {
+        return size == other.size && mtime == other.mtime && hash == other.hash && settings == other.settings;
+    }
+};
+
+// Вид на загруженный кэш. Указатели смотрят прямо в отображённый файл.
+struct CachedMeshView {
+    const Vertex*   vertices    = nullptr;
+    size_t          vertexCount = 0;
+    const uint32_t* indices     = nullptr;
+    size_t          indexCount  = 0;
+    Bounds          bounds;
+    // LOD1..n: индексы сразу за индексами LOD0 и таблица уровней.
+    const uint32_t* lodIndices    = nullptr;
+    size_t          lodIndexCount = 0;
+    const MeshLod*  lods          = nullptr;
+    size_t          lodCount      = 0;
+    const Meshlet*  meshlets      = nullptr;
+    size_t          meshletCount  = 0;
+    // BVH, если её уже построил рабочий поток загрузчика; иначе Mesh строит
+    // её сам. Как и MeshData::bvh, в кэш не пишется.
+    std::shared_ptr<const MeshBvh> bvh;
+
+    // Копия в MeshData; нормали в кэше и архиве всегда уже есть.
+    void copyTo(MeshData& data) const {
+        data.vertices.assign(vertices, vertices + vertexCount);
+        data.indices.assign(indices, indices + indexCount);
+        data.lodIndices.assign(lodIndices, lodIndices + lodIndexCount);
+        data.lods.assign(lods, lods + lodCount);
+        data.meshlets.assign(meshlets, meshlets + meshletCount);
+        data.hasNormals = true;
+    }
+};
+
+// Бинарный кэш готовой сетки рядом с исходником: <model>.obj.<ключ настроек>.meshcache,
+// так что сетки одного файла с разными настройками не вытесняют друг друга.
+class MeshCache {
+public:
+    static constexpr uint32_t VERSION = 5;   // 2: сетки после MeshOptimizer, 3: уровни LOD, 4: кластеры,
+                                             // 5: настройки сборки в заголовке
+
+    static std::string pathFor(const std::string& sourcePath, uint32_t settings) {
+        char key[16];
+        std::snprintf(key, sizeof(key), "%08x", settings);
+        return sourcePath + "." + key + ".meshcache";
+    }
+
+    // Всё, от чего зависит содержимое готовой сетки, кроме исходника (см.
+    // ModelLoadOptions): взвешивание нормалей, оптимизация, число LOD, кластеры.
+    // Упаковано без потерь, так что разные настройки дают разные ключи.
+    static uint32_t settingsKey(uint32_t normalWeighting, bool optimize, uint32_t lodLevels, bool meshlets) {
+        return (normalWeighting & 0xFFu) | (optimize ? 1u << 8 : 0u) | (meshlets ? 1u << 9 : 0u) |
+               (std::min(lodLevels, 0xFFFFu) << 16);
+    }
+
+    static SourceStamp stamp(const std::string& sourcePath, const MappedFile& source, uint32_t settings) {
+        return stamp(sourcePath, source.data(), source.size(), settings);
+    }
+
+    static SourceStamp stamp(const std::string& sourcePath, const char* data, size_t size, uint32_t settings) {
+        SourceStamp s;
+        s.size = size;
+        s.settings = settings;
+        s.mtime = modifiedTime(sourcePath);
+        s.hash = hashBytes(data, size);
+        return s;
+    }
+
+    // Время изменения файла в тиках file_clock; 0, если файла нет.
+    static int64_t modifiedTime(const std::string& path) {
+        std::error_code ec;
+        auto time = std::filesystem::last_write_time(path, ec);
+        return ec ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+    }
+
+    // Открывает кэш и проверяет его по отпечатку исходника. При успехе cacheFile
+    // остаётся открытым и view указывает в него.
+    static bool load(const std::string& cachePath, const SourceStamp& source,
+                     MappedFile& cacheFile, CachedMeshView& view) {
+        if (!cacheFile.open(cachePath)) {
+            return false;
+        }
+        if (cacheFile.size() < sizeof(Header)) {
+            cacheFile.close();
+            return false;
+        }
+
+        Header header;
+        std::memcpy(&header, cacheFile.data(), sizeof(Header));
+        if (std::memcmp(header.magic, MAGIC, 4) != 0 ||
+            header.version != VERSION ||
+            header.vertexStride != sizeof(Vertex) ||
+            header.sourceSize != source.size ||
+            header.sourceMtime != source.mtime ||
+            header.sourceHash != source.hash ||
+            header.settings != source.settings) {
+            cacheFile.close();
+            return false;
+        }
+
+        size_t vertexBytes = header.vertexCount * sizeof(Vertex);
+        size_t indexBytes = header.indexCount * sizeof(uint32_t);
+        size_t lodIndexBytes = header.lodIndexCount * sizeof(uint32_t);
+        size_t lodBytes = header.lodCount * sizeof(MeshLod);
+        size_t meshletBytes = header.meshletCount * sizeof(Meshlet);
+        if (cacheFile.size() != sizeof(Header) + vertexBytes + indexBytes + lodIndexBytes + lodBytes + meshletBytes) {
+            cacheFile.close();
+            return false;
+        }
+
+        const char* payload = cacheFile.data() + sizeof(Header);
+        view.vertices = reinterpret_cast<const Vertex*>(payload);
+        view.vertexCount = header.vertexCount;
+        view.indices = reinterpret_cast<const uint32_t*>(payload + vertexBytes);
+        view.indexCount = header.indexCount;
+        view.lodIndices = reinterpret_cast<const uint32_t*>(payload + vertexBytes + indexBytes);
+        view.lodIndexCount = header.lodIndexCount;
+        view.lods = reinterpret_cast<const MeshLod*>(payload + vertexBytes + indexBytes + lodIndexBytes);
+        view.lodCount = header.lodCount;
+        view.meshlets = reinterpret_cast<const Meshlet*>(payload + vertexBytes + indexBytes + lodIndexBytes + lodBytes);
+        view.meshletCount = header.meshletCount;
+        view.bounds.min = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+        view.bounds.max = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+        return true;
+    }
+
+    // Пишет во временный файл и переименовывает, чтобы параллельный запуск
+    // никогда не увидел наполовину записанный кэш.
+    static bool write(const std::string& cachePath, const MeshData& data,
+                      const Bounds& bounds, const SourceStamp& source) {
+        Header header{};
+        std::memcpy(header.magic, MAGIC, 4);
+        header.version = VERSION;
+        header.vertexStride = sizeof(Vertex);
+        header.sourceSize = source.size;
+        header.sourceMtime = source.mtime;
+        header.sourceHash = source.hash;
+        header.settings = source.settings;
+        header.vertexCount = data.vertices.size();
+        header.indexCount = data.indices.size();
+        header.lodIndexCount = data.lodIndices.size();
+        header.lodCount = data.lods.size();
+        header.meshletCount = data.meshlets.size();
+        header.boundsMin[0] = bounds.min.x; header.boundsMin[1] = bounds.min.y; header.boundsMin[2] = bounds.min.z;
+        header.boundsMax[0] = bounds.max.x; header.boundsMax[1] = bounds.max.y; header.boundsMax[2] = bounds.max.z;
+
+        std::string tmpPath = cachePath + ".tmp";
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) {
+                std::cerr << "Failed to write mesh cache: " << cachePath << std::endl;
+                return false;
+            }
+            out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+            out.write(reinterpret_cast<const char*>(data.vertices.data()),
+                      data.vertices.size() * sizeof(Vertex));
+            out.write(reinterpret_cast<const char*>(data.indices.data()),
+                      data.indices.size() * sizeof(uint32_t));
+            out.write(reinterpret_cast<const char*>(data.lodIndices.data()),
+                      data.lodIndices.size() * sizeof(uint32_t));
+            out.write(reinterpret_cast<const char*>(data.lods.data()),
+                      data.lods.size() * sizeof(MeshLod));
+            out.write(reinterpret_cast<const char*>(data.meshlets.data()),
+                      data.meshlets.size() * sizeof(Meshlet));
+            if (!out.good()) {
+                out.close();
+                std::filesystem::remove(tmpPath);
+                std::cerr << "Failed to write mesh cache: " << cachePath << std::endl;
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tmpPath, cachePath, ec);
+        if (ec) {
+            std::filesystem::remove(tmpPath, ec);
+            std::cerr << "Failed to write mesh cache: " << cachePath << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Быстрый 64-битный хеш содержимого (4 независимые полосы по 8 байт).
+    static uint64_t hashBytes(const void* data, size_t size) {
+        const uint64_t P1 = 0x9E3779B185EBCA87ull;
+        const uint64_t P2 = 0xC2B2AE3D27D4EB4Full;
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        const unsigned char* end = p + size;
+
+        uint64_t lanes[4] = { P1, P2, P1 ^ P2, P2 - P1 };
+        while (end - p >= 32) {
+            for (int i = 0; i < 4; ++i) {
+                uint64_t word;
+                std::memcpy(&word, p + i * 8, 8);
+                lanes[i] = rotl(lanes[i] + word * P2, 31) * P1;
+            }
+            p += 32;
+        }
+
+        uint64_t h = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+        h ^= static_cast<uint64_t>(size) * P1;
+        while (end - p >= 8) {
+            uint64_t word;
+            std::memcpy(&word, p, 8);
+            h = rotl(h ^ (word * P2), 27) * P1 + P2;
+            p += 8;
+        }
+        while (p < end) {
+            h = rotl(h ^ (*p * P1), 11) * P2;
+            ++p;
+        }
+
+        h ^= h >> 33;
+        h *= P2;
+        h ^= h >> 29;
+        h *= P1;
+        h ^= h >> 32;
+        return h;
+    }
+
+private:
+    static constexpr char MAGIC[4] = { 'M', 'S', 'H', 'C' };
+
+    struct Header {
+        char     magic[4];
+        uint32_t version;
+        uint32_t vertexStride;
+        uint32_t settings;      // settingsKey
+        uint64_t sourceSize;
+        int64_t  sourceMtime;
+        uint64_t sourceHash;
+        uint64_t vertexCount;
+        uint64_t indexCount;
+        float    boundsMin[3];
+        float    boundsMax[3];
+        uint64_t lodIndexCount;
+        uint64_t lodCount;
+        uint64_t meshletCount;
+    };
+
+    static uint64_t rotl(uint64_t x, int r) {
+        return (x << r) | (x >> (64 - r));
+    }
+};
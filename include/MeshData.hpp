@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include <glm/glm.hpp>
+#include "Vertex.hpp"
+
+class MeshBvh;
+
+// Упрощённый уровень детализации: участок индексного буфера над теми же
+// вершинами, что и у полной сетки.
+struct MeshLod {
+    uint32_t firstIndex = 0;   // от начала EBO: уровни лежат сразу за индексами LOD0
+    uint32_t indexCount = 0;
+    float    error = 0.0f;     // геометрическая ошибка в единицах модели
+};
+
+// Кластер LOD0: подряд идущие треугольники участка индексного буфера со
+// сферой-оболочкой и конусом нормалей. Если направление взгляда на кластер
+// лежит внутри конуса, все его треугольники смотрят от камеры.
+struct Meshlet {
+    uint32_t  firstIndex = 0;       // от начала EBO
+    uint32_t  indexCount = 0;
+    glm::vec3 center = glm::vec3(0.0f);
+    float     radius = 0.0f;
+    glm::vec3 coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+    float     coneCutoff = 1.0f;    // 1 — нормали слишком разные, конус ничего не отсекает
+};
+
+// Геометрия на стороне CPU, ещё не загруженная в GL-буферы.
+struct MeshData {
+    std::vector<Vertex>   vertices;
+    std::vector<uint32_t> indices;
+    bool hasNormals = false;
+    // LOD1..n (LOD0 — сами indices). lodIndices загружаются в EBO после indices.
+    std::vector<uint32_t> lodIndices;
+    std::vector<MeshLod>  lods;
+    // Кластеры LOD0 (пусто — сетка рисуется целиком); indices упорядочены по ним.
+    std::vector<Meshlet>  meshlets;
+    // BVH треугольников LOD0 для запросов к сцене; строится в рабочем потоке
+    // загрузчика, иначе в Mesh. В кэш не пишется.
+    std::shared_ptr<const MeshBvh> bvh;
+};
@@ -0,0 +1,436 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <glm/glm.hpp>
+#include "Vertex.hpp"
+#include "MeshData.hpp"
+#include "ObjParser.hpp"
+
+// ACMR — промахи кэша на треугольник (от 0.5 у идеальной сетки до 3),
+// ATVR — промахи на уникальную вершину (1.0 — каждая вершина обработана один раз).
+struct MeshOptimizeStats {
+    float acmrBefore = 0.0f;
+    float acmrAfter  = 0.0f;
+    float atvrBefore = 0.0f;
+    float atvrAfter  = 0.0f;
+    size_t welded     = 0;   // слитых вершин-дубликатов
+    size_t degenerate = 0;   // выброшенных вырожденных треугольников
+};
+
+// Оптимизация сетки после загрузки. Первые два прохода меняют наборы:
+// weld сливает побайтно одинаковые вершины, removeDegenerate выбрасывает
+// треугольники с повторяющимися индексами или совпадающими позициями (и
+// сжимает участки материалов). Остальные только переставляют: треугольники —
+// под кэш вершин (алгоритм Форсайта) и под перерисовку, вершины — по первому
+// использованию (попутно уходят вершины, на которые больше нет ссылок).
+// Участки материалов (usemtl) переставляются каждый внутри себя.
+class MeshOptimizer {
+public:
+    static constexpr size_t CACHE_SIZE = 32;          // модель кэша для оптимизации
+    static constexpr size_t STATS_CACHE_SIZE = 16;    // FIFO для ACMR/ATVR
+    static constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+    static MeshOptimizeStats optimize(MeshData& data, std::vector<ObjMaterialRange>* ranges = nullptr) {
+        MeshOptimizeStats stats;
+        if (data.indices.size() < 3) return stats;
+
+        stats.acmrBefore = acmr(data.indices, data.vertices.size());
+        stats.atvrBefore = atvr(data.indices, data.vertices.size());
+
+        stats.welded = weld(data.vertices, data.indices);
+        stats.degenerate = removeDegenerate(data.vertices, data.indices, ranges);
+
+        forEachRange(data.indices, ranges, [&](uint32_t* indices, size_t count) {
+            optimizeVertexCache(indices, count, data.vertices.size());
+            optimizeOverdraw(indices, count, data.vertices, OVERDRAW_THRESHOLD);
+        });
+        optimizeVertexFetch(data.vertices, data.indices);
+
+        stats.acmrAfter = acmr(data.indices, data.vertices.size());
+        stats.atvrAfter = atvr(data.indices, data.vertices.size());
+        return stats;
+    }
+
+    // Сливает побайтно одинаковые вершины. Возвращает число слитых.
+    // Таблица с открытой адресацией, как VertexDedupTable, но ключ — сама вершина.
+    static size_t weld(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+        constexpr uint32_t EMPTY = UINT32_MAX;
+        size_t capacity = 64;
+        while (capacity * 7 < vertices.size() * 10) capacity <<= 1;
+        std::vector<uint32_t> table(capacity, EMPTY);
+        const size_t mask = capacity - 1;
+
+        std::vector<uint32_t> remap(vertices.size());
+        std::vector<Vertex> welded;
+        welded.reserve(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            size_t slot = hashVertex(vertices[i]) & mask;
+            while (table[slot] != EMPTY &&
+                   std::memcmp(&welded[table[slot]], &vertices[i], sizeof(Vertex)) != 0) {
+                slot = (slot + 1) & mask;
+            }
+            if (table[slot] == EMPTY) {
+                table[slot] = static_cast<uint32_t>(welded.size());
+                welded.push_back(vertices[i]);
+            }
+            remap[i] = table[slot];
+        }
+
+        size_t removed = vertices.size() - welded.size();
+        if (removed == 0) return 0;
+        for (uint32_t& index : indices) index = remap[index];
+        vertices = std::move(welded);
+        return removed;
+    }
+
+    // Треугольники с повторяющимися индексами или совпадающими позициями
+    // не дают ни одного пикселя. Участки материалов сдвигаются соответственно.
+    static size_t removeDegenerate(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+                                   std::vector<ObjMaterialRange>* ranges = nullptr) {
+        auto degenerate = [&](size_t t) {
+            uint32_t a = indices[t], b = indices[t + 1], c = indices[t + 2];
+            if (a == b || b == c || a == c) return true;
+            const glm::vec3& pa = vertices[a].position;
+            const glm::vec3& pb = vertices[b].position;
+            const glm::vec3& pc = vertices[c].position;
+            return pa == pb || pb == pc || pa == pc;
+        };
+
+        size_t out = 0;
+        auto compact = [&](size_t begin, size_t end) {
+            for (size_t t = begin; t + 2 < end; t += 3) {
+                if (degenerate(t)) continue;
+                indices[out] = indices[t];
+                indices[out + 1] = indices[t + 1];
+                indices[out + 2] = indices[t + 2];
+                out += 3;
+            }
+        };
+
+        if (ranges && !ranges->empty()) {
+            for (ObjMaterialRange& range : *ranges) {
+                size_t first = out;
+                compact(range.indexOffset, range.indexOffset + range.indexCount);
+                range.indexOffset = static_cast<uint32_t>(first);
+                range.indexCount = static_cast<uint32_t>(out - first);
+            }
+            ranges->erase(std::remove_if(ranges->begin(), ranges->end(),
+                                         [](const ObjMaterialRange& r) { return r.indexCount == 0; }),
+                          ranges->end());
+        } else {
+            compact(0, indices.size());
+        }
+
+        size_t removed = (indices.size() - out) / 3;
+        indices.resize(out);
+        return removed;
+    }
+
+    // Форсайт, "Linear-Speed Vertex Cache Optimisation": жадно выбирается
+    // треугольник с наибольшей суммой оценок вершин; оценка растёт у вершин,
+    // недавно попавших в кэш, и у вершин с малым числом оставшихся треугольников.
+    static void optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount) {
+        const size_t triangleCount = indexCount / 3;
+        if (triangleCount < 2) return;
+
+        // Смежность вершина -> треугольники (CSR); live — ещё не выданные.
+        std::vector<uint32_t> live(vertexCount, 0);
+        for (size_t i = 0; i < triangleCount * 3; ++i) ++live[indices[i]];
+        std::vector<uint32_t> offsets(vertexCount + 1, 0);
+        for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] = offsets[v] + live[v];
+        std::vector<uint32_t> adjacency(triangleCount * 3);
+        {
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < triangleCount * 3; ++i) {
+                adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        std::vector<int> cachePosition(vertexCount, -1);
+        std::vector<float> vertexScore(vertexCount);
+        for (size_t v = 0; v < vertexCount; ++v) vertexScore[v] = score(-1, live[v]);
+
+        std::vector<float> triangleScore(triangleCount);
+        for (size_t t = 0; t < triangleCount; ++t) {
+            triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] +
+                               vertexScore[indices[t * 3 + 2]];
+        }
+
+        std::vector<uint8_t> emitted(triangleCount, 0);
+        std::vector<uint32_t> result;
+        result.reserve(triangleCount * 3);
+
+        std::vector<uint32_t> cache, next;
+        cache.reserve(CACHE_SIZE + 3);
+        next.reserve(CACHE_SIZE + 3);
+
+        size_t cursor = 0;
+        int64_t best = 0;
+        while (best >= 0) {
+            const uint32_t* tri = indices + best * 3;
+            emitted[best] = 1;
+            result.insert(result.end(), tri, tri + 3);
+
+            // Новый порядок кэша: вершины треугольника впереди.
+            next.assign(tri, tri + 3);
+            for (uint32_t v : cache) {
+                if (v != tri[0] && v != tri[1] && v != tri[2]) next.push_back(v);
+            }
+
+            for (int k = 0; k < 3; ++k) {
+                uint32_t v = tri[k];
+                uint32_t* begin = adjacency.data() + offsets[v];
+                uint32_t* end = begin + live[v];
+                uint32_t* found = std::find(begin, end, static_cast<uint32_t>(best));
+                if (found != end) {
+                    *found = end[-1];
+                    --live[v];
+                }
+            }
+
+            // Вытесненные вершины теряют позицию, остальные получают новую;
+            // оценки их треугольников сдвигаются на изменение оценки вершины.
+            auto rescore = [&](uint32_t v, int position) {
+                cachePosition[v] = position;
+                float updated = score(position, live[v]);
+                float delta = updated - vertexScore[v];
+                vertexScore[v] = updated;
+                const uint32_t* adj = adjacency.data() + offsets[v];
+                for (uint32_t j = 0; j < live[v]; ++j) triangleScore[adj[j]] += delta;
+            };
+            for (size_t i = CACHE_SIZE; i < next.size(); ++i) rescore(next[i], -1);
+            if (next.size() > CACHE_SIZE) next.resize(CACHE_SIZE);
+
+            best = -1;
+            float bestScore = -1.0f;
+            for (size_t i = 0; i < next.size(); ++i) {
+                uint32_t v = next[i];
+                rescore(v, static_cast<int>(i));
+                const uint32_t* adj = adjacency.data() + offsets[v];
+                for (uint32_t j = 0; j < live[v]; ++j) {
+                    if (triangleScore[adj[j]] > bestScore) {
+                        bestScore = triangleScore[adj[j]];
+                        best = adj[j];
+                    }
+                }
+            }
+            std::swap(cache, next);
+
+            // Тупик: в кэше не осталось вершин с невыданными треугольниками.
+            if (best < 0) {
+                while (cursor < triangleCount && emitted[cursor]) ++cursor;
+                if (cursor < triangleCount) best = static_cast<int64_t>(cursor);
+            }
+        }
+
+        std::copy(result.begin(), result.end(), indices);
+    }
+
+    // Как в meshoptimizer: треугольники, уже упорядоченные под кэш, режутся на
+    // кластеры там, где кэш всё равно сбрасывается (жёсткие границы) или где
+    // ACMR от начала кластера не хуже threshold * ACMR всего куска (мягкие).
+    // Кластеры, смотрящие наружу от центра сетки, рисуются первыми и закрывают
+    // собой остальные, а порядок внутри кластера сохраняет попадания в кэш.
+    static void optimizeOverdraw(uint32_t* indices, size_t indexCount, const std::vector<Vertex>& vertices,
+                                 float threshold) {
+        const size_t triangleCount = indexCount / 3;
+        if (triangleCount < 2) return;
+
+        FifoCache cache(vertices.size(), STATS_CACHE_SIZE);
+        std::vector<uint32_t> hard;
+        for (size_t t = 0; t < triangleCount; ++t) {
+            if (cache.triangleMisses(indices + t * 3) == 3) hard.push_back(static_cast<uint32_t>(t));
+        }
+        if (hard.empty() || hard[0] != 0) hard.insert(hard.begin(), 0);
+        hard.push_back(static_cast<uint32_t>(triangleCount));
+
+        std::vector<uint32_t> clusters;
+        for (size_t h = 0; h + 1 < hard.size(); ++h) {
+            size_t begin = hard[h], end = hard[h + 1];
+            size_t total = 0;
+            cache.reset();
+            for (size_t t = begin; t < end; ++t) total += cache.triangleMisses(indices + t * 3);
+            float limit = threshold * static_cast<float>(total) / static_cast<float>(end - begin);
+
+            cache.reset();
+            size_t start = begin, misses = 0;
+            clusters.push_back(static_cast<uint32_t>(begin));
+            for (size_t t = begin; t < end; ++t) {
+                misses += cache.triangleMisses(indices + t * 3);
+                float current = static_cast<float>(misses) / static_cast<float>(t - start + 1);
+                if (t + 1 < end && current <= limit) {
+                    clusters.push_back(static_cast<uint32_t>(t + 1));
+                    cache.reset();
+                    start = t + 1;
+                    misses = 0;
+                }
+            }
+        }
+        clusters.push_back(static_cast<uint32_t>(triangleCount));
+
+        // Центр сетки — среднее центров треугольников с весом площади.
+        glm::vec3 meshCenter(0.0f);
+        float meshArea = 0.0f;
+        for (size_t t = 0; t < triangleCount; ++t) {
+            glm::vec3 n;
+            glm::vec3 c = triangle(indices + t * 3, vertices, n);
+            float area = glm::length(n);
+            meshCenter += c * area;
+            meshArea += area;
+        }
+        if (meshArea > 0.0f) meshCenter /= meshArea;
+
+        const size_t clusterCount = clusters.size() - 1;
+        std::vector<float> sortKey(clusterCount);
+        for (size_t k = 0; k < clusterCount; ++k) {
+            glm::vec3 center(0.0f), normal(0.0f);
+            float area = 0.0f;
+            for (size_t t = clusters[k]; t < clusters[k + 1]; ++t) {
+                glm::vec3 n;
+                glm::vec3 c = triangle(indices + t * 3, vertices, n);
+                float a = glm::length(n);
+                center += c * a;
+                normal += n;
+                area += a;
+            }
+            float length = glm::length(normal);
+            sortKey[k] = (area > 0.0f && length > 0.0f)
+                ? glm::dot(center / area - meshCenter, normal / length)
+                : 0.0f;
+        }
+
+        std::vector<uint32_t> order(clusterCount);
+        std::iota(order.begin(), order.end(), 0u);
+        std::stable_sort(order.begin(), order.end(),
+                         [&](uint32_t a, uint32_t b) { return sortKey[a] > sortKey[b]; });
+
+        std::vector<uint32_t> result;
+        result.reserve(triangleCount * 3);
+        for (uint32_t k : order) {
+            result.insert(result.end(), indices + clusters[k] * 3, indices + clusters[k + 1] * 3);
+        }
+        std::copy(result.begin(), result.end(), indices);
+    }
+
+    // Вершины переставляются в порядке первого появления в индексах, чтобы
+    // выборка из VBO шла почти последовательно. Неиспользуемые выбрасываются.
+    static void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+        constexpr uint32_t UNUSED = UINT32_MAX;
+        std::vector<uint32_t> remap(vertices.size(), UNUSED);
+        std::vector<Vertex> ordered;
+        ordered.reserve(vertices.size());
+        for (uint32_t& index : indices) {
+            if (remap[index] == UNUSED) {
+                remap[index] = static_cast<uint32_t>(ordered.size());
+                ordered.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+        vertices = std::move(ordered);
+    }
+
+    static float acmr(const std::vector<uint32_t>& indices, size_t vertexCount) {
+        return acmr(indices.data(), indices.size(), vertexCount);
+    }
+
+    static float acmr(const uint32_t* indices, size_t indexCount, size_t vertexCount) {
+        size_t triangles = indexCount / 3;
+        if (triangles == 0) return 0.0f;
+        return static_cast<float>(simulateMisses(indices, triangles * 3, vertexCount)) / triangles;
+    }
+
+    static float atvr(const std::vector<uint32_t>& indices, size_t vertexCount) {
+        std::vector<uint8_t> used(vertexCount, 0);
+        size_t unique = 0;
+        for (uint32_t index : indices) {
+            if (!used[index]) {
+                used[index] = 1;
+                ++unique;
+            }
+        }
+        if (unique == 0) return 0.0f;
+        return static_cast<float>(simulateMisses(indices.data(), indices.size() / 3 * 3, vertexCount)) / unique;
+    }
+
+private:
+    // FNV-1a по байтам вершины; в Vertex нет выравнивающих пропусков.
+    static size_t hashVertex(const Vertex& v) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&v);
+        uint64_t h = 14695981039346656037ull;
+        for (size_t i = 0; i < sizeof(Vertex); ++i) {
+            h = (h ^ bytes[i]) * 1099511628211ull;
+        }
+        return static_cast<size_t>(h);
+    }
+
+    // FIFO-кэш по отметкам времени: вершина в кэше, если её добавили
+    // не раньше, чем size добавлений назад.
+    struct FifoCache {
+        std::vector<uint32_t> stamps;
+        uint32_t time;
+        uint32_t size;
+
+        FifoCache(size_t vertexCount, size_t cacheSize)
+            : stamps(vertexCount, 0), time(static_cast<uint32_t>(cacheSize) + 1),
+              size(static_cast<uint32_t>(cacheSize)) {}
+
+        bool access(uint32_t v) {
+            if (time - stamps[v] <= size) return false;
+            stamps[v] = time++;
+            return true;
+        }
+
+        unsigned triangleMisses(const uint32_t* tri) {
+            return access(tri[0]) + access(tri[1]) + access(tri[2]);
+        }
+
+        void reset() { time += size + 1; }
+    };
+
+    static size_t simulateMisses(const uint32_t* indices, size_t indexCount, size_t vertexCount) {
+        FifoCache cache(vertexCount, STATS_CACHE_SIZE);
+        size_t misses = 0;
+        for (size_t i = 0; i < indexCount; ++i) misses += cache.access(indices[i]);
+        return misses;
+    }
+
+    // Оценка вершины у Форсайта: -1 — у вершины не осталось треугольников.
+    static float score(int cachePosition, uint32_t liveTriangles) {
+        if (liveTriangles == 0) return -1.0f;
+        float value = 0.0f;
+        if (cachePosition >= 0) {
+            if (cachePosition < 3) {
+                value = 0.75f;
+            } else {
+                float scaled = 1.0f - static_cast<float>(cachePosition - 3) / (CACHE_SIZE - 3);
+                value = std::pow(scaled, 1.5f);
+            }
+        }
+        return value + 2.0f / std::sqrt(static_cast<float>(liveTriangles));
+    }
+
+    // Центр треугольника; в normal — ненормированная нормаль (длина = 2 * площадь).
+    static glm::vec3 triangle(const uint32_t* tri, const std::vector<Vertex>& vertices, glm::vec3& normal) {
+        const glm::vec3& a = vertices[tri[0]].position;
+        const glm::vec3& b = vertices[tri[1]].position;
+        const glm::vec3& c = vertices[tri[2]].position;
+        normal = glm::cross(b - a, c - a);
+        return (a + b + c) / 3.0f;
+    }
+
+    template <typename Fn>
+    static void forEachRange(std::vector<uint32_t>& indices, std::vector<ObjMaterialRange>* ranges, Fn&& fn) {
+        if (ranges && !ranges->empty()) {
+            for (const ObjMaterialRange& range : *ranges) {
+                fn(indices.data() + range.indexOffset, range.indexCount);
+            }
+        } else {
+            fn(indices.data(), indices.size());
+        }
+    }
+};
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <iostream>
+#include "Mesh.hpp"
+#include "MeshData.hpp"
+#include "Material.hpp"
+#include "Texture.hpp"
+#include "Primitives.hpp"
+#include "ModelLoader.hpp"
+#include "AssetArchive.hpp"
+
+struct MeshRegistryStats {
+    size_t entries   = 0;   // ключи, у которых ещё есть живые копии
+    size_t hits      = 0;   // выдано без новой загрузки
+    size_t misses    = 0;   // загружено или построено заново
+    size_t cpuBytes  = 0;   // CPU-копии вершин и индексов живых сеток
+    size_t gpuBytes  = 0;   // их VBO + EBO
+};
+
+// Реестр общих сеток: одинаковые загрузки и одинаковые примитивы получают
+// одни GL-буферы и одну CPU-копию. Записи хранят только слабые ссылки, так
+// что сетка живёт, пока жива хоть одна её копия в сцене, и после этого
+// строится заново. Материал и текстура у каждой выданной копии свои.
+// Работает только в GL-потоке.
+class MeshRegistry {
+public:
+    static MeshRegistry& global() {
+        static MeshRegistry registry;
+        return registry;
+    }
+
+    // В этом режиме CPU-копия отпускается сразу после загрузки в GL: сетки
+    // рисуются, но их вершины на CPU больше недоступны.
+    void setReleaseCpuData(bool release) { releaseCpu = release; }
+    bool releasesCpuData() const { return releaseCpu; }
+
+    // Живая сетка по ключу, если она есть.
+    bool find(const std::string& key, Mesh& out) {
+        auto it = entries.find(key);
+        if (it == entries.end() || it->second.buffers.expired()) return false;
+        out = instance(it->second);
+        ++hitCount;
+        return true;
+    }
+
+    // build вызывается, только если живой сетки с таким ключом нет.
+    Mesh acquire(const std::string& key, const std::function<Mesh()>& build) {
+        Mesh shared;
+        if (find(key, shared)) return shared;
+        return adopt(key, build());
+    }
+
+    // Регистрирует уже загруженную сетку (например, собранную в фоне). Если
+    // за это время под тем же ключом появилась другая, возвращается она.
+    Mesh adopt(const std::string& key, Mesh mesh) {
+        Mesh shared;
+        if (find(key, shared)) return shared;
+        ++missCount;
+        if (!mesh.buffers) return mesh;
+
+        Entry entry;
+        entry.gpuBytes = mesh.buffers->bytes;
+        if (releaseCpu) {
+            mesh.releaseCpuData();
+        }
+        entry.prototype = mesh;
+        entry.prototype.buffers.reset();
+        entry.prototype.cpuData.reset();
+        entry.prototype.texture.reset();
+        entry.buffers = mesh.buffers;
+        entry.cpu = mesh.cpuData;
+        entries[key] = std::move(entry);
+        return mesh;
+    }
+
+    Mesh cube(const Material& mat = Material::PlasticWhite()) {
+        return withMaterial(acquire("cube", [] { return Mesh::CreateCube(); }), mat);
+    }
+
+    Mesh plane(float width, float height, const Material& mat = Material::PlasticWhite()) {
+        std::string key = "plane:" + std::to_string(width) + "x" + std::to_string(height);
+        return withMaterial(acquire(key, [&] { return Mesh::CreatePlane(width, height); }), mat);
+    }
+
+    Mesh sphere(float radius, int segments = 32, int rings = 16,
+                const Material& mat = Material::PlasticWhite()) {
+        std::string key = "sphere:" + std::to_string(radius) + "/" + std::to_string(segments) +
+                          "/" + std::to_string(rings);
+        return withMaterial(acquire(key, [&] { return Mesh::CreateSphere(radius, segments, rings); }), mat);
+    }
+
+    // Как Mesh::CreateVolumePictureFrame, но планки всех рамок — один куб,
+    // а полотна одного размера — одна плоскость.
+    PictureFrameMeshes pictureFrame(float width, float height, float frameThickness, float frameDepth,
+                                    const Material& frameMat, const Material& pictureMat) {
+        std::string key = "picture:" + std::to_string(width) + "x" + std::to_string(height) + "/" +
+                          std::to_string(frameThickness) + "/" + std::to_string(frameDepth);
+        Mesh picture = acquire(key, [&] {
+            MeshData data = Primitives::PicturePlane(width, height, frameThickness, frameDepth);
+            Bounds bounds = Bounds::fromVertices(data.vertices);
+            return Mesh(std::move(data), bounds);
+        });
+
+        PictureFrameMeshes res;
+        res.picturePlane = new Mesh(withMaterial(picture, pictureMat));
+        Mesh bar = cube(frameMat);
+        res.bottomBar = new Mesh(bar);
+        res.topBar    = new Mesh(bar);
+        res.leftBar   = new Mesh(bar);
+        res.rightBar  = new Mesh(bar);
+        return res;
+    }
+
+    // OBJ через ModelLoader::loadOBJ: одна загрузка на файл.
+    Mesh obj(const std::string& path, const Material& material = Material::PlasticWhite(),
+             TextureHandle texture = nullptr, const ModelLoadOptions& options = ModelLoadOptions()) {
+        Mesh mesh = acquire(objKey(path, options), [&] {
+            return ModelLoader::loadOBJ(path, material, texture, options);
+        });
+        mesh.material = material;
+        mesh.texture = texture;
+        return mesh;
+    }
+
+    // Те же настройки, что различает кэш сеток (ModelLoadOptions::cacheKey).
+    static std::string objKey(const std::string& path, const ModelLoadOptions& options = ModelLoadOptions()) {
+        return "obj:" + AssetArchive::normalize(path) + "#" + std::to_string(options.cacheKey());
+    }
+
+    MeshRegistryStats stats() const {
+        MeshRegistryStats s;
+        s.hits = hitCount;
+        s.misses = missCount;
+        for (const auto& [key, entry] : entries) {
+            if (entry.buffers.expired()) continue;
+            ++s.entries;
+            s.gpuBytes += entry.gpuBytes;
+            if (auto cpu = entry.cpu.lock()) {
+                s.cpuBytes += cpu->vertices.capacity() * sizeof(Vertex) +
+                              (cpu->indices.capacity() + cpu->lodIndices.capacity()) * sizeof(uint32_t) +
+                              cpu->meshlets.capacity() * sizeof(Meshlet);
+            }
+        }
+        return s;
+    }
+
+    void printStats() const {
+        MeshRegistryStats s = stats();
+        std::cout << "Mesh registry: " << s.entries << " shared meshes, " << s.hits << " reused, "
+                  << s.misses << " built; CPU copies " << s.cpuBytes / (1024.0 * 1024.0) << " MB, GPU buffers "
+                  << s.gpuBytes / (1024.0 * 1024.0) << " MB" << (releaseCpu ? " (CPU copies released)" : "")
+                  << "\n";
+    }
+
+    // Забывает записи; уже выданные сетки остаются действительными.
+    void clear() {
+        entries.clear();
+        hitCount = 0;
+        missCount = 0;
+    }
+
+private:
+    struct Entry {
+        Mesh prototype;                      // без буферов, CPU-копии и текстуры
+        std::weak_ptr<MeshBuffers> buffers;
+        std::weak_ptr<const MeshData> cpu;
+        size_t gpuBytes = 0;
+    };
+
+    std::unordered_map<std::string, Entry> entries;
+    bool releaseCpu = false;
+    size_t hitCount = 0;
+    size_t missCount = 0;
+
+    static Mesh instance(const Entry& entry) {
+        Mesh mesh = entry.prototype;
+        mesh.buffers = entry.buffers.lock();
+        mesh.cpuData = entry.cpu.lock();
+        return mesh;
+    }
+
+    static Mesh withMaterial(Mesh mesh, const Material& mat) {
+        mesh.material = mat;
+        return mesh;
+    }
+};
@@ -0,0 +1,443 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <cfloat>
+#include <glm/glm.hpp>
+#include "Vertex.hpp"
+#include "MeshData.hpp"
+#include "Bounds.hpp"
+#include "ObjParser.hpp"
+#include "MeshOptimizer.hpp"
+
+// Один уровень упрощения: треугольники над исходными вершинами.
+struct SimplifiedLevel {
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> sourceTriangles;   // номер исходного треугольника для каждого оставшегося
+    float error = 0.0f;                      // в единицах модели
+};
+
+// Упрощение по квадрикам ошибки (Garland–Heckbert) стягиванием рёбер в одну
+// из конечных вершин: новых вершин не появляется, так что все уровни рисуются
+// из VBO полной сетки. Вершины с одной позицией (швы нормалей и UV) стягиваются
+// вместе; угол треугольника переходит в ту вершину цели, чьи нормаль и UV
+// ближе. Рёбра стягиваются проходами: в каждом — самые дешёвые из тех, что не
+// задевают окрестности друг друга.
+class MeshSimplifier {
+public:
+    static constexpr size_t MIN_TRIANGLES = 256;      // сетки меньше не упрощаются
+    static constexpr float BOUNDARY_WEIGHT = 10.0f;   // удержание открытых краёв
+    static constexpr float MAX_RELATIVE_ERROR = 0.05f; // от диагонали габаритов
+
+    // targets — желаемые числа треугольников по убыванию. Уровни, до которых
+    // дойти не удалось (ошибка выше maxError или стягивать больше нечего),
+    // не возвращаются.
+    static std::vector<SimplifiedLevel> simplify(const std::vector<Vertex>& vertices,
+                                                 const std::vector<uint32_t>& indices,
+                                                 const std::vector<size_t>& targets,
+                                                 float maxError = FLT_MAX) {
+        std::vector<SimplifiedLevel> levels;
+        const size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0 || targets.empty()) return levels;
+
+        State s;
+        s.vertices = &vertices;
+        buildGroups(s);
+        buildQuadrics(s, indices);
+
+        s.tris.assign(indices.begin(), indices.begin() + triangleCount * 3);
+        s.alive.assign(triangleCount, 1);
+        s.aliveCount = triangleCount;
+        for (size_t t = 0; t < triangleCount; ++t) {
+            if (groupDegenerate(s, t)) {
+                s.alive[t] = 0;
+                --s.aliveCount;
+            }
+        }
+
+        size_t level = 0;
+        size_t lastCount = triangleCount;
+        while (level < targets.size()) {
+            if (s.aliveCount <= targets[level]) {
+                levels.push_back(snapshot(s));
+                lastCount = s.aliveCount;
+                ++level;
+                continue;
+            }
+            if (!collapsePass(s, targets[level], maxError)) {
+                // Дальше не упростить: оставляем то, что есть, если это
+                // заметно меньше предыдущего уровня.
+                if (s.aliveCount * 5 < lastCount * 4) levels.push_back(snapshot(s));
+                break;
+            }
+        }
+        return levels;
+    }
+
+    // Строит до levelCount уровней, каждый примерно вдвое меньше предыдущего,
+    // и кладёт их в data.lodIndices/data.lods. Если заданы участки материалов,
+    // треугольники каждого уровня остаются сгруппированы по ним, а в
+    // rangeLods[r][k] записывается участок r на уровне k + 1.
+    static void buildLods(MeshData& data, unsigned levelCount,
+                          const std::vector<ObjMaterialRange>* ranges = nullptr,
+                          std::vector<std::vector<MeshLod>>* rangeLods = nullptr) {
+        data.lodIndices.clear();
+        data.lods.clear();
+        const size_t triangleCount = data.indices.size() / 3;
+        if (levelCount == 0 || triangleCount < MIN_TRIANGLES) return;
+
+        std::vector<size_t> targets;
+        for (unsigned k = 1; k <= levelCount; ++k) {
+            targets.push_back(std::max<size_t>(triangleCount >> k, 1));
+        }
+        Bounds bounds = Bounds::fromVertices(data.vertices);
+        float maxError = glm::length(bounds.max - bounds.min) * MAX_RELATIVE_ERROR;
+
+        std::vector<SimplifiedLevel> levels = simplify(data.vertices, data.indices, targets, maxError);
+
+        bool split = ranges && !ranges->empty();
+        if (rangeLods) rangeLods->assign(split ? ranges->size() : 0, {});
+
+        const uint32_t base = static_cast<uint32_t>(data.indices.size());
+        for (SimplifiedLevel& level : levels) {
+            MeshLod lod;
+            lod.firstIndex = base + static_cast<uint32_t>(data.lodIndices.size());
+            lod.error = level.error;
+
+            if (!split) {
+                MeshOptimizer::optimizeVertexCache(level.indices.data(), level.indices.size(),
+                                                   data.vertices.size());
+                data.lodIndices.insert(data.lodIndices.end(), level.indices.begin(), level.indices.end());
+            } else {
+                // Исходные треугольники упорядочены по участкам, и порядок
+                // оставшихся сохраняется, так что участки идут подряд.
+                size_t t = 0;
+                const size_t kept = level.sourceTriangles.size();
+                for (size_t r = 0; r < ranges->size(); ++r) {
+                    const ObjMaterialRange& range = (*ranges)[r];
+                    uint32_t end = (range.indexOffset + range.indexCount) / 3;
+                    size_t begin = t;
+                    while (t < kept && level.sourceTriangles[t] < end) ++t;
+
+                    MeshLod part;
+                    part.firstIndex = base + static_cast<uint32_t>(data.lodIndices.size());
+                    part.indexCount = static_cast<uint32_t>((t - begin) * 3);
+                    part.error = level.error;
+                    MeshOptimizer::optimizeVertexCache(level.indices.data() + begin * 3, (t - begin) * 3,
+                                                       data.vertices.size());
+                    data.lodIndices.insert(data.lodIndices.end(), level.indices.begin() + begin * 3,
+                                           level.indices.begin() + t * 3);
+                    if (rangeLods) (*rangeLods)[r].push_back(part);
+                }
+            }
+            lod.indexCount = base + static_cast<uint32_t>(data.lodIndices.size()) - lod.firstIndex;
+            data.lods.push_back(lod);
+        }
+    }
+
+private:
+    // Симметричная матрица 4x4 квадрики и её суммарный вес (площадь).
+    struct Quadric {
+        double a00 = 0, a11 = 0, a22 = 0, a01 = 0, a02 = 0, a12 = 0;
+        double b0 = 0, b1 = 0, b2 = 0, c = 0;
+        double weight = 0;
+
+        static Quadric plane(const glm::vec3& n, float d, double w) {
+            Quadric q;
+            q.a00 = w * n.x * n.x; q.a11 = w * n.y * n.y; q.a22 = w * n.z * n.z;
+            q.a01 = w * n.x * n.y; q.a02 = w * n.x * n.z; q.a12 = w * n.y * n.z;
+            q.b0 = w * n.x * d; q.b1 = w * n.y * d; q.b2 = w * n.z * d;
+            q.c = w * d * d;
+            q.weight = w;
+            return q;
+        }
+
+        void add(const Quadric& o) {
+            a00 += o.a00; a11 += o.a11; a22 += o.a22; a01 += o.a01; a02 += o.a02; a12 += o.a12;
+            b0 += o.b0; b1 += o.b1; b2 += o.b2; c += o.c;
+            weight += o.weight;
+        }
+
+        double eval(const glm::vec3& p) const {
+            double x = p.x, y = p.y, z = p.z;
+            double r = a00 * x * x + a11 * y * y + a22 * z * z +
+                       2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+                       2.0 * (b0 * x + b1 * y + b2 * z) + c;
+            return r > 0.0 ? r : 0.0;
+        }
+    };
+
+    struct State {
+        const std::vector<Vertex>* vertices = nullptr;
+        std::vector<uint32_t> group;            // вершина -> группа по позиции
+        std::vector<glm::vec3> positions;       // позиция группы
+        std::vector<uint32_t> memberOffsets;    // группа -> её вершины (CSR)
+        std::vector<uint32_t> members;
+        std::vector<Quadric> quadrics;
+        std::vector<uint32_t> tris;             // текущие индексы треугольников
+        std::vector<uint8_t> alive;
+        size_t aliveCount = 0;
+        float error = 0.0f;
+    };
+
+    struct Collapse {
+        uint32_t from, to;
+        float error;
+    };
+
+    static void buildGroups(State& s) {
+        const std::vector<Vertex>& vertices = *s.vertices;
+        constexpr uint32_t EMPTY = UINT32_MAX;
+        size_t capacity = 64;
+        while (capacity * 7 < vertices.size() * 10) capacity <<= 1;
+        std::vector<uint32_t> table(capacity, EMPTY);
+        const size_t mask = capacity - 1;
+
+        s.group.resize(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            const glm::vec3& p = vertices[i].position;
+            size_t slot = hashPosition(p) & mask;
+            while (table[slot] != EMPTY && s.positions[table[slot]] != p) {
+                slot = (slot + 1) & mask;
+            }
+            if (table[slot] == EMPTY) {
+                table[slot] = static_cast<uint32_t>(s.positions.size());
+                s.positions.push_back(p);
+            }
+            s.group[i] = table[slot];
+        }
+
+        s.memberOffsets.assign(s.positions.size() + 1, 0);
+        for (uint32_t g : s.group) ++s.memberOffsets[g + 1];
+        for (size_t g = 0; g < s.positions.size(); ++g) s.memberOffsets[g + 1] += s.memberOffsets[g];
+        s.members.resize(vertices.size());
+        std::vector<uint32_t> fill(s.memberOffsets.begin(), s.memberOffsets.end() - 1);
+        for (size_t i = 0; i < vertices.size(); ++i) s.members[fill[s.group[i]]++] = static_cast<uint32_t>(i);
+    }
+
+    // Квадрики плоскостей граней с весом площади плюс плоскости вдоль открытых
+    // краёв, перпендикулярные грани, — чтобы края не сползали внутрь.
+    static void buildQuadrics(State& s, const std::vector<uint32_t>& indices) {
+        s.quadrics.assign(s.positions.size(), Quadric());
+        const size_t triangleCount = indices.size() / 3;
+
+        struct Edge {
+            uint32_t a, b, triangle;
+        };
+        std::vector<Edge> edges;
+        edges.reserve(triangleCount * 3);
+
+        for (size_t t = 0; t < triangleCount; ++t) {
+            uint32_t g[3] = { s.group[indices[t * 3]], s.group[indices[t * 3 + 1]], s.group[indices[t * 3 + 2]] };
+            if (g[0] == g[1] || g[1] == g[2] || g[0] == g[2]) continue;
+            glm::vec3 n = glm::cross(s.positions[g[1]] - s.positions[g[0]], s.positions[g[2]] - s.positions[g[0]]);
+            float length = glm::length(n);
+            if (length <= 0.0f) continue;
+            n /= length;
+            Quadric q = Quadric::plane(n, -glm::dot(n, s.positions[g[0]]), length * 0.5);
+            for (uint32_t v : g) s.quadrics[v].add(q);
+            for (int k = 0; k < 3; ++k) {
+                uint32_t a = g[k], b = g[(k + 1) % 3];
+                edges.push_back({ std::min(a, b), std::max(a, b), static_cast<uint32_t>(t) });
+            }
+        }
+
+        std::sort(edges.begin(), edges.end(), [](const Edge& x, const Edge& y) {
+            return x.a != y.a ? x.a < y.a : x.b < y.b;
+        });
+        for (size_t i = 0; i < edges.size();) {
+            size_t j = i + 1;
+            while (j < edges.size() && edges[j].a == edges[i].a && edges[j].b == edges[i].b) ++j;
+            if (j - i == 1) {
+                const Edge& e = edges[i];
+                size_t t = e.triangle;
+                glm::vec3 p0 = s.positions[s.group[indices[t * 3]]];
+                glm::vec3 p1 = s.positions[s.group[indices[t * 3 + 1]]];
+                glm::vec3 p2 = s.positions[s.group[indices[t * 3 + 2]]];
+                glm::vec3 faceNormal = glm::cross(p1 - p0, p2 - p0);
+                glm::vec3 dir = s.positions[e.b] - s.positions[e.a];
+                glm::vec3 side = glm::cross(dir, faceNormal);
+                float sideLength = glm::length(side);
+                if (sideLength > 0.0f) {
+                    side /= sideLength;
+                    double w = glm::dot(dir, dir) * BOUNDARY_WEIGHT;
+                    Quadric q = Quadric::plane(side, -glm::dot(side, s.positions[e.a]), w);
+                    // Вес краевой плоскости в среднюю ошибку не входит.
+                    q.weight = 0.0;
+                    s.quadrics[e.a].add(q);
+                    s.quadrics[e.b].add(q);
+                }
+            }
+            i = j;
+        }
+    }
+
+    // Один проход: стягивает самые дешёвые рёбра, пока не останется target
+    // треугольников. false — не удалось стянуть ни одного.
+    static bool collapsePass(State& s, size_t target, float maxError) {
+        const size_t groupCount = s.positions.size();
+        const size_t triangleCount = s.alive.size();
+
+        // Смежность группа -> живые треугольники (CSR).
+        std::vector<uint32_t> offsets(groupCount + 1, 0);
+        for (size_t t = 0; t < triangleCount; ++t) {
+            if (!s.alive[t]) continue;
+            for (int k = 0; k < 3; ++k) ++offsets[s.group[s.tris[t * 3 + k]] + 1];
+        }
+        for (size_t g = 0; g < groupCount; ++g) offsets[g + 1] += offsets[g];
+        std::vector<uint32_t> adjacency(offsets[groupCount]);
+        {
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t t = 0; t < triangleCount; ++t) {
+                if (!s.alive[t]) continue;
+                for (int k = 0; k < 3; ++k) adjacency[fill[s.group[s.tris[t * 3 + k]]]++] = static_cast<uint32_t>(t);
+            }
+        }
+
+        // Рёбра живых треугольников и лучшее направление стягивания каждого.
+        std::vector<uint64_t> keys;
+        keys.reserve(s.aliveCount * 3);
+        for (size_t t = 0; t < triangleCount; ++t) {
+            if (!s.alive[t]) continue;
+            for (int k = 0; k < 3; ++k) {
+                uint32_t a = s.group[s.tris[t * 3 + k]];
+                uint32_t b = s.group[s.tris[t * 3 + (k + 1) % 3]];
+                keys.push_back((uint64_t(std::min(a, b)) << 32) | std::max(a, b));
+            }
+        }
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+        std::vector<Collapse> candidates;
+        candidates.reserve(keys.size());
+        for (uint64_t key : keys) {
+            uint32_t a = static_cast<uint32_t>(key >> 32);
+            uint32_t b = static_cast<uint32_t>(key);
+            Quadric q = s.quadrics[a];
+            q.add(s.quadrics[b]);
+            float toB = collapseError(q, s.positions[b]);
+            float toA = collapseError(q, s.positions[a]);
+            candidates.push_back(toB <= toA ? Collapse{ a, b, toB } : Collapse{ b, a, toA });
+        }
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const Collapse& x, const Collapse& y) { return x.error < y.error; });
+
+        std::vector<uint8_t> locked(groupCount, 0);
+        std::vector<Collapse> accepted;
+        size_t removing = 0;
+        for (const Collapse& c : candidates) {
+            if (c.error > maxError || s.aliveCount - removing <= target) break;
+            if (locked[c.from] || locked[c.to]) continue;
+            if (flips(s, adjacency, offsets, c.from, c.to)) continue;
+
+            // Окрестность from меняется целиком: её группы в этом проходе не трогаем.
+            for (uint32_t i = offsets[c.from]; i < offsets[c.from + 1]; ++i) {
+                uint32_t t = adjacency[i];
+                bool shared = false;
+                for (int k = 0; k < 3; ++k) {
+                    uint32_t g = s.group[s.tris[t * 3 + k]];
+                    locked[g] = 1;
+                    shared |= g == c.to;
+                }
+                removing += shared;
+            }
+            locked[c.to] = 1;
+            accepted.push_back(c);
+        }
+        if (accepted.empty()) return false;
+
+        for (const Collapse& c : accepted) {
+            s.quadrics[c.to].add(s.quadrics[c.from]);
+            s.error = std::max(s.error, c.error);
+            for (uint32_t i = offsets[c.from]; i < offsets[c.from + 1]; ++i) {
+                uint32_t t = adjacency[i];
+                for (int k = 0; k < 3; ++k) {
+                    uint32_t& v = s.tris[t * 3 + k];
+                    if (s.group[v] == c.from) v = closestMember(s, v, c.to);
+                }
+                if (groupDegenerate(s, t)) {
+                    s.alive[t] = 0;
+                    --s.aliveCount;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Стягивание переворачивает (или почти вырождает) какой-нибудь треугольник вокруг from.
+    static bool flips(const State& s, const std::vector<uint32_t>& adjacency,
+                      const std::vector<uint32_t>& offsets, uint32_t from, uint32_t to) {
+        for (uint32_t i = offsets[from]; i < offsets[from + 1]; ++i) {
+            uint32_t t = adjacency[i];
+            glm::vec3 p[3], moved[3];
+            bool shared = false;
+            for (int k = 0; k < 3; ++k) {
+                uint32_t g = s.group[s.tris[t * 3 + k]];
+                shared |= g == to;
+                p[k] = s.positions[g];
+                moved[k] = g == from ? s.positions[to] : p[k];
+            }
+            if (shared) continue;
+            glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+            glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+            if (glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after)) return true;
+        }
+        return false;
+    }
+
+    // Вершина группы to, ближайшая к v по нормали и UV.
+    static uint32_t closestMember(const State& s, uint32_t v, uint32_t to) {
+        uint32_t begin = s.memberOffsets[to], end = s.memberOffsets[to + 1];
+        if (end - begin == 1) return s.members[begin];
+        const Vertex& source = (*s.vertices)[v];
+        uint32_t best = s.members[begin];
+        float bestDistance = FLT_MAX;
+        for (uint32_t i = begin; i < end; ++i) {
+            const Vertex& candidate = (*s.vertices)[s.members[i]];
+            glm::vec2 uv = candidate.texCoords - source.texCoords;
+            float distance = 1.0f - glm::dot(candidate.normal, source.normal) + glm::dot(uv, uv);
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                best = s.members[i];
+            }
+        }
+        return best;
+    }
+
+    static bool groupDegenerate(const State& s, size_t t) {
+        uint32_t a = s.group[s.tris[t * 3]], b = s.group[s.tris[t * 3 + 1]], c = s.group[s.tris[t * 3 + 2]];
+        return a == b || b == c || a == c;
+    }
+
+    // Среднеквадратичное расстояние до плоскостей, в единицах модели.
+    static float collapseError(const Quadric& q, const glm::vec3& p) {
+        double w = q.weight > 0.0 ? q.weight : 1.0;
+        return static_cast<float>(std::sqrt(q.eval(p) / w));
+    }
+
+    static SimplifiedLevel snapshot(const State& s) {
+        SimplifiedLevel level;
+        level.error = s.error;
+        level.indices.reserve(s.aliveCount * 3);
+        level.sourceTriangles.reserve(s.aliveCount);
+        for (size_t t = 0; t < s.alive.size(); ++t) {
+            if (!s.alive[t]) continue;
+            level.indices.insert(level.indices.end(), s.tris.begin() + t * 3, s.tris.begin() + t * 3 + 3);
+            level.sourceTriangles.push_back(static_cast<uint32_t>(t));
+        }
+        return level;
+    }
+
+    static size_t hashPosition(const glm::vec3& p) {
+        uint32_t bits[3];
+        std::memcpy(bits, &p, sizeof(bits));
+        uint64_t h = bits[0] * 0x9E3779B185EBCA87ull;
+        h = (h ^ bits[1]) * 0xC2B2AE3D27D4EB4Full;
+        h = (h ^ bits[2]) * 0x9E3779B185EBCA87ull;
+        return static_cast<size_t>(h ^ (h >> 29));
+    }
+};
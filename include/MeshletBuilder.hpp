@@ -0,0 +1,263 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+#include <cfloat>
+#include <glm/glm.hpp>
+#include "Vertex.hpp"
+#include "MeshData.hpp"
+#include "ObjParser.hpp"
+#include "MeshOptimizer.hpp"
+
+// Разбиение LOD0 на кластеры (meshlets), чтобы отсекать геометрию мельче
+// целого объекта. Кластер растёт от затравочного треугольника через соседей
+// по позициям вершин (швы нормалей и UV не разрывают поверхность); из
+// кандидатов берётся тот, что добавляет меньше новых вершин, а при равенстве —
+// ближе к центру кластера и ближе по нормали к его оси, чтобы сфера и конус
+// нормалей получались узкими. Внутри кластера треугольники упорядочиваются
+// под кэш вершин. Треугольники переставляются внутри своих участков (usemtl),
+// сами участки не сдвигаются.
+class MeshletBuilder {
+public:
+    static constexpr size_t MAX_VERTICES = 64;
+    static constexpr size_t MAX_TRIANGLES = 124;
+    static constexpr size_t MIN_TRIANGLES = 1024;   // сетки меньше рисуются целиком
+    static constexpr float CONE_WEIGHT = 0.5f;      // доля разброса нормалей в оценке кандидата
+    static constexpr float MIN_CONE_DOT = 0.1f;     // конус шире ~84° ничего не отсекает
+
+    // Заполняет data.meshlets и упорядочивает data.indices по кластерам.
+    // Возвращает число кластеров.
+    static size_t build(MeshData& data, const std::vector<ObjMaterialRange>* ranges = nullptr) {
+        data.meshlets.clear();
+        const size_t triangleCount = data.indices.size() / 3;
+        if (triangleCount < MIN_TRIANGLES) return 0;
+
+        Adjacency adjacency(data.vertices, data.indices);
+        if (ranges && !ranges->empty()) {
+            for (const ObjMaterialRange& range : *ranges) {
+                buildSpan(data, adjacency, range.indexOffset / 3, (range.indexOffset + range.indexCount) / 3);
+            }
+        } else {
+            buildSpan(data, adjacency, 0, static_cast<uint32_t>(triangleCount));
+        }
+        return data.meshlets.size();
+    }
+
+    // Сфера и конус нормалей для треугольников indices[0, indexCount);
+    // firstIndex — их место в EBO.
+    static Meshlet bounds(const std::vector<Vertex>& vertices, const uint32_t* indices,
+                          uint32_t firstIndex, uint32_t indexCount) {
+        Meshlet meshlet;
+        meshlet.firstIndex = firstIndex;
+        meshlet.indexCount = indexCount;
+        if (indexCount == 0) return meshlet;
+
+        glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+        for (uint32_t i = 0; i < indexCount; ++i) {
+            lo = glm::min(lo, vertices[indices[i]].position);
+            hi = glm::max(hi, vertices[indices[i]].position);
+        }
+        meshlet.center = (lo + hi) * 0.5f;
+        for (uint32_t i = 0; i < indexCount; ++i) {
+            meshlet.radius = std::max(meshlet.radius, glm::length(vertices[indices[i]].position - meshlet.center));
+        }
+
+        glm::vec3 axis(0.0f);
+        for (uint32_t i = 0; i + 2 < indexCount; i += 3) {
+            axis += unitNormal(vertices, indices + i);
+        }
+        float length = glm::length(axis);
+        if (length < 1e-6f) return meshlet;
+        axis /= length;
+
+        float minDot = 1.0f;
+        for (uint32_t i = 0; i + 2 < indexCount; i += 3) {
+            glm::vec3 n = unitNormal(vertices, indices + i);
+            if (n != glm::vec3(0.0f)) minDot = std::min(minDot, glm::dot(n, axis));
+        }
+        meshlet.coneAxis = axis;
+        meshlet.coneCutoff = minDot <= MIN_CONE_DOT ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+        return meshlet;
+    }
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    // Треугольники каждой позиции (CSR) и то, что нужно для оценки кандидатов.
+    struct Adjacency {
+        std::vector<uint32_t> group;            // группа позиции каждой вершины
+        std::vector<uint32_t> offsets;          // по группам
+        std::vector<uint32_t> triangles;
+        std::vector<glm::vec3> centroids;
+        std::vector<glm::vec3> normals;         // единичные; 0 у вырожденных
+        std::vector<uint8_t> used;
+        std::vector<uint32_t> vertexCluster;    // кластер, в котором вершина уже есть
+        std::vector<uint32_t> candidateCluster; // кластер, в чьих кандидатах треугольник уже есть
+        uint32_t cluster = 0;
+        float expectedRadius = 1.0f;
+
+        Adjacency(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+            : triangles(indices.size()), centroids(indices.size() / 3), normals(indices.size() / 3),
+              used(indices.size() / 3, 0), vertexCluster(vertices.size(), NONE),
+              candidateCluster(indices.size() / 3, NONE) {
+            // Соседство по позициям: вершины с одной позицией — одна группа.
+            std::vector<uint32_t> byPosition(vertices.size());
+            for (uint32_t v = 0; v < byPosition.size(); ++v) byPosition[v] = v;
+            auto less = [&](uint32_t a, uint32_t b) {
+                const glm::vec3& p = vertices[a].position;
+                const glm::vec3& q = vertices[b].position;
+                return p.x != q.x ? p.x < q.x : p.y != q.y ? p.y < q.y : p.z < q.z;
+            };
+            std::sort(byPosition.begin(), byPosition.end(), less);
+            group.assign(vertices.size(), 0);
+            uint32_t groups = 0;
+            for (size_t i = 0; i < byPosition.size(); ++i) {
+                if (i > 0 && less(byPosition[i - 1], byPosition[i])) ++groups;
+                group[byPosition[i]] = groups;
+            }
+            offsets.assign(size_t(groups) + 2, 0);
+
+            for (uint32_t index : indices) ++offsets[group[index] + 1];
+            for (size_t g = 0; g + 1 < offsets.size(); ++g) offsets[g + 1] += offsets[g];
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+
+            double area = 0.0;
+            for (size_t t = 0; t < centroids.size(); ++t) {
+                const uint32_t* tri = indices.data() + t * 3;
+                for (int k = 0; k < 3; ++k) triangles[fill[group[tri[k]]]++] = static_cast<uint32_t>(t);
+                const glm::vec3& a = vertices[tri[0]].position;
+                const glm::vec3& b = vertices[tri[1]].position;
+                const glm::vec3& c = vertices[tri[2]].position;
+                centroids[t] = (a + b + c) / 3.0f;
+                glm::vec3 n = glm::cross(b - a, c - a);
+                float length = glm::length(n);
+                normals[t] = length > 0.0f ? n / length : glm::vec3(0.0f);
+                area += length * 0.5;
+            }
+            // Кластер из MAX_TRIANGLES средних треугольников — примерно круг такого радиуса.
+            double clusterArea = area / std::max<size_t>(centroids.size(), 1) * MAX_TRIANGLES;
+            expectedRadius = clusterArea > 0.0 ? static_cast<float>(std::sqrt(clusterArea / 3.14159265)) : 1.0f;
+        }
+    };
+
+    static void buildSpan(MeshData& data, Adjacency& adj, uint32_t begin, uint32_t end) {
+        const std::vector<uint32_t>& indices = data.indices;
+        std::vector<uint32_t> order;
+        order.reserve(size_t(end - begin) * 3);
+        std::vector<uint32_t> members;
+        std::vector<uint32_t> candidates;
+        std::vector<uint32_t> local;
+
+        uint32_t seed = begin;
+        while (true) {
+            while (seed < end && adj.used[seed]) ++seed;
+            if (seed >= end) break;
+
+            const uint32_t cluster = adj.cluster++;
+            size_t vertexCount = 0;
+            glm::vec3 centroidSum(0.0f), normalSum(0.0f);
+            members.clear();
+            candidates.clear();
+
+            auto freshVertices = [&](uint32_t t) {
+                int fresh = 0;
+                for (int k = 0; k < 3; ++k) fresh += adj.vertexCluster[indices[t * 3 + k]] != cluster;
+                return static_cast<size_t>(fresh);
+            };
+            auto add = [&](uint32_t t) {
+                adj.used[t] = 1;
+                members.push_back(t);
+                centroidSum += adj.centroids[t];
+                normalSum += adj.normals[t];
+                for (int k = 0; k < 3; ++k) {
+                    uint32_t v = indices[t * 3 + k];
+                    if (adj.vertexCluster[v] == cluster) continue;
+                    adj.vertexCluster[v] = cluster;
+                    ++vertexCount;
+                    uint32_t g = adj.group[v];
+                    for (uint32_t i = adj.offsets[g]; i < adj.offsets[g + 1]; ++i) {
+                        uint32_t n = adj.triangles[i];
+                        if (n < begin || n >= end || adj.used[n] || adj.candidateCluster[n] == cluster) continue;
+                        adj.candidateCluster[n] = cluster;
+                        candidates.push_back(n);
+                    }
+                }
+            };
+
+            add(seed);
+            while (members.size() < MAX_TRIANGLES) {
+                glm::vec3 center = centroidSum / static_cast<float>(members.size());
+                float axisLength = glm::length(normalSum);
+                glm::vec3 axis = axisLength > 0.0f ? normalSum / axisLength : glm::vec3(0.0f);
+
+                uint32_t best = NONE;
+                size_t bestFresh = 4;
+                float bestScore = FLT_MAX;
+                for (size_t i = 0; i < candidates.size();) {
+                    uint32_t t = candidates[i];
+                    if (adj.used[t]) {
+                        candidates[i] = candidates.back();
+                        candidates.pop_back();
+                        continue;
+                    }
+                    ++i;
+                    size_t fresh = freshVertices(t);
+                    if (vertexCount + fresh > MAX_VERTICES || fresh > bestFresh) continue;
+                    float score = (1.0f - CONE_WEIGHT) * glm::length(adj.centroids[t] - center) / adj.expectedRadius +
+                                  CONE_WEIGHT * (1.0f - glm::dot(adj.normals[t], axis));
+                    if (fresh < bestFresh || score < bestScore) {
+                        best = t;
+                        bestFresh = fresh;
+                        bestScore = score;
+                    }
+                }
+
+                if (best == NONE) {
+                    // Связная часть кончилась: следующий треугольник потока
+                    // присоединяется, только если он рядом и помещается.
+                    while (seed < end && adj.used[seed]) ++seed;
+                    if (seed >= end || vertexCount + freshVertices(seed) > MAX_VERTICES ||
+                        glm::length(adj.centroids[seed] - center) > adj.expectedRadius) {
+                        break;
+                    }
+                    best = seed;
+                }
+                add(best);
+            }
+
+            size_t first = order.size();
+            for (uint32_t t : members) {
+                order.insert(order.end(), indices.begin() + t * 3, indices.begin() + t * 3 + 3);
+            }
+            optimizeLocally(order.data() + first, order.size() - first, local);
+            data.meshlets.push_back(bounds(data.vertices, order.data() + first,
+                                           static_cast<uint32_t>(begin * 3 + first),
+                                           static_cast<uint32_t>(order.size() - first)));
+        }
+        std::copy(order.begin(), order.end(), data.indices.begin() + size_t(begin) * 3);
+    }
+
+    // Порядок треугольников кластера под кэш вершин: вершины кластера
+    // перенумеровываются подряд, чтобы Форсайту хватило массивов на 64 вершины.
+    static void optimizeLocally(uint32_t* indices, size_t indexCount, std::vector<uint32_t>& local) {
+        std::vector<uint32_t> globals;
+        globals.reserve(MAX_VERTICES);
+        local.resize(indexCount);
+        for (size_t i = 0; i < indexCount; ++i) {
+            auto it = std::find(globals.begin(), globals.end(), indices[i]);
+            local[i] = static_cast<uint32_t>(it - globals.begin());
+            if (it == globals.end()) globals.push_back(indices[i]);
+        }
+        MeshOptimizer::optimizeVertexCache(local.data(), local.size(), globals.size());
+        for (size_t i = 0; i < indexCount; ++i) indices[i] = globals[local[i]];
+    }
+
+    static glm::vec3 unitNormal(const std::vector<Vertex>& vertices, const uint32_t* tri) {
+        const glm::vec3& a = vertices[tri[0]].position;
+        glm::vec3 n = glm::cross(vertices[tri[1]].position - a, vertices[tri[2]].position - a);
+        float length = glm::length(n);
+        return length > 0.0f ? n / length : glm::vec3(0.0f);
+    }
+};
@@ -1,120 +1,455 @@
 #pragma once
 
 #include <vector>
+#include <deque>
 #include <string>
+#include <string_view>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <memory>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <algorithm>
 #include <unordered_map>
+#include <filesystem>
 #include "Mesh.hpp"
+#include "MeshData.hpp"
+#include "MappedFile.hpp"
+#include "MeshCache.hpp"
+#include "Bounds.hpp"
+#include "ObjParser.hpp"
+#include "MtlParser.hpp"
+#include "ObjStreamParser.hpp"
+#include "VertexDedupTable.hpp"
+#include "NormalGenerator.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+#include "MeshletBuilder.hpp"
+#include "GltfLoader.hpp"
+#include "AssetArchive.hpp"
 #include "Material.hpp"
 #include "Texture.hpp"
+#include "TextureCache.hpp"
+
+struct ModelLoadOptions {
+    // 0 — выбрать автоматически: крупные файлы разбираются на всех ядрах.
+    unsigned parseThreads = 0;
+    // Читать/писать бинарный кэш <model>.obj.<ключ>.meshcache рядом с исходником.
+    bool useCache = true;
+    // Взвешивание нормалей граней, если в файле нет своих vn.
+    NormalWeighting normalWeighting = NormalWeighting::Uniform;
+    // Переупорядочить треугольники и вершины под кэш вершин (MeshOptimizer).
+    bool optimize = true;
+    // Сколько упрощённых уровней (LOD1..n) строить, каждый вдвое меньше.
+    unsigned lodLevels = 3;
+    // Разбить LOD0 на кластеры для отсечения по частям (MeshletBuilder).
+    bool meshlets = true;
+
+    // Ключ настроек, от которых зависит готовая сетка (кэш и архив).
+    uint32_t cacheKey() const {
+        return MeshCache::settingsKey(static_cast<uint32_t>(normalWeighting), optimize, lodLevels, meshlets);
+    }
+};
+
+// CPU-часть загрузки OBJ. Сетка из архива или бинарного кэша остаётся видом
+// на отображённый файл (кэш держит открытым mapping, архив отображён всё
+// время) и уходит в GL без копии; разобранная заново лежит в data.
+struct LoadedObj {
+    MeshData data;
+    Bounds bounds;
+    CachedMeshView view;
+    std::shared_ptr<MappedFile> mapping;
+
+    bool isMapped() const { return view.vertices != nullptr; }
+};
+
+// Модель из .glb: части (примитивы glTF) и их размещение по узлам сцены.
+struct GltfModel {
+    struct Instance {
+        size_t part;
+        glm::mat4 transform;
+    };
+
+    std::vector<Mesh> parts;
+    std::vector<Instance> instances;
+    // GL-буферы bufferView, общие для нескольких частей: Mesh::cleanup их
+    // не удаляет, за них отвечает владелец модели.
+    std::vector<GLuint> buffers;
+
+    bool isValid() const { return !parts.empty(); }
+};
 
 class ModelLoader {
 public:
+    static constexpr size_t PARALLEL_PARSE_THRESHOLD = 16u << 20;
     
     static Mesh loadOBJ(const std::string& filepath,
                         const Material& material = Material::PlasticWhite(),
-                        Texture* texture = nullptr) {
-        std::vector<glm::vec3> temp_positions;
-        std::vector<glm::vec3> temp_normals;
-        std::vector<glm::vec2> temp_texcoords;
-        
-        std::vector<Vertex> vertices;
-        std::vector<uint32_t> indices;
-        
-        
-        std::unordered_map<std::string, uint32_t> uniqueVertices;
-        
-        std::ifstream file(filepath);
-        if (!file.is_open()) {
-            std::cerr << "Failed to open OBJ file: " << filepath << std::endl;
+                        TextureHandle texture = nullptr,
+                        const ModelLoadOptions& options = ModelLoadOptions()) {
+        LoadedObj loaded;
+        if (!loadOBJData(filepath, loaded, options)) {
             return Mesh::CreateCube(material); 
         }
+        return createMesh(std::move(loaded), material, texture);
+    }
+    
+    // GL-часть: сетка из результата loadOBJData. Отображение кэша нужно
+    // только до этого вызова.
+    static Mesh createMesh(LoadedObj&& loaded,
+                           const Material& material = Material::PlasticWhite(),
+                           TextureHandle texture = nullptr) {
+        if (loaded.isMapped()) {
+            return Mesh(loaded.view, material, texture);
+        }
+        return Mesh(std::move(loaded.data), loaded.bounds, material, texture);
+    }
+    
+    // Вся CPU-часть loadOBJ (архив, кэш, разбор, нормали) без обращения к GL,
+    // поэтому её можно вызывать из рабочих потоков.
+    static bool loadOBJData(const std::string& filepath, LoadedObj& out,
+                            const ModelLoadOptions& options = ModelLoadOptions()) {
+        // Сетки в архиве уже разобраны и с нормалями; годятся, только если
+        // собраны с теми же настройками.
+        if (AssetArchive::global().findMesh(filepath, options.cacheKey(), out.view)) {
+            out.bounds = out.view.bounds;
+            return true;
+        }
         
+        MappedFile file(filepath);
+        if (!file.isOpen()) {
+            std::cerr << "Failed to open OBJ file: " << filepath << std::endl;
+            return false;
+        }
+        return loadOBJData(filepath, file.view(), out, options);
+    }
+    
+    // То же для уже прочитанного содержимого файла (например, пачкой через
+    // AsyncFileReader); filepath нужен для кэша и сообщений.
+    static bool loadOBJData(const std::string& filepath, std::string_view contents, LoadedObj& out,
+                            const ModelLoadOptions& options = ModelLoadOptions()) {
         std::cout << "Loading OBJ: " << filepath << std::endl;
         
-        std::string line;
-        while (std::getline(file, line)) {
-            std::istringstream iss(line);
-            std::string prefix;
-            iss >> prefix;
+        SourceStamp stamp;
+        if (options.useCache) {
+            auto start = std::chrono::steady_clock::now();
+            stamp = MeshCache::stamp(filepath, contents.data(), contents.size(), options.cacheKey());
             
-            if (prefix == "v") {
-                
-                glm::vec3 position;
-                iss >> position.x >> position.y >> position.z;
-                temp_positions.push_back(position);
+            auto cacheFile = std::make_shared<MappedFile>();
+            if (MeshCache::load(MeshCache::pathFor(filepath, stamp.settings), stamp, *cacheFile, out.view)) {
+                out.mapping = std::move(cacheFile);
+                out.bounds = out.view.bounds;
+                auto finish = std::chrono::steady_clock::now();
+                std::cout << "Loaded OBJ from cache: " << out.view.vertexCount << " vertices, "
+                          << out.view.indexCount / 3 << " triangles in "
+                          << std::chrono::duration<double, std::milli>(finish - start).count()
+                          << " ms\n";
+                return true;
             }
-            else if (prefix == "vt") {
-                
-                glm::vec2 texcoord;
-                iss >> texcoord.x >> texcoord.y;
-                temp_texcoords.push_back(texcoord);
+        }
+        
+        out.data = parseOBJ(filepath, contents, options);
+        
+        out.bounds = Bounds::fromVertices(out.data.vertices);
+        if (options.useCache) {
+            MeshCache::write(MeshCache::pathFor(filepath, stamp.settings), out.data, out.bounds, stamp);
+        }
+        
+        std::cout << "Loaded OBJ: " << out.data.vertices.size() << " vertices, " 
+                  << out.data.indices.size() / 3 << " triangles\n";
+        return true;
+    }
+    
+    
+    // Разбор уже открытого файла без обращения к GL: вершины, индексы и нормали.
+    static MeshData parseOBJ(const std::string& filepath, const MappedFile& file,
+                             const ModelLoadOptions& options = ModelLoadOptions()) {
+        return parseOBJ(filepath, file.view(), options);
+    }
+    
+    static MeshData parseOBJ(const std::string& filepath, std::string_view contents,
+                             const ModelLoadOptions& options = ModelLoadOptions()) {
+        unsigned threads = options.parseThreads;
+        if (threads == 0) {
+            threads = contents.size() >= PARALLEL_PARSE_THRESHOLD
+                ? Parallel::hardwareThreads()
+                : 1u;
+        }
+        
+        auto start = std::chrono::steady_clock::now();
+        MeshData data = threads > 1 ? ObjParser::parseParallel(contents, threads)
+                                    : ObjParser::parse(contents);
+        auto finish = std::chrono::steady_clock::now();
+        
+        double seconds = std::chrono::duration<double>(finish - start).count();
+        double megabytes = contents.size() / (1024.0 * 1024.0);
+        std::cout << "Parsed " << megabytes << " MB in " << seconds * 1000.0 << " ms ("
+                  << (seconds > 0.0 ? megabytes / seconds : 0.0) << " MB/s, "
+                  << threads << " thread(s))\n";
+        
+        if (!data.hasNormals) {
+            std::cout << "Calculating normals for " << filepath << std::endl;
+            NormalGenerator::generate(data.vertices, data.indices, options.normalWeighting);
+        }
+        if (options.optimize) {
+            optimizeMesh(filepath, data);
+        }
+        if (options.meshlets) {
+            buildMeshlets(filepath, data);
+        }
+        buildLods(filepath, data, options.lodLevels);
+        return data;
+    }
+    
+    // Уровни LOD с отчётом о числе треугольников и ошибке каждого.
+    static void buildLods(const std::string& filepath, MeshData& data, unsigned levels,
+                          const std::vector<ObjMaterialRange>* ranges = nullptr,
+                          std::vector<std::vector<MeshLod>>* rangeLods = nullptr) {
+        if (levels == 0) return;
+        auto start = std::chrono::steady_clock::now();
+        MeshSimplifier::buildLods(data, levels, ranges, rangeLods);
+        if (data.lods.empty()) return;
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "LODs for " << filepath << ": " << data.indices.size() / 3;
+        for (const MeshLod& lod : data.lods) {
+            std::cout << " -> " << lod.indexCount / 3 << " (error " << lod.error << ")";
+        }
+        std::cout << " triangles in " << ms << " ms\n";
+    }
+    
+    // Кластеры LOD0 с отчётом об их числе и среднем размере.
+    static void buildMeshlets(const std::string& filepath, MeshData& data,
+                              const std::vector<ObjMaterialRange>* ranges = nullptr) {
+        auto start = std::chrono::steady_clock::now();
+        size_t count = MeshletBuilder::build(data, ranges);
+        if (count == 0) return;
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Meshlets for " << filepath << ": " << count << " clusters, "
+                  << data.indices.size() / 3 / count << " triangles each on average, in " << ms << " ms\n";
+    }
+    
+    // Оптимизация сетки с отчётом ACMR/ATVR до и после.
+    static void optimizeMesh(const std::string& filepath, MeshData& data,
+                             std::vector<ObjMaterialRange>* ranges = nullptr) {
+        auto start = std::chrono::steady_clock::now();
+        MeshOptimizeStats stats = MeshOptimizer::optimize(data, ranges);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Optimized " << filepath << ": ACMR " << stats.acmrBefore << " -> " << stats.acmrAfter
+                  << ", ATVR " << stats.atvrBefore << " -> " << stats.atvrAfter << ", "
+                  << stats.welded << " vertices welded, " << stats.degenerate
+                  << " degenerate triangles dropped in " << ms << " ms\n";
+    }
+    
+    // Загрузка .glb: файл отображается в память, и bufferView'ы уходят в
+    // glBufferData прямо из отображения, без разбора и копирования вершин.
+    // Примитивы, которые так нарисовать нельзя, проходят через MeshData.
+    static GltfModel loadGLB(const std::string& filepath,
+                             const ModelLoadOptions& options = ModelLoadOptions()) {
+        GltfModel model;
+        auto start = std::chrono::steady_clock::now();
+        
+        GltfDocument doc;
+        if (!GltfLoader::load(filepath, doc)) {
+            return model;
+        }
+        std::cout << "Loading glTF: " << filepath << std::endl;
+        
+        // deque: ссылки на уже загруженные буферы не меняются при добавлении.
+        std::deque<VBO> uploaded;
+        std::vector<int> viewBuffers(doc.bufferViews.size(), -1);
+        std::vector<TextureHandle> images(doc.images.size());
+        std::vector<std::vector<size_t>> meshParts(doc.meshes.size());
+        size_t directParts = 0;
+        size_t uploadedBytes = 0;
+        
+        // Части, которые уходят в GL напрямую, CPU-копии не имеют: их BVH
+        // строится по accessor'ам в отображении в отдельном потоке, пока этот
+        // (GL) поток грузит буферы и текстуры.
+        struct DirectBvh {
+            const GltfPrimitive* prim;
+            size_t part = 0;
+            std::shared_ptr<const MeshBvh> bvh;
+        };
+        std::vector<DirectBvh> directBvhs;
+        for (const GltfMesh& mesh : doc.meshes) {
+            for (const GltfPrimitive& prim : mesh.primitives) {
+                if (GltfLoader::canUseDirectly(doc, prim)) directBvhs.push_back({ &prim });
             }
-            else if (prefix == "vn") {
-                
-                glm::vec3 normal;
-                iss >> normal.x >> normal.y >> normal.z;
-                temp_normals.push_back(normal);
+        }
+        std::thread bvhWorker([&doc, &directBvhs] {
+            for (DirectBvh& entry : directBvhs) {
+                entry.bvh = GltfLoader::buildBvh(doc, *entry.prim);
             }
-            else if (prefix == "f") {
-                
-                std::vector<std::string> faceVertices;
-                std::string vertex;
-                
-                while (iss >> vertex) {
-                    faceVertices.push_back(vertex);
+        });
+        
+        for (size_t m = 0; m < doc.meshes.size(); ++m) {
+            for (const GltfPrimitive& prim : doc.meshes[m].primitives) {
+                Material material = Material::PlasticWhite();
+                TextureHandle texture;
+                if (prim.material >= 0) {
+                    const GltfMaterial& src = doc.materials[prim.material];
+                    material = GltfLoader::toMaterial(src);
+                    texture = gltfTexture(filepath, doc, src.baseColorImage, images);
                 }
                 
-                
-                if (faceVertices.size() >= 3) {
-                    for (size_t i = 1; i < faceVertices.size() - 1; ++i) {
-                        processVertex(faceVertices[0], temp_positions, temp_texcoords, 
-                                    temp_normals, vertices, indices, uniqueVertices);
-                        processVertex(faceVertices[i], temp_positions, temp_texcoords, 
-                                    temp_normals, vertices, indices, uniqueVertices);
-                        processVertex(faceVertices[i + 1], temp_positions, temp_texcoords, 
-                                    temp_normals, vertices, indices, uniqueVertices);
+                Mesh part;
+                if (directParts < directBvhs.size() && directBvhs[directParts].prim == &prim) {
+                    auto viewBuffer = [&](int view) -> VBO& {
+                        if (viewBuffers[view] < 0) {
+                            const GltfBufferView& bv = doc.bufferViews[view];
+                            viewBuffers[view] = static_cast<int>(uploaded.size());
+                            uploaded.emplace_back(bv.data, static_cast<GLsizeiptr>(bv.length));
+                            uploadedBytes += bv.length;
+                        }
+                        return uploaded[viewBuffers[view]];
+                    };
+                    part = uploadPrimitive(doc, prim, viewBuffer);
+                    directBvhs[directParts++].part = model.parts.size();
+                } else {
+                    MeshData data;
+                    if (!GltfLoader::toMeshData(doc, prim, data, options.normalWeighting)) {
+                        continue;
                     }
+                    part = Mesh(std::move(data), prim.bounds, material, texture);
                 }
+                part.material = material;
+                part.texture = texture;
+                part.bounds = prim.bounds;
+                
+                meshParts[m].push_back(model.parts.size());
+                model.parts.push_back(std::move(part));
             }
         }
         
-        file.close();
-        
-        
-        if (temp_normals.empty()) {
-            std::cout << "Calculating normals for " << filepath << std::endl;
-            calculateNormals(vertices, indices);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        for (const VBO& vbo : uploaded) {
+            model.buffers.push_back(vbo.id);
+        }
+        bvhWorker.join();
+        for (DirectBvh& entry : directBvhs) {
+            model.parts[entry.part].bvh = std::move(entry.bvh);
+        }
+        for (const GltfInstance& instance : doc.instances) {
+            for (size_t part : meshParts[instance.mesh]) {
+                model.instances.push_back({ part, instance.transform });
+            }
         }
         
-        std::cout << "Loaded OBJ: " << vertices.size() << " vertices, " 
-                  << indices.size() / 3 << " triangles\n";
-        std::cout << texture << std::endl;
-        Mesh mesh(vertices, indices, material, texture);
-        return mesh;
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Loaded glTF: " << model.parts.size() << " parts (" << directParts << " direct, "
+                  << uploadedBytes / (1024.0 * 1024.0) << " MB uploaded from the mapping), "
+                  << model.instances.size() << " instances in " << ms << " ms\n";
+        return model;
     }
     
     
     static Mesh loadOBJWithTexture(const std::string& objPath,
                                     const std::string& texturePath,
-                                    const Material& material = Material::PlasticWhite()) {
-        Texture* texture = nullptr;
+                                    const Material& material = Material::PlasticWhite(),
+                                    const ModelLoadOptions& options = ModelLoadOptions()) {
+        TextureHandle texture;
         
         if (!texturePath.empty()) {
-            texture = new Texture(texturePath.c_str(), 
-                                 GL_TEXTURE_2D, 
-                                 GL_TEXTURE0, 
-                                 GL_RGBA, 
-                                 GL_UNSIGNED_BYTE);
+            texture = TextureCache::global().load(texturePath);
         }
         
-        return loadOBJ(objPath, material, texture);
+        return loadOBJ(objPath, material, texture, options);
     }
     
     
+    // Модель с материалами из mtllib: вся геометрия в одних VBO/EBO, а
+    // usemtl превращаются в участки Mesh::submeshes (по одному на материал).
+    // Материалы, которых нет в .mtl, получают defaultMaterial. Кэш сеток и
+    // архив хранят только вершины и индексы, поэтому здесь не используются.
+    static Mesh loadOBJWithMaterials(const std::string& filepath,
+                                     const Material& defaultMaterial = Material::PlasticWhite(),
+                                     const ModelLoadOptions& options = ModelLoadOptions()) {
+        auto start = std::chrono::steady_clock::now();
+        
+        MappedFile file;
+        std::string_view contents;
+        if (!AssetArchive::global().findRaw(filepath, contents)) {
+            if (!file.open(filepath)) {
+                std::cerr << "Failed to open OBJ file: " << filepath << std::endl;
+                return Mesh::CreateCube(defaultMaterial);
+            }
+            contents = file.view();
+        }
+        
+        ObjModelData model = ObjParser::parseWithMaterials(contents);
+        if (model.mesh.indices.empty()) {
+            std::cerr << "No faces in OBJ file: " << filepath << std::endl;
+            return Mesh::CreateCube(defaultMaterial);
+        }
+        if (!model.mesh.hasNormals) {
+            NormalGenerator::generate(model.mesh.vertices, model.mesh.indices, options.normalWeighting);
+        }
+        if (options.optimize) {
+            optimizeMesh(filepath, model.mesh, &model.ranges);
+        }
+        if (options.meshlets) {
+            buildMeshlets(filepath, model.mesh, &model.ranges);
+        }
+        std::vector<std::vector<MeshLod>> rangeLods;
+        buildLods(filepath, model.mesh, options.lodLevels, &model.ranges, &rangeLods);
+        
+        std::string baseDir = std::filesystem::path(filepath).parent_path().generic_string();
+        std::vector<MtlMaterial> library;
+        for (const auto& name : model.materialLibraries) {
+            std::vector<MtlMaterial> loaded;
+            std::string path = (std::filesystem::path(baseDir) / name).lexically_normal().generic_string();
+            if (MtlParser::load(path, loaded)) {
+                library.insert(library.end(), loaded.begin(), loaded.end());
+            }
+        }
+        
+        // Одна текстура на файл, даже если на неё ссылаются несколько материалов.
+        std::unordered_map<std::string, TextureHandle> textures;
+        auto texture = [&](const std::string& path) -> TextureHandle {
+            auto it = textures.find(path);
+            if (it != textures.end()) return it->second;
+            TextureHandle tex = TextureCache::global().load(path);
+            textures.emplace(path, tex);
+            return tex;
+        };
+        
+        std::vector<SubMesh> submeshes;
+        submeshes.reserve(model.ranges.size());
+        for (size_t r = 0; r < model.ranges.size(); ++r) {
+            const ObjMaterialRange& range = model.ranges[r];
+            SubMesh sub;
+            sub.firstIndex = range.indexOffset;
+            sub.indexCount = static_cast<GLsizei>(range.indexCount);
+            if (r < rangeLods.size()) sub.lods = std::move(rangeLods[r]);
+            sub.material = defaultMaterial;
+            auto found = std::find_if(library.begin(), library.end(),
+                                      [&](const MtlMaterial& m) { return m.name == range.material; });
+            if (found != library.end()) {
+                sub.material = found->toMaterial();
+                if (!found->diffuseMap.empty()) {
+                    sub.texture = texture(found->diffuseMap);
+                }
+            } else if (!range.material.empty()) {
+                std::cerr << "Material " << range.material << " not found for " << filepath << std::endl;
+            }
+            submeshes.push_back(sub);
+        }
+        
+        Bounds bounds = Bounds::fromVertices(model.mesh.vertices);
+        size_t vertexCount = model.mesh.vertices.size();
+        size_t triangleCount = model.mesh.indices.size() / 3;
+        Mesh mesh(std::move(model.mesh), bounds, defaultMaterial);
+        mesh.submeshes = std::move(submeshes);
+        
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Loaded OBJ with materials: " << filepath << ": " << vertexCount << " vertices, "
+                  << triangleCount << " triangles, " << mesh.submeshes.size() << " draw ranges, "
+                  << textures.size() << " textures in " << ms << " ms\n";
+        return mesh;
+    }
+    
     static std::vector<Mesh> loadOBJMultiple(const std::string& filepath,
                                              const Material& material = Material::PlasticWhite()) {
         std::vector<Mesh> meshes;
@@ -126,7 +461,7 @@ public:
         
         std::vector<Vertex> currentVertices;
         std::vector<uint32_t> currentIndices;
-        std::unordered_map<std::string, uint32_t> uniqueVertices;
+        VertexDedupTable uniqueVertices;
         
         std::string currentGroup = "default";
         
@@ -161,7 +496,7 @@ public:
                 
                 if (!currentVertices.empty()) {
                     if (temp_normals.empty()) {
-                        calculateNormals(currentVertices, currentIndices);
+                        NormalGenerator::generate(currentVertices, currentIndices);
                     }
                     meshes.emplace_back(currentVertices, currentIndices, material);
                     currentVertices.clear();
@@ -171,11 +506,14 @@ public:
                 iss >> currentGroup;
             }
             else if (prefix == "f") {
-                std::vector<std::string> faceVertices;
+                std::vector<ObjParser::Corner> faceVertices;
                 std::string vertex;
                 
                 while (iss >> vertex) {
-                    faceVertices.push_back(vertex);
+                    ObjParser::Corner corner = ObjParser::parseCorner(vertex);
+                    ObjParser::resolveCorner(corner, temp_positions.size(),
+                                             temp_texcoords.size(), temp_normals.size());
+                    faceVertices.push_back(corner);
                 }
                 
                 if (faceVertices.size() >= 3) {
@@ -194,7 +532,7 @@ public:
         
         if (!currentVertices.empty()) {
             if (temp_normals.empty()) {
-                calculateNormals(currentVertices, currentIndices);
+                NormalGenerator::generate(currentVertices, currentIndices);
             }
             meshes.emplace_back(currentVertices, currentIndices, material);
         }
@@ -205,105 +543,121 @@ public:
         return meshes;
     }
 
-private:
-    static void processVertex(const std::string& vertexData,
-                             const std::vector<glm::vec3>& positions,
-                             const std::vector<glm::vec2>& texcoords,
-                             const std::vector<glm::vec3>& normals,
-                             std::vector<Vertex>& vertices,
-                             std::vector<uint32_t>& indices,
-                             std::unordered_map<std::string, uint32_t>& uniqueVertices) {
-        
-        auto it = uniqueVertices.find(vertexData);
-        if (it != uniqueVertices.end()) {
-            
-            indices.push_back(it->second);
-            return;
-        }
-        
-        
-        std::istringstream iss(vertexData);
-        std::string indexStr;
-        int posIdx = 0, texIdx = -1, normIdx = -1;
-        
-        
-        std::getline(iss, indexStr, '/');
-        if (!indexStr.empty()) {
-            posIdx = std::stoi(indexStr) - 1;
-        }
-        
-        if (std::getline(iss, indexStr, '/')) {
-            if (!indexStr.empty()) {
-                texIdx = std::stoi(indexStr) - 1;
-            }
-            if (std::getline(iss, indexStr)) {
-                if (!indexStr.empty()) {
-                    normIdx = std::stoi(indexStr) - 1;
+    // Потоковый вариант loadOBJMultiple: каждая группа g/o отдаётся в onMesh
+    // сразу, как только собрана, а рабочая память не превышает потолка.
+    static StreamLoadStats loadOBJStreaming(const std::string& filepath,
+                                            const std::function<void(Mesh&&, const std::string&)>& onMesh,
+                                            const Material& material = Material::PlasticWhite(),
+                                            const StreamLoadOptions& options = StreamLoadOptions()) {
+        StreamLoadStats stats;
+        auto start = std::chrono::steady_clock::now();
+        
+        bool opened = ObjStreamParser::parse(filepath,
+            [&](MeshData&& data, const std::string& groupName) {
+                if (!data.hasNormals) {
+                    NormalGenerator::generate(data.vertices, data.indices);
                 }
-            }
-        }
-        
-        
-        Vertex vertex;
+                onMesh(Mesh(data.vertices, data.indices, material), groupName);
+            },
+            options, stats);
         
-        if (posIdx >= 0 && posIdx < (int)positions.size()) {
-            vertex.position = positions[posIdx];
-        } else {
-            vertex.position = glm::vec3(0.0f);
-        }
-        
-        if (texIdx >= 0 && texIdx < (int)texcoords.size()) {
-            vertex.texCoords = texcoords[texIdx];
-        } else {
-            vertex.texCoords = glm::vec2(0.0f);
+        if (!opened) {
+            std::cerr << "Failed to open OBJ file: " << filepath << std::endl;
+            return stats;
         }
         
-        if (normIdx >= 0 && normIdx < (int)normals.size()) {
-            vertex.normal = normals[normIdx];
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Streamed " << stats.meshesEmitted << " meshes (" << stats.groups << " groups) from "
+                  << filepath << ": " << stats.bytesProcessed / (1024.0 * 1024.0) << " MB processed, peak "
+                  << stats.peakMemory / (1024.0 * 1024.0) << " MB of "
+                  << options.memoryCeiling / (1024.0 * 1024.0) << " MB ceiling, "
+                  << seconds * 1000.0 << " ms\n";
+        return stats;
+    }
+
+private:
+    // VAO над уже загруженными bufferView: смещения и шаги берутся из
+    // accessor'ов, индексы читаются из EBO со смещения accessor'а.
+    template <typename ViewBuffer>
+    static Mesh uploadPrimitive(const GltfDocument& doc, const GltfPrimitive& prim,
+                                ViewBuffer&& viewBuffer) {
+        const GltfAccessor& positions = doc.accessors[prim.position];
+        const GltfAccessor& normals = doc.accessors[prim.normal];
+        const GltfAccessor& indices = doc.accessors[prim.indices];
+        
+        VBO& positionBuffer = viewBuffer(positions.bufferView);
+        VBO& normalBuffer = viewBuffer(normals.bufferView);
+        VBO& indexBuffer = viewBuffer(indices.bufferView);
+        
+        VAO vao;
+        vao.bind();
+        vao.linkAttrib(positionBuffer, 0, 3, GL_FLOAT,
+                       static_cast<GLsizeiptr>(doc.bufferViews[positions.bufferView].stride),
+                       (void*)positions.offset);
+        vao.linkAttrib(normalBuffer, 1, 3, GL_FLOAT,
+                       static_cast<GLsizeiptr>(doc.bufferViews[normals.bufferView].stride),
+                       (void*)normals.offset);
+        if (prim.texCoord >= 0) {
+            const GltfAccessor& texCoords = doc.accessors[prim.texCoord];
+            vao.linkAttrib(viewBuffer(texCoords.bufferView), 2, 2, texCoords.componentType,
+                           static_cast<GLsizeiptr>(doc.bufferViews[texCoords.bufferView].stride),
+                           (void*)texCoords.offset, texCoords.normalized ? GL_TRUE : GL_FALSE);
         } else {
-            vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+            glDisableVertexAttribArray(2);
+            glVertexAttrib2f(2, 0.0f, 0.0f);
         }
-        
-        
-        uint32_t newIndex = static_cast<uint32_t>(vertices.size());
-        vertices.push_back(vertex);
-        indices.push_back(newIndex);
-        uniqueVertices[vertexData] = newIndex;
+        // Привязка EBO запоминается в VAO.
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer.id);
+        vao.unbind();
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        
+        Mesh mesh;
+        mesh.VAO_id = vao.id;
+        // Буферы bufferView принадлежат модели, сетке — только свой VAO.
+        mesh.buffers = std::make_shared<MeshBuffers>(vao.id, 0, 0);
+        mesh.indexCount = static_cast<GLsizei>(indices.count);
+        mesh.indexType = indices.componentType;
+        mesh.indexOffset = indices.offset;
+        return mesh;
     }
     
-    static void calculateNormals(std::vector<Vertex>& vertices,
-                                const std::vector<uint32_t>& indices) {
-        
-        for (auto& vertex : vertices) {
-            vertex.normal = glm::vec3(0.0f);
-        }
-        
-        
-        for (size_t i = 0; i < indices.size(); i += 3) {
-            uint32_t idx0 = indices[i];
-            uint32_t idx1 = indices[i + 1];
-            uint32_t idx2 = indices[i + 2];
-            
-            glm::vec3 v0 = vertices[idx0].position;
-            glm::vec3 v1 = vertices[idx1].position;
-            glm::vec3 v2 = vertices[idx2].position;
-            
-            glm::vec3 edge1 = v1 - v0;
-            glm::vec3 edge2 = v2 - v0;
-            glm::vec3 normal = glm::normalize(glm::cross(edge1, edge2));
-            
-            vertices[idx0].normal += normal;
-            vertices[idx1].normal += normal;
-            vertices[idx2].normal += normal;
-        }
-        
+    // Текстура baseColor: изображение декодируется один раз на файл, даже
+    // если на него ссылаются несколько материалов, и одна на все загрузки
+    // того же .glb (через TextureCache).
+    static TextureHandle gltfTexture(const std::string& filepath, const GltfDocument& doc, int image,
+                                     std::vector<TextureHandle>& cache) {
+        if (image < 0) return nullptr;
+        if (cache[image] != nullptr) return cache[image];
+        
+        const GltfImage& src = doc.images[image];
+        TextureSampling sampling;
+        sampling.flipVertically = false;
+        std::string key = src.data != nullptr
+            ? AssetArchive::normalize(filepath) + "#image" + std::to_string(image)
+            : AssetArchive::normalize(src.path);
+        cache[image] = TextureCache::global().acquire(key, sampling, [&](TextureImage& decoded) {
+            return src.data != nullptr
+                ? Texture::decodeMemory(src.data, src.size, decoded, false)
+                : !src.path.empty() && Texture::decode(src.path.c_str(), decoded, false);
+        });
+        return cache[image];
+    }
+    
+    static void processVertex(const ObjParser::Corner& corner,
+                             const std::vector<glm::vec3>& positions,
+                             const std::vector<glm::vec2>& texcoords,
+                             const std::vector<glm::vec3>& normals,
+                             std::vector<Vertex>& vertices,
+                             std::vector<uint32_t>& indices,
+                             VertexDedupTable& uniqueVertices) {
         
-        for (auto& vertex : vertices) {
-            if (glm::length(vertex.normal) > 0.0f) {
-                vertex.normal = glm::normalize(vertex.normal);
-            } else {
-                vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);
-            }
+        bool inserted = false;
+        uint32_t newIndex = static_cast<uint32_t>(vertices.size());
+        uint32_t index = uniqueVertices.findOrInsert(corner.pos, corner.tex, corner.norm,
+                                                     newIndex, inserted);
+        if (inserted) {
+            vertices.push_back(ObjParser::makeVertex(corner, positions, texcoords, normals));
         }
+        indices.push_back(index);
     }
 };
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <filesystem>
+#include <algorithm>
+#include <iostream>
+#include <glm/glm.hpp>
+#include "ObjParser.hpp"
+#include "MappedFile.hpp"
+#include "AssetArchive.hpp"
+#include "Material.hpp"
+
+// Материал из .mtl. Пути к текстурам уже разрешены относительно файла .mtl.
+struct MtlMaterial {
+    std::string name;
+    glm::vec3 ambient  = glm::vec3(0.0f);
+    glm::vec3 diffuse  = glm::vec3(0.8f);
+    glm::vec3 specular = glm::vec3(0.0f);
+    float shininess = 32.0f;
+    std::string diffuseMap;
+
+    Material toMaterial() const {
+        // Ns = 0 в экспортах встречается часто, а pow(x, 0) даёт блик на всём.
+        return { ambient, diffuse, specular, std::clamp(shininess, 1.0f, 1000.0f) };
+    }
+};
+
+// Разбор .mtl: Ka/Kd/Ks/Ns и map_Kd. Остальные параметры (d, illum, карты
+// нормалей и т. п.) шейдер не использует и пропускаются.
+class MtlParser {
+public:
+    static std::vector<MtlMaterial> parse(std::string_view text, const std::string& baseDir) {
+        std::vector<MtlMaterial> materials;
+
+        const char* p = text.data();
+        const char* end = p + text.size();
+        while (p < end) {
+            const char* eol = ObjParser::lineEnd(p, end);
+            const char* start = ObjParser::skipSpaces(p, eol);
+            const char* stop = ObjParser::tokenEnd(start, eol);
+            std::string_view key(start, static_cast<size_t>(stop - start));
+            p = eol + 1;
+
+            if (key == "newmtl") {
+                MtlMaterial material;
+                material.name = std::string(ObjParser::restOfLine(stop, eol));
+                materials.push_back(std::move(material));
+                continue;
+            }
+            if (materials.empty()) continue;
+
+            MtlMaterial& material = materials.back();
+            if (key == "Ka") {
+                material.ambient = ObjParser::readVec3(stop, eol);
+            } else if (key == "Kd") {
+                material.diffuse = ObjParser::readVec3(stop, eol);
+            } else if (key == "Ks") {
+                material.specular = ObjParser::readVec3(stop, eol);
+            } else if (key == "Ns") {
+                ObjParser::parseFloat(stop, eol, material.shininess);
+            } else if (key == "map_Kd") {
+                // Опции вида "-s 1 1 1" идут перед именем файла: берём последний токен.
+                std::string_view file = lastToken(stop, eol);
+                if (!file.empty()) {
+                    material.diffuseMap = (std::filesystem::path(baseDir) / std::string(file))
+                                              .lexically_normal().generic_string();
+                }
+            }
+        }
+        return materials;
+    }
+
+    // Загрузка файла (сначала из смонтированного архива). Ошибка чтения не
+    // фатальна: модель просто получит материалы по умолчанию.
+    static bool load(const std::string& path, std::vector<MtlMaterial>& out) {
+        std::string baseDir = std::filesystem::path(path).parent_path().generic_string();
+
+        std::string_view archived;
+        if (AssetArchive::global().findRaw(path, archived)) {
+            out = parse(archived, baseDir);
+            return true;
+        }
+
+        MappedFile file(path);
+        if (!file.isOpen()) {
+            std::cerr << "Failed to open MTL file: " << path << std::endl;
+            return false;
+        }
+        out = parse(file.view(), baseDir);
+        return true;
+    }
+
+private:
+    static std::string_view lastToken(const char* p, const char* end) {
+        while (end > p && ObjParser::isSpace(end[-1])) --end;
+        const char* start = end;
+        while (start > p && !ObjParser::isSpace(start[-1])) --start;
+        return std::string_view(start, static_cast<size_t>(end - start));
+    }
+};
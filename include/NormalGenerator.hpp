@@ -0,0 +1,294 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <barrier>
+#include <cmath>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "Vertex.hpp"
+#include "Parallel.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NORMALS_SSE 1
+#endif
+
+enum class NormalWeighting {
+    Uniform,   // единичные нормали граней, как в исходном calculateNormals
+    Area,      // вклад грани пропорционален её площади
+    Angle      // вклад грани пропорционален углу при вершине
+};
+
+// Генерация вершинных нормалей по индексированным треугольникам.
+// Вклады граней (для Angle — углов) считаются пачками в SoA-массивы и
+// нормализуются по четыре за раз (SSE2); вершинные суммы нормализуются так же.
+// Один поток идёт по граням блоками, которые помещаются в L1, и сразу
+// прибавляет вклады к нормалям вершин. На нескольких каждый поток считает
+// вклады своих блоков граней, а после барьера суммирует свой диапазон
+// вершин сам — без гонок и атомарных float, за один запуск потоков.
+// Блоки одинаковы в обеих ветках и вклады суммируются в порядке индексов,
+// поэтому результат не зависит от числа потоков.
+class NormalGenerator {
+public:
+    static constexpr size_t MIN_FACES_PER_THREAD = 4096;
+    static constexpr size_t BLOCK = 64;   // граней или вершин в одной пачке
+
+    static void generate(std::vector<Vertex>& vertices,
+                         const std::vector<uint32_t>& indices,
+                         NormalWeighting weighting = NormalWeighting::Uniform,
+                         unsigned threadCount = 0) {
+        if (vertices.empty()) return;
+        if (threadCount == 0) threadCount = Parallel::hardwareThreads();
+
+        const size_t faceCount = indices.size() / 3;
+        const size_t chunks = std::min<size_t>(threadCount, faceCount / MIN_FACES_PER_THREAD);
+        if (chunks <= 1) {
+            generateSequential(vertices, indices, weighting);
+        } else {
+            generateParallel(vertices, indices, weighting, static_cast<unsigned>(chunks));
+        }
+    }
+
+    // Нормализация в SoA-раскладке, с SSE2 — по четыре вектора за раз.
+    // Нулевые векторы заменяются на (0, 1, 0).
+    static void normalizeSoA(float* x, float* y, float* z, size_t count) {
+        normalizeSoA(x, y, z, count, 1.0f);
+    }
+
+private:
+    // fallbackY: во что превращается нулевой вектор — (0, fallbackY, 0).
+    // sqrt и деление точные и в SSE, так что хвост без SIMD даёт те же биты.
+    static void normalizeSoA(float* x, float* y, float* z, size_t count, float fallbackY) {
+        size_t i = 0;
+#ifdef NORMALS_SSE
+        for (; i + 4 <= count; i += 4) {
+            __m128 vx = _mm_loadu_ps(x + i);
+            __m128 vy = _mm_loadu_ps(y + i);
+            __m128 vz = _mm_loadu_ps(z + i);
+            normalize4(vx, vy, vz, fallbackY);
+            _mm_storeu_ps(x + i, vx);
+            _mm_storeu_ps(y + i, vy);
+            _mm_storeu_ps(z + i, vz);
+        }
+#endif
+        for (; i < count; ++i) {
+            float len2 = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+            bool valid = len2 > 0.0f;
+            float inv = 1.0f / std::sqrt(valid ? len2 : 1.0f);
+            x[i] = valid ? x[i] * inv : 0.0f;
+            y[i] = valid ? y[i] * inv : fallbackY;
+            z[i] = valid ? z[i] * inv : 0.0f;
+        }
+    }
+
+#ifdef NORMALS_SSE
+    static void normalize4(__m128& x, __m128& y, __m128& z, float fallbackY) {
+        const __m128 one = _mm_set1_ps(1.0f);
+        __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        __m128 valid = _mm_cmpgt_ps(len2, _mm_setzero_ps());
+        __m128 inv = _mm_div_ps(one, _mm_sqrt_ps(_mm_or_ps(_mm_and_ps(valid, len2), _mm_andnot_ps(valid, one))));
+        x = _mm_and_ps(valid, _mm_mul_ps(x, inv));
+        y = _mm_or_ps(_mm_and_ps(valid, _mm_mul_ps(y, inv)), _mm_andnot_ps(valid, _mm_set1_ps(fallbackY)));
+        z = _mm_and_ps(valid, _mm_mul_ps(z, inv));
+    }
+#endif
+
+    static size_t stride(NormalWeighting weighting) {
+        // Uniform и Area: один вклад на грань, Angle: по одному на угол.
+        return weighting == NormalWeighting::Angle ? 3 : 1;
+    }
+
+    static void generateSequential(std::vector<Vertex>& vertices,
+                                   const std::vector<uint32_t>& indices,
+                                   NormalWeighting weighting) {
+        const size_t vertexCount = vertices.size();
+        const size_t faceCount = indices.size() / 3;
+        const size_t step = stride(weighting);
+        for (auto& vertex : vertices) {
+            vertex.normal = glm::vec3(0.0f);
+        }
+
+        // Позиции вершин блока только что прочитаны, и их нормали (та же
+        // строка кэша) ещё в L1, когда к ним прибавляются вклады.
+        float cx[BLOCK * 3], cy[BLOCK * 3], cz[BLOCK * 3];
+        for (size_t begin = 0; begin < faceCount; begin += BLOCK) {
+            size_t end = std::min(begin + BLOCK, faceCount);
+            contributions(vertices, indices.data(), begin, end, weighting, cx, cy, cz);
+            const uint32_t* tri = indices.data() + begin * 3;
+            for (size_t f = 0; f < end - begin; ++f, tri += 3) {
+                if (tri[0] >= vertexCount || tri[1] >= vertexCount || tri[2] >= vertexCount) continue;
+                for (size_t k = 0; k < 3; ++k) {
+                    size_t j = f * step + (step == 1 ? 0 : k);
+                    glm::vec3& n = vertices[tri[k]].normal;
+                    n.x += cx[j];
+                    n.y += cy[j];
+                    n.z += cz[j];
+                }
+            }
+        }
+
+        normalizeNormals(vertices, 0, vertexCount);
+    }
+
+    // Поток t считает вклады своих блоков граней и запоминает для каждого
+    // блока наименьший и наибольший номер вершины. После барьера поток t
+    // владеет диапазоном вершин: обнуляет, суммирует и нормализует его,
+    // проходя в порядке углов только блоки, которые его касаются. Вершины в
+    // OBJ нумеруются по первому появлению, так что таких блоков немного.
+    static void generateParallel(std::vector<Vertex>& vertices,
+                                 const std::vector<uint32_t>& indices,
+                                 NormalWeighting weighting, unsigned chunks) {
+        const size_t vertexCount = vertices.size();
+        const size_t faceCount = indices.size() / 3;
+        const size_t step = stride(weighting);
+        const size_t blockCount = (faceCount + BLOCK - 1) / BLOCK;
+
+        std::vector<float> cx(faceCount * step), cy(faceCount * step), cz(faceCount * step);
+        std::vector<uint32_t> blockMin(blockCount), blockMax(blockCount);
+        std::barrier sync(static_cast<std::ptrdiff_t>(chunks));
+
+        Parallel::forEachIndex(chunks, [&](size_t t) {
+            for (size_t block = blockCount * t / chunks; block < blockCount * (t + 1) / chunks; ++block) {
+                const size_t b = block * BLOCK;
+                const size_t e = std::min(b + BLOCK, faceCount);
+                contributions(vertices, indices.data(), b, e, weighting,
+                              cx.data() + b * step, cy.data() + b * step, cz.data() + b * step);
+                uint32_t lo = UINT32_MAX, hi = 0;
+                for (size_t c = b * 3; c < e * 3; ++c) {
+                    lo = std::min(lo, indices[c]);
+                    hi = std::max(hi, indices[c]);
+                }
+                blockMin[block] = lo;
+                blockMax[block] = hi;
+            }
+
+            sync.arrive_and_wait();
+
+            const size_t begin = (t * vertexCount + chunks - 1) / chunks;
+            const size_t end = ((t + 1) * vertexCount + chunks - 1) / chunks;
+            for (size_t v = begin; v < end; ++v) {
+                vertices[v].normal = glm::vec3(0.0f);
+            }
+            for (size_t block = 0; block < blockCount; ++block) {
+                if (blockMax[block] < begin || blockMin[block] >= end) continue;
+                const size_t last = std::min((block + 1) * BLOCK, faceCount) * 3;
+                for (size_t c = block * BLOCK * 3; c < last; ++c) {
+                    size_t v = indices[c];
+                    if (v - begin >= end - begin) continue;
+                    size_t j = step == 1 ? c / 3 : c;
+                    glm::vec3& n = vertices[v].normal;
+                    n.x += cx[j];
+                    n.y += cy[j];
+                    n.z += cz[j];
+                }
+            }
+            normalizeNormals(vertices, begin, end);
+        });
+    }
+
+    // Нормали вершин [begin, end) пачками через SoA.
+    static void normalizeNormals(std::vector<Vertex>& vertices, size_t begin, size_t end) {
+        float x[BLOCK], y[BLOCK], z[BLOCK];
+        for (size_t b = begin; b < end; b += BLOCK) {
+            size_t count = std::min(BLOCK, end - b);
+            for (size_t i = 0; i < count; ++i) {
+                const glm::vec3& n = vertices[b + i].normal;
+                x[i] = n.x;
+                y[i] = n.y;
+                z[i] = n.z;
+            }
+            normalizeSoA(x, y, z, count, 1.0f);
+            for (size_t i = 0; i < count; ++i) {
+                glm::vec3& n = vertices[b + i].normal;
+                n.x = x[i];
+                n.y = y[i];
+                n.z = z[i];
+            }
+        }
+    }
+
+    // Вклады граней [begin, end) в cx/cy/cz с нуля (не больше BLOCK граней).
+    // Сначала векторные произведения, затем нормализация или масштаб одним
+    // проходом по SoA. Вырожденные грани и выход индекса за пределы массива
+    // дают нулевой вклад (раньше — NaN).
+    static void contributions(const std::vector<Vertex>& vertices, const uint32_t* indices,
+                              size_t begin, size_t end, NormalWeighting weighting,
+                              float* cx, float* cy, float* cz) {
+        const size_t vertexCount = vertices.size();
+        if (weighting == NormalWeighting::Angle) {
+            for (size_t f = begin; f < end; ++f) {
+                glm::vec3 c[3];
+                angleContributions(vertices, &indices[f * 3], c);
+                for (size_t k = 0; k < 3; ++k) {
+                    size_t j = (f - begin) * 3 + k;
+                    cx[j] = c[k].x;
+                    cy[j] = c[k].y;
+                    cz[j] = c[k].z;
+                }
+            }
+            return;
+        }
+
+        const size_t count = end - begin;
+        for (size_t i = 0; i < count; ++i) {
+            const uint32_t* tri = &indices[(begin + i) * 3];
+            if (tri[0] >= vertexCount || tri[1] >= vertexCount || tri[2] >= vertexCount) {
+                cx[i] = cy[i] = cz[i] = 0.0f;
+                continue;
+            }
+            const glm::vec3& p0 = vertices[tri[0]].position;
+            const glm::vec3& p1 = vertices[tri[1]].position;
+            const glm::vec3& p2 = vertices[tri[2]].position;
+            float e1x = p1.x - p0.x, e1y = p1.y - p0.y, e1z = p1.z - p0.z;
+            float e2x = p2.x - p0.x, e2y = p2.y - p0.y, e2z = p2.z - p0.z;
+            cx[i] = e1y * e2z - e1z * e2y;
+            cy[i] = e1z * e2x - e1x * e2z;
+            cz[i] = e1x * e2y - e1y * e2x;
+        }
+
+        if (weighting == NormalWeighting::Uniform) {
+            normalizeSoA(cx, cy, cz, count, 0.0f);
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                float len2 = cx[i] * cx[i] + cy[i] * cy[i] + cz[i] * cz[i];
+                float scale = len2 > 0.0f ? 0.5f : 0.0f;
+                cx[i] *= scale;
+                cy[i] *= scale;
+                cz[i] *= scale;
+            }
+        }
+    }
+
+    // Вклад каждого угла: единичная нормаль грани, умноженная на угол при вершине.
+    static void angleContributions(const std::vector<Vertex>& vertices, const uint32_t* tri, glm::vec3 out[3]) {
+        out[0] = out[1] = out[2] = glm::vec3(0.0f);
+        const size_t vertexCount = vertices.size();
+        if (tri[0] >= vertexCount || tri[1] >= vertexCount || tri[2] >= vertexCount) {
+            return;
+        }
+
+        const glm::vec3& p0 = vertices[tri[0]].position;
+        const glm::vec3& p1 = vertices[tri[1]].position;
+        const glm::vec3& p2 = vertices[tri[2]].position;
+        const glm::vec3 e1 = p1 - p0;
+        const glm::vec3 e2 = p2 - p0;
+        const glm::vec3 cross = glm::cross(e1, e2);
+        const float len2 = glm::dot(cross, cross);
+        if (!(len2 > 0.0f)) {
+            return;
+        }
+
+        const glm::vec3 unit = cross / std::sqrt(len2);
+        out[0] = unit * cornerAngle(e1, e2);
+        out[1] = unit * cornerAngle(p2 - p1, p0 - p1);
+        out[2] = unit * cornerAngle(p0 - p2, p1 - p2);
+    }
+
+    static float cornerAngle(const glm::vec3& a, const glm::vec3& b) {
+        float la = glm::length(a), lb = glm::length(b);
+        if (la <= 0.0f || lb <= 0.0f) return 0.0f;
+        float c = glm::dot(a, b) / (la * lb);
+        return std::acos(c < -1.0f ? -1.0f : (c > 1.0f ? 1.0f : c));
+    }
+};
@@ -0,0 +1,631 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "Vertex.hpp"
+#include "MeshData.hpp"
+#include "VertexDedupTable.hpp"
+#include "Parallel.hpp"
+
+// Участок индексов одного материала (usemtl) в общей сетке модели.
+struct ObjMaterialRange {
+    std::string material;      // пусто — грани до первого usemtl
+    uint32_t indexOffset = 0;
+    uint32_t indexCount = 0;
+};
+
+// Модель с материалами: одна сетка на все части, индексы сгруппированы по
+// материалам в порядке их первого появления, на каждый материал один участок.
+struct ObjModelData {
+    MeshData mesh;
+    std::vector<ObjMaterialRange> ranges;
+    std::vector<std::string> materialLibraries;   // mtllib, как записаны в файле
+};
+
+// Разбор OBJ прямо по буферу (обычно отображённому в память файлу),
+// без std::string и istringstream на каждую строку.
+class ObjParser {
+public:
+    enum class LineType {
+        Other,
+        Position,
+        TexCoord,
+        Normal,
+        Face,
+        Group,
+        UseMaterial,
+        MaterialLibrary
+    };
+
+    struct Corner {
+        int pos  = 0;
+        int tex  = -1;
+        int norm = -1;
+    };
+
+    static MeshData parse(std::string_view text) {
+        MeshData out;
+
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec2> texcoords;
+        std::vector<Corner> faceCorners;
+        VertexDedupTable uniqueVertices(expectedVertexCount(countFaces(text)));
+
+        const char* p = text.data();
+        const char* end = p + text.size();
+
+        while (p < end) {
+            const char* eol = lineEnd(p, end);
+            const char* cur = p;
+
+            switch (classify(cur, eol)) {
+            case LineType::Position:
+                positions.push_back(readVec3(cur, eol));
+                break;
+            case LineType::TexCoord:
+                texcoords.push_back(readVec2(cur, eol));
+                break;
+            case LineType::Normal:
+                normals.push_back(readVec3(cur, eol));
+                break;
+            case LineType::Face:
+                readFaceCorners(cur, eol, faceCorners);
+                for (Corner& c : faceCorners) {
+                    resolveCorner(c, positions.size(), texcoords.size(), normals.size());
+                }
+                if (faceCorners.size() >= 3) {
+                    for (size_t i = 1; i < faceCorners.size() - 1; ++i) {
+                        processCorner(faceCorners[0], positions, texcoords, normals, out, uniqueVertices);
+                        processCorner(faceCorners[i], positions, texcoords, normals, out, uniqueVertices);
+                        processCorner(faceCorners[i + 1], positions, texcoords, normals, out, uniqueVertices);
+                    }
+                }
+                break;
+            default:
+                break;
+            }
+
+            p = eol + 1;
+        }
+
+        out.hasNormals = !normals.empty();
+        return out;
+    }
+
+    // Разбор с учётом usemtl/mtllib. Вершины общие для всей модели (как в
+    // parse()), а треугольники раскладываются по материалам, чтобы каждый
+    // материал рисовался одним вызовом из общего EBO.
+    static ObjModelData parseWithMaterials(std::string_view text) {
+        ObjModelData out;
+
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec2> texcoords;
+        std::vector<Corner> faceCorners;
+        VertexDedupTable uniqueVertices(expectedVertexCount(countFaces(text)));
+
+        std::vector<std::string> names;
+        std::vector<std::vector<uint32_t>> perMaterial;
+        size_t current = SIZE_MAX;
+
+        const char* p = text.data();
+        const char* end = p + text.size();
+
+        while (p < end) {
+            const char* eol = lineEnd(p, end);
+            const char* cur = p;
+
+            switch (classify(cur, eol)) {
+            case LineType::Position:
+                positions.push_back(readVec3(cur, eol));
+                break;
+            case LineType::TexCoord:
+                texcoords.push_back(readVec2(cur, eol));
+                break;
+            case LineType::Normal:
+                normals.push_back(readVec3(cur, eol));
+                break;
+            case LineType::UseMaterial: {
+                std::string_view name = restOfLine(cur, eol);
+                auto it = std::find(names.begin(), names.end(), name);
+                current = static_cast<size_t>(it - names.begin());
+                if (it == names.end()) {
+                    names.emplace_back(name);
+                    perMaterial.emplace_back();
+                }
+                break;
+            }
+            case LineType::MaterialLibrary:
+                while (true) {
+                    cur = skipSpaces(cur, eol);
+                    if (cur >= eol) break;
+                    const char* stop = tokenEnd(cur, eol);
+                    out.materialLibraries.emplace_back(cur, stop);
+                    cur = stop;
+                }
+                break;
+            case LineType::Face:
+                readFaceCorners(cur, eol, faceCorners);
+                for (Corner& c : faceCorners) {
+                    resolveCorner(c, positions.size(), texcoords.size(), normals.size());
+                }
+                if (faceCorners.size() >= 3) {
+                    // Грани до первого usemtl — материал с пустым именем.
+                    if (current == SIZE_MAX) {
+                        current = names.size();
+                        names.emplace_back();
+                        perMaterial.emplace_back();
+                    }
+                    std::vector<uint32_t>& indices = perMaterial[current];
+                    for (size_t i = 1; i < faceCorners.size() - 1; ++i) {
+                        indices.push_back(vertexIndex(faceCorners[0], positions, texcoords, normals,
+                                                      out.mesh.vertices, uniqueVertices));
+                        indices.push_back(vertexIndex(faceCorners[i], positions, texcoords, normals,
+                                                      out.mesh.vertices, uniqueVertices));
+                        indices.push_back(vertexIndex(faceCorners[i + 1], positions, texcoords, normals,
+                                                      out.mesh.vertices, uniqueVertices));
+                    }
+                }
+                break;
+            default:
+                break;
+            }
+
+            p = eol + 1;
+        }
+
+        size_t total = 0;
+        for (const auto& indices : perMaterial) total += indices.size();
+        out.mesh.indices.reserve(total);
+        for (size_t m = 0; m < perMaterial.size(); ++m) {
+            if (perMaterial[m].empty()) continue;
+            ObjMaterialRange range;
+            range.material = names[m];
+            range.indexOffset = static_cast<uint32_t>(out.mesh.indices.size());
+            range.indexCount = static_cast<uint32_t>(perMaterial[m].size());
+            out.mesh.indices.insert(out.mesh.indices.end(), perMaterial[m].begin(), perMaterial[m].end());
+            out.ranges.push_back(std::move(range));
+        }
+
+        out.mesh.hasNormals = !normals.empty();
+        return out;
+    }
+
+    // Многопоточный разбор: файл режется на чанки по границам строк, каждый
+    // чанк разбирается в своём потоке, затем результаты сливаются по порядку.
+    // Результат совпадает с parse() байт в байт.
+    static MeshData parseParallel(std::string_view text, unsigned threadCount = 0) {
+        if (threadCount == 0) {
+            threadCount = Parallel::hardwareThreads();
+        }
+        size_t maxChunks = std::max<size_t>(1, text.size() / MIN_CHUNK_SIZE);
+        size_t chunkCount = std::min<size_t>(threadCount, maxChunks);
+        if (chunkCount <= 1) {
+            return parse(text);
+        }
+
+        std::vector<Chunk> chunks = splitIntoChunks(text, chunkCount);
+
+        // Проход 1: считаем v/vt/vn в каждом чанке, чтобы знать глобальные смещения.
+        Parallel::forEachIndex(chunks.size(), [&](size_t i) {
+            countRecords(chunks[i]);
+        });
+
+        size_t totalPositions = 0, totalTexcoords = 0, totalNormals = 0;
+        for (Chunk& chunk : chunks) {
+            chunk.positionOffset = totalPositions;
+            chunk.texcoordOffset = totalTexcoords;
+            chunk.normalOffset = totalNormals;
+            totalPositions += chunk.positionCount;
+            totalTexcoords += chunk.texcoordCount;
+            totalNormals += chunk.normalCount;
+        }
+
+        std::vector<glm::vec3> positions(totalPositions);
+        std::vector<glm::vec2> texcoords(totalTexcoords);
+        std::vector<glm::vec3> normals(totalNormals);
+
+        // Проход 2: атрибуты пишутся сразу на свои места, грани раскладываются
+        // веером в тройки углов с уже проверенными индексами.
+        Parallel::forEachIndex(chunks.size(), [&](size_t i) {
+            parseChunk(chunks[i], positions, texcoords, normals);
+        });
+
+        // Проход 3: каждый чанк дедуплицирует свои углы в своей таблице.
+        Parallel::forEachIndex(chunks.size(), [&](size_t i) {
+            dedupChunk(chunks[i]);
+        });
+
+        // Проход 4: уникальные углы чанков по порядку сливаются в общую
+        // таблицу. Внутри чанка они идут в порядке первого появления, так
+        // что вершины нумеруются в порядке файла, как в parse(). Этот проход
+        // последовательный, но на вершину чанка в нём один угол, а не все
+        // (на сетке из квадов — примерно в 6 раз меньше работы).
+        size_t cornerCount = 0;
+        size_t uniqueCount = 0;
+        for (Chunk& chunk : chunks) {
+            chunk.indexOffset = cornerCount;
+            cornerCount += chunk.localIndices.size();
+            uniqueCount += chunk.uniqueCorners.size();
+        }
+
+        VertexDedupTable uniqueVertices(uniqueCount);
+        std::vector<Corner> vertexCorners;
+        vertexCorners.reserve(uniqueCount);
+        for (Chunk& chunk : chunks) {
+            chunk.remap.resize(chunk.uniqueCorners.size());
+            for (size_t j = 0; j < chunk.uniqueCorners.size(); ++j) {
+                const Corner& c = chunk.uniqueCorners[j];
+                bool inserted = false;
+                uint32_t newIndex = static_cast<uint32_t>(vertexCorners.size());
+                chunk.remap[j] = uniqueVertices.findOrInsert(c.pos, c.tex, c.norm, newIndex, inserted);
+                if (inserted) {
+                    vertexCorners.push_back(c);
+                }
+            }
+            chunk.uniqueCorners = std::vector<Corner>();
+        }
+
+        // Проход 5: индексы переписываются через remap чанка, вершины
+        // собираются из атрибутов — и то и другое по потокам.
+        MeshData out;
+        out.indices.resize(cornerCount);
+        out.vertices.resize(vertexCorners.size());
+        Parallel::forEachIndex(chunks.size(), [&](size_t i) {
+            Chunk& chunk = chunks[i];
+            uint32_t* indices = out.indices.data() + chunk.indexOffset;
+            for (size_t j = 0; j < chunk.localIndices.size(); ++j) {
+                indices[j] = chunk.remap[chunk.localIndices[j]];
+            }
+            chunk.localIndices = std::vector<uint32_t>();
+            chunk.remap = std::vector<uint32_t>();
+
+            size_t begin = vertexCorners.size() * i / chunks.size();
+            size_t end = vertexCorners.size() * (i + 1) / chunks.size();
+            for (size_t v = begin; v < end; ++v) {
+                out.vertices[v] = makeVertex(vertexCorners[v], positions, texcoords, normals);
+            }
+        });
+
+        out.hasNormals = totalNormals > 0;
+        return out;
+    }
+
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    static const char* lineEnd(const char* p, const char* end) {
+        const void* nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+        return nl ? static_cast<const char*>(nl) : end;
+    }
+
+    static const char* skipSpaces(const char* p, const char* end) {
+        while (p < end && isSpace(*p)) ++p;
+        return p;
+    }
+
+    static const char* tokenEnd(const char* p, const char* end) {
+        while (p < end && !isSpace(*p)) ++p;
+        return p;
+    }
+
+    // Остаток строки без пробелов по краям (имена материалов и файлов
+    // могут содержать пробелы).
+    static std::string_view restOfLine(const char* p, const char* end) {
+        p = skipSpaces(p, end);
+        while (end > p && isSpace(end[-1])) --end;
+        return std::string_view(p, static_cast<size_t>(end - p));
+    }
+
+    // Определяет тип строки по первому токену и сдвигает p за него.
+    static LineType classify(const char*& p, const char* end) {
+        const char* start = skipSpaces(p, end);
+        const char* stop = tokenEnd(start, end);
+        p = stop;
+
+        size_t len = static_cast<size_t>(stop - start);
+        if (len == 1) {
+            if (start[0] == 'v') return LineType::Position;
+            if (start[0] == 'f') return LineType::Face;
+            if (start[0] == 'g' || start[0] == 'o') return LineType::Group;
+        } else if (len == 2 && start[0] == 'v') {
+            if (start[1] == 't') return LineType::TexCoord;
+            if (start[1] == 'n') return LineType::Normal;
+        } else if (len == 6) {
+            if (std::memcmp(start, "usemtl", 6) == 0) return LineType::UseMaterial;
+            if (std::memcmp(start, "mtllib", 6) == 0) return LineType::MaterialLibrary;
+        }
+        return LineType::Other;
+    }
+
+    // Читает float как operator>>: пропускает пробелы, допускает ведущий '+'.
+    static const char* parseFloat(const char* p, const char* end, float& out) {
+        p = skipSpaces(p, end);
+        const char* start = p;
+        if (p < end && *p == '+') ++start;
+        auto res = std::from_chars(start, end, out);
+        if (res.ec != std::errc()) {
+            out = 0.0f;
+            return end;
+        }
+        return res.ptr;
+    }
+
+    // Читает целое как std::stoi: пробелы, необязательный знак, цифры.
+    static const char* parseInt(const char* p, const char* end, int& out, bool& ok) {
+        p = skipSpaces(p, end);
+        const char* start = p;
+        if (p < end && *p == '+') ++start;
+        auto res = std::from_chars(start, end, out);
+        ok = res.ec == std::errc();
+        return ok ? res.ptr : p;
+    }
+
+    static glm::vec3 readVec3(const char* p, const char* end) {
+        glm::vec3 v(0.0f);
+        p = parseFloat(p, end, v.x);
+        p = parseFloat(p, end, v.y);
+        parseFloat(p, end, v.z);
+        return v;
+    }
+
+    static glm::vec2 readVec2(const char* p, const char* end) {
+        glm::vec2 v(0.0f);
+        p = parseFloat(p, end, v.x);
+        parseFloat(p, end, v.y);
+        return v;
+    }
+
+    static void readFaceCorners(const char* p, const char* end, std::vector<Corner>& corners) {
+        corners.clear();
+        while (true) {
+            p = skipSpaces(p, end);
+            if (p >= end) break;
+            const char* stop = tokenEnd(p, end);
+            corners.push_back(parseCorner(std::string_view(p, static_cast<size_t>(stop - p))));
+            p = stop;
+        }
+    }
+
+    // Индекс, ссылающийся вперёд (на ещё не объявленный атрибут), считается
+    // недействительным, как и в исходном загрузчике.
+    static int resolveIndex(int index, size_t visibleCount) {
+        return (index >= 0 && static_cast<size_t>(index) < visibleCount) ? index : -1;
+    }
+
+    static void resolveCorner(Corner& c, size_t positionCount, size_t texcoordCount, size_t normalCount) {
+        c.pos = resolveIndex(c.pos, positionCount);
+        c.tex = resolveIndex(c.tex, texcoordCount);
+        c.norm = resolveIndex(c.norm, normalCount);
+    }
+
+    static size_t countFaces(std::string_view text) {
+        size_t faces = 0;
+        const char* p = text.data();
+        const char* end = p + text.size();
+        while (p < end) {
+            p = skipSpaces(p, end);
+            if (end - p >= 2 && p[0] == 'f' && isSpace(p[1])) {
+                ++faces;
+            }
+            p = lineEnd(p, end) + 1;
+        }
+        return faces;
+    }
+
+    // Для типичных сеток уникальных вершин не больше полутора числа граней.
+    static size_t expectedVertexCount(size_t faceCount) {
+        return faceCount + faceCount / 2;
+    }
+
+    // Разбирает "p", "p/t", "p//n" или "p/t/n" в индексы с нуля (-1 — нет атрибута).
+    static Corner parseCorner(std::string_view token) {
+        Corner c;
+        const char* p = token.data();
+        const char* end = p + token.size();
+        const char* slash = static_cast<const char*>(std::memchr(p, '/', token.size()));
+        const char* fieldEnd = slash ? slash : end;
+
+        int value = 0;
+        bool ok = false;
+        if (fieldEnd != p) {
+            parseInt(p, fieldEnd, value, ok);
+            if (ok) c.pos = value - 1;
+        }
+        if (!slash) return c;
+
+        p = slash + 1;
+        slash = static_cast<const char*>(std::memchr(p, '/', static_cast<size_t>(end - p)));
+        fieldEnd = slash ? slash : end;
+        if (fieldEnd != p) {
+            parseInt(p, fieldEnd, value, ok);
+            if (ok) c.tex = value - 1;
+        }
+        if (!slash) return c;
+
+        p = slash + 1;
+        if (p != end) {
+            parseInt(p, end, value, ok);
+            if (ok) c.norm = value - 1;
+        }
+        return c;
+    }
+
+    static Vertex makeVertex(const Corner& c,
+                             const std::vector<glm::vec3>& positions,
+                             const std::vector<glm::vec2>& texcoords,
+                             const std::vector<glm::vec3>& normals) {
+        Vertex vertex;
+
+        if (c.pos >= 0 && c.pos < (int)positions.size()) {
+            vertex.position = positions[c.pos];
+        } else {
+            vertex.position = glm::vec3(0.0f);
+        }
+
+        if (c.tex >= 0 && c.tex < (int)texcoords.size()) {
+            vertex.texCoords = texcoords[c.tex];
+        } else {
+            vertex.texCoords = glm::vec2(0.0f);
+        }
+
+        if (c.norm >= 0 && c.norm < (int)normals.size()) {
+            vertex.normal = normals[c.norm];
+        } else {
+            vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+        }
+
+        return vertex;
+    }
+
+private:
+    static constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
+
+    struct Chunk {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        size_t positionCount = 0;
+        size_t texcoordCount = 0;
+        size_t normalCount = 0;
+        size_t faceCount = 0;
+        size_t positionOffset = 0;
+        size_t texcoordOffset = 0;
+        size_t normalOffset = 0;
+        size_t indexOffset = 0;
+        std::vector<Corner> corners;
+        std::vector<Corner> uniqueCorners;    // в порядке первого появления в чанке
+        std::vector<uint32_t> localIndices;   // на угол — номер в uniqueCorners
+        std::vector<uint32_t> remap;          // номер в uniqueCorners -> вершина модели
+    };
+
+    static std::vector<Chunk> splitIntoChunks(std::string_view text, size_t chunkCount) {
+        std::vector<Chunk> chunks;
+        const char* begin = text.data();
+        const char* end = begin + text.size();
+        const char* cur = begin;
+        for (size_t i = 1; i <= chunkCount && cur < end; ++i) {
+            const char* stop = end;
+            if (i < chunkCount) {
+                const char* target = begin + text.size() * i / chunkCount;
+                if (target < cur) target = cur;
+                stop = lineEnd(target, end);
+                if (stop < end) ++stop;
+            }
+            Chunk chunk;
+            chunk.begin = cur;
+            chunk.end = stop;
+            chunks.push_back(std::move(chunk));
+            cur = stop;
+        }
+        return chunks;
+    }
+
+    static void countRecords(Chunk& chunk) {
+        const char* p = chunk.begin;
+        while (p < chunk.end) {
+            const char* eol = lineEnd(p, chunk.end);
+            const char* cur = p;
+            switch (classify(cur, eol)) {
+            case LineType::Position: ++chunk.positionCount; break;
+            case LineType::TexCoord: ++chunk.texcoordCount; break;
+            case LineType::Normal:   ++chunk.normalCount; break;
+            case LineType::Face:     ++chunk.faceCount; break;
+            default: break;
+            }
+            p = eol + 1;
+        }
+    }
+
+    static void parseChunk(Chunk& chunk,
+                           std::vector<glm::vec3>& positions,
+                           std::vector<glm::vec2>& texcoords,
+                           std::vector<glm::vec3>& normals) {
+        size_t pos = chunk.positionOffset;
+        size_t tex = chunk.texcoordOffset;
+        size_t norm = chunk.normalOffset;
+        std::vector<Corner> faceCorners;
+        chunk.corners.reserve(chunk.faceCount * 3);
+
+        const char* p = chunk.begin;
+        while (p < chunk.end) {
+            const char* eol = lineEnd(p, chunk.end);
+            const char* cur = p;
+
+            switch (classify(cur, eol)) {
+            case LineType::Position:
+                positions[pos++] = readVec3(cur, eol);
+                break;
+            case LineType::TexCoord:
+                texcoords[tex++] = readVec2(cur, eol);
+                break;
+            case LineType::Normal:
+                normals[norm++] = readVec3(cur, eol);
+                break;
+            case LineType::Face:
+                readFaceCorners(cur, eol, faceCorners);
+                for (Corner& c : faceCorners) {
+                    resolveCorner(c, pos, tex, norm);
+                }
+                if (faceCorners.size() >= 3) {
+                    for (size_t i = 1; i < faceCorners.size() - 1; ++i) {
+                        chunk.corners.push_back(faceCorners[0]);
+                        chunk.corners.push_back(faceCorners[i]);
+                        chunk.corners.push_back(faceCorners[i + 1]);
+                    }
+                }
+                break;
+            default:
+                break;
+            }
+
+            p = eol + 1;
+        }
+    }
+
+    static void dedupChunk(Chunk& chunk) {
+        VertexDedupTable table(expectedVertexCount(chunk.faceCount));
+        chunk.localIndices.resize(chunk.corners.size());
+        for (size_t j = 0; j < chunk.corners.size(); ++j) {
+            const Corner& c = chunk.corners[j];
+            bool inserted = false;
+            uint32_t newIndex = static_cast<uint32_t>(chunk.uniqueCorners.size());
+            chunk.localIndices[j] = table.findOrInsert(c.pos, c.tex, c.norm, newIndex, inserted);
+            if (inserted) {
+                chunk.uniqueCorners.push_back(c);
+            }
+        }
+        chunk.corners = std::vector<Corner>();
+    }
+
+    static uint32_t vertexIndex(const Corner& c,
+                                const std::vector<glm::vec3>& positions,
+                                const std::vector<glm::vec2>& texcoords,
+                                const std::vector<glm::vec3>& normals,
+                                std::vector<Vertex>& vertices,
+                                VertexDedupTable& uniqueVertices) {
+        bool inserted = false;
+        uint32_t newIndex = static_cast<uint32_t>(vertices.size());
+        uint32_t index = uniqueVertices.findOrInsert(c.pos, c.tex, c.norm, newIndex, inserted);
+        if (inserted) {
+            vertices.push_back(makeVertex(c, positions, texcoords, normals));
+        }
+        return index;
+    }
+
+    static void processCorner(const Corner& c,
+                              const std::vector<glm::vec3>& positions,
+                              const std::vector<glm::vec2>& texcoords,
+                              const std::vector<glm::vec3>& normals,
+                              MeshData& out,
+                              VertexDedupTable& uniqueVertices) {
+        out.indices.push_back(vertexIndex(c, positions, texcoords, normals, out.vertices, uniqueVertices));
+    }
+};
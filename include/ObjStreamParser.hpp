@@ -0,0 +1,319 @@
+#pragma once
+
+#include <vector>
+#include <list>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "MeshData.hpp"
+#include "MappedFile.hpp"
+#include "ObjParser.hpp"
+#include "VertexDedupTable.hpp"
+
+struct StreamLoadOptions {
+    // Потолок рабочей памяти загрузчика (атрибуты в кэше + собираемая группа).
+    size_t memoryCeiling = 512u << 20;
+};
+
+struct StreamLoadStats {
+    size_t bytesProcessed = 0;
+    size_t peakMemory     = 0;
+    size_t groups         = 0;
+    size_t meshesEmitted  = 0;
+};
+
+// Потоковый разбор OBJ по группам g/o. Файл отображается в память, атрибуты
+// не хранятся целиком: они декодируются блоками по требованию и живут в
+// LRU-кэше, ограниченном memoryCeiling. Слишком большая группа выдаётся
+// несколькими частями, чтобы не выйти за потолок.
+class ObjStreamParser {
+public:
+    using GroupCallback = std::function<void(MeshData&& data, const std::string& groupName)>;
+
+    static bool parse(const std::string& filepath, const GroupCallback& onGroup,
+                      const StreamLoadOptions& options, StreamLoadStats& stats) {
+        MappedFile file(filepath);
+        if (!file.isOpen()) {
+            return false;
+        }
+        ObjStreamParser parser(file, options, stats);
+        parser.scan();
+        parser.emitGroups(onGroup);
+        return true;
+    }
+
+private:
+    static constexpr size_t BLOCK_RECORDS = 4096;
+    static constexpr size_t EVICT_GRANULARITY = 16u << 20;
+    static constexpr size_t MIN_OUTPUT_BUDGET = 1u << 20;
+
+    enum Kind { KIND_POSITION = 0, KIND_TEXCOORD = 1, KIND_NORMAL = 2, KIND_COUNT = 3 };
+
+    struct Group {
+        std::string name;
+        size_t begin = 0;
+        size_t end = 0;
+        size_t countsAtBegin[KIND_COUNT] = { 0, 0, 0 };
+        size_t normalsAtFlush = 0;
+    };
+
+    struct Block {
+        std::vector<glm::vec3> values;
+        std::list<uint64_t>::iterator lruIt;
+    };
+
+    const MappedFile& file;
+    StreamLoadOptions options;
+    StreamLoadStats& stats;
+
+    std::vector<size_t> checkpoints[KIND_COUNT];
+    size_t totals[KIND_COUNT] = { 0, 0, 0 };
+    std::vector<Group> groups;
+
+    std::unordered_map<uint64_t, Block> blocks;
+    std::list<uint64_t> lru;
+    size_t blockBytes = 0;
+    size_t blockBudget = 0;
+    size_t workingBytes = 0;
+
+    ObjStreamParser(const MappedFile& f, const StreamLoadOptions& opts, StreamLoadStats& s)
+        : file(f), options(opts), stats(s) {
+        size_t minimum = BLOCK_RECORDS * sizeof(glm::vec3) * KIND_COUNT * 2;
+        blockBudget = std::max(options.memoryCeiling / 2, minimum);
+    }
+
+    static Kind kindOf(ObjParser::LineType type) {
+        switch (type) {
+        case ObjParser::LineType::TexCoord: return KIND_TEXCOORD;
+        case ObjParser::LineType::Normal:   return KIND_NORMAL;
+        default:                            return KIND_POSITION;
+        }
+    }
+
+    static bool isAttribute(ObjParser::LineType type) {
+        return type == ObjParser::LineType::Position ||
+               type == ObjParser::LineType::TexCoord ||
+               type == ObjParser::LineType::Normal;
+    }
+
+    size_t metadataBytes() const {
+        size_t bytes = groups.capacity() * sizeof(Group);
+        for (const auto& c : checkpoints) bytes += c.capacity() * sizeof(size_t);
+        return bytes;
+    }
+
+    void track(size_t currentBytes) {
+        workingBytes = currentBytes;
+        stats.peakMemory = std::max(stats.peakMemory, workingBytes + blockBytes + metadataBytes());
+    }
+
+    // Проход 1: только классификация строк. Запоминаем, где начинается каждый
+    // BLOCK_RECORDS-й атрибут каждого вида и байтовые границы групп.
+    void scan() {
+        const char* base = file.data();
+        const char* p = base;
+        const char* end = base + file.size();
+        const char* evicted = base;
+
+        Group current;
+        current.name = "default";
+
+        while (p < end) {
+            const char* eol = ObjParser::lineEnd(p, end);
+            const char* cur = p;
+            ObjParser::LineType type = ObjParser::classify(cur, eol);
+
+            if (isAttribute(type)) {
+                Kind kind = kindOf(type);
+                if (totals[kind] % BLOCK_RECORDS == 0) {
+                    checkpoints[kind].push_back(static_cast<size_t>(p - base));
+                }
+                ++totals[kind];
+            } else if (type == ObjParser::LineType::Group) {
+                current.end = static_cast<size_t>(p - base);
+                current.normalsAtFlush = totals[KIND_NORMAL];
+                groups.push_back(current);
+
+                current = Group();
+                cur = ObjParser::skipSpaces(cur, eol);
+                current.name.assign(cur, ObjParser::tokenEnd(cur, eol));
+                current.begin = static_cast<size_t>(eol - base) + 1;
+                for (int k = 0; k < KIND_COUNT; ++k) current.countsAtBegin[k] = totals[k];
+            }
+
+            p = eol + 1;
+            if (p - evicted >= static_cast<ptrdiff_t>(EVICT_GRANULARITY)) {
+                file.evict(evicted, std::min(p, end));
+                evicted = std::min(p, end);
+            }
+        }
+
+        current.end = file.size();
+        current.normalsAtFlush = totals[KIND_NORMAL];
+        current.begin = std::min(current.begin, current.end);
+        groups.push_back(current);
+
+        file.evict(evicted, end);
+        stats.bytesProcessed += file.size();
+        track(0);
+    }
+
+    // Достаёт атрибут по глобальному индексу, при необходимости декодируя его блок.
+    const glm::vec3& attribute(Kind kind, size_t index) {
+        size_t blockIndex = index / BLOCK_RECORDS;
+        uint64_t key = (static_cast<uint64_t>(blockIndex) << 2) | kind;
+
+        auto it = blocks.find(key);
+        if (it != blocks.end()) {
+            lru.splice(lru.begin(), lru, it->second.lruIt);
+            return it->second.values[index % BLOCK_RECORDS];
+        }
+
+        Block block;
+        decodeBlock(kind, blockIndex, block.values);
+        size_t bytes = block.values.capacity() * sizeof(glm::vec3);
+
+        while (!lru.empty() && blockBytes + bytes > blockBudget) {
+            auto victim = blocks.find(lru.back());
+            blockBytes -= victim->second.values.capacity() * sizeof(glm::vec3);
+            blocks.erase(victim);
+            lru.pop_back();
+        }
+
+        lru.push_front(key);
+        block.lruIt = lru.begin();
+        blockBytes += bytes;
+        auto inserted = blocks.emplace(key, std::move(block)).first;
+        track(workingBytes);
+        return inserted->second.values[index % BLOCK_RECORDS];
+    }
+
+    void decodeBlock(Kind kind, size_t blockIndex, std::vector<glm::vec3>& out) {
+        size_t first = blockIndex * BLOCK_RECORDS;
+        size_t count = std::min(BLOCK_RECORDS, totals[kind] - first);
+        out.reserve(count);
+
+        const char* base = file.data();
+        const char* p = base + checkpoints[kind][blockIndex];
+        const char* start = p;
+        const char* end = base + file.size();
+
+        while (p < end && out.size() < count) {
+            const char* eol = ObjParser::lineEnd(p, end);
+            const char* cur = p;
+            ObjParser::LineType type = ObjParser::classify(cur, eol);
+            if (isAttribute(type) && kindOf(type) == kind) {
+                if (kind == KIND_TEXCOORD) {
+                    glm::vec2 uv = ObjParser::readVec2(cur, eol);
+                    out.emplace_back(uv.x, uv.y, 0.0f);
+                } else {
+                    out.push_back(ObjParser::readVec3(cur, eol));
+                }
+            }
+            p = eol + 1;
+        }
+
+        stats.bytesProcessed += static_cast<size_t>(std::min(p, end) - start);
+        file.evict(start, std::min(p, end));
+    }
+
+    Vertex makeVertex(const ObjParser::Corner& c) {
+        Vertex vertex;
+        vertex.position = c.pos >= 0 ? attribute(KIND_POSITION, c.pos) : glm::vec3(0.0f);
+        if (c.tex >= 0) {
+            const glm::vec3& uv = attribute(KIND_TEXCOORD, c.tex);
+            vertex.texCoords = glm::vec2(uv.x, uv.y);
+        } else {
+            vertex.texCoords = glm::vec2(0.0f);
+        }
+        vertex.normal = c.norm >= 0 ? attribute(KIND_NORMAL, c.norm) : glm::vec3(0.0f, 1.0f, 0.0f);
+        return vertex;
+    }
+
+    // Проход 2: группы по порядку; грани разбираются заново и собираются в сетку.
+    void emitGroups(const GroupCallback& onGroup) {
+        const char* base = file.data();
+        std::vector<ObjParser::Corner> faceCorners;
+
+        for (const Group& group : groups) {
+            ++stats.groups;
+
+            MeshData part;
+            part.hasNormals = group.normalsAtFlush > 0;
+            VertexDedupTable uniqueVertices;
+            size_t counts[KIND_COUNT] = { group.countsAtBegin[0], group.countsAtBegin[1], group.countsAtBegin[2] };
+            size_t partIndex = 0;
+
+            auto partBytes = [&]() {
+                return part.vertices.capacity() * sizeof(Vertex) +
+                       part.indices.capacity() * sizeof(uint32_t) +
+                       uniqueVertices.memoryBytes();
+            };
+
+            auto flush = [&]() {
+                if (part.vertices.empty()) return;
+                std::string name = group.name;
+                if (partIndex > 0) name += "#" + std::to_string(partIndex);
+                ++partIndex;
+                ++stats.meshesEmitted;
+                bool hasNormals = part.hasNormals;
+                onGroup(std::move(part), name);
+                part = MeshData();
+                part.hasNormals = hasNormals;
+                uniqueVertices = VertexDedupTable();
+                track(0);
+            };
+
+            const char* p = base + group.begin;
+            const char* end = base + group.end;
+            const char* start = p;
+            size_t outputBudget = std::max(options.memoryCeiling - std::min(options.memoryCeiling, blockBudget),
+                                           MIN_OUTPUT_BUDGET);
+
+            while (p < end) {
+                const char* eol = ObjParser::lineEnd(p, end);
+                const char* cur = p;
+                ObjParser::LineType type = ObjParser::classify(cur, eol);
+
+                if (isAttribute(type)) {
+                    ++counts[kindOf(type)];
+                } else if (type == ObjParser::LineType::Face) {
+                    ObjParser::readFaceCorners(cur, eol, faceCorners);
+                    for (ObjParser::Corner& c : faceCorners) {
+                        ObjParser::resolveCorner(c, counts[KIND_POSITION], counts[KIND_TEXCOORD], counts[KIND_NORMAL]);
+                    }
+                    if (faceCorners.size() >= 3) {
+                        if (partBytes() > outputBudget) {
+                            flush();
+                        }
+                        for (size_t i = 1; i < faceCorners.size() - 1; ++i) {
+                            addCorner(faceCorners[0], part, uniqueVertices);
+                            addCorner(faceCorners[i], part, uniqueVertices);
+                            addCorner(faceCorners[i + 1], part, uniqueVertices);
+                        }
+                        track(partBytes());
+                    }
+                }
+                p = eol + 1;
+            }
+
+            flush();
+            stats.bytesProcessed += static_cast<size_t>(end - start);
+            file.evict(start, end);
+        }
+    }
+
+    void addCorner(const ObjParser::Corner& c, MeshData& part, VertexDedupTable& uniqueVertices) {
+        bool inserted = false;
+        uint32_t newIndex = static_cast<uint32_t>(part.vertices.size());
+        uint32_t index = uniqueVertices.findOrInsert(c.pos, c.tex, c.norm, newIndex, inserted);
+        if (inserted) {
+            part.vertices.push_back(makeVertex(c));
+        }
+        part.indices.push_back(index);
+    }
+};
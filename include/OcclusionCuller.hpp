@@ -0,0 +1,290 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "MeshBvh.hpp"
+#include "Parallel.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OCCLUSION_SSE 1
+#endif
+
+// Программное отсечение перекрытых объектов (по мотивам Masked Occlusion
+// Culling, Andersson et al. 2015). Несколько крупных простых окклюдеров
+// (стены, постаменты) растеризуются на CPU в буфер низкого разрешения,
+// потом AABB объектов проверяются по нему до отправки на GPU.
+//
+// Буфер разбит на тайлы 8×4 пикселя. У тайла два слоя: опорный — весь тайл
+// закрыт не дальше zMax0, и рабочий — пиксели из mask закрыты не дальше
+// zMax1. Когда рабочий слой покрывает тайл целиком, он становится опорным.
+// Глубина — z/w в NDC OpenGL; все оценки консервативные: окклюдер может
+// лишь недозакрыть, но не закрыть лишнего (с точностью до центров пикселей).
+// Без GL: годится для проверки без окна и GPU.
+class OcclusionCuller {
+public:
+    static constexpr int WIDTH = 256;
+    static constexpr int HEIGHT = 128;
+    static constexpr int TILE_WIDTH = 8;
+    static constexpr int TILE_HEIGHT = 4;
+    static constexpr int TILES_X = WIDTH / TILE_WIDTH;
+    static constexpr int TILES_Y = HEIGHT / TILE_HEIGHT;
+    // Меньше треугольников — растеризация в одном потоке: запуск потоков дороже.
+    static constexpr size_t PARALLEL_TRIANGLES = 512;
+
+    // Новый кадр: пустой буфер и матрица projection * view.
+    void begin(const glm::mat4& viewProjection) {
+        this->viewProjection = viewProjection;
+        triangles.clear();
+        mask.assign(TILES_X * TILES_Y, 0);
+        zMax0.assign(TILES_X * TILES_Y, FLT_MAX);
+        zMax1.assign(TILES_X * TILES_Y, 0.0f);
+    }
+
+    // Треугольники окклюдера (в пространстве модели) с матрицей model.
+    // Обе стороны граней закрывают одинаково.
+    void addOccluder(const MeshBvh& mesh, const glm::mat4& model) {
+        glm::mat4 mvp = viewProjection * model;
+        for (uint32_t i = 0; i < mesh.triangleCount(); ++i) {
+            glm::vec3 a, b, c;
+            mesh.triangle(i, a, b, c);
+            addTriangle(mvp * glm::vec4(a, 1.0f), mvp * glm::vec4(b, 1.0f), mvp * glm::vec4(c, 1.0f));
+        }
+    }
+
+    // Растеризует накопленные окклюдеры; полосы строк тайлов — по потокам.
+    void rasterize(unsigned threadCount = 0) {
+        unsigned threads = triangles.size() >= PARALLEL_TRIANGLES ? threadCount : 1;
+        Parallel::forRange(TILES_Y, threads, 4, [this](size_t begin, size_t end) {
+            for (const Triangle& triangle : triangles) {
+                rasterizeTriangle(triangle, static_cast<int>(begin), static_cast<int>(end));
+            }
+        });
+    }
+
+    size_t triangleCount() const { return triangles.size(); }
+
+    // false — мировой AABB целиком за окклюдерами. Объекты, задевающие
+    // ближнюю плоскость или вне экрана, считаются видимыми.
+    bool isVisible(const glm::vec3& center, const glm::vec3& extents) const {
+        float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+        float nearest = FLT_MAX;
+        for (int corner = 0; corner < 8; ++corner) {
+            glm::vec3 offset((corner & 1) ? extents.x : -extents.x, (corner & 2) ? extents.y : -extents.y,
+                             (corner & 4) ? extents.z : -extents.z);
+            glm::vec4 clip = viewProjection * glm::vec4(center + offset, 1.0f);
+            if (clip.z < -clip.w || clip.w <= 1e-6f) return true;
+            float x = (clip.x / clip.w * 0.5f + 0.5f) * WIDTH;
+            float y = (clip.y / clip.w * 0.5f + 0.5f) * HEIGHT;
+            minX = std::min(minX, x);
+            maxX = std::max(maxX, x);
+            minY = std::min(minY, y);
+            maxY = std::max(maxY, y);
+            nearest = std::min(nearest, clip.z / clip.w);
+        }
+
+        int x0 = std::max(0, static_cast<int>(std::floor(minX)));
+        int y0 = std::max(0, static_cast<int>(std::floor(minY)));
+        int x1 = std::min(WIDTH - 1, std::max(static_cast<int>(std::ceil(maxX)) - 1, x0));
+        int y1 = std::min(HEIGHT - 1, std::max(static_cast<int>(std::ceil(maxY)) - 1, y0));
+        if (x0 > x1 || y0 > y1) return true;
+
+        for (int ty = y0 / TILE_HEIGHT; ty <= y1 / TILE_HEIGHT; ++ty) {
+            for (int tx = x0 / TILE_WIDTH; tx <= x1 / TILE_WIDTH; ++tx) {
+                size_t tile = static_cast<size_t>(ty) * TILES_X + tx;
+                if (nearest >= zMax0[tile]) continue;
+                if (nearest < zMax1[tile]) return true;
+                // Ближе опорного слоя, но за рабочим: закрыт, только если
+                // все его пиксели в тайле покрыты рабочим слоем.
+                uint32_t covered = rectMask(x0 - tx * TILE_WIDTH, x1 - tx * TILE_WIDTH,
+                                            y0 - ty * TILE_HEIGHT, y1 - ty * TILE_HEIGHT);
+                if ((covered & ~mask[tile]) != 0) return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    // Треугольник в пикселях буфера: уравнения рёбер (внутри — все >= 0),
+    // плоскость глубины и ограничивающий прямоугольник.
+    struct Triangle {
+        float edgeA[3], edgeB[3], edgeC[3];
+        float depthA, depthB, depthC;
+        float depthMax;
+        int minX, minY, maxX, maxY;
+    };
+
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    std::vector<Triangle> triangles;
+    std::vector<uint32_t> mask;
+    std::vector<float> zMax0;
+    std::vector<float> zMax1;
+
+    // Отсекает треугольник ближней плоскостью (z + w >= 0) и переводит
+    // получившиеся один-два треугольника в пиксели.
+    void addTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c) {
+        const glm::vec4 in[3] = { a, b, c };
+        glm::vec4 polygon[4];
+        int count = 0;
+        for (int i = 0; i < 3; ++i) {
+            const glm::vec4& p = in[i];
+            const glm::vec4& q = in[(i + 1) % 3];
+            float dp = p.z + p.w, dq = q.z + q.w;
+            if (dp >= 0.0f) polygon[count++] = p;
+            if ((dp >= 0.0f) != (dq >= 0.0f)) {
+                polygon[count++] = p + (q - p) * (dp / (dp - dq));
+            }
+        }
+        if (count < 3) return;
+
+        glm::vec3 screen[4];
+        for (int i = 0; i < count; ++i) {
+            float w = std::max(polygon[i].w, 1e-6f);
+            screen[i] = glm::vec3((polygon[i].x / w * 0.5f + 0.5f) * WIDTH,
+                                  (polygon[i].y / w * 0.5f + 0.5f) * HEIGHT, polygon[i].z / w);
+        }
+        setupTriangle(screen[0], screen[1], screen[2]);
+        if (count == 4) setupTriangle(screen[0], screen[2], screen[3]);
+    }
+
+    void setupTriangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2) {
+        float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+        if (std::abs(area) < 1e-8f) return;
+
+        Triangle t;
+        t.minX = std::max(0, static_cast<int>(std::floor(std::min({ v0.x, v1.x, v2.x }))));
+        t.maxX = std::min(WIDTH - 1, static_cast<int>(std::ceil(std::max({ v0.x, v1.x, v2.x }))));
+        t.minY = std::max(0, static_cast<int>(std::floor(std::min({ v0.y, v1.y, v2.y }))));
+        t.maxY = std::min(HEIGHT - 1, static_cast<int>(std::ceil(std::max({ v0.y, v1.y, v2.y }))));
+        if (t.minX > t.maxX || t.minY > t.maxY) return;
+
+        // Рёбра ориентируются так, чтобы внутренность была положительной
+        // при любом обходе: грани видны с обеих сторон.
+        const glm::vec3* v[3] = { &v0, &v1, &v2 };
+        float sign = area > 0.0f ? 1.0f : -1.0f;
+        for (int e = 0; e < 3; ++e) {
+            const glm::vec3& p = *v[e];
+            const glm::vec3& q = *v[(e + 1) % 3];
+            t.edgeA[e] = sign * (p.y - q.y);
+            t.edgeB[e] = sign * (q.x - p.x);
+            t.edgeC[e] = sign * (p.x * q.y - p.y * q.x);
+        }
+
+        t.depthA = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+        t.depthB = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+        t.depthC = v0.z - t.depthA * v0.x - t.depthB * v0.y;
+        t.depthMax = std::max({ v0.z, v1.z, v2.z });
+        triangles.push_back(t);
+    }
+
+    // Тайлы треугольника в строках [rowBegin, rowEnd): у каждого потока
+    // свои строки, так что тайлы не делятся между потоками.
+    void rasterizeTriangle(const Triangle& t, int rowBegin, int rowEnd) {
+        int ty0 = std::max(rowBegin, t.minY / TILE_HEIGHT);
+        int ty1 = std::min(rowEnd - 1, t.maxY / TILE_HEIGHT);
+        for (int ty = ty0; ty <= ty1; ++ty) {
+            for (int tx = t.minX / TILE_WIDTH; tx <= t.maxX / TILE_WIDTH; ++tx) {
+                float x0 = static_cast<float>(tx * TILE_WIDTH);
+                float y0 = static_cast<float>(ty * TILE_HEIGHT);
+                uint32_t coverage = tileCoverage(t, x0, y0);
+                if (coverage == 0) continue;
+
+                // Глубина треугольника в тайле не дальше плоскости в дальнем
+                // углу тайла и дальней вершины.
+                float cornerX = t.depthA > 0.0f ? x0 + TILE_WIDTH : x0;
+                float cornerY = t.depthB > 0.0f ? y0 + TILE_HEIGHT : y0;
+                float depth = std::min(t.depthA * cornerX + t.depthB * cornerY + t.depthC, t.depthMax);
+                updateTile(static_cast<size_t>(ty) * TILES_X + tx, coverage, depth);
+            }
+        }
+    }
+
+    // Покрытие центров пикселей тайла: бит r * 8 + x.
+    static uint32_t tileCoverage(const Triangle& t, float x0, float y0) {
+        bool full = true;
+        for (int e = 0; e < 3; ++e) {
+            // Центры пикселей, где ребро больше и меньше всего.
+            float hiX = t.edgeA[e] > 0.0f ? x0 + TILE_WIDTH - 0.5f : x0 + 0.5f;
+            float hiY = t.edgeB[e] > 0.0f ? y0 + TILE_HEIGHT - 0.5f : y0 + 0.5f;
+            float loX = t.edgeA[e] > 0.0f ? x0 + 0.5f : x0 + TILE_WIDTH - 0.5f;
+            float loY = t.edgeB[e] > 0.0f ? y0 + 0.5f : y0 + TILE_HEIGHT - 0.5f;
+            if (t.edgeA[e] * hiX + t.edgeB[e] * hiY + t.edgeC[e] < 0.0f) return 0;
+            if (t.edgeA[e] * loX + t.edgeB[e] * loY + t.edgeC[e] < 0.0f) full = false;
+        }
+        if (full) return 0xFFFFFFFFu;
+
+        uint32_t coverage = 0;
+#ifdef OCCLUSION_SSE
+        const __m128 zero = _mm_setzero_ps();
+        __m128 xs[2] = { _mm_setr_ps(x0 + 0.5f, x0 + 1.5f, x0 + 2.5f, x0 + 3.5f),
+                         _mm_setr_ps(x0 + 4.5f, x0 + 5.5f, x0 + 6.5f, x0 + 7.5f) };
+        __m128 a[3], b[3], c[3];
+        for (int e = 0; e < 3; ++e) {
+            a[e] = _mm_set1_ps(t.edgeA[e]);
+            b[e] = _mm_set1_ps(t.edgeB[e]);
+            c[e] = _mm_set1_ps(t.edgeC[e]);
+        }
+        for (int r = 0; r < TILE_HEIGHT; ++r) {
+            __m128 y = _mm_set1_ps(y0 + r + 0.5f);
+            for (int half = 0; half < 2; ++half) {
+                __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+                for (int e = 0; e < 3; ++e) {
+                    __m128 value = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[e], xs[half]), _mm_mul_ps(b[e], y)), c[e]);
+                    inside = _mm_and_ps(inside, _mm_cmpge_ps(value, zero));
+                }
+                coverage |= static_cast<uint32_t>(_mm_movemask_ps(inside)) << (r * TILE_WIDTH + half * 4);
+            }
+        }
+#else
+        for (int r = 0; r < TILE_HEIGHT; ++r) {
+            float y = y0 + r + 0.5f;
+            for (int x = 0; x < TILE_WIDTH; ++x) {
+                float px = x0 + x + 0.5f;
+                bool inside = true;
+                for (int e = 0; e < 3; ++e) {
+                    inside = inside && t.edgeA[e] * px + t.edgeB[e] * y + t.edgeC[e] >= 0.0f;
+                }
+                if (inside) coverage |= 1u << (r * TILE_WIDTH + x);
+            }
+        }
+#endif
+        return coverage;
+    }
+
+    void updateTile(size_t tile, uint32_t coverage, float depth) {
+        if (depth >= zMax0[tile]) return;   // за опорным слоем — ничего не даёт
+        if (mask[tile] == 0) {
+            zMax1[tile] = depth;
+        } else if (zMax1[tile] - depth > zMax0[tile] - zMax1[tile]) {
+            // Рабочий слой ближе к опорному, чем к новому треугольнику:
+            // слияние отодвинуло бы новый, так что старый слой отбрасывается.
+            mask[tile] = 0;
+            zMax1[tile] = depth;
+        } else {
+            zMax1[tile] = std::max(zMax1[tile], depth);
+        }
+        mask[tile] |= coverage;
+        if (mask[tile] == 0xFFFFFFFFu) {
+            zMax0[tile] = std::min(zMax0[tile], zMax1[tile]);
+            mask[tile] = 0;
+        }
+    }
+
+    // Пиксели [x0, x1] × [y0, y1] тайла (координаты внутри тайла, обрезаются).
+    static uint32_t rectMask(int x0, int x1, int y0, int y1) {
+        x0 = std::max(x0, 0);
+        y0 = std::max(y0, 0);
+        x1 = std::min(x1, TILE_WIDTH - 1);
+        y1 = std::min(y1, TILE_HEIGHT - 1);
+        uint32_t row = ((1u << (x1 - x0 + 1)) - 1u) << x0;
+        uint32_t result = 0;
+        for (int r = y0; r <= y1; ++r) {
+            result |= row << (r * TILE_WIDTH);
+        }
+        return result;
+    }
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <cstddef>
+
+// Простые примитивы для разбиения работы по потокам без пула: потоки
+// создаются на вызов, текущий поток берёт первую часть работы сам.
+class Parallel {
+public:
+    static unsigned hardwareThreads() {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Вызывает fn(i) для i в [0, count), каждый в своём потоке.
+    template <typename Fn>
+    static void forEachIndex(size_t count, Fn&& fn) {
+        std::vector<std::thread> workers;
+        workers.reserve(count > 0 ? count - 1 : 0);
+        for (size_t i = 1; i < count; ++i) {
+            workers.emplace_back([&fn, i] { fn(i); });
+        }
+        if (count > 0) fn(0);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // Делит [0, total) на непрерывные диапазоны и вызывает fn(begin, end).
+    // Диапазонов не больше threadCount и не меньше minPerThread элементов в каждом.
+    template <typename Fn>
+    static void forRange(size_t total, unsigned threadCount, size_t minPerThread, Fn&& fn) {
+        if (threadCount == 0) threadCount = hardwareThreads();
+        size_t maxChunks = std::max<size_t>(1, total / std::max<size_t>(1, minPerThread));
+        size_t chunks = std::min<size_t>(threadCount, maxChunks);
+        if (chunks <= 1) {
+            fn(size_t(0), total);
+            return;
+        }
+        forEachIndex(chunks, [&](size_t c) {
+            fn(total * c / chunks, total * (c + 1) / chunks);
+        });
+    }
+};
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include "Vertex.hpp"
+#include "MeshData.hpp"
+
+// Геометрия встроенных примитивов без обращения к GL. Mesh::Create* загружают
+// её в буферы, а бенчмарк гоняет генерацию отдельно.
+class Primitives {
+public:
+    static MeshData Cube() {
+        std::vector<Vertex> verts = {
+            
+            Vertex(glm::vec3(-1, -1,  1), glm::vec3(0, 0,  1), glm::vec2(0, 0)),
+            Vertex(glm::vec3( 1, -1,  1), glm::vec3(0, 0,  1), glm::vec2(1, 0)),
+            Vertex(glm::vec3( 1,  1,  1), glm::vec3(0, 0,  1), glm::vec2(1, 1)),
+            Vertex(glm::vec3(-1,  1,  1), glm::vec3(0, 0,  1), glm::vec2(0, 1)),
+
+            
+            Vertex(glm::vec3( 1, -1, -1), glm::vec3(0, 0, -1), glm::vec2(0, 0)),
+            Vertex(glm::vec3(-1, -1, -1), glm::vec3(0, 0, -1), glm::vec2(1, 0)),
+            Vertex(glm::vec3(-1,  1, -1), glm::vec3(0, 0, -1), glm::vec2(1, 1)),
+            Vertex(glm::vec3( 1,  1, -1), glm::vec3(0, 0, -1), glm::vec2(0, 1)),
+
+            
+            Vertex(glm::vec3(-1,  1, -1), glm::vec3(0, 1, 0), glm::vec2(0, 0)),
+            Vertex(glm::vec3(-1,  1,  1), glm::vec3(0, 1, 0), glm::vec2(1, 0)),
+            Vertex(glm::vec3( 1,  1,  1), glm::vec3(0, 1, 0), glm::vec2(1, 1)),
+            Vertex(glm::vec3( 1,  1, -1), glm::vec3(0, 1, 0), glm::vec2(0, 1)),
+
+            
+            Vertex(glm::vec3(-1, -1, -1), glm::vec3(0, -1, 0), glm::vec2(0, 0)),
+            Vertex(glm::vec3( 1, -1, -1), glm::vec3(0, -1, 0), glm::vec2(1, 0)),
+            Vertex(glm::vec3( 1, -1,  1), glm::vec3(0, -1, 0), glm::vec2(1, 1)),
+            Vertex(glm::vec3(-1, -1,  1), glm::vec3(0, -1, 0), glm::vec2(0, 1)),
+
+            
+            Vertex(glm::vec3( 1, -1,  1), glm::vec3(1, 0, 0), glm::vec2(0, 0)),
+            Vertex(glm::vec3( 1, -1, -1), glm::vec3(1, 0, 0), glm::vec2(1, 0)),
+            Vertex(glm::vec3( 1,  1, -1), glm::vec3(1, 0, 0), glm::vec2(1, 1)),
+            Vertex(glm::vec3( 1,  1,  1), glm::vec3(1, 0, 0), glm::vec2(0, 1)),
+
+            
+            Vertex(glm::vec3(-1, -1, -1), glm::vec3(-1, 0, 0), glm::vec2(0, 0)),
+            Vertex(glm::vec3(-1, -1,  1), glm::vec3(-1, 0, 0), glm::vec2(1, 0)),
+            Vertex(glm::vec3(-1,  1,  1), glm::vec3(-1, 0, 0), glm::vec2(1, 1)),
+            Vertex(glm::vec3(-1,  1, -1), glm::vec3(-1, 0, 0), glm::vec2(0, 1))
+        };
+
+        std::vector<uint32_t> inds = {
+            0,  1,  2,  2,  3,  0,   
+            4,  5,  6,  6,  7,  4,   
+            8,  9,  10, 10, 11, 8,   
+            12, 13, 14, 14, 15, 12,  
+            16, 17, 18, 18, 19, 16,  
+            20, 21, 22, 22, 23, 20   
+        };
+
+        return make(std::move(verts), std::move(inds));
+    }
+
+    static MeshData Plane(float width, float height) {
+        std::vector<Vertex> verts = {
+            Vertex(glm::vec3(-width/2, 0, -height/2), glm::vec3(0, 1, 0), glm::vec2(0, 0)),
+            Vertex(glm::vec3( width/2, 0, -height/2), glm::vec3(0, 1, 0), glm::vec2(1, 0)),
+            Vertex(glm::vec3( width/2, 0,  height/2), glm::vec3(0, 1, 0), glm::vec2(1, 1)),
+            Vertex(glm::vec3(-width/2, 0,  height/2), glm::vec3(0, 1, 0), glm::vec2(0, 1))
+        };
+
+        std::vector<uint32_t> inds = {0, 1, 2, 2, 3, 0};
+
+        return make(std::move(verts), std::move(inds));
+    }
+
+    static MeshData Sphere(float radius, int segments = 32, int rings = 16) {
+        std::vector<Vertex>   verts;
+        std::vector<uint32_t> inds;
+
+        for (int i = 0; i <= rings; ++i) {
+            float phi = glm::pi<float>() * i / rings;
+            for (int j = 0; j <= segments; ++j) {
+                float theta = 2.0f * glm::pi<float>() * j / segments;
+
+                float x = radius * std::sin(phi) * std::cos(theta);
+                float y = radius * std::cos(phi);
+                float z = radius * std::sin(phi) * std::sin(theta);
+
+                glm::vec3 pos(x, y, z);
+                glm::vec3 normal = glm::normalize(pos);
+                glm::vec2 uv((float)j / segments, (float)i / rings);
+
+                verts.emplace_back(pos, normal, uv);
+            }
+        }
+
+        for (int i = 0; i < rings; ++i) {
+            for (int j = 0; j < segments; ++j) {
+                uint32_t a = i * (segments + 1) + j;
+                uint32_t b = a + segments + 1;
+
+                inds.push_back(a);
+                inds.push_back(b);
+                inds.push_back(a + 1);
+
+                inds.push_back(a + 1);
+                inds.push_back(b);
+                inds.push_back(b + 1);
+            }
+        }
+
+        return make(std::move(verts), std::move(inds));
+    }
+
+    // Плоскость картины внутри рамки, чуть впереди задней стенки.
+    static MeshData PicturePlane(float width, float height,
+                                 float frameThickness, float frameDepth) {
+        float halfW = width  * 0.5f;
+        float halfH = height * 0.5f;
+        float t     = frameThickness;
+        float d     = frameDepth;
+
+        std::vector<Vertex>   verts;
+        std::vector<uint32_t> inds = {0,1,2, 2,3,0};
+
+        float z = -d * 0.5f + 0.001f;
+
+        verts.emplace_back(glm::vec3(-halfW + t, -halfH + t, z),
+                           glm::vec3(0,0,1), glm::vec2(0,0));
+        verts.emplace_back(glm::vec3( halfW - t, -halfH + t, z),
+                           glm::vec3(0,0,1), glm::vec2(1,0));
+        verts.emplace_back(glm::vec3( halfW - t,  halfH - t, z),
+                           glm::vec3(0,0,1), glm::vec2(1,1));
+        verts.emplace_back(glm::vec3(-halfW + t,  halfH - t, z),
+                           glm::vec3(0,0,1), glm::vec2(0,1));
+
+        return make(std::move(verts), std::move(inds));
+    }
+
+private:
+    static MeshData make(std::vector<Vertex>&& verts, std::vector<uint32_t>&& inds) {
+        MeshData data;
+        data.vertices = std::move(verts);
+        data.indices = std::move(inds);
+        data.hasNormals = true;
+        return data;
+    }
+};
@@ -3,13 +3,77 @@
 #include <vector>
 #include <array>
 #include <iostream>
+#include <algorithm>
+#include <numeric>
 #include "Mesh.hpp"
+#include "Frustum.hpp"
+#include "OcclusionCuller.hpp"
+#include "CellGraph.hpp"
+#include "LightClusters.hpp"
+#include "ClusterBuffers.hpp"
 #include "Material.hpp"
 #include "Light.hpp"
 #include "ShadowMap.hpp"
 #include "ShadowCube.hpp"
 #include "Shader.hpp"
 
+// Выбор уровня детализации: для каждого объекта в каждом виде берётся самый
+// грубый уровень, чья геометрическая ошибка на экране (или в карте теней) не
+// больше pixelError пикселей.
+struct LodSettings {
+    float pixelError = 1.0f;    // 0 — всегда полная сетка
+    float shadowBias = 4.0f;    // в картах теней допускается во столько раз больше
+    float hysteresis = 0.25f;   // уровень меняется, только выйдя из полосы ±25% вокруг порога
+};
+
+// Что ушло на GPU за последний кадр.
+struct RenderStats {
+    size_t mainTriangles = 0;
+    size_t shadowTriangles = 0;
+    size_t drawCalls = 0;
+    size_t clustersTested = 0;   // во всех проходах
+    size_t clustersCulled = 0;
+    size_t vertexArrayBinds = 0;  // смен VAO; сетки одной арены GeometryStore идут без них
+    size_t objectsCulled = 0;     // объекты вне пирамиды камеры в основном проходе
+    size_t objectsOccluded = 0;   // в пирамиде, но за окклюдерами
+    size_t occluderTriangles = 0;
+    // Тени считаются в парах (объект, проход): проход — карта направленного
+    // света или грань куба. В каждом проходе casters + outsideLight +
+    // outsideFrustum = число объектов кадра (см. ShadowPassStats).
+    size_t shadowCasters = 0;              // нарисовано
+    size_t shadowCastersOutsideLight = 0;  // вне сферы действия источника куба
+    size_t shadowCastersCulled = 0;        // в сфере, но вне пирамиды прохода
+    // Источники, чья сфера действия не видна камере: ни куба, ни проходов.
+    size_t shadowLightsSkipped = 0;
+    size_t cellsVisible = 0;      // ячеек CellGraph, видимых через проёмы
+    size_t objectsSkipped = 0;    // объекты в невидимых ячейках (не проверялись вовсе)
+    size_t lightsActive = 0;      // источники, переданные в шейдер и тени
+    size_t clusterLightRefs = 0;  // ссылок на источники во всех кластерах
+    size_t maxClusterLights = 0;  // больше всего источников на один кластер
+};
+
+// Один проход карты теней: источник (номер в addLight), грань куба
+// (-1 — карта направленного света), сколько объектов в неё нарисовано и
+// сколько отсечено: сферой действия источника (одни и те же для шести
+// граней куба, у направленного 0) и пирамидой самого прохода.
+struct ShadowPassStats {
+    size_t light = 0;
+    int face = -1;
+    size_t casters = 0;
+    size_t outsideLight = 0;
+    size_t outsideFrustum = 0;
+};
+
+// Вид, из которого отсекаются кластеры сеток: пирамида видимости и откуда
+// на них смотрят.
+struct ClusterView {
+    Frustum frustum;
+    glm::vec3 eye = glm::vec3(0.0f);        // перспектива: камера или источник света
+    glm::vec3 direction = glm::vec3(0.0f);  // ортографическая проекция: направление взгляда
+    bool orthographic = false;
+    bool cullFrontFaces = false;            // проходы теней рисуют задние грани (glCullFace(GL_FRONT))
+};
+
 class Renderer {
 private:
     std::vector<Mesh*> meshes;
@@ -30,6 +94,65 @@ private:
     int screenWidth;
     int screenHeight;
 
+    glm::vec3 viewPosition = glm::vec3(0.0f);
+    float pixelsPerUnit = 0.0f;          // на расстоянии 1 от камеры; 0 — вид не задан
+    LodSettings lodSettings;
+    std::vector<size_t> viewLods;        // текущий уровень каждого объекта в основном проходе
+    RenderStats stats;
+
+    bool meshletCulling = true;
+    bool shadowCulling = true;
+    bool occlusionCulling = true;
+    bool hasView = false;
+    ClusterView mainView;
+    // Общие для всех сеток буферы отсечения кластеров.
+    std::vector<uint8_t> clusterVisible;
+    std::vector<GLsizei> rangeCounts;
+    std::vector<const void*> rangeOffsets;
+    std::vector<GLint> rangeBaseVertices;
+    // Мировые AABB объектов для отсечения по пирамиде камеры. Пересчитываются,
+    // только когда меняется матрица объекта (setTransform) или границы его
+    // сетки (догрузилась заглушка).
+    BoxBatch worldBoxes;
+    std::vector<Bounds> worldBoxSource;     // локальные границы, по которым считан worldBoxes
+    std::vector<uint8_t> worldBoxDirty;
+    std::vector<uint8_t> objectVisible;
+    // Привязанный сейчас VAO: соседние вызовы из одной арены его не меняют.
+    GLuint boundVertexArray = 0;
+    // Порядок объектов в картах теней: сгруппированы по VAO.
+    std::vector<size_t> casterOrder;
+    // Отсечение теней: объекты в сфере действия текущего точечного
+    // источника (в порядке casterOrder).
+    std::vector<size_t> lightCasters;
+    std::vector<size_t> casterLods;
+    std::vector<ShadowPassStats> shadowPasses;
+    // Отсечение перекрытых объектов: окклюдеры — простые крупные сетки
+    // (стены, постаменты) или отмеченные setOccluder.
+    static constexpr size_t MAX_OCCLUDER_TRIANGLES = 64;
+    static constexpr float MIN_OCCLUDER_SIZE = 1.0f;    // наибольший размер мирового AABB
+    OcclusionCuller occlusion;
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    std::vector<int8_t> occluderMode;       // -1 — по сетке, 0 — нет, 1 — да
+    // Залы и проёмы: в кадре участвуют только объекты и источники ячеек,
+    // видимых из ячейки камеры (-1 — вне ячеек, участвуют всегда). Без
+    // графа — все.
+    const CellGraph* cellGraph = nullptr;
+    CellVisibility cellVisibility;
+    std::vector<int> lightCells;
+    std::vector<std::vector<size_t>> cellObjects;
+    std::vector<size_t> looseObjects;
+    std::vector<size_t> frameObjects;       // кандидаты кадра
+    std::vector<size_t> drawList;           // прошли отсечение; по ним идёт основной проход
+    std::vector<size_t> activeLights;       // номера в addLight
+    // Освещение по кластерам: каждому фрагменту — только доходящие до него
+    // источники (LightClusters); куб тени источника — в shadowSlots.
+    static const int CLUSTER_TEXTURE_UNIT = 7;  // 0 — карта теней, 1..5 — кубы, 6 — диффузная
+    LightClusters lightClusters;
+    ClusterBuffers clusterBuffers;
+    std::vector<int> shadowSlots;
+    glm::mat4 viewMatrix = glm::mat4(1.0f);
+    glm::mat4 projectionMatrix = glm::mat4(1.0f);
+
 public:
     Renderer(Shader& s)
         : shader(s), shadowShader(nullptr), shadowMap(nullptr),
@@ -38,14 +161,19 @@ public:
     }
 
     ~Renderer() {
-        if (shadowMap != nullptr) {
-            delete shadowMap;
-        }
+        cleanup();
+    }
+
+    // GL-объекты рендерера; вызывать, пока контекст ещё жив.
+    void cleanup() {
+        delete shadowMap;
+        shadowMap = nullptr;
         for (int i = 0; i < MAX_POINT_SHADOWS; ++i) {
-            if (shadowCubes[i] != nullptr) {
-                delete shadowCubes[i];
-            }
+            delete shadowCubes[i];
+            shadowCubes[i] = nullptr;
         }
+        numActiveShadowCubes = 0;
+        clusterBuffers.cleanup();
     }
 
     void initShadowMap(Shader& shadowS, int width = 1920, int height = 1080) {
@@ -71,37 +199,137 @@ public:
                   << ", far plane: " << far_plane << ")\n";
     }
 
+    // Положение камеры и её матрицы: по ним выбираются уровни LOD и
+    // отсекаются кластеры сеток.
+    void setView(const glm::vec3& position, const glm::mat4& view, const glm::mat4& projection) {
+        viewPosition = position;
+        pixelsPerUnit = projection[1][1] * screenHeight * 0.5f;
+        viewProjection = projection * view;
+        viewMatrix = view;
+        projectionMatrix = projection;
+        mainView.frustum = Frustum::fromMatrix(viewProjection);
+        mainView.eye = position;
+        hasView = true;
+    }
+
+    // Отсечение кластеров по пирамиде видимости и конусу нормалей.
+    // Задние грани в основном проходе не отсекаются самим GL, так что для
+    // незамкнутых сеток, видимых изнутри, его стоит выключить.
+    void setMeshletCulling(bool enabled) {
+        meshletCulling = enabled;
+    }
+
+    // Отсечение объектов в проходах теней: по пирамиде направленного света,
+    // по сфере действия точечного источника и по пирамиде каждой грани куба.
+    void setShadowCulling(bool enabled) {
+        shadowCulling = enabled;
+    }
+
+    // Отсечение объектов, целиком закрытых окклюдерами, по буферу глубины
+    // низкого разрешения на CPU (OcclusionCuller).
+    void setOcclusionCulling(bool enabled) {
+        occlusionCulling = enabled;
+    }
+
+    // Явно включает объект в окклюдеры или исключает из них. Окклюдер
+    // должен быть непрозрачным и закрывать всё, что внутри его сетки:
+    // годятся упрощённые подставки под экспонаты, но не LOD, выходящий за
+    // силуэт оригинала. Нужна MeshBvh сетки.
+    void setOccluder(size_t object, bool occluder) {
+        occluderMode[object] = occluder ? 1 : 0;
+    }
+
+    // Граф залов сцены; nullptr — без него. Граф должен жить дольше
+    // рендерера, номера ячеек — те же, что в addObject/addLight.
+    void setCellGraph(const CellGraph* graph) {
+        cellGraph = graph;
+    }
+
+    void setLodSettings(const LodSettings& settings) {
+        lodSettings = settings;
+    }
+
+    const LodSettings& getLodSettings() const {
+        return lodSettings;
+    }
+
+    const RenderStats& lastFrameStats() const {
+        return stats;
+    }
+
+    const std::vector<ShadowPassStats>& lastShadowPasses() const {
+        return shadowPasses;
+    }
+
+    // cell — ячейка CellGraph, в которой стоит объект; -1 — рисуется
+    // независимо от видимости ячеек.
     void addObject(Mesh* mesh, const glm::mat4& transform,
-                   const Material& material, const glm::vec3& color) {
+                   const Material& material, const glm::vec3& color, int cell = -1) {
+        if (cell >= 0) {
+            if (cellObjects.size() <= static_cast<size_t>(cell)) cellObjects.resize(cell + 1);
+            cellObjects[cell].push_back(meshes.size());
+        } else {
+            looseObjects.push_back(meshes.size());
+        }
+        viewLods.push_back(0);
         meshes.push_back(mesh);
         transforms.push_back(transform);
         materials.push_back(material);
         colors.push_back(color);
+        worldBoxSource.push_back(Bounds());
+        worldBoxDirty.push_back(1);
+        occluderMode.push_back(-1);
+    }
+
+    // Новая матрица объекта с номером object (в порядке addObject).
+    void setTransform(size_t object, const glm::mat4& transform) {
+        transforms[object] = transform;
+        worldBoxDirty[object] = 1;
     }
 
-    void addLight(const Light& light) {
+    void addLight(const Light& light, int cell = -1) {
         lights.push_back(light);
+        lightCells.push_back(cell);
     }
 
     void clearObjects() {
+        viewLods.clear();
         meshes.clear();
         transforms.clear();
         materials.clear();
         colors.clear();
+        worldBoxes.clear();
+        worldBoxSource.clear();
+        worldBoxDirty.clear();
+        occluderMode.clear();
+        objectVisible.clear();
+        cellObjects.clear();
+        looseObjects.clear();
     }
 
     void clearLights() {
         lights.clear();
+        lightCells.clear();
     }
 
     void render() {
+        stats = RenderStats();
+        shadowPasses.clear();
+        boundVertexArray = 0;
+        gatherVisibleCells();
+        cullObjects();
+        cullOccludedObjects();
+        collectDrawList();
+        selectViewLods();
+
         if (shadowShader == nullptr || shadowMap == nullptr || lights.empty()) {
             renderDirect();
-            return;
+        } else {
+            sortCasters();
+            renderShadowMaps();
+            renderWithShadows();
         }
-
-        renderShadowMaps();
-        renderWithShadows();
+        bindVertexArray(0);
     }
 
 private:
@@ -113,9 +341,12 @@ private:
         glClear(GL_DEPTH_BUFFER_BIT);
 
         glm::vec3 lightDir = glm::vec3(0.3f, -1.0f, 0.3f);
-        for (const auto& light : lights) {
-            if (light.type == LightType::DIRECTIONAL) {
-                lightDir = light.direction;
+        ShadowPassStats directionalPass;
+        directionalPass.light = lights.size();
+        for (size_t l = 0; l < lights.size(); ++l) {
+            if (lights[l].type == LightType::DIRECTIONAL) {
+                lightDir = lights[l].direction;
+                directionalPass.light = l;
                 break;
             }
         }
@@ -132,32 +363,75 @@ private:
 
         shadowShader->setMat4("lightSpaceMatrix", lightSpaceMatrix);
 
-        for (size_t i = 0; i < meshes.size(); ++i) {
+        // Ортографическая проекция: размер texel'а одинаков на любом расстоянии.
+        const float shadowThreshold = lodSettings.pixelError * lodSettings.shadowBias;
+        const float texelsPerUnit = shadowMap->getWidth() / (2.0f * sceneRadius);
+        ClusterView directionalView;
+        directionalView.frustum = Frustum::fromMatrix(lightSpaceMatrix);
+        directionalView.direction = glm::normalize(lightDir);
+        directionalView.orthographic = true;
+        directionalView.cullFrontFaces = true;
+        for (size_t i : casterOrder) {
+            if (shadowCulling && !directionalView.frustum.intersectsBox(worldBoxes.center(i), worldBoxes.extents(i))) {
+                ++directionalPass.outsideFrustum;
+                continue;
+            }
+            ++directionalPass.casters;
             shadowShader->setMat4("model", transforms[i]);
-            meshes[i]->draw();
+            setVertexDecode(*shadowShader, *meshes[i]);
+            size_t lod = chooseLod(*meshes[i], worldScale(transforms[i]) * texelsPerUnit, shadowThreshold, 0, 0.0f);
+            drawShadowCaster(*meshes[i], transforms[i], lod, &directionalView);
         }
 
+        stats.shadowCasters += directionalPass.casters;
+        stats.shadowCastersCulled += directionalPass.outsideFrustum;
+        shadowPasses.push_back(directionalPass);
+
         glCullFace(GL_BACK);
         glDisable(GL_CULL_FACE);
         shadowMap->unbindForRendering();
         glViewport(0, 0, screenWidth, screenHeight);
 
+        shadowSlots.assign(lights.size(), -1);
         if (pointShadowShader != nullptr && shadowCubes[0] != nullptr) {
-            std::vector<glm::vec3> localLightPositions;
-            for (const auto& l : lights) {
-                if (l.type == LightType::POINT || l.type == LightType::SPOTLIGHT) {
-                    localLightPositions.push_back(l.position);
-                    if (localLightPositions.size() >= MAX_POINT_SHADOWS) {
-                        break;
-                    }
+            // Кубов меньше, чем источников: они достаются точечным и
+            // прожекторам, чья сфера действия видна камере, — ближайшим к ней.
+            // Дальше Light::influenceRadius свет не виден, а дальше far_plane
+            // куб ничего не хранит. Объекты вне этой сферы затеняют только
+            // неосвещённое; если сфера не видна камере, куб не нужен вовсе.
+            const float cubeFar = shadowCubes[0]->getFarPlane();
+            std::vector<size_t> localLights;
+            for (size_t l : activeLights) {
+                const Light& light = lights[l];
+                if (light.type != LightType::POINT && light.type != LightType::SPOTLIGHT) continue;
+                if (shadowCulling && hasView && !mainView.frustum.intersectsSphere(light.position, light.influenceRadius())) {
+                    ++stats.shadowLightsSkipped;
+                    continue;
                 }
+                localLights.push_back(l);
             }
+            if (hasView) {
+                std::stable_sort(localLights.begin(), localLights.end(), [this](size_t a, size_t b) {
+                    return glm::length(lights[a].position - viewPosition) < glm::length(lights[b].position - viewPosition);
+                });
+            }
+            if (localLights.size() > MAX_POINT_SHADOWS) localLights.resize(MAX_POINT_SHADOWS);
 
-            numActiveShadowCubes = static_cast<int>(localLightPositions.size());
+            numActiveShadowCubes = static_cast<int>(localLights.size());
 
-            for (size_t lightIdx = 0; lightIdx < localLightPositions.size(); ++lightIdx) {
-                glm::vec3 lightPos = localLightPositions[lightIdx];
+            for (size_t lightIdx = 0; lightIdx < localLights.size(); ++lightIdx) {
+                const Light& light = lights[localLights[lightIdx]];
+                glm::vec3 lightPos = light.position;
                 ShadowCube* cube = shadowCubes[lightIdx];
+                shadowSlots[localLights[lightIdx]] = static_cast<int>(lightIdx);
+
+                float radius = std::min(light.influenceRadius(), cubeFar);
+                lightCasters.clear();
+                for (size_t m : casterOrder) {
+                    if (!shadowCulling || worldBoxes.touchesSphere(m, lightPos, radius)) {
+                        lightCasters.push_back(m);
+                    }
+                }
 
                 pointShadowShader->activate();
                 cube->bindForWriting();
@@ -176,6 +450,19 @@ private:
                 shadowTransforms.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3( 0.0, 0.0, 1.0), glm::vec3(0.0, -1.0, 0.0)));
                 shadowTransforms.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3( 0.0, 0.0,-1.0), glm::vec3(0.0, -1.0, 0.0)));
 
+                // Уровни по расстоянию до источника: у куба 90° на грань,
+                // так что на расстоянии 1 в единицу длины помещается size / 2 texel'ов.
+                casterLods.resize(meshes.size());
+                const float texelsAtUnit = cube->getSize() * 0.5f;
+                for (size_t m : lightCasters) {
+                    float distance = viewDistance(*meshes[m], transforms[m], lightPos);
+                    casterLods[m] = chooseLod(*meshes[m], worldScale(transforms[m]) * texelsAtUnit / distance,
+                                              shadowThreshold, 0, 0.0f);
+                }
+
+                ClusterView faceView;
+                faceView.eye = lightPos;
+                faceView.cullFrontFaces = true;
                 for (unsigned int faceIdx = 0; faceIdx < 6; ++faceIdx) {
                     cube->attachFace(faceIdx);
                     glClear(GL_DEPTH_BUFFER_BIT);
@@ -184,10 +471,25 @@ private:
                     pointShadowShader->setVec3("lightPos", lightPos);
                     pointShadowShader->setFloat("far_plane", far_plane);
 
-                    for (size_t m = 0; m < meshes.size(); ++m) {
+                    faceView.frustum = Frustum::fromMatrix(shadowTransforms[faceIdx]);
+                    ShadowPassStats facePass;
+                    facePass.light = localLights[lightIdx];
+                    facePass.face = static_cast<int>(faceIdx);
+                    facePass.outsideLight = casterOrder.size() - lightCasters.size();
+                    for (size_t m : lightCasters) {
+                        if (shadowCulling && !faceView.frustum.intersectsBox(worldBoxes.center(m), worldBoxes.extents(m))) {
+                            ++facePass.outsideFrustum;
+                            continue;
+                        }
+                        ++facePass.casters;
                         pointShadowShader->setMat4("model", transforms[m]);
-                        meshes[m]->draw();
+                        setVertexDecode(*pointShadowShader, *meshes[m]);
+                        drawShadowCaster(*meshes[m], transforms[m], casterLods[m], &faceView);
                     }
+                    stats.shadowCasters += facePass.casters;
+                    stats.shadowCastersOutsideLight += facePass.outsideLight;
+                    stats.shadowCastersCulled += facePass.outsideFrustum;
+                    shadowPasses.push_back(facePass);
                 }
 
                 cube->unbind();
@@ -237,28 +539,22 @@ private:
         shader.setInt("numPointShadows", numActiveShadowCubes);
         shader.setFloat("far_plane", shadowCubes[0] != nullptr ? shadowCubes[0]->getFarPlane() : 50.0f);
 
-        shader.setInt("numLights", static_cast<int>(lights.size()));
-        for (size_t i = 0; i < lights.size() && i < 8; ++i) {
-            std::string prefix = "lights[" + std::to_string(i) + "]";
-            shader.setInt(prefix + ".type", static_cast<int>(lights[i].type));
-            shader.setVec3(prefix + ".position", lights[i].position);
-            shader.setVec3(prefix + ".direction", lights[i].direction);
-            shader.setVec3(prefix + ".color", lights[i].color);
-            shader.setFloat(prefix + ".intensity", lights[i].intensity);
-            shader.setFloat(prefix + ".range", lights[i].range);
-
-            shader.setFloat(prefix + ".cutOff", glm::cos(glm::radians(lights[i].cutOff)));
-            shader.setFloat(prefix + ".outerCutOff", glm::cos(glm::radians(lights[i].outerCutOff)));
-        }
+        uploadLights();
 
-        for (size_t i = 0; i < meshes.size(); ++i) {
+        for (size_t i : drawList) {
             shader.setMat4("model", transforms[i]);
+            setVertexDecode(shader, *meshes[i]);
             shader.setVec3("matAmbient", materials[i].ambient);
             shader.setVec3("matDiffuse", materials[i].diffuse);
             shader.setVec3("matSpecular", materials[i].specular);
             shader.setFloat("matShininess", materials[i].shininess);
             shader.setVec3("objectColor", colors[i]);
 
+            if (!meshes[i]->submeshes.empty()) {
+                drawSubMeshes(*meshes[i], transforms[i], true, viewLods[i]);
+                continue;
+            }
+
             if (meshes[i]->texture != nullptr) {
                 glActiveTexture(GL_TEXTURE6);
                 meshes[i]->texture->Bind();
@@ -268,34 +564,420 @@ private:
                 shader.setBool("useTexture", false);
             }
 
-            meshes[i]->draw();
+            drawMain(*meshes[i], transforms[i], viewLods[i]);
         }
     }
 
     void renderDirect() {
         shader.activate();
-        shader.setInt("numLights", static_cast<int>(lights.size()));
+        shadowSlots.assign(lights.size(), -1);
+        uploadLights();
 
-        for (size_t i = 0; i < lights.size() && i < 8; ++i) {
-            std::string prefix = "lights[" + std::to_string(i) + "]";
-            shader.setInt(prefix + ".type", static_cast<int>(lights[i].type));
-            shader.setVec3(prefix + ".position", lights[i].position);
-            shader.setVec3(prefix + ".direction", lights[i].direction);
-            shader.setVec3(prefix + ".color", lights[i].color);
-            shader.setFloat(prefix + ".intensity", lights[i].intensity);
-            shader.setFloat(prefix + ".range", lights[i].range);
-            shader.setFloat(prefix + ".cutOff", glm::cos(glm::radians(lights[i].cutOff)));
-            shader.setFloat(prefix + ".outerCutOff", glm::cos(glm::radians(lights[i].outerCutOff)));
-        }
-
-        for (size_t i = 0; i < meshes.size(); ++i) {
+        for (size_t i : drawList) {
             shader.setMat4("model", transforms[i]);
+            setVertexDecode(shader, *meshes[i]);
             shader.setVec3("matAmbient", materials[i].ambient);
             shader.setVec3("matDiffuse", materials[i].diffuse);
             shader.setVec3("matSpecular", materials[i].specular);
             shader.setFloat("matShininess", materials[i].shininess);
             shader.setVec3("objectColor", colors[i]);
-            meshes[i]->draw();
+            if (!meshes[i]->submeshes.empty()) {
+                drawSubMeshes(*meshes[i], transforms[i], false, viewLods[i]);
+                continue;
+            }
+            drawMain(*meshes[i], transforms[i], viewLods[i]);
+        }
+    }
+
+    // Списки источников по кластерам вида — на CPU, в буферные текстуры.
+    // Без вида камеры (и для ортографической проекции) — один общий список.
+    void uploadLights() {
+        if (hasView && projectionMatrix[2][3] != 0.0f) {
+            lightClusters.build(lights, activeLights, shadowSlots, viewMatrix, projectionMatrix);
+        } else {
+            lightClusters.buildUnclustered(lights, activeLights, shadowSlots);
+        }
+        stats.clusterLightRefs = lightClusters.indices.size();
+        stats.maxClusterLights = lightClusters.maxPerCluster;
+        clusterBuffers.upload(lightClusters);
+        clusterBuffers.bind(CLUSTER_TEXTURE_UNIT);
+
+        shader.setInt("lightData", CLUSTER_TEXTURE_UNIT);
+        shader.setInt("clusterGrid", CLUSTER_TEXTURE_UNIT + 1);
+        shader.setInt("clusterLights", CLUSTER_TEXTURE_UNIT + 2);
+        shader.setInt("numGlobalLights", lightClusters.globalLights);
+        shader.setVec3("clusterSize", glm::vec3(lightClusters.size));
+        shader.setFloat("clusterScale", lightClusters.sliceScale);
+        shader.setFloat("clusterBias", lightClusters.sliceBias);
+        shader.setVec4("clusterDepthPlane", lightClusters.depthPlane);
+        shader.setVec2("screenSize", glm::vec2(static_cast<float>(screenWidth), static_cast<float>(screenHeight)));
+    }
+
+    // Части модели из общих VBO/EBO: VAO привязывается один раз, на участок
+    // выставляется только его материал, а текстура перепривязывается, лишь
+    // когда она меняется. Участки без видимых кластеров пропускаются.
+    void drawSubMeshes(const Mesh& mesh, const glm::mat4& model, bool textures, size_t lod) {
+        if (!mesh.isReady()) return;
+        bool clustered = cullMeshlets(mesh, model, lod, hasView ? &mainView : nullptr);
+        bindVertexArray(mesh.VAO_id);
+        if (!clustered) stats.mainTriangles += mesh.triangleCount(lod);
+
+        bool first = true;
+        const Texture* bound = nullptr;
+        for (const SubMesh& sub : mesh.submeshes) {
+            if (sub.indexCount == 0) continue;
+            std::pair<size_t, size_t> clusters;
+            if (clustered) {
+                clusters = mesh.meshletRange(sub.firstIndex, static_cast<size_t>(sub.indexCount));
+                if (!anyVisible(clusters.first, clusters.second)) continue;
+            }
+            shader.setVec3("matAmbient", sub.material.ambient);
+            shader.setVec3("matDiffuse", sub.material.diffuse);
+            shader.setVec3("matSpecular", sub.material.specular);
+            shader.setFloat("matShininess", sub.material.shininess);
+
+            if (textures && (first || sub.texture.get() != bound)) {
+                if (sub.texture != nullptr) {
+                    glActiveTexture(GL_TEXTURE6);
+                    sub.texture->Bind();
+                    shader.setInt("diffuseTexture", 6);
+                }
+                if (first || (sub.texture != nullptr) != (bound != nullptr)) {
+                    shader.setBool("useTexture", sub.texture != nullptr);
+                }
+                bound = sub.texture.get();
+            }
+            first = false;
+            if (clustered) {
+                stats.mainTriangles += drawVisibleMeshlets(mesh, clusters.first, clusters.second);
+            } else {
+                mesh.drawSubMesh(sub, lod);
+            }
+            ++stats.drawCalls;
+        }
+    }
+
+    void drawMain(Mesh& mesh, const glm::mat4& model, size_t lod) {
+        if (!mesh.isReady()) return;
+        if (cullMeshlets(mesh, model, lod, hasView ? &mainView : nullptr)) {
+            stats.mainTriangles += drawMeshlets(mesh);
+            return;
         }
+        bindVertexArray(mesh.VAO_id);
+        mesh.drawLevel(lod);
+        stats.mainTriangles += mesh.triangleCount(lod);
+        ++stats.drawCalls;
+    }
+
+    // В карту теней сетка с участками идёт одним вызовом: участки уровня лежат подряд.
+    void drawShadowCaster(Mesh& mesh, const glm::mat4& model, size_t lod, const ClusterView* view) {
+        if (!mesh.isReady()) return;
+        if (cullMeshlets(mesh, model, lod, view)) {
+            stats.shadowTriangles += drawMeshlets(mesh);
+            return;
+        }
+        bindVertexArray(mesh.VAO_id);
+        mesh.drawLevel(lod);
+        stats.shadowTriangles += mesh.triangleCount(lod);
+        ++stats.drawCalls;
+    }
+
+    // Видимость кластеров сетки из view в clusterVisible. false — отсекать
+    // нечего (нет вида, у сетки нет кластеров или рисуется не LOD0), и сетка
+    // рисуется как раньше.
+    bool cullMeshlets(const Mesh& mesh, const glm::mat4& model, size_t lod, const ClusterView* view) {
+        if (!meshletCulling || view == nullptr || mesh.meshlets.empty() || (lod > 0 && !mesh.lods.empty())) {
+            return false;
+        }
+
+        glm::vec3 axes[3] = { glm::vec3(model[0]), glm::vec3(model[1]), glm::vec3(model[2]) };
+        float minScale = std::min({ glm::length(axes[0]), glm::length(axes[1]), glm::length(axes[2]) });
+        float maxScale = std::max({ glm::length(axes[0]), glm::length(axes[1]), glm::length(axes[2]) });
+        float determinant = glm::dot(glm::cross(axes[0], axes[1]), axes[2]);
+        // Конус нормалей переносится в мир только при равномерном масштабе;
+        // зеркальное отражение меняет обход треугольников, а с ним и ось.
+        bool cones = minScale > 0.0f && maxScale <= minScale * 1.01f;
+        float axisScale = cones ? ((determinant < 0.0f) != view->cullFrontFaces ? -1.0f : 1.0f) / minScale : 0.0f;
+
+        clusterVisible.resize(mesh.meshlets.size());
+        size_t culled = 0;
+        for (size_t i = 0; i < mesh.meshlets.size(); ++i) {
+            const Meshlet& m = mesh.meshlets[i];
+            glm::vec3 center = glm::vec3(model * glm::vec4(m.center, 1.0f));
+            float radius = m.radius * maxScale;
+            bool visible = view->frustum.intersectsSphere(center, radius);
+            if (visible && cones && m.coneCutoff < 1.0f) {
+                glm::vec3 axis = glm::vec3(model * glm::vec4(m.coneAxis, 0.0f)) * axisScale;
+                if (view->orthographic) {
+                    visible = glm::dot(view->direction, axis) < m.coneCutoff;
+                } else {
+                    glm::vec3 toCenter = center - view->eye;
+                    visible = glm::dot(toCenter, axis) < m.coneCutoff * glm::length(toCenter) + radius;
+                }
+            }
+            clusterVisible[i] = visible;
+            culled += !visible;
+        }
+        stats.clustersTested += mesh.meshlets.size();
+        stats.clustersCulled += culled;
+        return true;
+    }
+
+    bool anyVisible(size_t first, size_t count) const {
+        return std::any_of(clusterVisible.begin() + first, clusterVisible.begin() + first + count,
+                           [](uint8_t v) { return v != 0; });
+    }
+
+    size_t drawMeshlets(const Mesh& mesh) {
+        if (!anyVisible(0, mesh.meshlets.size())) return 0;
+        bindVertexArray(mesh.VAO_id);
+        size_t triangles = drawVisibleMeshlets(mesh, 0, mesh.meshlets.size());
+        ++stats.drawCalls;
+        return triangles;
+    }
+
+    // Видимые кластеры [first, first + count) одним glMultiDrawElements:
+    // соседние по EBO сливаются в один диапазон. VAO уже привязан.
+    size_t drawVisibleMeshlets(const Mesh& mesh, size_t first, size_t count) {
+        rangeCounts.clear();
+        rangeOffsets.clear();
+        rangeBaseVertices.clear();
+        size_t triangles = 0;
+        uint32_t runBegin = 0, runEnd = 0;
+        for (size_t i = first; i < first + count; ++i) {
+            if (!clusterVisible[i]) continue;
+            const Meshlet& m = mesh.meshlets[i];
+            triangles += m.indexCount / 3;
+            if (runEnd > runBegin && m.firstIndex == runEnd) {
+                runEnd += m.indexCount;
+                continue;
+            }
+            if (runEnd > runBegin) {
+                rangeCounts.push_back(static_cast<GLsizei>(runEnd - runBegin));
+                rangeOffsets.push_back(mesh.indexPointer(runBegin));
+            }
+            runBegin = m.firstIndex;
+            runEnd = m.firstIndex + m.indexCount;
+        }
+        if (runEnd > runBegin) {
+            rangeCounts.push_back(static_cast<GLsizei>(runEnd - runBegin));
+            rangeOffsets.push_back(mesh.indexPointer(runBegin));
+        }
+        if (!rangeCounts.empty()) {
+            rangeBaseVertices.assign(rangeCounts.size(), mesh.baseVertex());
+            glMultiDrawElementsBaseVertex(GL_TRIANGLES, rangeCounts.data(), mesh.indexType, rangeOffsets.data(),
+                                          static_cast<GLsizei>(rangeCounts.size()), rangeBaseVertices.data());
+        }
+        return triangles;
+    }
+
+    // Кандидаты кадра: объекты и источники видимых ячеек и вне ячеек.
+    // Работа дальше зависит от того, что видно, а не от размера музея.
+    void gatherVisibleCells() {
+        frameObjects.clear();
+        activeLights.clear();
+        if (!usesCells()) {
+            frameObjects.resize(meshes.size());
+            std::iota(frameObjects.begin(), frameObjects.end(), size_t(0));
+            activeLights.resize(lights.size());
+            std::iota(activeLights.begin(), activeLights.end(), size_t(0));
+            stats.lightsActive = lights.size();
+            return;
+        }
+        cellGraph->traverse(viewPosition, viewProjection, cellVisibility);
+        stats.cellsVisible = cellVisibility.order.size();
+        frameObjects = looseObjects;
+        for (int c : cellVisibility.order) {
+            if (static_cast<size_t>(c) >= cellObjects.size()) continue;
+            frameObjects.insert(frameObjects.end(), cellObjects[c].begin(), cellObjects[c].end());
+        }
+        stats.objectsSkipped = meshes.size() - frameObjects.size();
+        for (size_t l = 0; l < lights.size(); ++l) {
+            if (lightReachesVisibleCell(l)) activeLights.push_back(l);
+        }
+        stats.lightsActive = activeLights.size();
+    }
+
+    bool usesCells() const {
+        return cellGraph != nullptr && !cellGraph->empty() && hasView;
+    }
+
+    // Источник светит в видимую ячейку: стоит в ней или в соседней и
+    // достаёт до проёма между ними. Через два проёма свет не считается.
+    bool lightReachesVisibleCell(size_t l) const {
+        const Light& light = lights[l];
+        int cell = lightCells[l];
+        if (cell < 0 || static_cast<size_t>(cell) >= cellVisibility.visible.size() ||
+            cellVisibility.visible[cell] || light.type == LightType::DIRECTIONAL) {
+            return true;
+        }
+        for (size_t p : cellGraph->cells[cell].portals) {
+            const Portal& portal = cellGraph->portals[p];
+            int next = portal.cells[0] == cell ? portal.cells[1] : portal.cells[0];
+            if (!cellVisibility.visible[next]) continue;
+            glm::vec3 d = glm::max(glm::max(portal.min - light.position, light.position - portal.max), glm::vec3(0.0f));
+            float radius = light.influenceRadius();
+            if (glm::dot(d, d) <= radius * radius) return true;
+        }
+        return false;
+    }
+
+    // Видимость объектов для основного прохода. Без ячеек — мировые AABB
+    // пачкой против пирамиды камеры; с ними — против пирамиды, суженной до
+    // прямоугольника, через который видна ячейка объекта. Для карт теней —
+    // свои проверки в renderShadowMaps.
+    void cullObjects() {
+        updateWorldBoxes();
+        objectVisible.resize(meshes.size());
+        if (!hasView) {
+            for (size_t i : frameObjects) objectVisible[i] = 1;
+            return;
+        }
+        if (!usesCells()) {
+            stats.objectsCulled = mainView.frustum.cullBoxes(worldBoxes, objectVisible.data());
+            return;
+        }
+        cullObjectsAgainst(mainView.frustum, looseObjects);
+        for (int c : cellVisibility.order) {
+            if (static_cast<size_t>(c) >= cellObjects.size()) continue;
+            Frustum through = Frustum::fromMatrix(CellGraph::rectMatrix(cellVisibility.rects[c]) * viewProjection);
+            cullObjectsAgainst(through, cellObjects[c]);
+        }
+    }
+
+    void cullObjectsAgainst(const Frustum& frustum, const std::vector<size_t>& objects) {
+        for (size_t i : objects) {
+            objectVisible[i] = frustum.intersectsBox(worldBoxes.center(i), worldBoxes.extents(i));
+            stats.objectsCulled += !objectVisible[i];
+        }
+    }
+
+    void collectDrawList() {
+        drawList.clear();
+        for (size_t i : frameObjects) {
+            if (objectVisible[i]) drawList.push_back(i);
+        }
+    }
+
+    // Окклюдеры из уже прошедших отсечение по пирамиде растеризуются в
+    // буфер, остальные видимые объекты проверяются по нему. Сами окклюдеры
+    // не проверяются (закрыли бы себя); тени рисуются как раньше.
+    void cullOccludedObjects() {
+        if (!occlusionCulling || !hasView) return;
+        occlusion.begin(viewProjection);
+        for (size_t i : frameObjects) {
+            if (objectVisible[i] && isOccluder(i)) {
+                occlusion.addOccluder(*meshes[i]->bvh, transforms[i]);
+            }
+        }
+        stats.occluderTriangles = occlusion.triangleCount();
+        if (occlusion.triangleCount() == 0) return;
+        occlusion.rasterize();
+        for (size_t i : frameObjects) {
+            if (!objectVisible[i] || isOccluder(i)) continue;
+            if (!occlusion.isVisible(worldBoxes.center(i), worldBoxes.extents(i))) {
+                objectVisible[i] = 0;
+                ++stats.objectsOccluded;
+            }
+        }
+    }
+
+    bool isOccluder(size_t i) const {
+        const Mesh& mesh = *meshes[i];
+        if (!mesh.bvh || mesh.bvh->empty() || occluderMode[i] == 0) return false;
+        if (occluderMode[i] == 1) return true;
+        glm::vec3 extents = worldBoxes.extents(i);
+        return mesh.bvh->triangleCount() <= MAX_OCCLUDER_TRIANGLES &&
+               2.0f * std::max({ extents.x, extents.y, extents.z }) >= MIN_OCCLUDER_SIZE;
+    }
+
+    void updateWorldBoxes() {
+        worldBoxes.resize(meshes.size());
+        for (size_t i : frameObjects) {
+            const Bounds& local = meshes[i]->bounds;
+            if (!worldBoxDirty[i] && local.min == worldBoxSource[i].min && local.max == worldBoxSource[i].max) {
+                continue;
+            }
+            // Полуразмеры AABB после поворота и масштаба — сумма модулей
+            // столбцов матрицы, взвешенных исходными полуразмерами.
+            const glm::mat4& m = transforms[i];
+            glm::vec3 e = local.extents();
+            glm::vec3 center = glm::vec3(m * glm::vec4(local.center(), 1.0f));
+            glm::vec3 extents = glm::abs(glm::vec3(m[0])) * e.x + glm::abs(glm::vec3(m[1])) * e.y +
+                                glm::abs(glm::vec3(m[2])) * e.z;
+            // Без границ объект не отсекается.
+            if (!local.isValid()) extents = glm::vec3(1e30f);
+            worldBoxes.set(i, center, extents);
+            worldBoxSource[i] = local;
+            worldBoxDirty[i] = 0;
+        }
+    }
+
+    void bindVertexArray(GLuint id) {
+        if (id == boundVertexArray) return;
+        glBindVertexArray(id);
+        boundVertexArray = id;
+        if (id != 0) ++stats.vertexArrayBinds;
+    }
+
+    // В картах теней меняется только матрица модели, так что объекты идут
+    // по VAO: у сеток одной арены он общий. Тени отбрасывают только
+    // кандидаты кадра.
+    void sortCasters() {
+        casterOrder = frameObjects;
+        std::stable_sort(casterOrder.begin(), casterOrder.end(),
+                         [this](size_t a, size_t b) { return meshes[a]->VAO_id < meshes[b]->VAO_id; });
+    }
+
+    // Униформы распаковки компактных вершин; у несжатых сеток — тождественные.
+    static void setVertexDecode(const Shader& target, const Mesh& mesh) {
+        target.setVec3("positionScale", mesh.decode.positionScale);
+        target.setVec3("positionOffset", mesh.decode.positionOffset);
+        target.setVec4("texCoordTransform", mesh.decode.texCoordTransform);
+        target.setBool("octahedralNormal", mesh.decode.octahedralNormal);
+    }
+
+    // Уровни основного прохода с гистерезисом: без него объект на границе
+    // порога переключался бы каждый кадр.
+    void selectViewLods() {
+        viewLods.resize(meshes.size(), 0);
+        for (size_t i : drawList) {
+            if (pixelsPerUnit <= 0.0f) {
+                viewLods[i] = 0;
+                continue;
+            }
+            float distance = viewDistance(*meshes[i], transforms[i], viewPosition);
+            viewLods[i] = chooseLod(*meshes[i], worldScale(transforms[i]) * pixelsPerUnit / distance,
+                                    lodSettings.pixelError, viewLods[i], lodSettings.hysteresis);
+        }
+    }
+
+    // pixelsPerModelUnit — во сколько пикселей проецируется единица длины
+    // модели. Уровень огрубляется, пока его ошибка ниже порога (с запасом
+    // hysteresis), и уточняется, когда ошибка текущего выходит за порог.
+    static size_t chooseLod(const Mesh& mesh, float pixelsPerModelUnit, float threshold,
+                            size_t current, float hysteresis) {
+        if (threshold <= 0.0f || mesh.lods.empty()) return 0;
+        size_t level = std::min(current, mesh.lods.size());
+        while (level < mesh.lods.size() &&
+               mesh.lodError(level + 1) * pixelsPerModelUnit <= threshold * (1.0f - hysteresis)) {
+            ++level;
+        }
+        while (level > 0 && mesh.lodError(level) * pixelsPerModelUnit > threshold * (1.0f + hysteresis)) {
+            --level;
+        }
+        return level;
+    }
+
+    // Расстояние от точки зрения до ближайшей точки ограничивающей сферы.
+    static float viewDistance(const Mesh& mesh, const glm::mat4& transform, const glm::vec3& eye) {
+        glm::vec3 center = glm::vec3(transform * glm::vec4(mesh.bounds.center(), 1.0f));
+        float radius = mesh.bounds.radius() * worldScale(transform);
+        return std::max(glm::length(center - eye) - radius, 0.1f);
+    }
+
+    static float worldScale(const glm::mat4& transform) {
+        return std::max({ glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])),
+                          glm::length(glm::vec3(transform[2])) });
     }
 };
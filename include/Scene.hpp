@@ -1,21 +1,45 @@
 #pragma once
 
 #include <vector>
+#include <deque>
+#include <string>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include "Mesh.hpp"
 #include "Material.hpp"
 #include "Light.hpp"
 #include "ModelLoader.hpp"
+#include "MeshRegistry.hpp"
+#include "TextureCache.hpp"
+#include "AssetPipeline.hpp"
+#include "CellGraph.hpp"
+
+// Размещение одного экземпляра модели в сцене.
+struct ObjectPlacement {
+    glm::mat4 transform;
+    Material  material;
+    glm::vec3 color = glm::vec3(1.0f);
+};
 
 
 class Scene {
 public:
-    std::vector<Mesh> meshes;
+    // deque: адреса сеток не меняются при добавлении, на них ссылаются
+    // Renderer и колбэки фоновой загрузки.
+    std::deque<Mesh> meshes;
     std::vector<glm::mat4> transforms;
     std::vector<Material> materials;
     std::vector<glm::vec3> colors;
     std::vector<Light> lights;
+    // GL-буферы, на которые ссылаются несколько сеток (bufferView из .glb).
+    std::vector<GLuint> sharedBuffers;
+    // Залы и проёмы между ними. Объект и источник относятся к ячейке, в
+    // которой стоит их начало координат (-1 — вне ячеек, видны всегда),
+    // так что ячейки задаются до объектов, а объект не должен выходить
+    // за свою ячейку дальше, чем через её проёмы видно.
+    CellGraph cells;
+    std::vector<int> meshCells;
+    std::vector<int> lightCells;
 
     Scene() = default;
 
@@ -25,10 +49,12 @@ public:
         transforms.push_back(transform);
         materials.push_back(material);
         colors.push_back(color);
+        meshCells.push_back(cells.findCell(glm::vec3(transform[3])));
     }
 
     void addLight(const Light& light) {
         lights.push_back(light);
+        lightCells.push_back(light.type == LightType::DIRECTIONAL ? -1 : cells.findCell(light.position));
     }
 
     void clear() {
@@ -37,6 +63,10 @@ public:
         materials.clear();
         colors.clear();
         lights.clear();
+        sharedBuffers.clear();
+        cells = CellGraph();
+        meshCells.clear();
+        lightCells.clear();
     }
 
     
@@ -49,64 +79,160 @@ public:
         addMesh(loadedMesh, transform, material, color);
     }
 
+    // Общая текстура из TextureCache: сразу, если assets == nullptr, иначе
+    // заглушка, которая заменится изображением, когда его декодирует рабочий
+    // поток. Один и тот же файл декодируется один раз.
+    static TextureHandle loadTexture(AssetPipeline* assets, const std::string& path,
+                                     const TextureSampling& sampling = TextureSampling()) {
+        TextureCache& cache = TextureCache::global();
+        if (assets == nullptr) {
+            return cache.load(path, sampling);
+        }
+
+        std::string key = AssetArchive::normalize(path);
+        TextureHandle texture = cache.find(key, sampling);
+        if (texture) return texture;
+
+        texture = cache.reserve(key, sampling);
+        std::weak_ptr<Texture> target = texture;
+        assets->loadTexture(path, [target, sampling](TextureImage&& image, bool ok) {
+            // Никто не дождался текстуры — загружать некуда.
+            TextureHandle texture = target.lock();
+            if (ok && texture) {
+                TextureCache::global().upload(*texture, image, sampling);
+            }
+        }, sampling.flipVertically);
+        return texture;
+    }
+
+    // Модель из OBJ в одном или нескольких местах сцены. С assets сетки
+    // добавляются пустыми (ничего не рисуют) и заполняются в GL-потоке,
+    // когда рабочий поток закончит разбор; все экземпляры получают общий VAO.
+    void addOBJModel(AssetPipeline* assets, const std::string& objPath,
+                     const Material& meshMaterial, TextureHandle texture,
+                     const std::vector<ObjectPlacement>& placements) {
+        if (placements.empty()) return;
+
+        // Уже загруженная сетка (та же модель в другом месте сцены) берётся
+        // из реестра без повторной загрузки.
+        MeshRegistry& registry = MeshRegistry::global();
+        std::string key = MeshRegistry::objKey(objPath);
+        Mesh loaded;
+        if (assets == nullptr || registry.find(key, loaded)) {
+            if (!loaded.isReady()) {
+                loaded = registry.obj(objPath, meshMaterial, texture);
+            }
+            loaded.material = meshMaterial;
+            loaded.texture = texture;
+            for (const auto& p : placements) {
+                addMesh(loaded, p.transform, p.material, p.color);
+            }
+            return;
+        }
+
+        std::vector<Mesh*> instances;
+        for (const auto& p : placements) {
+            Mesh placeholder;
+            placeholder.material = meshMaterial;
+            placeholder.texture = texture;
+            addMesh(placeholder, p.transform, p.material, p.color);
+            instances.push_back(&meshes.back());
+        }
+
+        // Текстуру держат заглушки, а не колбэк: незабранный результат не
+        // должен оказаться её последним владельцем после закрытия контекста.
+        assets->loadMesh(objPath, [instances, key, meshMaterial](LoadedObj&& loaded, bool ok) {
+            Mesh& first = *instances[0];
+            TextureHandle texture = first.texture;
+            first = ok ? MeshRegistry::global().adopt(key, ModelLoader::createMesh(std::move(loaded)))
+                       : MeshRegistry::global().cube();
+            first.material = meshMaterial;
+            first.texture = texture;
+            for (size_t i = 1; i < instances.size(); ++i) {
+                *instances[i] = first;
+            }
+        });
+    }
+
+    // Модель из OBJ с материалами из её .mtl: одна сетка с участками на
+    // каждый usemtl, материал размещения служит запасным для участков без
+    // описания в .mtl. Грузится сразу, в GL-потоке.
+    void addOBJModelWithMaterials(const std::string& objPath,
+                                  const std::vector<ObjectPlacement>& placements) {
+        if (placements.empty()) return;
+
+        Mesh loaded = ModelLoader::loadOBJWithMaterials(objPath, placements[0].material);
+        for (const auto& p : placements) {
+            addMesh(loaded, p.transform, p.material, p.color);
+        }
+    }
+
+    // Модель из .glb: каждая часть добавляется во всех узлах сцены glTF,
+    // transform применяется поверх матриц узлов. Материалы и текстуры
+    // берутся из файла.
+    void addGLBModel(const std::string& glbPath, const glm::mat4& transform,
+                     const glm::vec3& color = glm::vec3(1.0f)) {
+        GltfModel model = ModelLoader::loadGLB(glbPath);
+        if (!model.isValid()) {
+            addMesh(MeshRegistry::global().cube(), transform, Material::PlasticWhite(), color);
+            return;
+        }
+
+        sharedBuffers.insert(sharedBuffers.end(), model.buffers.begin(), model.buffers.end());
+        for (const auto& instance : model.instances) {
+            const Mesh& part = model.parts[instance.part];
+            addMesh(part, transform * instance.transform, part.material, color);
+        }
+    }
+
     size_t getMeshCount() const { return meshes.size(); }
     size_t getLightCount() const { return lights.size(); }
 
     
-    static Scene CreateMuseumRoom() {
+    // С assets модели и текстуры грузятся в фоне (см. AssetPipeline::pump),
+    // без него — сразу, как раньше.
+    static Scene CreateMuseumRoom(AssetPipeline* assets = nullptr) {
         Scene scene;
+        // Одинаковые примитивы (плинтусы, планки рамок, стены) делят буферы.
+        MeshRegistry& shared = MeshRegistry::global();
+        // Весь зал — одна ячейка; с запасом на плинтусы за стенами.
+        scene.cells.addCell("hall", glm::vec3(-31.0f, -5.5f, -16.0f), glm::vec3(31.0f, 15.5f, 16.0f));
         scene.addLight(Light(glm::vec3(0.0f, 14.0f, 0.0f),
                 glm::vec3(1.0f, 0.98f, 0.9f), 8.0f, 40.0f));
 
 
-        Texture* floorTexture = new Texture("res/textures/floor.jpg", 
-                                            GL_TEXTURE_2D, 
-                                            GL_TEXTURE2, 
-                                            GL_RGB, 
-                                            GL_UNSIGNED_BYTE);
-
-        Texture* wallTexture = new Texture("res/textures/wall.jpg", 
-                                            GL_TEXTURE_2D, 
-                                            GL_TEXTURE2, 
-                                            GL_RGB, 
-                                            GL_UNSIGNED_BYTE);
+        TextureHandle floorTexture = loadTexture(assets, "res/textures/floor.jpg");
+        TextureHandle wallTexture = loadTexture(assets, "res/textures/wall.jpg");
 
         
-        Mesh column = ModelLoader::loadOBJ("res/models/Column.obj", 
-                                            Material::Wall());
-        column.addTexture(wallTexture);
-        scene.addMesh(column, 
-                      glm::translate(glm::mat4(1.0f), glm::vec3(-30.0f, -5.0f, -15.0f)) *
-                      glm::scale(glm::mat4(1.0f), glm::vec3(0.04f)),
-                      Material::Marble(), glm::vec3(0.8f,0.8f,0.8f));
-
-        scene.addMesh(column, 
-                glm::translate(glm::mat4(1.0f), glm::vec3(30.0f, -5.0f, -15.0f)) *
-                glm::scale(glm::mat4(1.0f), glm::vec3(0.04f)),
-                Material::Marble(), glm::vec3(0.8f,0.8f,0.8f));
+        scene.addOBJModel(assets, "res/models/Column.obj", Material::Wall(), wallTexture, {
+            { glm::translate(glm::mat4(1.0f), glm::vec3(-30.0f, -5.0f, -15.0f)) *
+              glm::scale(glm::mat4(1.0f), glm::vec3(0.04f)),
+              Material::Marble(), glm::vec3(0.8f,0.8f,0.8f) },
 
-        scene.addMesh(column, 
-                      glm::translate(glm::mat4(1.0f), glm::vec3(30.0f, -5.0f, 15.0f)) *
-                      glm::scale(glm::mat4(1.0f), glm::vec3(0.04f)),
-                      Material::Marble(), glm::vec3(0.8f,0.8f,0.8f));
+            { glm::translate(glm::mat4(1.0f), glm::vec3(30.0f, -5.0f, -15.0f)) *
+              glm::scale(glm::mat4(1.0f), glm::vec3(0.04f)),
+              Material::Marble(), glm::vec3(0.8f,0.8f,0.8f) },
 
-        scene.addMesh(column, 
-                      glm::translate(glm::mat4(1.0f), glm::vec3(-30.0f, -5.0f, 15.0f)) *
-                      glm::scale(glm::mat4(1.0f), glm::vec3(0.04f)) *
-                      glm::rotate(glm::mat4(1.0f), glm::radians(12.0f), glm::vec3(0.0f, 1.0f, 0.0f)),
-                      Material::Marble(), glm::vec3(0.8f,0.8f,0.8f));
+            { glm::translate(glm::mat4(1.0f), glm::vec3(30.0f, -5.0f, 15.0f)) *
+              glm::scale(glm::mat4(1.0f), glm::vec3(0.04f)),
+              Material::Marble(), glm::vec3(0.8f,0.8f,0.8f) },
 
+            { glm::translate(glm::mat4(1.0f), glm::vec3(-30.0f, -5.0f, 15.0f)) *
+              glm::scale(glm::mat4(1.0f), glm::vec3(0.04f)) *
+              glm::rotate(glm::mat4(1.0f), glm::radians(12.0f), glm::vec3(0.0f, 1.0f, 0.0f)),
+              Material::Marble(), glm::vec3(0.8f,0.8f,0.8f) },
+        });
 
-        Mesh phone = ModelLoader::loadOBJWithTexture("res/models/iphone.obj", 
-                                                     "res/textures/iphone.png",
-                                                     Material::Marble());
 
-
-        scene.addMesh(phone, glm::translate(glm::mat4(1.0f), glm::vec3(-20.13f, -4.99f, -7.0f)) *
-                             glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(1.0f,0.0f,0.0f)) *
-                             glm::rotate(glm::mat4(1.0f), glm::radians(40.0f), glm::vec3(0.0f,0.0f,1.0f)) *
-                                 glm::scale(glm::mat4(1.0f), glm::vec3(0.08f)),
-                             Material::iPhoneGlass(), glm::vec3(0.5f,0.5f,0.5f));
+        scene.addOBJModel(assets, "res/models/iphone.obj", Material::Marble(),
+                          loadTexture(assets, "res/textures/iphone.png"), {
+            { glm::translate(glm::mat4(1.0f), glm::vec3(-20.13f, -4.99f, -7.0f)) *
+              glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(1.0f,0.0f,0.0f)) *
+              glm::rotate(glm::mat4(1.0f), glm::radians(40.0f), glm::vec3(0.0f,0.0f,1.0f)) *
+              glm::scale(glm::mat4(1.0f), glm::vec3(0.08f)),
+              Material::iPhoneGlass(), glm::vec3(0.5f,0.5f,0.5f) },
+        });
 
         glm::mat4 phoneTransform = 
             glm::translate(glm::mat4(1.0f), glm::vec3(-23.0f, -4.99f, -8.0f));
@@ -133,69 +259,63 @@ public:
             outerAngle               
         ));
 
-        Mesh olen = ModelLoader::loadOBJ("res/models/olen.obj", 
-                                        Material::Marble());
-
-        scene.addMesh(olen, glm::translate(glm::mat4(1.0f), glm::vec3(20.0f, -5.0f, -5.0f)) *
-                             glm::scale(glm::mat4(1.0f), glm::vec3(0.06f)) * 
-                             glm::rotate(glm::mat4(1.0f), glm::radians(-40.0f), glm::vec3(0.0f,1.0f,0.0f)),
-                             Material::Marble(), glm::vec3(0.8f,0.8f,0.8f));
-
-        Mesh venus = ModelLoader::loadOBJ("res/models/venus.obj", 
-                                        Material::Marble());
-
-        scene.addMesh(venus, glm::translate(glm::mat4(1.0f), glm::vec3(24.f,-5.0f,10.0f)) *
-                             glm::scale(glm::mat4(1.0f), glm::vec3(0.08f)) * 
-                             glm::rotate(glm::mat4(1.0f), glm::radians(-120.0f), glm::vec3(0.0f,1.0f,0.0f)),
-                             Material::Marble(), glm::vec3(0.8f,0.8f,0.8f));
-
-        Mesh cat = ModelLoader::loadOBJ("res/models/cat.obj", 
-                                        Material::Marble());
-
-        scene.addMesh(cat, glm::translate(glm::mat4(1.0f), glm::vec3(-11,-5.0f,-7)) *
-                             glm::scale(glm::mat4(1.0f), glm::vec3(30.08f)) * 
-                             glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(1.0f,0.0f,0.0f))*
-                             glm::rotate(glm::mat4(1.0f), glm::radians(-30.0f), glm::vec3(0.0f,0.0f,1.0f)),
-                             Material::Marble(), glm::vec3(0.8f,0.8f,0.8f));
-
-
-        Mesh sofa = ModelLoader::loadOBJWithTexture("res/models/sofa.obj", 
-                                        "res/textures/sofaTx.jpg",
-                                        Material::Marble());
-
-        scene.addMesh(sofa, glm::translate(glm::mat4(1.0f), glm::vec3(0,-5,10)) *
-                             glm::scale(glm::mat4(1.0f), glm::vec3(0.008f)) *
-                             glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(0.0f,1.0f,0.0f)),
-
-                             Material::Stone(), glm::vec3(0.8f,0.8f,0.8f));
-
-        Mesh lamp = ModelLoader::loadOBJ("res/models/lamp.obj", 
-                                        Material::Marble());
-
-        scene.addMesh(lamp, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f,15.0f, 0.0f)) *
-                             glm::scale(glm::mat4(1.0f), glm::vec3(0.008f)) *
-                             glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(0.0f,0.0f,1.0f)),
-                             Material::Marble(), glm::vec3(0.8f,0.8f,0.8f));
+        scene.addOBJModel(assets, "res/models/olen.obj", Material::Marble(), nullptr, {
+            { glm::translate(glm::mat4(1.0f), glm::vec3(20.0f, -5.0f, -5.0f)) *
+              glm::scale(glm::mat4(1.0f), glm::vec3(0.06f)) * 
+              glm::rotate(glm::mat4(1.0f), glm::radians(-40.0f), glm::vec3(0.0f,1.0f,0.0f)),
+              Material::Marble(), glm::vec3(0.8f,0.8f,0.8f) },
+        });
+
+        scene.addOBJModel(assets, "res/models/venus.obj", Material::Marble(), nullptr, {
+            { glm::translate(glm::mat4(1.0f), glm::vec3(24.f,-5.0f,10.0f)) *
+              glm::scale(glm::mat4(1.0f), glm::vec3(0.08f)) * 
+              glm::rotate(glm::mat4(1.0f), glm::radians(-120.0f), glm::vec3(0.0f,1.0f,0.0f)),
+              Material::Marble(), glm::vec3(0.8f,0.8f,0.8f) },
+        });
+
+        scene.addOBJModel(assets, "res/models/cat.obj", Material::Marble(), nullptr, {
+            { glm::translate(glm::mat4(1.0f), glm::vec3(-11,-5.0f,-7)) *
+              glm::scale(glm::mat4(1.0f), glm::vec3(30.08f)) * 
+              glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(1.0f,0.0f,0.0f))*
+              glm::rotate(glm::mat4(1.0f), glm::radians(-30.0f), glm::vec3(0.0f,0.0f,1.0f)),
+              Material::Marble(), glm::vec3(0.8f,0.8f,0.8f) },
+        });
+
+
+        scene.addOBJModel(assets, "res/models/sofa.obj", Material::Marble(),
+                          loadTexture(assets, "res/textures/sofaTx.jpg"), {
+            { glm::translate(glm::mat4(1.0f), glm::vec3(0,-5,10)) *
+              glm::scale(glm::mat4(1.0f), glm::vec3(0.008f)) *
+              glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(0.0f,1.0f,0.0f)),
+              Material::Stone(), glm::vec3(0.8f,0.8f,0.8f) },
+        });
+
+        scene.addOBJModel(assets, "res/models/lamp.obj", Material::Marble(), nullptr, {
+            { glm::translate(glm::mat4(1.0f), glm::vec3(0.0f,15.0f, 0.0f)) *
+              glm::scale(glm::mat4(1.0f), glm::vec3(0.008f)) *
+              glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(0.0f,0.0f,1.0f)),
+              Material::Marble(), glm::vec3(0.8f,0.8f,0.8f) },
+        });
                 
 
         
         
         
-        Mesh floor = Mesh::CreatePlane(60.0f, 30.0f, Material::Floor());
+        Mesh floor = shared.plane(60.0f, 30.0f, Material::Floor());
         
         floor.addTexture(floorTexture);
         scene.addMesh(floor, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -5.0f, 0.0f)),
                  Material::Floor(), glm::vec3(0.5f, 0.5f, 0.5f));
 
         
-        Mesh ceiling = Mesh::CreatePlane(60.0f, 30.0f, Material::Ceiling());
+        Mesh ceiling = shared.plane(60.0f, 30.0f, Material::Ceiling());
         ceiling.addTexture(floorTexture);
         scene.addMesh(ceiling, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 15.0f, 0.0f)),
                      Material::Ceiling(), glm::vec3(0.9f, 0.9f, 0.9f));
 
         
         
-        Mesh frontWall = Mesh::CreatePlane(60.0f, 20.0f, Material::Wall());
+        Mesh frontWall = shared.plane(60.0f, 20.0f, Material::Wall());
         frontWall.addTexture(wallTexture);
         scene.addMesh(frontWall, 
                      glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 5.0f, -15.0f)) * 
@@ -205,7 +325,7 @@ public:
 
         
         
-        Mesh backWall = Mesh::CreatePlane(60.0f, 20.0f, Material::Wall());
+        Mesh backWall = shared.plane(60.0f, 20.0f, Material::Wall());
         backWall.addTexture(wallTexture);
         
         scene.addMesh(backWall,
@@ -215,7 +335,7 @@ public:
 
         
         
-        Mesh leftWall = Mesh::CreatePlane(20.0f, 30.0f, Material::Wall());
+        Mesh leftWall = shared.plane(20.0f, 30.0f, Material::Wall());
         leftWall.addTexture(wallTexture);
         scene.addMesh(leftWall, 
                      glm::translate(glm::mat4(1.0f), glm::vec3(-30.0f, 5.0f, 0.0f)) * 
@@ -225,7 +345,7 @@ public:
 
         
         
-        Mesh rightWall = Mesh::CreatePlane(20.0f, 30.0f, Material::Wall());
+        Mesh rightWall = shared.plane(20.0f, 30.0f, Material::Wall());
         rightWall.addTexture(wallTexture);
         scene.addMesh(rightWall, 
                      glm::translate(glm::mat4(1.0f), glm::vec3(30.0f, 5.0f, 0.0f)) * 
@@ -237,7 +357,7 @@ public:
         glm::mat4 base = glm::translate(glm::mat4(1.0f), glm::vec3(-15.0f, 7.0f, -14.79f)) * 
                                         glm::scale(glm::mat4(1.0f), glm::vec3(2.0f, 2.0f, 1.0f)); 
 
-        PictureFrameMeshes frame = Mesh::CreateVolumePictureFrame(
+        PictureFrameMeshes frame = shared.pictureFrame(
             4.0f, 3.0f,      
             0.3f,            
             0.4f,            
@@ -245,13 +365,7 @@ public:
             Material::PlasticWhite()   
         );
         Mesh picturePlane = *frame.picturePlane;
-        picturePlane.addTexture(new Texture(
-            "res/textures/sadcat.jpg",
-            GL_TEXTURE_2D,
-            GL_TEXTURE2,
-            GL_RGBA,
-            GL_UNSIGNED_BYTE
-        ));
+        picturePlane.addTexture(loadTexture(assets, "res/textures/sadcat.jpg"));
 
     
         scene.addMesh(
@@ -306,15 +420,13 @@ public:
             glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f)) *
             glm::scale(glm::mat4(1.0f), glm::vec3(2.0f, 2.0f, 1.0f));
 
-        PictureFrameMeshes frameCenter = Mesh::CreateVolumePictureFrame(
+        PictureFrameMeshes frameCenter = shared.pictureFrame(
             4.0f, 3.0f, 0.3f, 0.4f,
             Material::Marble(), Material::PlasticWhite()
         );
 
         Mesh pictureCenter = *frameCenter.picturePlane;
-        pictureCenter.addTexture(new Texture("res/textures/lisa.png",
-                                            GL_TEXTURE_2D, GL_TEXTURE2,
-                                            GL_RGBA, GL_UNSIGNED_BYTE));
+        pictureCenter.addTexture(loadTexture(assets, "res/textures/lisa.png"));
 
         scene.addMesh(pictureCenter, baseCenter,
                     Material::Wall(), glm::vec3(1.0f));
@@ -360,15 +472,13 @@ public:
             glm::translate(glm::mat4(1.0f), glm::vec3(15.0f, 1.5f, -14.79f)) *
             glm::scale(glm::mat4(1.0f), glm::vec3(2.0f, 2.0f, 1.0f));
 
-        PictureFrameMeshes frameRight = Mesh::CreateVolumePictureFrame(
+        PictureFrameMeshes frameRight = shared.pictureFrame(
             4.0f, 3.0f, 0.3f, 0.4f,
             Material::Marble(), Material::PlasticWhite()
         );
 
         Mesh pictureRight = *frameRight.picturePlane;
-        pictureRight.addTexture(new Texture("res/textures/bog.png",
-                                            GL_TEXTURE_2D, GL_TEXTURE2,
-                                            GL_RGBA, GL_UNSIGNED_BYTE));
+        pictureRight.addTexture(loadTexture(assets, "res/textures/bog.png"));
 
         scene.addMesh(pictureRight, baseRight,
                     Material::PlasticWhite(), glm::vec3(1.0f));
@@ -408,14 +518,14 @@ public:
             glm::vec3(1.0f, 1.0f, 1.0f)
         );
 
-        Mesh cube = Mesh::CreateCube(Material::PlasticWhite());
+        Mesh cube = shared.cube(Material::PlasticWhite());
         scene.addMesh(cube,
                       glm::translate(glm::mat4(1.0f), glm::vec3(-21.0f, -3.0f, -10.0f)) *
                       glm::scale(glm::mat4(1.0f), glm::vec3(2.0f, 2.0f, 2.0f)),
                       Material::MetalGold()), glm::vec3(0.1f, 0.2f, 0.2f);
         
 
-        Mesh sphere = Mesh::CreateSphere(1.5f, 32, 16, Material::Stone());
+        Mesh sphere = shared.sphere(1.5f, 32, 16, Material::Stone());
         scene.addMesh(sphere,
                 glm::translate(glm::mat4(1.0f), glm::vec3(-16.0f, -3.5f, -10.0f)),
                 Material::Marble()), glm::vec3(0.1f, 0.2f, 0.2f);
@@ -428,7 +538,7 @@ public:
         glm::vec3 plinthColor(0.95f, 0.95f, 0.95f);
 
         
-        Mesh frontPlinth = Mesh::CreateCube(plinthMat);
+        Mesh frontPlinth = shared.cube(plinthMat);
         scene.addMesh(
             frontPlinth,
             glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -4.5f, -15.5f)) *
@@ -437,7 +547,7 @@ public:
         );
 
         
-        Mesh backPlinth = Mesh::CreateCube(plinthMat);
+        Mesh backPlinth = shared.cube(plinthMat);
         scene.addMesh(
             backPlinth,
             glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -4.5f, 15.5f)) *
@@ -446,7 +556,7 @@ public:
         );
 
         
-        Mesh leftPlinth = Mesh::CreateCube(plinthMat);
+        Mesh leftPlinth = shared.cube(plinthMat);
         scene.addMesh(
             leftPlinth,
             glm::translate(glm::mat4(1.0f), glm::vec3(-30.5f, -4.5f, 0.0f)) *
@@ -455,7 +565,7 @@ public:
         );
 
         
-        Mesh rightPlinth = Mesh::CreateCube(plinthMat);
+        Mesh rightPlinth = shared.cube(plinthMat);
         scene.addMesh(
             rightPlinth,
             glm::translate(glm::mat4(1.0f), glm::vec3(30.5f, -4.5f, 0.0f)) *
@@ -474,6 +584,127 @@ public:
         
         
 
+        frame.release();
+        frameCenter.release();
+        frameRight.release();
+
+        // Все файлы сцены поставлены в очередь: читаем их одной пачкой.
+        if (assets != nullptr) {
+            assets->flushReads();
+        }
+
+        return scene;
+    }
+
+    // Анфилада из halls залов 30×30 вдоль оси X, соединённых дверными
+    // проёмами 4×8 в торцевых стенах; в каждом зале потолочный свет и
+    // прожекторы над экспонатами, колонны по углам и экспонаты на постаментах. Каждый зал — ячейка,
+    // каждый проём — портал: из зала видны только залы, чьи проёмы попадают
+    // в кадр.
+    static Scene CreateGallery(AssetPipeline* assets, int halls) {
+        Scene scene;
+        MeshRegistry& shared = MeshRegistry::global();
+        const float size = 30.0f;
+        const float half = size * 0.5f;
+        const float wall = 0.2f;         // полутолщина стены
+        const float doorHalfWidth = 2.0f;
+        const float doorTop = 3.0f;
+
+        for (int i = 0; i < halls; ++i) {
+            float x = i * size;
+            scene.cells.addCell("hall " + std::to_string(i), glm::vec3(x - half, -5.5f, -half - 0.5f),
+                                glm::vec3(x + half, 15.5f, half + 0.5f));
+            if (i > 0) {
+                float door = x - half;
+                scene.cells.addPortal(i - 1, i, {
+                    glm::vec3(door, -5.0f, -doorHalfWidth), glm::vec3(door, -5.0f, doorHalfWidth),
+                    glm::vec3(door, doorTop, doorHalfWidth), glm::vec3(door, doorTop, -doorHalfWidth) });
+            }
+        }
+
+        TextureHandle floorTexture = loadTexture(assets, "res/textures/floor.jpg");
+        TextureHandle wallTexture = loadTexture(assets, "res/textures/wall.jpg");
+        Mesh floor = shared.plane(size, size, Material::Floor());
+        floor.addTexture(floorTexture);
+        Mesh ceiling = shared.plane(size, size, Material::Ceiling());
+        ceiling.addTexture(floorTexture);
+        Mesh block = shared.cube(Material::Wall());
+        block.addTexture(wallTexture);
+        Mesh plinth = shared.cube(Material::Marble());
+        Mesh sphere = shared.sphere(1.5f, 32, 16, Material::Stone());
+
+        // Коробка по центру и полуразмерам (куб реестра — от -1 до 1).
+        auto box = [](const glm::vec3& center, const glm::vec3& halfSize) {
+            return glm::translate(glm::mat4(1.0f), center) * glm::scale(glm::mat4(1.0f), halfSize);
+        };
+
+        std::vector<ObjectPlacement> columns;
+        std::vector<ObjectPlacement> statues;
+        for (int i = 0; i < halls; ++i) {
+            float x = i * size;
+            scene.addLight(Light(glm::vec3(x, 14.0f, 0.0f), glm::vec3(1.0f, 0.98f, 0.9f), 6.0f, 32.0f));
+            // Трековые прожекторы над экспонатами.
+            for (float z : { -1.0f, 1.0f }) {
+                for (float exhibit : { -7.0f, 7.0f }) {
+                    glm::vec3 target(x + exhibit, -2.0f, z * 8.0f);
+                    glm::vec3 track(x + exhibit * 0.6f, 13.0f, z * 4.0f);
+                    scene.addLight(Light(track, target - track, glm::vec3(1.0f, 0.95f, 0.85f), 3.0f, 20.0f, 12.0f, 18.0f));
+                }
+            }
+
+            scene.addMesh(floor, glm::translate(glm::mat4(1.0f), glm::vec3(x, -5.0f, 0.0f)),
+                          Material::Floor(), glm::vec3(0.5f));
+            scene.addMesh(ceiling, glm::translate(glm::mat4(1.0f), glm::vec3(x, 15.0f, 0.0f)),
+                          Material::Ceiling(), glm::vec3(0.9f));
+
+            // Продольные стены целиком; торцевые — с проёмом, если за ними
+            // есть зал. У соседних залов свои стены вплотную, чтобы каждая
+            // принадлежала своей ячейке.
+            for (float side : { -1.0f, 1.0f }) {
+                scene.addMesh(block, box(glm::vec3(x, 5.0f, side * (half - wall)), glm::vec3(half, 10.0f, wall)),
+                              Material::Wall(), glm::vec3(0.9f));
+                float wallX = x + side * (half - wall);
+                bool door = side < 0.0f ? i > 0 : i + 1 < halls;
+                if (!door) {
+                    scene.addMesh(block, box(glm::vec3(wallX, 5.0f, 0.0f), glm::vec3(wall, 10.0f, half)),
+                                  Material::Wall(), glm::vec3(0.9f));
+                    continue;
+                }
+                float jamb = (half - doorHalfWidth) * 0.5f;
+                for (float z : { -1.0f, 1.0f }) {
+                    scene.addMesh(block, box(glm::vec3(wallX, 5.0f, z * (doorHalfWidth + jamb)), glm::vec3(wall, 10.0f, jamb)),
+                                  Material::Wall(), glm::vec3(0.9f));
+                }
+                scene.addMesh(block, box(glm::vec3(wallX, (doorTop + 15.0f) * 0.5f, 0.0f),
+                                         glm::vec3(wall, (15.0f - doorTop) * 0.5f, doorHalfWidth)),
+                              Material::Wall(), glm::vec3(0.9f));
+            }
+
+            for (float z : { -1.0f, 1.0f }) {
+                scene.addMesh(plinth, box(glm::vec3(x - 7.0f, -4.0f, z * 8.0f), glm::vec3(1.5f, 1.0f, 1.5f)),
+                              Material::Marble(), glm::vec3(0.95f));
+                scene.addMesh(sphere, glm::translate(glm::mat4(1.0f), glm::vec3(x - 7.0f, -1.5f, z * 8.0f)),
+                              Material::Stone(), glm::vec3(0.8f));
+                statues.push_back({ glm::translate(glm::mat4(1.0f), glm::vec3(x + 7.0f, -5.0f, z * 8.0f)) *
+                                    glm::scale(glm::mat4(1.0f), glm::vec3(0.08f)) *
+                                    glm::rotate(glm::mat4(1.0f), glm::radians(z * 90.0f), glm::vec3(0.0f, 1.0f, 0.0f)),
+                                    Material::Marble(), glm::vec3(0.8f) });
+                for (float corner : { -1.0f, 1.0f }) {
+                    columns.push_back({ glm::translate(glm::mat4(1.0f),
+                                                       glm::vec3(x + corner * (half - 4.0f), -5.0f, z * (half - 4.0f))) *
+                                        glm::scale(glm::mat4(1.0f), glm::vec3(0.04f)),
+                                        Material::Marble(), glm::vec3(0.8f) });
+                }
+            }
+        }
+
+        scene.addOBJModel(assets, "res/models/Column.obj", Material::Wall(), wallTexture, columns);
+        scene.addOBJModel(assets, "res/models/venus.obj", Material::Marble(), nullptr, statues);
+
+        if (assets != nullptr) {
+            assets->flushReads();
+        }
+
         return scene;
     }
 };
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cfloat>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "Bvh.hpp"
+#include "MeshBvh.hpp"
+
+// Попадание луча в объект сцены.
+struct RayHit {
+    size_t    object = 0;       // номер объекта (в порядке addObject)
+    uint32_t  triangle = 0;     // номер треугольника в индексах LOD0 его сетки
+    float     t = FLT_MAX;      // в длинах направления луча
+    glm::vec3 point = glm::vec3(0.0f);
+    glm::vec3 normal = glm::vec3(0.0f);   // мировая нормаль грани, к лучу
+};
+
+// Двухуровневая BVH для запросов к сцене (выбор экспоната мышью и т.п.):
+// верхний уровень — по мировым AABB объектов, нижний — MeshBvh их сеток,
+// общий для всех экземпляров. Луч переводится в пространство объекта
+// обратной матрицей, так что экземпляры не копируют треугольники.
+// Смена матриц обходится refit() без перестройки.
+class SceneBvh {
+public:
+    void clear() {
+        objects.clear();
+        boxMin.clear();
+        boxMax.clear();
+        tree = Bvh();
+    }
+
+    // bvh == nullptr (сетка ещё грузится или без CPU-копии) — объект
+    // занимает номер, но запросам не виден.
+    size_t addObject(std::shared_ptr<const MeshBvh> bvh, const glm::mat4& transform) {
+        Object object;
+        object.bvh = std::move(bvh);
+        objects.push_back(std::move(object));
+        boxMin.emplace_back(FLT_MAX);
+        boxMax.emplace_back(-FLT_MAX);
+        setTransform(objects.size() - 1, transform);
+        return objects.size() - 1;
+    }
+
+    // Новая матрица объекта; дерево обновит refit() или build().
+    void setTransform(size_t index, const glm::mat4& transform) {
+        Object& object = objects[index];
+        object.transform = transform;
+        object.inverse = glm::inverse(transform);
+        object.minScale = std::min({ glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])),
+                                     glm::length(glm::vec3(transform[2])) });
+        if (!object.bvh || object.bvh->empty()) return;
+
+        glm::vec3 center = (object.bvh->boundsMin() + object.bvh->boundsMax()) * 0.5f;
+        glm::vec3 extents = (object.bvh->boundsMax() - object.bvh->boundsMin()) * 0.5f;
+        glm::vec3 worldCenter = glm::vec3(transform * glm::vec4(center, 1.0f));
+        glm::vec3 worldExtents = glm::abs(glm::vec3(transform[0])) * extents.x +
+                                 glm::abs(glm::vec3(transform[1])) * extents.y +
+                                 glm::abs(glm::vec3(transform[2])) * extents.z;
+        boxMin[index] = worldCenter - worldExtents;
+        boxMax[index] = worldCenter + worldExtents;
+    }
+
+    void build() {
+        tree.build(boxMin, boxMax);
+    }
+
+    // После setTransform: те же узлы, новые AABB. Объекты, у которых
+    // при build() не было сетки, так в дерево не попадут — для них build().
+    void refit() {
+        tree.refit(boxMin, boxMax);
+    }
+
+    size_t objectCount() const { return objects.size(); }
+
+    // Ближайшее попадание луча при t в [0, maxT).
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, RayHit& hit,
+                 float maxT = FLT_MAX) const {
+        if (tree.empty()) return false;
+        glm::vec3 invDir = Bvh::inverseDirection(direction);
+        MeshHit best;
+        best.t = maxT;
+        bool found = false;
+        size_t bestObject = 0;
+
+        uint32_t stack[MeshBvh::STACK_SIZE];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const BvhNode& node = tree.nodes[stack[--top]];
+            if (Bvh::rayBox(origin, invDir, best.t, node.min, node.max) == FLT_MAX) continue;
+            if (node.isLeaf()) {
+                for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                    size_t index = tree.order[i];
+                    const Object& object = objects[index];
+                    glm::vec3 localOrigin = glm::vec3(object.inverse * glm::vec4(origin, 1.0f));
+                    glm::vec3 localDirection = glm::vec3(object.inverse * glm::vec4(direction, 0.0f));
+                    // Аффинное преобразование сохраняет параметр t.
+                    if (object.bvh->raycast(localOrigin, localDirection, best)) {
+                        found = true;
+                        bestObject = index;
+                    }
+                }
+                continue;
+            }
+            if (top + 1 < MeshBvh::STACK_SIZE) {
+                stack[top++] = node.first + 1;
+                stack[top++] = node.first;
+            }
+        }
+        if (!found) return false;
+
+        const Object& object = objects[bestObject];
+        hit.object = bestObject;
+        hit.triangle = best.triangle;
+        hit.t = best.t;
+        hit.point = origin + direction * best.t;
+        hit.normal = worldNormal(object, best.normal);
+        if (glm::dot(hit.normal, direction) > 0.0f) hit.normal = -hit.normal;
+        return true;
+    }
+
+    // Отрезок from → to: hit.t в долях его длины.
+    bool intersectSegment(const glm::vec3& from, const glm::vec3& to, RayHit& hit) const {
+        return raycast(from, to - from, hit, 1.0f);
+    }
+
+    // Объекты, чья геометрия задевает сферу (по треугольникам, а не AABB).
+    void overlapSphere(const glm::vec3& center, float radius, std::vector<size_t>& result) const {
+        if (tree.empty()) return;
+        float r2 = radius * radius;
+        uint32_t stack[MeshBvh::STACK_SIZE];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const BvhNode& node = tree.nodes[stack[--top]];
+            if (Bvh::boxDistanceSquared(center, node.min, node.max) > r2) continue;
+            if (node.isLeaf()) {
+                for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                    if (objectTouchesSphere(objects[tree.order[i]], center, radius)) {
+                        result.push_back(tree.order[i]);
+                    }
+                }
+                continue;
+            }
+            if (top + 1 < MeshBvh::STACK_SIZE) {
+                stack[top++] = node.first + 1;
+                stack[top++] = node.first;
+            }
+        }
+    }
+
+private:
+    struct Object {
+        std::shared_ptr<const MeshBvh> bvh;
+        glm::mat4 transform = glm::mat4(1.0f);
+        glm::mat4 inverse = glm::mat4(1.0f);
+        float minScale = 1.0f;
+    };
+
+    std::vector<Object> objects;
+    std::vector<glm::vec3> boxMin;
+    std::vector<glm::vec3> boxMax;
+    Bvh tree;
+
+    // Сфера переводится в пространство объекта с радиусом по наименьшему
+    // масштабу (с запасом при неравномерном), треугольники проверяются в мире.
+    static bool objectTouchesSphere(const Object& object, const glm::vec3& center, float radius) {
+        if (object.minScale <= 0.0f) return false;
+        glm::vec3 localCenter = glm::vec3(object.inverse * glm::vec4(center, 1.0f));
+        float r2 = radius * radius;
+        bool found = false;
+        object.bvh->visitNear(localCenter, radius / object.minScale, [&](uint32_t i) {
+            glm::vec3 a, b, c;
+            object.bvh->triangle(i, a, b, c);
+            a = glm::vec3(object.transform * glm::vec4(a, 1.0f));
+            b = glm::vec3(object.transform * glm::vec4(b, 1.0f));
+            c = glm::vec3(object.transform * glm::vec4(c, 1.0f));
+            glm::vec3 d = MeshBvh::closestPointOnTriangle(center, a, b, c) - center;
+            found = glm::dot(d, d) <= r2;
+            return !found;
+        });
+        return found;
+    }
+
+    // Нормаль грани в мире: обратная транспонированная матрица.
+    static glm::vec3 worldNormal(const Object& object, const glm::vec3& n) {
+        glm::vec3 world(glm::dot(glm::vec3(object.inverse[0]), n), glm::dot(glm::vec3(object.inverse[1]), n),
+                        glm::dot(glm::vec3(object.inverse[2]), n));
+        float length = glm::length(world);
+        return length > 0.0f ? world / length : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+};
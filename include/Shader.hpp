@@ -7,12 +7,21 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <utility>
+#include "AssetArchive.hpp"
+#include "AsyncFileReader.hpp"
 
 class Shader {
 private:
     GLuint ID;
 
     std::string readShaderFile(const char* filePath) {
+        std::string_view packed;
+        if (AssetArchive::global().findRaw(filePath, packed)) {
+            return std::string(packed);
+        }
+
         std::ifstream shaderFile;
         shaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
         try {
@@ -44,13 +53,7 @@ private:
         glDeleteShader(shader);
     }
 
-public:
-    Shader(const char* vertexPath, const char* fragmentPath) {
-        ID = glCreateProgram();
-
-        std::string vertexCode = readShaderFile(vertexPath);
-        std::string fragmentCode = readShaderFile(fragmentPath);
-
+    void build(const std::string& vertexCode, const std::string& fragmentCode) {
         if (vertexCode.empty() || fragmentCode.empty()) {
             std::cerr << "ERROR::SHADER::FAILED_TO_READ_FILES" << std::endl;
             return;
@@ -70,6 +73,55 @@ public:
         }
     }
 
+public:
+    // Исходники одной программы, прочитанные заранее (см. readSources).
+    struct Source {
+        std::string vertex;
+        std::string fragment;
+    };
+
+    Shader(const char* vertexPath, const char* fragmentPath) {
+        ID = glCreateProgram();
+        build(readShaderFile(vertexPath), readShaderFile(fragmentPath));
+    }
+
+    explicit Shader(const Source& source) {
+        ID = glCreateProgram();
+        build(source.vertex, source.fragment);
+    }
+
+    // Исходники нескольких программ (пары vert/frag) одной пачкой чтений
+    // через AsyncFileReader вместо череды блокирующих ifstream.
+    static std::vector<Source> readSources(const std::vector<std::pair<std::string, std::string>>& programs) {
+        std::vector<Source> sources(programs.size());
+        std::vector<std::string*> targets;
+        std::vector<std::string> paths;
+        for (size_t i = 0; i < programs.size(); ++i) {
+            for (auto [path, target] : { std::pair{ &programs[i].first, &sources[i].vertex },
+                                         std::pair{ &programs[i].second, &sources[i].fragment } }) {
+                std::string_view packed;
+                if (AssetArchive::global().findRaw(*path, packed)) {
+                    *target = std::string(packed);
+                } else {
+                    paths.push_back(*path);
+                    targets.push_back(target);
+                }
+            }
+        }
+
+        if (!paths.empty()) {
+            AsyncFileReader reader(static_cast<unsigned>(paths.size()));
+            reader.readAll(paths, [&](size_t index, FileBuffer&& file) {
+                if (file.ok) {
+                    *targets[index] = std::string(file.view());
+                } else {
+                    std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << file.path << std::endl;
+                }
+            });
+        }
+        return sources;
+    }
+
     ~Shader() {
         if (ID != 0) {
             glDeleteProgram(ID);
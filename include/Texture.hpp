@@ -2,15 +2,65 @@
 
 #include <glad/glad.h>
 #include <string>
+#include <memory>
 #include "Shader.hpp"
 
+// Декодированное изображение в памяти, ещё не загруженное в GL.
+// Готовится в любом потоке, загружается только в потоке с контекстом.
+struct TextureImage {
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    std::unique_ptr<unsigned char, void (*)(void*)> pixels{ nullptr, nullptr };
+
+    bool isValid() const { return pixels != nullptr; }
+};
+
+// Параметры выборки; вместе с путём образуют ключ в TextureCache.
+struct TextureSampling {
+    GLenum wrapS = GL_REPEAT;
+    GLenum wrapT = GL_REPEAT;
+    GLenum minFilter = GL_LINEAR_MIPMAP_LINEAR;
+    GLenum magFilter = GL_LINEAR;
+    bool mipmaps = true;
+    bool flipVertically = true;
+};
+
+class Texture;
+// Общая текстура: GL-объект удаляется вместе с последним владельцем.
+using TextureHandle = std::shared_ptr<Texture>;
+
 class Texture {
 public:
-    GLuint ID;
-    GLenum type;
+    GLuint ID = 0;
+    GLenum type = GL_TEXTURE_2D;
+    int width = 0;
+    int height = 0;
+    // Оценка занятой видеопамяти (с мип-уровнями), считается в upload().
+    size_t gpuBytes = 0;
 
+    Texture() = default;
     Texture(const char* image, GLenum texType, GLenum slot, GLenum format, GLenum pixelType);
 
+    // Серая текстура 1x1, которую заменит upload(), когда изображение будет готово.
+    static Texture* CreatePlaceholder(GLenum texType = GL_TEXTURE_2D);
+
+    // Потокобезопасно: флаг переворота stb_image ставится для текущего потока.
+    // glTF хранит UV от верхнего края изображения, ему переворот не нужен.
+    static bool decode(const char* image, TextureImage& out, bool flipVertically = true);
+    // То же для закодированного изображения в памяти (PNG/JPEG внутри .glb).
+    static bool decodeMemory(const unsigned char* data, size_t size, TextureImage& out,
+                             bool flipVertically = true);
+
+    // Загружает изображение в GL (в существующий ID или создаёт новый).
+    void upload(const TextureImage& img, GLenum slot, GLenum pixelType = GL_UNSIGNED_BYTE);
+    void upload(const TextureImage& img, const TextureSampling& sampling);
+
+    // Уменьшение вдвое усреднением 2x2, без GL; нечётный край отбрасывается.
+    static TextureImage downscale(const TextureImage& img);
+    // Сколько видеопамяти займёт изображение такого размера.
+    static size_t estimateBytes(int width, int height, int channels, bool mipmaps);
+
     void texUnit(Shader& shader, const char* uniform, GLuint unit);
     void Bind();
     void Unbind();
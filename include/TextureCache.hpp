@@ -0,0 +1,161 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include "Texture.hpp"
+#include "AssetArchive.hpp"
+
+struct TextureUsage {
+    std::string key;
+    int width = 0;
+    int height = 0;
+    size_t bytes = 0;
+    long users = 0;
+};
+
+// Общие текстуры по пути и параметрам выборки. Каждое изображение
+// декодируется и загружается один раз; записи держат слабые ссылки, и
+// GL-текстура удаляется вместе с последним владельцем. Если задан бюджет
+// видеопамяти, изображение, которое в него не помещается, уменьшается вдвое
+// до тех пор, пока не поместится. Работает только в GL-потоке.
+class TextureCache {
+public:
+    using Decode = std::function<bool(TextureImage& out)>;
+
+    static TextureCache& global() {
+        static TextureCache cache;
+        return cache;
+    }
+
+    // 0 — без ограничения.
+    void setBudget(size_t bytes) { budget = bytes; }
+    size_t getBudget() const { return budget; }
+
+    // Текстура из файла (или из смонтированного архива), декодируется сразу.
+    TextureHandle load(const std::string& path, const TextureSampling& sampling = TextureSampling()) {
+        return acquire(AssetArchive::normalize(path), sampling, [&](TextureImage& out) {
+            return Texture::decode(path.c_str(), out, sampling.flipVertically);
+        });
+    }
+
+    // decode вызывается, только если живой текстуры с таким ключом нет.
+    // Неудачное декодирование даёт nullptr, и в кэш ничего не попадает.
+    TextureHandle acquire(const std::string& key, const TextureSampling& sampling, const Decode& decode) {
+        TextureHandle texture = find(key, sampling);
+        if (texture) return texture;
+
+        TextureImage image;
+        if (!decode(image)) return nullptr;
+        texture = makeHandle(new Texture());
+        upload(*texture, image, sampling);
+        entries[entryKey(key, sampling)] = texture;
+        return texture;
+    }
+
+    TextureHandle find(const std::string& key, const TextureSampling& sampling = TextureSampling()) {
+        auto it = entries.find(entryKey(key, sampling));
+        if (it == entries.end()) return nullptr;
+        TextureHandle texture = it->second.lock();
+        if (!texture) entries.erase(it);
+        return texture;
+    }
+
+    // Заглушка под ключом, которую позже заполнит upload() (фоновая загрузка).
+    TextureHandle reserve(const std::string& key, const TextureSampling& sampling = TextureSampling()) {
+        TextureHandle texture = makeHandle(Texture::CreatePlaceholder());
+        entries[entryKey(key, sampling)] = texture;
+        return texture;
+    }
+
+    // Загрузка в GL с учётом бюджета: место, занятое самой текстурой
+    // (например, заглушкой), не считается.
+    void upload(Texture& texture, const TextureImage& image, const TextureSampling& sampling) {
+        if (!image.isValid()) return;
+
+        size_t available = SIZE_MAX;
+        if (budget > 0) {
+            size_t used = residentBytes() - texture.gpuBytes;
+            available = used < budget ? budget - used : 0;
+        }
+
+        const TextureImage* src = &image;
+        TextureImage reduced;
+        int levels = 0;
+        while (Texture::estimateBytes(src->width, src->height, src->channels, sampling.mipmaps) > available &&
+               src->width >= 2 && src->height >= 2) {
+            reduced = Texture::downscale(*src);
+            src = &reduced;
+            ++levels;
+        }
+        if (levels > 0) {
+            std::cerr << "Texture " << image.width << "x" << image.height << " exceeds the VRAM budget, uploading "
+                      << src->width << "x" << src->height << "\n";
+        }
+        texture.upload(*src, sampling);
+    }
+
+    size_t residentBytes() const {
+        size_t total = 0;
+        for (const auto& [key, weak] : entries) {
+            if (TextureHandle texture = weak.lock()) total += texture->gpuBytes;
+        }
+        return total;
+    }
+
+    std::vector<TextureUsage> usage() const {
+        std::vector<TextureUsage> result;
+        for (const auto& [key, weak] : entries) {
+            TextureHandle texture = weak.lock();
+            if (!texture) continue;
+            // Сам texture — ещё одна ссылка.
+            result.push_back({ key.substr(0, key.find('|')), texture->width, texture->height,
+                               texture->gpuBytes, texture.use_count() - 1 });
+        }
+        std::sort(result.begin(), result.end(),
+                  [](const TextureUsage& a, const TextureUsage& b) { return a.bytes > b.bytes; });
+        return result;
+    }
+
+    void printUsage() const {
+        size_t total = 0;
+        std::vector<TextureUsage> list = usage();
+        for (const TextureUsage& u : list) {
+            std::cout << "  " << u.key << ": " << u.width << "x" << u.height << ", "
+                      << u.bytes / (1024.0 * 1024.0) << " MB, " << u.users << " user(s)\n";
+            total += u.bytes;
+        }
+        std::cout << "Textures: " << list.size() << " resident, " << total / (1024.0 * 1024.0) << " MB";
+        if (budget > 0) {
+            std::cout << " of " << budget / (1024.0 * 1024.0) << " MB budget";
+        }
+        std::cout << "\n";
+    }
+
+    // Забывает записи; уже выданные текстуры остаются действительными.
+    void clear() {
+        entries.clear();
+    }
+
+private:
+    std::unordered_map<std::string, std::weak_ptr<Texture>> entries;
+    size_t budget = 0;
+
+    static TextureHandle makeHandle(Texture* texture) {
+        return TextureHandle(texture, [](Texture* t) {
+            t->Delete();
+            delete t;
+        });
+    }
+
+    static std::string entryKey(const std::string& key, const TextureSampling& s) {
+        return key + "|" + std::to_string(s.wrapS) + "," + std::to_string(s.wrapT) + "," +
+               std::to_string(s.minFilter) + "," + std::to_string(s.magFilter) + "," +
+               (s.mipmaps ? "m" : "-") + (s.flipVertically ? "f" : "-");
+    }
+};
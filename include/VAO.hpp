@@ -10,7 +10,8 @@ public:
     VAO();
 
     void linkAttrib(VBO& vbo, GLuint layout, GLuint numComponents,
-                    GLenum type, GLsizeiptr stride, void* offset);
+                    GLenum type, GLsizeiptr stride, void* offset,
+                    GLboolean normalized = GL_FALSE);
 
     void bind();
     void unbind();
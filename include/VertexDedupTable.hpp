@@ -0,0 +1,110 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Плоская хеш-таблица с открытой адресацией (линейное пробирование) для
+// дедупликации углов граней по тройке индексов (позиция, текстура, нормаль).
+class VertexDedupTable {
+public:
+    static constexpr uint32_t EMPTY = 0xFFFFFFFFu;
+    static constexpr size_t MAX_LOAD_PERCENT = 70;
+
+    VertexDedupTable() {
+        reserve(0);
+    }
+
+    explicit VertexDedupTable(size_t expectedCount) {
+        reserve(expectedCount);
+    }
+
+    // Подбирает ёмкость так, чтобы expectedCount ключей поместились без рехеширования.
+    void reserve(size_t expectedCount) {
+        size_t capacity = 64;
+        while (capacity * MAX_LOAD_PERCENT < expectedCount * 100) {
+            capacity <<= 1;
+        }
+        if (capacity > slots.size()) {
+            rehash(capacity);
+        }
+    }
+
+    // Возвращает индекс уже встреченной тройки или вставляет новую с value.
+    // inserted == true, если тройка встретилась впервые.
+    uint32_t findOrInsert(int pos, int tex, int norm, uint32_t value, bool& inserted) {
+        if ((count + 1) * 100 > slots.size() * MAX_LOAD_PERCENT) {
+            rehash(slots.size() * 2);
+        }
+
+        size_t mask = slots.size() - 1;
+        size_t i = hash(pos, tex, norm) & mask;
+        while (true) {
+            Slot& slot = slots[i];
+            if (slot.value == EMPTY) {
+                slot.pos = pos;
+                slot.tex = tex;
+                slot.norm = norm;
+                slot.value = value;
+                ++count;
+                inserted = true;
+                return value;
+            }
+            if (slot.pos == pos && slot.tex == tex && slot.norm == norm) {
+                inserted = false;
+                return slot.value;
+            }
+            i = (i + 1) & mask;
+        }
+    }
+
+    void clear() {
+        for (Slot& slot : slots) {
+            slot.value = EMPTY;
+        }
+        count = 0;
+    }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return slots.size(); }
+    size_t memoryBytes() const { return slots.size() * sizeof(Slot); }
+
+private:
+    struct Slot {
+        int32_t  pos;
+        int32_t  tex;
+        int32_t  norm;
+        uint32_t value = EMPTY;
+    };
+
+    std::vector<Slot> slots;
+    size_t count = 0;
+
+    static size_t hash(int pos, int tex, int norm) {
+        uint64_t h = static_cast<uint32_t>(pos) * 0x9E3779B97F4A7C15ull;
+        h ^= static_cast<uint32_t>(tex) * 0xC2B2AE3D27D4EB4Full;
+        h ^= static_cast<uint32_t>(norm) * 0x165667B19E3779F9ull;
+        h ^= h >> 29;
+        h *= 0xBF58476D1CE4E5B9ull;
+        h ^= h >> 32;
+        return static_cast<size_t>(h);
+    }
+
+    void rehash(size_t newCapacity) {
+        std::vector<Slot> old;
+        old.swap(slots);
+        slots.assign(newCapacity, Slot{});
+        count = 0;
+
+        size_t mask = newCapacity - 1;
+        for (const Slot& slot : old) {
+            if (slot.value == EMPTY) continue;
+            size_t i = hash(slot.pos, slot.tex, slot.norm) & mask;
+            while (slots[i].value != EMPTY) {
+                i = (i + 1) & mask;
+            }
+            slots[i] = slot;
+            ++count;
+        }
+    }
+};
@@ -0,0 +1,372 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "Vertex.hpp"
+#include "VAO.hpp"
+#include "VBO.hpp"
+
+enum class PositionEncoding : uint8_t {
+    Float32,        // 12 байт
+    Unorm16,        // 8 байт: xyz в долях габаритов сетки (+2 байта выравнивания)
+};
+
+enum class NormalEncoding : uint8_t {
+    Float32,        // 12 байт
+    Packed1010102,  // 4 байта: GL_INT_2_10_10_10_REV
+    Octahedral16,   // 4 байта: октаэдрическая проекция, 2 x snorm16
+};
+
+enum class TexCoordEncoding : uint8_t {
+    Float32,        // 8 байт
+    Half,           // 4 байта: 2 x half float
+    Unorm16,        // 4 байта: в долях диапазона UV сетки
+};
+
+// Как распаковать вершины сетки в шейдере: position = attr * scale + offset,
+// texCoords = attr * texCoordTransform.xy + texCoordTransform.zw. Для
+// несжатых атрибутов это тождественное преобразование.
+struct VertexDecode {
+    glm::vec3 positionScale  = glm::vec3(1.0f);
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+    glm::vec4 texCoordTransform = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+    bool octahedralNormal = false;
+};
+
+// Что разрешено сжимать. Конкретный формат выбирается для каждой сетки по её
+// данным: позиции квантуются, только если это не склеивает вершины рёбер,
+// половинные UV — только в диапазоне, где их точности хватает.
+struct VertexFormatPolicy {
+    bool quantizePositions = true;
+    NormalEncoding normals = NormalEncoding::Octahedral16;
+    TexCoordEncoding texCoords = TexCoordEncoding::Unorm16;
+    bool shortIndices = true;
+
+    static VertexFormatPolicy& global() {
+        static VertexFormatPolicy policy;
+        return policy;
+    }
+
+    static VertexFormatPolicy full() {
+        VertexFormatPolicy p;
+        p.quantizePositions = false;
+        p.normals = NormalEncoding::Float32;
+        p.texCoords = TexCoordEncoding::Float32;
+        p.shortIndices = false;
+        return p;
+    }
+
+    // "full", "compact" или список через запятую: pos16, pos32, oct, 1010102,
+    // normal32, uv16, half, uv32, idx16, idx32. Список правит компактный вариант.
+    static bool parse(const std::string& text, VertexFormatPolicy& out) {
+        if (text == "full") {
+            out = full();
+            return true;
+        }
+        VertexFormatPolicy p;
+        if (text == "compact") {
+            out = p;
+            return true;
+        }
+        std::stringstream list(text);
+        std::string token;
+        while (std::getline(list, token, ',')) {
+            if (token == "pos16") p.quantizePositions = true;
+            else if (token == "pos32") p.quantizePositions = false;
+            else if (token == "oct") p.normals = NormalEncoding::Octahedral16;
+            else if (token == "1010102") p.normals = NormalEncoding::Packed1010102;
+            else if (token == "normal32") p.normals = NormalEncoding::Float32;
+            else if (token == "uv16") p.texCoords = TexCoordEncoding::Unorm16;
+            else if (token == "half") p.texCoords = TexCoordEncoding::Half;
+            else if (token == "uv32") p.texCoords = TexCoordEncoding::Float32;
+            else if (token == "idx16") p.shortIndices = true;
+            else if (token == "idx32") p.shortIndices = false;
+            else return false;
+        }
+        out = p;
+        return true;
+    }
+};
+
+// Раскладка вершин одной сетки в VBO.
+struct VertexFormat {
+    PositionEncoding position = PositionEncoding::Float32;
+    NormalEncoding normal = NormalEncoding::Float32;
+    TexCoordEncoding texCoord = TexCoordEncoding::Float32;
+
+    static constexpr float HALF_UV_LIMIT = 2.0f;                 // дальше шаг half грубее 1/1024
+    static constexpr size_t MAX_COLLAPSED_EDGES_PER_MILLE = 1;   // допустимая доля склеенных рёбер
+
+    bool isFull() const {
+        return position == PositionEncoding::Float32 && normal == NormalEncoding::Float32 &&
+               texCoord == TexCoordEncoding::Float32;
+    }
+
+    size_t positionBytes() const { return position == PositionEncoding::Float32 ? 12 : 8; }
+    size_t normalBytes() const { return normal == NormalEncoding::Float32 ? 12 : 4; }
+    size_t texCoordBytes() const { return texCoord == TexCoordEncoding::Float32 ? 8 : 4; }
+    size_t stride() const { return positionBytes() + normalBytes() + texCoordBytes(); }
+
+    std::string describe() const {
+        static const char* positions[] = { "pos32", "pos16" };
+        static const char* normals[] = { "normal32", "1010102", "oct" };
+        static const char* texCoords[] = { "uv32", "half", "uv16" };
+        return std::string(positions[static_cast<int>(position)]) + "," + normals[static_cast<int>(normal)] +
+               "," + texCoords[static_cast<int>(texCoord)];
+    }
+
+    // Формат для конкретной сетки в рамках policy; decode заполняется
+    // параметрами распаковки.
+    static VertexFormat choose(const Vertex* vertices, size_t vertexCount,
+                               const uint32_t* indices, size_t indexCount,
+                               const VertexFormatPolicy& policy, VertexDecode& decode) {
+        VertexFormat format;
+        decode = VertexDecode();
+        if (vertexCount == 0) return format;
+
+        glm::vec3 minPos(vertices[0].position), maxPos(vertices[0].position);
+        glm::vec2 minUv(vertices[0].texCoords), maxUv(vertices[0].texCoords);
+        for (size_t i = 1; i < vertexCount; ++i) {
+            minPos = glm::min(minPos, vertices[i].position);
+            maxPos = glm::max(maxPos, vertices[i].position);
+            minUv = glm::min(minUv, vertices[i].texCoords);
+            maxUv = glm::max(maxUv, vertices[i].texCoords);
+        }
+
+        if (policy.quantizePositions) {
+            glm::vec3 scale = maxPos - minPos;
+            if (collapsedEdges(vertices, indices, indexCount, minPos, scale) * 1000 <=
+                (indexCount / 3) * MAX_COLLAPSED_EDGES_PER_MILLE) {
+                format.position = PositionEncoding::Unorm16;
+                decode.positionScale = scale;
+                decode.positionOffset = minPos;
+            }
+        }
+
+        format.normal = policy.normals;
+        decode.octahedralNormal = format.normal == NormalEncoding::Octahedral16;
+
+        format.texCoord = policy.texCoords;
+        if (format.texCoord == TexCoordEncoding::Half &&
+            std::max({ std::abs(minUv.x), std::abs(minUv.y), std::abs(maxUv.x), std::abs(maxUv.y) }) >
+                HALF_UV_LIMIT) {
+            format.texCoord = TexCoordEncoding::Unorm16;
+        }
+        if (format.texCoord == TexCoordEncoding::Unorm16) {
+            glm::vec2 range = maxUv - minUv;
+            decode.texCoordTransform = glm::vec4(range.x, range.y, minUv.x, minUv.y);
+        }
+        return format;
+    }
+
+    // Упаковка вершин в этот формат (interleaved, stride()).
+    std::vector<unsigned char> pack(const Vertex* vertices, size_t vertexCount, const VertexDecode& decode) const {
+        std::vector<unsigned char> out(vertexCount * stride());
+        unsigned char* p = out.data();
+        glm::vec3 positionInv = inverseScale(decode.positionScale);
+        glm::vec2 texCoordInv = inverseScale(glm::vec2(decode.texCoordTransform.x, decode.texCoordTransform.y));
+        glm::vec2 texCoordOffset(decode.texCoordTransform.z, decode.texCoordTransform.w);
+
+        for (size_t i = 0; i < vertexCount; ++i) {
+            const Vertex& v = vertices[i];
+            if (position == PositionEncoding::Float32) {
+                std::memcpy(p, &v.position, 12);
+            } else {
+                glm::vec3 t = (v.position - decode.positionOffset) * positionInv;
+                uint16_t q[4] = { unorm16(t.x), unorm16(t.y), unorm16(t.z), 0 };
+                std::memcpy(p, q, 8);
+            }
+            p += positionBytes();
+
+            if (normal == NormalEncoding::Float32) {
+                std::memcpy(p, &v.normal, 12);
+            } else if (normal == NormalEncoding::Packed1010102) {
+                uint32_t packed = packSnorm1010102(v.normal);
+                std::memcpy(p, &packed, 4);
+            } else {
+                glm::vec2 e = octEncode(v.normal);
+                int16_t q[2] = { snorm16(e.x), snorm16(e.y) };
+                std::memcpy(p, q, 4);
+            }
+            p += normalBytes();
+
+            if (texCoord == TexCoordEncoding::Float32) {
+                std::memcpy(p, &v.texCoords, 8);
+            } else if (texCoord == TexCoordEncoding::Half) {
+                uint16_t q[2] = { toHalf(v.texCoords.x), toHalf(v.texCoords.y) };
+                std::memcpy(p, q, 4);
+            } else {
+                glm::vec2 t = (v.texCoords - texCoordOffset) * texCoordInv;
+                uint16_t q[2] = { unorm16(t.x), unorm16(t.y) };
+                std::memcpy(p, q, 4);
+            }
+            p += texCoordBytes();
+        }
+        return out;
+    }
+
+    // Атрибуты 0/1/2 (позиция, нормаль, UV) для VAO, привязанного к vbo.
+    void linkAttributes(VAO& vao, VBO& vbo) const {
+        vao.bind();
+        vbo.bind();
+        linkAttributes();
+        vbo.unbind();
+    }
+
+    // То же для привязанных сейчас VAO и GL_ARRAY_BUFFER.
+    void linkAttributes() const {
+        GLsizei s = static_cast<GLsizei>(stride());
+        size_t offset = 0;
+        if (position == PositionEncoding::Float32) {
+            attribute(0, 3, GL_FLOAT, GL_FALSE, s, offset);
+        } else {
+            attribute(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, s, offset);
+        }
+        offset += positionBytes();
+
+        if (normal == NormalEncoding::Float32) {
+            attribute(1, 3, GL_FLOAT, GL_FALSE, s, offset);
+        } else if (normal == NormalEncoding::Packed1010102) {
+            attribute(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, s, offset);
+        } else {
+            attribute(1, 2, GL_SHORT, GL_TRUE, s, offset);
+        }
+        offset += normalBytes();
+
+        if (texCoord == TexCoordEncoding::Float32) {
+            attribute(2, 2, GL_FLOAT, GL_FALSE, s, offset);
+        } else if (texCoord == TexCoordEncoding::Half) {
+            attribute(2, 2, GL_HALF_FLOAT, GL_FALSE, s, offset);
+        } else {
+            attribute(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, s, offset);
+        }
+    }
+
+    // Октаэдрическая проекция единичного вектора в квадрат [-1, 1]^2.
+    static glm::vec2 octEncode(const glm::vec3& n) {
+        float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        if (l1 <= 0.0f) return glm::vec2(0.0f);
+        glm::vec2 p(n.x / l1, n.y / l1);
+        if (n.z < 0.0f) {
+            p = glm::vec2((1.0f - std::abs(p.y)) * signNotZero(p.x), (1.0f - std::abs(p.x)) * signNotZero(p.y));
+        }
+        return p;
+    }
+
+    static glm::vec3 octDecode(const glm::vec2& e) {
+        glm::vec3 v(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+        if (v.z < 0.0f) {
+            v.x = (1.0f - std::abs(e.y)) * signNotZero(e.x);
+            v.y = (1.0f - std::abs(e.x)) * signNotZero(e.y);
+        }
+        return glm::normalize(v);
+    }
+
+    // IEEE 754 binary16 с округлением к ближайшему; денормали сохраняются.
+    static uint16_t toHalf(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, 4);
+        uint32_t sign = (bits >> 16) & 0x8000u;
+        uint32_t mantissa = bits & 0x7FFFFFu;
+        int exponent = static_cast<int>((bits >> 23) & 0xFF) - 127 + 15;
+
+        if (((bits >> 23) & 0xFF) == 0xFF) {
+            return static_cast<uint16_t>(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+        }
+        if (exponent >= 31) return static_cast<uint16_t>(sign | 0x7C00u);
+        if (exponent <= 0) {
+            if (exponent < -10) return static_cast<uint16_t>(sign);
+            mantissa |= 0x800000u;
+            int shift = 14 - exponent;
+            uint32_t half = mantissa >> shift;
+            uint32_t rest = mantissa & ((1u << shift) - 1);
+            uint32_t halfway = 1u << (shift - 1);
+            if (rest > halfway || (rest == halfway && (half & 1u))) ++half;
+            return static_cast<uint16_t>(sign | half);
+        }
+        uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+        uint32_t rest = mantissa & 0x1FFFu;
+        if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) ++half;   // перенос в порядок допустим
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    static float fromHalf(uint16_t h) {
+        uint32_t sign = (h & 0x8000u) << 16;
+        uint32_t exponent = (h >> 10) & 0x1Fu;
+        uint32_t mantissa = h & 0x3FFu;
+        float value;
+        if (exponent == 0) {
+            value = std::ldexp(static_cast<float>(mantissa), -24);
+        } else if (exponent == 31) {
+            value = mantissa ? NAN : INFINITY;
+        } else {
+            value = std::ldexp(static_cast<float>(mantissa | 0x400u), static_cast<int>(exponent) - 25);
+        }
+        uint32_t bits;
+        std::memcpy(&bits, &value, 4);
+        bits |= sign;
+        std::memcpy(&value, &bits, 4);
+        return value;
+    }
+
+    static uint32_t packSnorm1010102(const glm::vec3& n) {
+        auto component = [](float v) {
+            int q = static_cast<int>(std::lround(std::clamp(v, -1.0f, 1.0f) * 511.0f));
+            return static_cast<uint32_t>(q) & 0x3FFu;
+        };
+        return component(n.x) | (component(n.y) << 10) | (component(n.z) << 20);
+    }
+
+private:
+    static void attribute(GLuint layout, GLint components, GLenum type, GLboolean normalized,
+                          GLsizei stride, size_t offset) {
+        glVertexAttribPointer(layout, components, type, normalized, stride, (void*)offset);
+        glEnableVertexAttribArray(layout);
+    }
+
+    static uint16_t unorm16(float v) {
+        return static_cast<uint16_t>(std::lround(std::clamp(v, 0.0f, 1.0f) * 65535.0f));
+    }
+
+    static int16_t snorm16(float v) {
+        return static_cast<int16_t>(std::lround(std::clamp(v, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    static float signNotZero(float v) {
+        return v >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    template <typename V>
+    static V inverseScale(const V& scale) {
+        V inv;
+        for (size_t i = 0; i < sizeof(V) / sizeof(float); ++i) inv[i] = scale[i] > 0.0f ? 1.0f / scale[i] : 0.0f;
+        return inv;
+    }
+
+    // Сколько рёбер с разными концами схлопнутся после квантования до 16 бит.
+    static size_t collapsedEdges(const Vertex* vertices, const uint32_t* indices, size_t indexCount,
+                                 const glm::vec3& offset, const glm::vec3& scale) {
+        glm::vec3 inv = inverseScale(scale);
+        auto quantize = [&](const glm::vec3& p) {
+            glm::vec3 t = (p - offset) * inv;
+            return std::array<uint16_t, 3>{ unorm16(t.x), unorm16(t.y), unorm16(t.z) };
+        };
+        size_t collapsed = 0;
+        for (size_t t = 0; t + 2 < indexCount; t += 3) {
+            for (int k = 0; k < 3; ++k) {
+                const glm::vec3& a = vertices[indices[t + k]].position;
+                const glm::vec3& b = vertices[indices[t + (k + 1) % 3]].position;
+                if (a != b && quantize(a) == quantize(b)) ++collapsed;
+            }
+        }
+        return collapsed;
+    }
+};
@@ -16,13 +16,24 @@ struct Light {
     float range;
     float cutOff;
     float outerCutOff;
+    int shadow;         // номер куба тени, -1 — без тени
 };
 
-#define MAX_LIGHTS 8
 #define MAX_POINT_SHADOWS 5
 
-uniform Light lights[MAX_LIGHTS];
-uniform int numLights;
+// Источники по кластерам пирамиды камеры (см. LightClusters.hpp): сначала
+// numGlobalLights направленных, они светят везде; остальные фрагмент берёт
+// из списка своего кластера.
+uniform samplerBuffer lightData;        // 4 texel'а на источник
+uniform usamplerBuffer clusterGrid;     // на кластер: начало и длина списка
+uniform usamplerBuffer clusterLights;   // номера источников
+uniform int numGlobalLights;
+uniform vec3 clusterSize;               // плиток по x, y и слоёв глубины
+uniform float clusterScale;             // слой = log(глубина) * clusterScale + clusterBias
+uniform float clusterBias;
+uniform vec4 clusterDepthPlane;         // глубина = dot(clusterDepthPlane, (FragPos, 1))
+uniform vec2 screenSize;
+
 uniform sampler2D shadowMap;
 uniform mat4 lightSpaceMatrix;
 uniform samplerCube pointShadowMaps[MAX_POINT_SHADOWS];
@@ -67,6 +78,16 @@ float ShadowCalculation(vec4 fragPosLightSpace, vec3 normal, vec3 lightDir) {
     return shadow;
 }
 
+// Массив сэмплеров в GLSL 3.30 индексируется только константой, а номер
+// куба приходит из списка кластера и разный у соседних фрагментов.
+float SampleShadowCube(int index, vec3 direction) {
+    if (index == 0) return texture(pointShadowMaps[0], direction).r;
+    if (index == 1) return texture(pointShadowMaps[1], direction).r;
+    if (index == 2) return texture(pointShadowMaps[2], direction).r;
+    if (index == 3) return texture(pointShadowMaps[3], direction).r;
+    return texture(pointShadowMaps[4], direction).r;
+}
+
 float PointShadowCalculation(vec3 fragPos, vec3 lightPos, vec3 normal, int shadowMapIndex) {
     if (shadowMapIndex < 0 || shadowMapIndex >= numPointShadows) {
         return 0.0;
@@ -90,8 +111,8 @@ float PointShadowCalculation(vec3 fragPos, vec3 lightPos, vec3 normal, int shado
     float diskRadius = (1.0 + (currentDepth / far_plane)) / 100.0;
 
     for(int i = 0; i < 20; ++i) {
-        float closestDepth = texture(pointShadowMaps[shadowMapIndex],
-                                    fragToLight + sampleOffsetDirections[i] * diskRadius).r;
+        float closestDepth = SampleShadowCube(shadowMapIndex,
+                                              fragToLight + sampleOffsetDirections[i] * diskRadius);
         closestDepth *= far_plane;
         if(currentDepth - bias > closestDepth)
             shadow += 1.0;
@@ -182,6 +203,32 @@ vec3 CalculateSpotLight(
 }
 
 
+Light FetchLight(int index) {
+    vec4 a = texelFetch(lightData, index * 4);
+    vec4 b = texelFetch(lightData, index * 4 + 1);
+    vec4 c = texelFetch(lightData, index * 4 + 2);
+    vec4 d = texelFetch(lightData, index * 4 + 3);
+    Light light;
+    light.position = a.xyz;
+    light.type = int(a.w);
+    light.direction = b.xyz;
+    light.range = b.w;
+    light.color = c.rgb;
+    light.intensity = c.a;
+    light.cutOff = d.x;
+    light.outerCutOff = d.y;
+    light.shadow = int(d.z);
+    return light;
+}
+
+int ClusterIndex() {
+    ivec3 size = ivec3(clusterSize);
+    float depth = max(dot(clusterDepthPlane, vec4(FragPos, 1.0)), 1e-4);
+    int slice = clamp(int(floor(log(depth) * clusterScale + clusterBias)), 0, size.z - 1);
+    ivec2 tile = clamp(ivec2(gl_FragCoord.xy / screenSize * vec2(size.xy)), ivec2(0), size.xy - 1);
+    return (slice * size.y + tile.y) * size.x + tile.x;
+}
+
 void main() {
     vec3 norm = normalize(Normal);
     vec3 viewDir = normalize(camPos - FragPos);
@@ -194,19 +241,18 @@ void main() {
 
     vec3 result = matAmbient * baseColor * 0.3;
 
-    int pointLightIndex = 0;
+    for (int i = 0; i < numGlobalLights; ++i) {
+        result += CalculateDirectionalLight(FetchLight(i), norm, viewDir, baseColor);
+    }
 
-    for (int i = 0; i < numLights && i < MAX_LIGHTS; ++i) {
-        if (lights[i].type == 1) { // DIRECTIONAL
-            result += CalculateDirectionalLight(lights[i], norm, viewDir, baseColor);
-        }
-        else if (lights[i].type == 0) { // POINT
-            result += CalculatePointLight(lights[i], norm, viewDir, baseColor, pointLightIndex);
-            pointLightIndex++;
+    uvec2 list = texelFetch(clusterGrid, ClusterIndex()).rg;
+    for (uint i = 0u; i < list.y; ++i) {
+        Light light = FetchLight(int(texelFetch(clusterLights, int(list.x + i)).r));
+        if (light.type == 0) { // POINT
+            result += CalculatePointLight(light, norm, viewDir, baseColor, light.shadow);
         }
-        else if (lights[i].type == 2) {
-            result += CalculateSpotLight(lights[i], norm, viewDir, baseColor, pointLightIndex);
-            pointLightIndex++;
+        else if (light.type == 2) { // SPOTLIGHT
+            result += CalculateSpotLight(light, norm, viewDir, baseColor, light.shadow);
         }
     }
 
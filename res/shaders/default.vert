@@ -9,15 +9,34 @@ uniform mat4 view;
 uniform mat4 projection;
 uniform mat4 lightSpaceMatrix;
 
+// Распаковка компактных вершин (см. VertexFormat.hpp).
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+uniform vec4 texCoordTransform;
+uniform bool octahedralNormal;
+
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
 out vec4 FragPosLightSpace;
 
+vec3 decodeNormal() {
+    if (!octahedralNormal) {
+        return normal;
+    }
+    vec3 n = vec3(normal.xy, 1.0 - abs(normal.x) - abs(normal.y));
+    if (n.z < 0.0) {
+        vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+        n.xy = (1.0 - abs(n.yx)) * signs;
+    }
+    return normalize(n);
+}
+
 void main() {
-    FragPos = vec3(model * vec4(position, 1.0));
-    Normal = mat3(transpose(inverse(model))) * normal;
-    TexCoords = texCoords;
+    vec3 localPos = position * positionScale + positionOffset;
+    FragPos = vec3(model * vec4(localPos, 1.0));
+    Normal = mat3(transpose(inverse(model))) * decodeNormal();
+    TexCoords = texCoords * texCoordTransform.xy + texCoordTransform.zw;
     
     
     FragPosLightSpace = lightSpaceMatrix * vec4(FragPos, 1.0);
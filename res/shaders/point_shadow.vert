@@ -4,10 +4,12 @@ layout(location = 0) in vec3 aPos;
 
 uniform mat4 model;
 uniform mat4 lightSpaceMatrix; 
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
 
 out vec3 FragPos;
 
 void main() {
-    FragPos = vec3(model * vec4(aPos, 1.0));
+    FragPos = vec3(model * vec4(aPos * positionScale + positionOffset, 1.0));
     gl_Position = lightSpaceMatrix * vec4(FragPos, 1.0);
 }
@@ -4,7 +4,9 @@ layout(location = 0) in vec3 position;
 
 uniform mat4 lightSpaceMatrix;  
 uniform mat4 model;
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
 
 void main() {
-    gl_Position = lightSpaceMatrix * model * vec4(position, 1.0);
+    gl_Position = lightSpaceMatrix * model * vec4(position * positionScale + positionOffset, 1.0);
 }
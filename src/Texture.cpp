@@ -1,4 +1,5 @@
 #include "Texture.hpp"
+#include "AssetArchive.hpp"
 #include <stb_image.h>
 #include <iostream>
 
@@ -7,39 +8,197 @@ Texture::Texture(const char* image, GLenum texType, GLenum slot,
 {
     type = texType;
 
+    TextureImage img;
+    if (!decode(image, img)) {
+        ID = 0;
+        return;
+    }
+    upload(img, slot, pixelType);
+}
+
+Texture* Texture::CreatePlaceholder(GLenum texType)
+{
+    static unsigned char grey[3] = { 128, 128, 128 };
+
+    Texture* texture = new Texture();
+    texture->type = texType;
+
+    TextureImage img;
+    img.width = 1;
+    img.height = 1;
+    img.channels = 3;
+    img.pixels = std::unique_ptr<unsigned char, void (*)(void*)>(grey, [](void*) {});
+    texture->upload(img, GL_TEXTURE0);
+    return texture;
+}
+
+bool Texture::decode(const char* image, TextureImage& out, bool flipVertically)
+{
+    // Заранее декодированная текстура из архива: пиксели остаются в
+    // отображении, удалять их не нужно.
+    const AssetArchive& archive = AssetArchive::global();
+    ArchiveTextureView cooked;
+    if (archive.findTexture(image, cooked) && cooked.flipped == flipVertically) {
+        out.width = cooked.width;
+        out.height = cooked.height;
+        out.channels = cooked.channels;
+        out.pixels = std::unique_ptr<unsigned char, void (*)(void*)>(
+            const_cast<unsigned char*>(cooked.pixels), [](void*) {});
+        return true;
+    }
+    std::string_view encoded;
+    if (archive.findRaw(image, encoded)) {
+        return decodeMemory(reinterpret_cast<const unsigned char*>(encoded.data()), encoded.size(),
+                            out, flipVertically);
+    }
+
+    // Глобальный stbi_set_flip_vertically_on_load не годится для рабочих потоков.
+    stbi_set_flip_vertically_on_load_thread(flipVertically);
+
     int widthImg, heightImg, numColCh;
-    stbi_set_flip_vertically_on_load(true);
     unsigned char* bytes = stbi_load(image, &widthImg, &heightImg, &numColCh, 0);
     if (!bytes) {
         std::cerr << "Failed to load texture: " << image << std::endl;
-        ID = 0;
+        return false;
+    }
+
+    out.width = widthImg;
+    out.height = heightImg;
+    out.channels = numColCh;
+    out.pixels = std::unique_ptr<unsigned char, void (*)(void*)>(bytes, stbi_image_free);
+    return true;
+}
+
+bool Texture::decodeMemory(const unsigned char* data, size_t size, TextureImage& out,
+                           bool flipVertically)
+{
+    stbi_set_flip_vertically_on_load_thread(flipVertically);
+
+    int widthImg, heightImg, numColCh;
+    unsigned char* bytes = stbi_load_from_memory(data, static_cast<int>(size),
+                                                 &widthImg, &heightImg, &numColCh, 0);
+    if (!bytes) {
+        std::cerr << "Failed to decode embedded texture (" << size << " bytes)" << std::endl;
+        return false;
+    }
+
+    out.width = widthImg;
+    out.height = heightImg;
+    out.channels = numColCh;
+    out.pixels = std::unique_ptr<unsigned char, void (*)(void*)>(bytes, stbi_image_free);
+    return true;
+}
+
+void Texture::upload(const TextureImage& img, GLenum slot, GLenum pixelType)
+{
+    if (!img.isValid()) {
         return;
     }
 
-    
     GLenum dataFormat = GL_RGB;
-    if (numColCh == 1)      dataFormat = GL_RED;
-    else if (numColCh == 3) dataFormat = GL_RGB;
-    else if (numColCh == 4) dataFormat = GL_RGBA;
+    if (img.channels == 1)      dataFormat = GL_RED;
+    else if (img.channels == 3) dataFormat = GL_RGB;
+    else if (img.channels == 4) dataFormat = GL_RGBA;
 
-    glGenTextures(1, &ID);
+    if (ID == 0) {
+        glGenTextures(1, &ID);
+    }
     glActiveTexture(slot);
-    glBindTexture(texType, ID);
+    glBindTexture(type, ID);
 
-    glTexParameteri(texType, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(texType, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(texType, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(texType, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(type, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(type, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(type, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(type, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-    glTexImage2D(texType, 0, dataFormat,
-                 widthImg, heightImg, 0,
-                 dataFormat, pixelType, bytes);
-    glGenerateMipmap(texType);
+    glTexImage2D(type, 0, dataFormat,
+                 img.width, img.height, 0,
+                 dataFormat, pixelType, img.pixels.get());
+    glGenerateMipmap(type);
 
-    stbi_image_free(bytes);
-    glBindTexture(texType, 0);
+    glBindTexture(type, 0);
+
+    width = img.width;
+    height = img.height;
+    gpuBytes = estimateBytes(img.width, img.height, img.channels, true);
+}
+
+void Texture::upload(const TextureImage& img, const TextureSampling& sampling)
+{
+    if (!img.isValid()) {
+        return;
+    }
+
+    GLenum dataFormat = GL_RGB;
+    if (img.channels == 1)      dataFormat = GL_RED;
+    else if (img.channels == 3) dataFormat = GL_RGB;
+    else if (img.channels == 4) dataFormat = GL_RGBA;
+
+    if (ID == 0) {
+        glGenTextures(1, &ID);
+    }
+    glBindTexture(type, ID);
+
+    glTexParameteri(type, GL_TEXTURE_MIN_FILTER, sampling.minFilter);
+    glTexParameteri(type, GL_TEXTURE_MAG_FILTER, sampling.magFilter);
+    glTexParameteri(type, GL_TEXTURE_WRAP_S, sampling.wrapS);
+    glTexParameteri(type, GL_TEXTURE_WRAP_T, sampling.wrapT);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    glTexImage2D(type, 0, dataFormat,
+                 img.width, img.height, 0,
+                 dataFormat, GL_UNSIGNED_BYTE, img.pixels.get());
+    if (sampling.mipmaps) {
+        glGenerateMipmap(type);
+    }
+
+    glBindTexture(type, 0);
+
+    width = img.width;
+    height = img.height;
+    gpuBytes = estimateBytes(img.width, img.height, img.channels, sampling.mipmaps);
+}
+
+TextureImage Texture::downscale(const TextureImage& img)
+{
+    TextureImage out;
+    if (!img.isValid() || img.width < 2 || img.height < 2) {
+        return out;
+    }
+
+    const int c = img.channels;
+    out.width = img.width / 2;
+    out.height = img.height / 2;
+    out.channels = c;
+    unsigned char* dst = new unsigned char[static_cast<size_t>(out.width) * out.height * c];
+    out.pixels = std::unique_ptr<unsigned char, void (*)(void*)>(
+        dst, [](void* p) { delete[] static_cast<unsigned char*>(p); });
+
+    const unsigned char* src = img.pixels.get();
+    const size_t rowBytes = static_cast<size_t>(img.width) * c;
+    for (int y = 0; y < out.height; ++y) {
+        const unsigned char* row0 = src + (2 * y) * rowBytes;
+        const unsigned char* row1 = row0 + rowBytes;
+        for (int x = 0; x < out.width; ++x) {
+            for (int k = 0; k < c; ++k) {
+                int sum = row0[(2 * x) * c + k] + row0[(2 * x + 1) * c + k] +
+                          row1[(2 * x) * c + k] + row1[(2 * x + 1) * c + k];
+                *dst++ = static_cast<unsigned char>((sum + 2) / 4);
+            }
+        }
+    }
+    return out;
+}
+
+size_t Texture::estimateBytes(int width, int height, int channels, bool mipmaps)
+{
+    // Драйверы хранят RGB как RGBA; полная цепочка мип-уровней — ещё треть.
+    size_t texel = channels == 3 ? 4 : static_cast<size_t>(channels);
+    size_t bytes = static_cast<size_t>(width) * height * texel;
+    return mipmaps ? bytes + bytes / 3 : bytes;
 }
 
 
@@ -59,4 +218,6 @@ void Texture::Unbind() {
 
 void Texture::Delete() {
     glDeleteTextures(1, &ID);
+    ID = 0;
+    gpuBytes = 0;
 }
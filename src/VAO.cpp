@@ -5,9 +5,10 @@ VAO::VAO() {
 }
 
 void VAO::linkAttrib(VBO& vbo, GLuint layout, GLuint numComponents,
-                    GLenum type, GLsizeiptr stride, void* offset) {
+                    GLenum type, GLsizeiptr stride, void* offset,
+                    GLboolean normalized) {
     vbo.bind();
-    glVertexAttribPointer(layout, numComponents, type, GL_FALSE, stride, offset);
+    glVertexAttribPointer(layout, numComponents, type, normalized, stride, offset);
     glEnableVertexAttribArray(layout);
     vbo.unbind();
 }
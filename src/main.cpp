@@ -1,5 +1,7 @@
 #include <iostream>
 #include <cmath>
+#include <cstdlib>
+#include <vector>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
@@ -10,6 +12,13 @@
 #include "Light.hpp"
 #include "Renderer.hpp"
 #include "Scene.hpp"
+#include "AssetPipeline.hpp"
+#include "AssetArchive.hpp"
+#include "MeshRegistry.hpp"
+#include "TextureCache.hpp"
+#include "GeometryStore.hpp"
+#include "SceneBvh.hpp"
+#include "CameraPath.hpp"
 
 const unsigned int WINDOW_WIDTH = 1920;
 const unsigned int WINDOW_HEIGHT = 1080;
@@ -54,9 +63,23 @@ int main() {
     glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
 
     
-    Shader shader("res/shaders/default.vert", "res/shaders/default.frag");
-    Shader shadowShader("res/shaders/shadow.vert", "res/shaders/shadow.frag");
-    Shader pointShadowShader("res/shaders/point_shadow.vert", "res/shaders/point_shadow.frag");
+    // Собранный illumination_cook архив, если он есть; иначе (и при
+    // ILLUMINATION_LOOSE_ASSETS=1 во время разработки) — файлы из res/.
+    // Файлы, изменённые после сборки архива, и так читаются из res/.
+    if (std::getenv("ILLUMINATION_LOOSE_ASSETS") == nullptr) {
+        AssetArchive::global().mount("res.pak");
+    }
+
+    
+    // Исходники всех программ читаются одной пачкой.
+    std::vector<Shader::Source> shaderSources = Shader::readSources({
+        { "res/shaders/default.vert", "res/shaders/default.frag" },
+        { "res/shaders/shadow.vert", "res/shaders/shadow.frag" },
+        { "res/shaders/point_shadow.vert", "res/shaders/point_shadow.frag" },
+    });
+    Shader shader(shaderSources[0]);
+    Shader shadowShader(shaderSources[1]);
+    Shader pointShadowShader(shaderSources[2]);
 
     
     FreeCamera camera(glm::vec3(0.0f, 2.0f, 8.0f),
@@ -64,7 +87,37 @@ int main() {
     camera.setProjection(45.0f, (float)WINDOW_WIDTH / WINDOW_HEIGHT, 0.1f, 1000.0f);
 
     
-    Scene scene = Scene::CreateMuseumRoom();
+    // Копии вершин на CPU рендереру не нужны; по запросу они отпускаются
+    // сразу после загрузки в GL.
+    if (std::getenv("ILLUMINATION_RELEASE_CPU_MESHES") != nullptr) {
+        MeshRegistry::global().setReleaseCpuData(true);
+    }
+
+    // Бюджет видеопамяти под текстуры; что не помещается, грузится уменьшенным.
+    if (const char* budget = std::getenv("ILLUMINATION_TEXTURE_BUDGET_MB")) {
+        TextureCache::global().setBudget(static_cast<size_t>(std::atol(budget)) << 20);
+    }
+
+    // Раскладка вершин в VBO: по умолчанию компактная, "full" — float как раньше.
+    if (const char* format = std::getenv("ILLUMINATION_VERTEX_FORMAT")) {
+        if (!VertexFormatPolicy::parse(format, VertexFormatPolicy::global())) {
+            std::cerr << "Unknown ILLUMINATION_VERTEX_FORMAT '" << format << "', using compact vertices\n";
+        }
+    }
+
+    // Статические сетки одного формата лежат в общих буферах (ILLUMINATION_GEOMETRY_ARENA=0 —
+    // у каждой свои, как раньше).
+    if (const char* arena = std::getenv("ILLUMINATION_GEOMETRY_ARENA")) {
+        GeometryStore::global().setEnabled(std::atoi(arena) != 0);
+    }
+
+    // Модели и текстуры грузятся в фоне, окно открывается сразу.
+    AssetPipeline assets;
+    // ILLUMINATION_GALLERY_HALLS=N — анфилада из N залов вместо одного.
+    const char* galleryHalls = std::getenv("ILLUMINATION_GALLERY_HALLS");
+    Scene scene = galleryHalls != nullptr && std::atoi(galleryHalls) > 0
+        ? Scene::CreateGallery(&assets, std::atoi(galleryHalls))
+        : Scene::CreateMuseumRoom(&assets);
 
     
     Renderer renderer(shader);
@@ -72,19 +125,65 @@ int main() {
     
     renderer.initPointShadow(pointShadowShader, 2048, 60.0f);
 
+    // Допустимая ошибка LOD в пикселях (0 — всегда полные сетки) и во сколько
+    // раз больше её допускается в картах теней.
+    LodSettings lodSettings;
+    if (const char* pixels = std::getenv("ILLUMINATION_LOD_PIXELS")) {
+        lodSettings.pixelError = static_cast<float>(std::atof(pixels));
+    }
+    if (const char* bias = std::getenv("ILLUMINATION_SHADOW_LOD_BIAS")) {
+        lodSettings.shadowBias = static_cast<float>(std::atof(bias));
+    }
+    renderer.setLodSettings(lodSettings);
+    // Отсечение кластеров сеток (ILLUMINATION_MESHLET_CULLING=0 — рисовать сетки целиком).
+    if (const char* culling = std::getenv("ILLUMINATION_MESHLET_CULLING")) {
+        renderer.setMeshletCulling(std::atoi(culling) != 0);
+    }
+    // Отсечение объектов в проходах теней (ILLUMINATION_SHADOW_CULLING=0 — рисовать все).
+    if (const char* culling = std::getenv("ILLUMINATION_SHADOW_CULLING")) {
+        renderer.setShadowCulling(std::atoi(culling) != 0);
+    }
+    // Отсечение перекрытых объектов (ILLUMINATION_OCCLUSION_CULLING=0 — выключить).
+    if (const char* culling = std::getenv("ILLUMINATION_OCCLUSION_CULLING")) {
+        renderer.setOcclusionCulling(std::atoi(culling) != 0);
+    }
+    const bool printFrameStats = std::getenv("ILLUMINATION_FRAME_STATS") != nullptr;
+    // Путь камеры для проигрывания без окна (illumination_bench --camera-path).
+    const char* recordCamera = std::getenv("ILLUMINATION_RECORD_CAMERA");
+    CameraPath cameraPath;
+
     
     for (size_t i = 0; i < scene.getMeshCount(); ++i) {
         renderer.addObject(&scene.meshes[i], scene.transforms[i],
-                          scene.materials[i], scene.colors[i]);
+                          scene.materials[i], scene.colors[i], scene.meshCells[i]);
     }
 
     
-    for (const auto& light : scene.lights) {
-        renderer.addLight(light);
+    for (size_t i = 0; i < scene.getLightCount(); ++i) {
+        renderer.addLight(scene.lights[i], scene.lightCells[i]);
     }
+    // Видимость через проёмы между залами (ILLUMINATION_CELL_VISIBILITY=0 — выключить).
+    const char* cellVisibility = std::getenv("ILLUMINATION_CELL_VISIBILITY");
+    if (cellVisibility == nullptr || std::atoi(cellVisibility) != 0) {
+        renderer.setCellGraph(&scene.cells);
+    }
+
+    // Выбор экспоната лучом из центра экрана (левая кнопка мыши); дерево
+    // пересобирается, когда фоновая загрузка подменяет заглушки сетками.
+    SceneBvh picking;
+    auto rebuildPicking = [&]() {
+        picking.clear();
+        for (size_t i = 0; i < scene.getMeshCount(); ++i) {
+            picking.addObject(scene.meshes[i].bvh, scene.transforms[i]);
+        }
+        picking.build();
+    };
+    rebuildPicking();
+    bool pickPressed = false;
 
     
     double lastTime = glfwGetTime();
+    double lastStatsTime = lastTime;
     int frameCount = 0;
 
     while (!glfwWindowShouldClose(window)) {
@@ -99,6 +198,30 @@ int main() {
             glfwSetWindowShouldClose(window, true);
         }
 
+        bool pickDown = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+        if (pickDown && !pickPressed) {
+            RayHit hit;
+            if (picking.raycast(camera.getPosition(), camera.getFront(), hit, 100.0f)) {
+                std::cout << "Picked object " << hit.object << ", triangle " << hit.triangle
+                          << ", distance " << hit.t << "\n";
+            } else {
+                std::cout << "Picked nothing\n";
+            }
+        }
+        pickPressed = pickDown;
+
+        
+        size_t loaded = assets.pump();
+        if (loaded > 0) {
+            rebuildPicking();
+        }
+        if (loaded > 0 && assets.isIdle()) {
+            GeometryStore::global().compact();
+            MeshRegistry::global().printStats();
+            GeometryStore::global().printStats();
+            TextureCache::global().printUsage();
+        }
+
         
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -107,19 +230,49 @@ int main() {
 
         
         camera.setShaderMatrix(shader);
+        if (recordCamera != nullptr) {
+            cameraPath.record(camera.getPosition(), camera.getFront());
+        }
+        renderer.setView(camera.getPosition(), camera.getViewMatrix(), camera.getProjectionMatrix());
 
         
         renderer.render();
 
+        if (printFrameStats && currentTime - lastStatsTime >= 2.0) {
+            const RenderStats& stats = renderer.lastFrameStats();
+            std::cout << "Frame: " << stats.mainTriangles << " main + " << stats.shadowTriangles
+                      << " shadow triangles, " << stats.drawCalls << " draw calls, " << stats.vertexArrayBinds
+                      << " VAO binds, " << stats.objectsCulled << " objects culled and " << stats.objectsOccluded
+                      << " occluded by " << stats.occluderTriangles << " occluder triangles, " << stats.clustersCulled
+                      << " of " << stats.clustersTested << " clusters culled, " << stats.shadowCasters
+                      << " shadow casters in " << renderer.lastShadowPasses().size() << " passes ("
+                      << stats.shadowCastersOutsideLight << " outside light spheres, " << stats.shadowCastersCulled
+                      << " outside pass frusta, " << stats.shadowLightsSkipped << " lights skipped), " << stats.cellsVisible << " cells visible ("
+                      << stats.objectsSkipped << " objects and " << scene.getLightCount() - stats.lightsActive
+                      << " lights behind walls), " << stats.clusterLightRefs << " light list entries (up to "
+                      << stats.maxClusterLights << " lights per froxel)\n";
+            lastStatsTime = currentTime;
+        }
+
         
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
     
+    if (recordCamera != nullptr) {
+        cameraPath.save(recordCamera);
+    }
+
+    // GL-объекты удаляются с последней копией сетки, пока контекст ещё жив.
     for (auto& mesh : scene.meshes) {
         mesh.cleanup();
     }
+    renderer.cleanup();
+    MeshRegistry::global().clear();
+    GeometryStore::global().clear();
+    TextureCache::global().clear();
+    glDeleteBuffers(static_cast<GLsizei>(scene.sharedBuffers.size()), scene.sharedBuffers.data());
 
     shader.remove();
     shadowShader.remove();
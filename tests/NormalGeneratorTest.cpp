@@ -0,0 +1,128 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <glm/glm.hpp>
+#include "LegacyNormals.hpp"
+#include "NormalGenerator.hpp"
+#include "ObjParser.hpp"
+#include "MappedFile.hpp"
+#include "MeshData.hpp"
+#include "Primitives.hpp"
+
+// NormalWeighting::Uniform против старого calculateNormals (bench/LegacyNormals.hpp)
+// и одинаковый результат при любом числе потоков для всех весов. Запускается
+// из корня репозитория (ctest задаёт WORKING_DIRECTORY), модели — из res/models.
+
+static constexpr float EPSILON = 1e-5f;
+
+// Та же волнистая сетка, что пишет bench/SyntheticObj, но сразу в памяти.
+static MeshData waveGrid(size_t cols, size_t rows) {
+    MeshData data;
+    for (size_t r = 0; r <= rows; ++r) {
+        for (size_t c = 0; c <= cols; ++c) {
+            Vertex v{};
+            float x = static_cast<float>(c) * 0.1f;
+            float z = static_cast<float>(r) * 0.1f;
+            v.position = glm::vec3(x, std::sin(x * 0.7f) * std::cos(z * 0.5f) * 0.5f, z);
+            data.vertices.push_back(v);
+        }
+    }
+    for (size_t r = 0; r < rows; ++r) {
+        for (size_t c = 0; c < cols; ++c) {
+            uint32_t a = static_cast<uint32_t>(r * (cols + 1) + c);
+            uint32_t b = a + 1;
+            uint32_t d = a + static_cast<uint32_t>(cols) + 1;
+            uint32_t e = d + 1;
+            data.indices.insert(data.indices.end(), { a, d, b, b, d, e });
+        }
+    }
+    return data;
+}
+
+static bool isFinite(const glm::vec3& v) {
+    return std::isfinite(v.x) && std::isfinite(v.y) && std::isfinite(v.z);
+}
+
+static bool check(const std::string& name, const MeshData& mesh) {
+    std::vector<Vertex> expected = mesh.vertices;
+    legacyCalculateNormals(expected, mesh.indices);
+
+    std::vector<Vertex> serial = mesh.vertices;
+    NormalGenerator::generate(serial, mesh.indices, NormalWeighting::Uniform, 1);
+
+    // Старый код даёт NaN вершинам вырожденных треугольников, новый их
+    // пропускает: такие вершины не сравниваются.
+    float maxError = 0.0f;
+    size_t skipped = 0;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (!isFinite(expected[i].normal)) {
+            ++skipped;
+            continue;
+        }
+        glm::vec3 d = glm::abs(serial[i].normal - expected[i].normal);
+        maxError = std::max(maxError, std::max(d.x, std::max(d.y, d.z)));
+    }
+    bool ok = maxError <= EPSILON;
+
+    for (NormalWeighting weighting : { NormalWeighting::Uniform, NormalWeighting::Area, NormalWeighting::Angle }) {
+        std::vector<Vertex> reference = mesh.vertices;
+        NormalGenerator::generate(reference, mesh.indices, weighting, 1);
+        for (unsigned threads : { 2u, 3u, 8u }) {
+            std::vector<Vertex> parallel = mesh.vertices;
+            NormalGenerator::generate(parallel, mesh.indices, weighting, threads);
+            for (size_t i = 0; i < parallel.size(); ++i) {
+                if (std::memcmp(&parallel[i].normal, &reference[i].normal, sizeof(glm::vec3)) != 0) {
+                    std::cerr << name << ": weighting " << static_cast<int>(weighting) << ", " << threads
+                              << " threads differ from 1 thread at vertex " << i << "\n";
+                    ok = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    std::cout << (ok ? "ok   " : "FAIL ") << name << ": " << mesh.vertices.size() << " vertices, "
+              << mesh.indices.size() / 3 << " triangles, max error " << maxError;
+    if (skipped > 0) {
+        std::cout << ", " << skipped << " degenerate vertices skipped";
+    }
+    std::cout << "\n";
+    return ok;
+}
+
+int main() {
+    bool ok = true;
+    ok &= check("cube", Primitives::Cube());
+    // Больше 2 * MIN_FACES_PER_THREAD граней: проходит и параллельная ветка.
+    ok &= check("wave grid", waveGrid(300, 200));
+
+    // Без моделей тест ничего не проверяет: запуск не из корня репозитория — ошибка.
+    std::error_code ec;
+    size_t models = 0;
+    for (const auto& entry : std::filesystem::directory_iterator("res/models", ec)) {
+        if (entry.path().extension() != ".obj") continue;
+        MappedFile file(entry.path().string());
+        if (!file.isOpen()) {
+            std::cerr << "Failed to open " << entry.path().string() << "\n";
+            ok = false;
+            continue;
+        }
+        ok &= check(entry.path().filename().string(), ObjParser::parse(file.view()));
+        ++models;
+    }
+    if (ec) {
+        std::cerr << "Failed to list res/models: " << ec.message() << "\n";
+        ok = false;
+    } else if (models == 0) {
+        std::cerr << "No .obj models found in res/models\n";
+        ok = false;
+    } else {
+        std::cout << models << " models checked\n";
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cctype>
+#include <stb_image.h>
+#include "AssetArchive.hpp"
+#include "MappedFile.hpp"
+#include "MeshData.hpp"
+#include "Bounds.hpp"
+#include "ObjParser.hpp"
+#include "NormalGenerator.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+#include "MeshletBuilder.hpp"
+#include "Parallel.hpp"
+
+// Офлайн-«повар» ресурсов: упаковывает дерево res/ в один архив.
+// OBJ сохраняются разобранными (с нормалями, оптимизированным порядком
+// треугольников и вершин и уровнями LOD), изображения — декодированными
+// и перевёрнутыми так же, как их грузит Texture, остальное — как есть.
+
+static void printUsage() {
+    std::cerr <<
+        "usage: illumination_cook [options]\n"
+        "  --root <dir>        resource tree to pack (default res)\n"
+        "  --out <file>        archive to write (default res.pak)\n"
+        "  --prefix <path>     key prefix for the entries (default: name of --root)\n"
+        "  --threads <n>       OBJ parse threads (default: all cores)\n"
+        "  --no-optimize       keep OBJ triangles and vertices in file order\n"
+        "  --no-meshlets       do not split meshes into culling clusters\n"
+        "  --lods <n>          simplified LOD levels per mesh (default 3, 0 to skip)\n";
+}
+
+static std::string lowerExtension(const std::filesystem::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return ext;
+}
+
+static bool isImage(const std::string& ext) {
+    return ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp" || ext == ".tga";
+}
+
+// Служебные файлы рядом с ресурсами в архив не попадают.
+static bool isSkipped(const std::string& ext) {
+    return ext == ".meshcache" || ext == ".tmp";
+}
+
+int main(int argc, char** argv) {
+    std::string root = "res";
+    std::string outPath = "res.pak";
+    std::string prefix;
+    unsigned threads = Parallel::hardwareThreads();
+    bool optimize = true;
+    bool meshlets = true;
+    unsigned lodLevels = 3;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << "\n";
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--root") {
+            root = value();
+        } else if (arg == "--out") {
+            outPath = value();
+        } else if (arg == "--prefix") {
+            prefix = value();
+        } else if (arg == "--threads") {
+            threads = static_cast<unsigned>(std::max(1, std::atoi(value().c_str())));
+        } else if (arg == "--no-optimize") {
+            optimize = false;
+        } else if (arg == "--no-meshlets") {
+            meshlets = false;
+        } else if (arg == "--lods") {
+            lodLevels = static_cast<unsigned>(std::max(0, std::atoi(value().c_str())));
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return 0;
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            printUsage();
+            return 2;
+        }
+    }
+
+    std::filesystem::path rootPath = std::filesystem::path(root).lexically_normal();
+    if (prefix.empty()) {
+        prefix = rootPath.filename().string();
+    }
+
+    std::error_code ec;
+    std::vector<std::filesystem::path> files;
+    for (auto it = std::filesystem::recursive_directory_iterator(rootPath, ec);
+         it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+        if (ec) break;
+        if (it->is_regular_file(ec) && !isSkipped(lowerExtension(it->path()))) {
+            files.push_back(it->path());
+        }
+    }
+    if (ec || files.empty()) {
+        std::cerr << "No resources found under " << root << std::endl;
+        return 1;
+    }
+    std::sort(files.begin(), files.end());
+
+    AssetArchiveWriter writer;
+    if (!writer.open(outPath)) {
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    size_t sourceBytes = 0;
+    size_t failures = 0;
+    for (const auto& path : files) {
+        std::string key = (std::filesystem::path(prefix) /
+                           std::filesystem::relative(path, rootPath, ec)).generic_string();
+        std::string ext = lowerExtension(path);
+        MappedFile source(path.string());
+        if (!source.isOpen()) {
+            std::cerr << "Failed to open " << path.string() << std::endl;
+            ++failures;
+            continue;
+        }
+        sourceBytes += source.size();
+        SourceStamp stamp;
+        stamp.size = source.size();
+        stamp.mtime = MeshCache::modifiedTime(path.string());
+
+        bool ok = false;
+        if (ext == ".obj") {
+            MeshData data = threads > 1 ? ObjParser::parseParallel(source.view(), threads)
+                                        : ObjParser::parse(source.view());
+            if (!data.hasNormals) {
+                NormalGenerator::generate(data.vertices, data.indices, NormalWeighting::Uniform, threads);
+            }
+            MeshOptimizeStats stats;
+            if (optimize) {
+                stats = MeshOptimizer::optimize(data);
+            }
+            if (meshlets) {
+                MeshletBuilder::build(data);
+            }
+            MeshSimplifier::buildLods(data, lodLevels);
+            stamp.settings = MeshCache::settingsKey(static_cast<uint32_t>(NormalWeighting::Uniform),
+                                                    optimize, lodLevels, meshlets);
+            ok = writer.addMesh(key, data, Bounds::fromVertices(data.vertices), stamp);
+            std::cout << "  mesh     " << key << ": " << data.vertices.size() << " vertices, "
+                      << data.indices.size() / 3 << " triangles";
+            if (optimize) {
+                std::cout << ", ACMR " << stats.acmrBefore << " -> " << stats.acmrAfter
+                          << ", ATVR " << stats.atvrBefore << " -> " << stats.atvrAfter;
+            }
+            if (!data.meshlets.empty()) {
+                std::cout << ", " << data.meshlets.size() << " meshlets";
+            }
+            for (const MeshLod& lod : data.lods) {
+                std::cout << ", LOD " << lod.indexCount / 3;
+            }
+            std::cout << "\n";
+        } else if (isImage(ext)) {
+            // Как Texture::decode по умолчанию: с переворотом для GL.
+            stbi_set_flip_vertically_on_load_thread(true);
+            int width, height, channels;
+            unsigned char* pixels = stbi_load_from_memory(
+                reinterpret_cast<const unsigned char*>(source.data()), static_cast<int>(source.size()),
+                &width, &height, &channels, 0);
+            if (pixels != nullptr) {
+                ok = writer.addTexture(key, pixels, width, height, channels, true, stamp);
+                stbi_image_free(pixels);
+                std::cout << "  texture  " << key << ": " << width << "x" << height << "x" << channels << "\n";
+            } else {
+                std::cerr << "Failed to decode " << path.string() << ", storing it as is\n";
+                ok = writer.addRaw(key, source.data(), source.size(), stamp);
+            }
+        } else {
+            ok = writer.addRaw(key, source.data(), source.size(), stamp);
+            std::cout << "  raw      " << key << ": " << source.size() << " bytes\n";
+        }
+        if (!ok) {
+            ++failures;
+        }
+    }
+
+    if (failures > 0) {
+        writer.abort();
+    }
+    if (failures > 0 || !writer.finish()) {
+        std::cerr << "Cooking failed (" << failures << " file(s))" << std::endl;
+        return 1;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Cooked " << files.size() << " files (" << sourceBytes / (1024.0 * 1024.0) << " MB) into "
+              << outPath << " (" << writer.bytesWritten() / (1024.0 * 1024.0) << " MB) in "
+              << seconds << " s\n";
+    return 0;
+}